@@ -189,6 +189,7 @@ void autocomplete(navitia::PbCreator& pb_creator, const std::string &q,
         pb_creator.fill_pb_error(pbnavitia::Error::bad_filter, "Autocomplete : value of q absent");
         return;
     }
+    d.load_section(nt::DataSection::Autocomplete);
     int nbmax_temp = nbmax;
     //For each object type we search in the dictionnary and keep (nbmax x 3) objects in the result.
     //It's always better to get more objects from the disctionnary and apply some rules to delete
@@ -386,46 +386,64 @@ void StopTimeFusioHandler::init(Data& data) {
     alighting_duration_c = csv.get_pos_col("alighting_duration");
 }
 
-void StopTimeFusioHandler::handle_line(Data& data, const csv_row& row, bool is_first_line) {
-    auto stop_times = StopTimeGtfsHandler::handle_line(data, row, is_first_line);
+void StopTimeFusioHandler::handle_line(Data& data, const csv_row& row, bool) {
+    auto line = parse_line(data, row);
+    link_line(data, line);
+}
+
+void StopTimeFusioHandler::link_line(Data& data, parsed_line& line) {
+    std::vector<ed::types::StopTime*> stop_times;
+    for (const auto& stop_time: line.stop_times) { stop_times.push_back(stop_time.get()); }
+    StopTimeGtfsHandler::link_line(data, line.stop_times);
+    for (auto stop_time: stop_times) {
+        if (! line.id.empty()) {
+            //if we have an id, we store the stoptime for futur use
+            gtfs_data.stop_time_map[line.id].push_back(stop_time);
+        }
+        if (! line.comment_id.empty()) {
+            data.add_pt_object_comment(stop_time, line.comment_id);
+        }
+    }
+}
+
+StopTimeFusioHandler::parsed_line StopTimeFusioHandler::parse_line(const Data& data, const csv_row& row) const {
+    parsed_line line;
+    line.stop_times = StopTimeGtfsHandler::parse_line(data, row);
     //gtfs can return many stoptimes for one line because of DST periods
-    if (stop_times.empty()) {
-        return;
+    if (line.stop_times.empty()) {
+        return line;
     }
-    for (auto stop_time: stop_times) {
+    if (is_valid(id_c, row)) {
+        line.id = row[id_c].to_string();
+    }
+    if (is_valid(desc_c, row)) {
+        std::string comment_id = row[desc_c].to_string();
+        if (data.comment_by_id.find(comment_id) != data.comment_by_id.end()) {
+            line.comment_id = std::move(comment_id);
+        }
+    }
+    for (auto& stop_time: line.stop_times) {
         if (is_valid(date_time_estimated_c, row))
             stop_time->date_time_estimated = (row[date_time_estimated_c] == "1");
         else
             stop_time->date_time_estimated = false;
 
-
-        if (is_valid(id_c, row)) {
-            //if we have an id, we store the stoptime for futur use
-            gtfs_data.stop_time_map[row[id_c]].push_back(stop_time);
-        }
-
-        if (is_valid(desc_c, row)) {
-            auto it_comment = data.comment_by_id.find(row[desc_c]);
-            if (it_comment != data.comment_by_id.end()) {
-                data.add_pt_object_comment(stop_time, row[desc_c]);
-            }
-        }
-
         if (is_valid(itl_c, row)) {
-            uint16_t local_traffic_zone =  boost::lexical_cast<uint16_t>(row[itl_c]);
+            uint16_t local_traffic_zone =  boost::lexical_cast<uint16_t>(row[itl_c].data(), row[itl_c].size());
             if (local_traffic_zone > 0) {
                 stop_time->local_traffic_zone = local_traffic_zone;
             }
         }
 
         if (is_valid(headsign_c, row)) {
-            stop_time->headsign = row[headsign_c];
+            stop_time->headsign = row[headsign_c].to_string();
         }
 
         if (is_valid(boarding_duration_c, row)) {
             unsigned int boarding_duration(0);
             try {
-                 boarding_duration = boost::lexical_cast<unsigned int>(row[boarding_duration_c]);
+                 boarding_duration = boost::lexical_cast<unsigned int>(row[boarding_duration_c].data(),
+                                                                      row[boarding_duration_c].size());
             }
             catch(boost::bad_lexical_cast) {
                 LOG4CPLUS_INFO(logger, "Impossible to parse boarding_duration for stop_time number "
@@ -440,7 +458,8 @@ void StopTimeFusioHandler::handle_line(Data& data, const csv_row& row, bool is_f
         if (is_valid(alighting_duration_c, row)) {
             unsigned int alighting_duration(0);
             try {
-                 alighting_duration = boost::lexical_cast<unsigned int>(row[alighting_duration_c]);
+                 alighting_duration = boost::lexical_cast<unsigned int>(row[alighting_duration_c].data(),
+                                                                       row[alighting_duration_c].size());
             }
             catch(boost::bad_lexical_cast) {
                 LOG4CPLUS_INFO(logger, "Impossible to parse boarding_duration for stop_time number "
@@ -452,6 +471,7 @@ void StopTimeFusioHandler::handle_line(Data& data, const csv_row& row, bool is_f
             stop_time->alighting_time += alighting_duration;
         }
     }
+    return line;
 }
 
 template<typename T>
@@ -141,10 +141,18 @@ struct TripsFusioHandler : public GenericHandler {
 };
 
 struct StopTimeFusioHandler : public StopTimeGtfsHandler {
-    StopTimeFusioHandler(GtfsData& gdata, CsvReader& reader) : StopTimeGtfsHandler(gdata, reader) {}
+    StopTimeFusioHandler(GtfsData& gdata, MmapCsvReader& reader) : StopTimeGtfsHandler(gdata, reader) {}
     int desc_c, itl_c, date_time_estimated_c, id_c, headsign_c, boarding_duration_c, alighting_duration_c;
     void init(Data&);
     void handle_line(Data& data, const csv_row& line, bool is_first_line);
+
+    struct parsed_line {
+        StopTimeGtfsHandler::parsed_line stop_times;
+        std::string id;
+        std::string comment_id;
+    };
+    parsed_line parse_line(const Data& data, const csv_row& line) const;
+    void link_line(Data& data, parsed_line& line);
 };
 
 struct ContributorFusioHandler : public GenericHandler {
@@ -168,18 +168,26 @@ ed::types::Company* GtfsData::get_or_create_default_company(Data & data) {
 }
 
 
-int time_to_int(const std::string & time) {
-    typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
-    boost::char_separator<char> sep(":");
-    tokenizer tokens(time, sep);
-    std::vector<std::string> elts(tokens.begin(), tokens.end());
+// called twice by stop time, so the fields are split in place
+int time_to_int(boost::string_ref time) {
+    boost::string_ref elts[3];
+    size_t nb_elts = 0;
+    while (! time.empty()) {
+        const size_t pos = std::min(time.find(':'), time.size());
+        // like a tokenizer, the empty fields are skipped
+        if (pos != 0) {
+            if (nb_elts == 3) { return -1; }
+            elts[nb_elts++] = time.substr(0, pos);
+        }
+        time.remove_prefix(std::min(pos + 1, time.size()));
+    }
     int result = 0;
-    if(elts.size() != 3)
+    if(nb_elts != 3)
         return -1;
     try {
-        result = boost::lexical_cast<int>(elts[0]) * 3600;
-        result += boost::lexical_cast<int>(elts[1]) * 60;
-        result += boost::lexical_cast<int>(elts[2]);
+        result = boost::lexical_cast<int>(elts[0].data(), elts[0].size()) * 3600;
+        result += boost::lexical_cast<int>(elts[1].data(), elts[1].size()) * 60;
+        result += boost::lexical_cast<int>(elts[2].data(), elts[2].size());
     }
     catch(boost::bad_lexical_cast){
         return std::numeric_limits<int>::min();
@@ -856,7 +864,8 @@ types::Route* TripsGtfsHandler::get_or_create_route(Data& data, const RouteId& r
 }
 
 void TripsGtfsHandler::handle_line(Data& data, const csv_row& row, bool) {
-    auto it = gtfs_data.line_map.find(row[id_c]);
+    const std::string trip_id = row[trip_c].to_string();
+    auto it = gtfs_data.line_map.find(row[id_c].to_string());
     if (it == gtfs_data.line_map.end()) {
         LOG4CPLUS_WARN(logger, "Impossible to find the Gtfs line " << row[id_c]
                        << " referenced by trip " << row[trip_c]);
@@ -869,30 +878,30 @@ void TripsGtfsHandler::handle_line(Data& data, const csv_row& row, bool) {
     // direction_id is optional (and possible values "0" or "1"), so defaulting to "0"
     std::string direction_id = "";
     if (direction_id_c != -1) {
-        direction_id = row[direction_id_c];
+        direction_id = row[direction_id_c].to_string();
     }
     nm::Route* route = get_or_create_route(data, {line, direction_id});
 
-    auto vp_range = gtfs_data.tz.vp_by_name.equal_range(row[service_c]);
+    auto vp_range = gtfs_data.tz.vp_by_name.equal_range(row[service_c].to_string());
     if(empty(vp_range)) {
-        LOG4CPLUS_WARN(logger, "Impossible to find the Gtfs service " + row[service_c]
-                       + " referenced by trip " + row[trip_c]);
+        LOG4CPLUS_WARN(logger, "Impossible to find the Gtfs service " << row[service_c]
+                       << " referenced by trip " << row[trip_c]);
         ignored++;
         return;
     }
 
     //we look in the meta vj table to see if we already have one such vj
-    if (data.meta_vj_map.find(row[trip_c]) != data.meta_vj_map.end()) {
-        LOG4CPLUS_DEBUG(logger, "vj " << row[trip_c] << " already read, we skip the second one");
+    if (data.meta_vj_map.find(trip_id) != data.meta_vj_map.end()) {
+        LOG4CPLUS_DEBUG(logger, "vj " << trip_id << " already read, we skip the second one");
         ignored_vj++;
         return;
     }
 
-    types::MetaVehicleJourney& meta_vj = data.meta_vj_map[row[trip_c]]; //we get a ref on a newly created meta vj
-    meta_vj.uri = row[trip_c];
+    types::MetaVehicleJourney& meta_vj = data.meta_vj_map[trip_id]; //we get a ref on a newly created meta vj
+    meta_vj.uri = trip_id;
 
     // get shape if possible
-    const std::string &shape_id = has_col(shape_id_c, row) ? row.at(shape_id_c) : "";
+    const std::string shape_id = has_col(shape_id_c, row) ? row[shape_id_c].to_string() : "";
 
     bool has_been_split = more_than_one_elt(vp_range); //check if the trip has been split over dst
 
@@ -903,7 +912,7 @@ void TripsGtfsHandler::handle_line(Data& data, const csv_row& row, bool) {
         nt::ValidityPattern* vp_xx = vp_it->second;
 
         nm::VehicleJourney* vj = new nm::VehicleJourney();
-        const std::string original_uri = row[trip_c];
+        const std::string& original_uri = trip_id;
         std::string vj_uri = original_uri;
         if (has_been_split) {
             vj_uri = generate_unique_vj_uri(gtfs_data, original_uri, cpt_vj);
@@ -911,7 +920,7 @@ void TripsGtfsHandler::handle_line(Data& data, const csv_row& row, bool) {
 
         vj->uri = vj_uri;
         if(has_col(headsign_c, row))
-            vj->name = row[headsign_c];
+            vj->name = row[headsign_c].to_string();
         else
             vj->name = vj->uri;
 
@@ -919,7 +928,7 @@ void TripsGtfsHandler::handle_line(Data& data, const csv_row& row, bool) {
         vj->adapted_validity_pattern = vp_xx;
         vj->route = route;
         if(has_col(block_id_c, row))
-            vj->block_id = row[block_id_c];
+            vj->block_id = row[block_id_c].to_string();
         else
             vj->block_id = "";
         if(has_col(wheelchair_c, row) && row[wheelchair_c] == "1")
@@ -939,7 +948,7 @@ void TripsGtfsHandler::handle_line(Data& data, const csv_row& row, bool) {
         data.vehicle_journeys.push_back(vj);
         //we add them on our meta vj
         meta_vj.theoric_vj.push_back(vj);
-        vj->meta_vj_name = row[trip_c];
+        vj->meta_vj_name = trip_id;
         vj->shape_id = shape_id;
     }
 }
@@ -1008,7 +1017,7 @@ void StopTimeGtfsHandler::finish(Data& data) {
     LOG4CPLUS_INFO(logger, "Nb stop times: " << data.stops.size());
 }
 
-static int to_utc(const std::string& local_time, int utc_offset) {
+static int to_utc(boost::string_ref local_time, int utc_offset) {
     int local = time_to_int(local_time);
     if (local != std::numeric_limits<int>::min()) {
         local -= utc_offset;
@@ -1017,23 +1026,32 @@ static int to_utc(const std::string& local_time, int utc_offset) {
 }
 
 std::vector<nm::StopTime*> StopTimeGtfsHandler::handle_line(Data& data, const csv_row& row, bool) {
-    auto stop_it = gtfs_data.stop_map.find(row[stop_c]);
+    auto line = parse_line(data, row);
+    std::vector<nm::StopTime*> stop_times;
+    for (const auto& stop_time: line) { stop_times.push_back(stop_time.get()); }
+    link_line(data, line);
+    return stop_times;
+}
+
+StopTimeGtfsHandler::parsed_line StopTimeGtfsHandler::parse_line(const Data& data, const csv_row& row) const {
+    auto stop_it = gtfs_data.stop_map.find(row[stop_c].to_string());
     if(stop_it == gtfs_data.stop_map.end()) {
-        LOG4CPLUS_WARN(logger, "Impossible to find the stop_point " + row[stop_c] + "!");
+        LOG4CPLUS_WARN(logger, "Impossible to find the stop_point " << row[stop_c] << "!");
         return {};
     }
 
-    auto vj_it = gtfs_data.tz.vj_by_name.lower_bound(row[id_c]);
+    const auto key = row[id_c].to_string();
+    auto vj_it = gtfs_data.tz.vj_by_name.lower_bound(key);
     if(vj_it == gtfs_data.tz.vj_by_name.end()) {
         LOG4CPLUS_WARN(logger, "Impossible to find the vehicle_journey '" << row[id_c] << "'");
         return {};
     }
-    std::vector<nm::StopTime*> stop_times;
+    parsed_line stop_times;
 
     //the validity pattern may have been split because of DST, so we need to create one vj for each
-    for (auto vj_end_it = gtfs_data.tz.vj_by_name.upper_bound(row[id_c]); vj_it != vj_end_it; ++vj_it) {
+    for (auto vj_end_it = gtfs_data.tz.vj_by_name.upper_bound(key); vj_it != vj_end_it; ++vj_it) {
 
-        nm::StopTime* stop_time = new nm::StopTime();
+        auto stop_time = std::make_unique<nm::StopTime>();
 
         //we need to convert the stop times in UTC
         int utc_offset = data.tz_wrapper.tz_handler.get_first_utc_offset(*vj_it->second->validity_pattern);
@@ -1046,7 +1064,7 @@ std::vector<nm::StopTime*> StopTimeGtfsHandler::handle_line(Data& data, const cs
         stop_time->boarding_time = stop_time->departure_time;
 
         stop_time->stop_point = stop_it->second;
-        stop_time->order = boost::lexical_cast<unsigned int>(row[stop_seq_c]);
+        stop_time->order = boost::lexical_cast<unsigned int>(row[stop_seq_c].data(), row[stop_seq_c].size());
         stop_time->vehicle_journey = vj_it->second;
 
         if(has_col(pickup_c, row) && has_col(drop_off_c, row))
@@ -1062,14 +1080,21 @@ std::vector<nm::StopTime*> StopTimeGtfsHandler::handle_line(Data& data, const cs
         else
             stop_time->drop_off_allowed = true;
 
-        stop_time->vehicle_journey->stop_time_list.push_back(stop_time);
         stop_time->wheelchair_boarding = stop_time->vehicle_journey->wheelchair_boarding;
+        stop_times.push_back(std::move(stop_time));
+    }
+    return stop_times;
+}
+
+// the stop times are handed over to the data
+void StopTimeGtfsHandler::link_line(Data& data, parsed_line& stop_times) {
+    for (auto& owned_stop_time: stop_times) {
+        auto* stop_time = owned_stop_time.release();
+        stop_time->vehicle_journey->stop_time_list.push_back(stop_time);
         stop_time->idx = data.stops.size();
         data.stops.push_back(stop_time);
         count++;
-        stop_times.push_back(stop_time);
     }
-    return stop_times;
 }
 
 void FrequenciesGtfsHandler::init(Data&) {
@@ -31,8 +31,14 @@ www.navitia.io
 #pragma once
 #include "ed/data.h"
 #include <boost/unordered_map.hpp>
+#include <atomic>
+#include <future>
+#include <memory>
 #include <queue>
+#include <thread>
+#include <type_traits>
 #include "utils/csv.h"
+#include "mmap_csv_reader.h"
 #include "utils/logger.h"
 #include "utils/functions.h"
 #include <boost/container/flat_set.hpp>
@@ -131,15 +137,19 @@ void split_validity_pattern_over_dst(Data& data, GtfsData& gtfs_data);
 // Africa/Abidjan is equivalent to utc since there is no dst and 0 offset from utc
 const std::string UTC_TIMEZONE = "Africa/Abidjan";
 
-inline bool has_col(int col_idx, const std::vector<std::string>& row) {
+// the rows are either std::string or boost::string_ref vectors
+template <typename Row>
+inline bool has_col(int col_idx, const Row& row) {
     return col_idx >= 0 && static_cast<size_t>(col_idx) < row.size();
 }
 
-inline bool is_active(int col_idx, const std::vector<std::string>& row) {
+template <typename Row>
+inline bool is_active(int col_idx, const Row& row) {
     return (has_col(col_idx, row) && row[col_idx] == "1");
 }
 
-inline bool is_valid(int col_idx, const std::vector<std::string>& row) {
+template <typename Row>
+inline bool is_valid(int col_idx, const Row& row) {
     return (has_col(col_idx, row) && (!row[col_idx].empty()));
 }
 
@@ -153,14 +163,25 @@ std::string generate_unique_vj_uri(const GtfsData& gtfs_data, const std::string
  * - init(Data&) called before reading the file to init what needs to be inited
  * - finish(Data&) called after reading the file to clean and log if needed
  * - handle_line(Data& data, const csv_row& line, bool is_first_line): called at each line
+ * The file is read with the Handler::reader_type reader.
+ *
+ * If Handler::parallel_parsing is true, the lines are instead parsed by several threads
+ * with parse_line(const Data&, const csv_row&) (that must be thread safe) and then given
+ * in the file order to link_line(Data&, parsed_line&).
  */
 template <typename Handler>
 class FileParser {
 protected:
-    CsvReader csv;
+    typename Handler::reader_type csv;
     bool fail_if_no_file;
     Handler handler;
+
+    void read_rows(Data& data, std::false_type);
+    void read_rows(Data& data, std::true_type);
 public:
+    /// number of threads parsing the lines when the handler allows it
+    size_t nb_threads = std::max(1u, std::thread::hardware_concurrency());
+
     FileParser(GtfsData& gdata, std::string file_name, bool fail = false) :
         csv(file_name, ',' , true), fail_if_no_file(fail), handler(gdata, csv) {}
     FileParser(GtfsData& gdata, std::stringstream& ss, bool fail = false) :
@@ -176,20 +197,32 @@ public:
  *
  * provide default method for init, finish and required_headers
  */
-struct GenericHandler {
-    GenericHandler(GtfsData& gdata, CsvReader& reader) : gtfs_data(gdata), csv(reader) {}
+template <typename Reader, typename Row>
+struct BasicHandler {
+    BasicHandler(GtfsData& gdata, Reader& reader) : gtfs_data(gdata), csv(reader) {}
 
+    using reader_type = Reader;
     GtfsData& gtfs_data;
-    using csv_row = std::vector<std::string>;
+    using csv_row = Row;
     log4cplus::Logger logger = log4cplus::Logger::getInstance("log");
-    CsvReader& csv;
+    Reader& csv;
 
     //default definition (not virtual since no dynamic polymorphism will occur)
+    static constexpr bool parallel_parsing = false;
     const std::vector<std::string> required_headers() const { return {}; }
     void init(Data&) {}
     void finish(Data&) {}
 };
 
+using GenericHandler = BasicHandler<CsvReader, std::vector<std::string>>;
+
+/**
+ * Base handler of the biggest files
+ * the fields of the rows reference the mapped file, they are only valid
+ * during handle_line and need to be copied to be kept
+ */
+using ZeroCopyHandler = BasicHandler<MmapCsvReader, MmapCsvReader::row_type>;
+
 struct FeedInfoGtfsHandler : public GenericHandler {
     FeedInfoGtfsHandler(GtfsData& gdata, CsvReader& reader) : GenericHandler(gdata, reader) {}
     int feed_publisher_name_c, feed_publisher_url_c, feed_start_date_c, feed_end_date_c;
@@ -315,8 +348,8 @@ struct ShapesGtfsHandler: public GenericHandler {
     }
 };
 
-struct TripsGtfsHandler : public GenericHandler {
-    TripsGtfsHandler(GtfsData& gdata, CsvReader& reader) : GenericHandler(gdata, reader) {}
+struct TripsGtfsHandler : public ZeroCopyHandler {
+    TripsGtfsHandler(GtfsData& gdata, MmapCsvReader& reader) : ZeroCopyHandler(gdata, reader) {}
     int id_c, service_c,
             trip_c, headsign_c,
             block_id_c, wheelchair_c,
@@ -338,8 +371,8 @@ struct TripsGtfsHandler : public GenericHandler {
 
     types::Route* get_or_create_route(Data& data, const RouteId&);
 };
-struct StopTimeGtfsHandler : public GenericHandler {
-    StopTimeGtfsHandler(GtfsData& gdata, CsvReader& reader) : GenericHandler(gdata, reader) {}
+struct StopTimeGtfsHandler : public ZeroCopyHandler {
+    StopTimeGtfsHandler(GtfsData& gdata, MmapCsvReader& reader) : ZeroCopyHandler(gdata, reader) {}
     int id_c, arrival_c,
     departure_c, stop_c,
     stop_seq_c, pickup_c,
@@ -349,6 +382,13 @@ struct StopTimeGtfsHandler : public GenericHandler {
     void init(Data& data);
     void finish(Data& data);
     std::vector<ed::types::StopTime*> handle_line(Data& data, const csv_row& line, bool is_first_line);
+
+    // the stop times of a line, one by vj (a trip may have been split because of DST),
+    // owned by the line until it is linked
+    static constexpr bool parallel_parsing = true;
+    using parsed_line = std::vector<std::unique_ptr<ed::types::StopTime>>;
+    parsed_line parse_line(const Data& data, const csv_row& line) const;
+    void link_line(Data& data, parsed_line& stop_times);
     const std::vector<std::string> required_headers() const {
         return {"trip_id" , "arrival_time", "departure_time", "stop_id", "stop_sequence"};
     }
@@ -432,7 +472,7 @@ void normalize_extcodes(Data & data);
   *
   * Retourne -1 s'il y a eu un problème
   */
-int time_to_int(const std::string & time);
+int time_to_int(boost::string_ref time);
 
 struct FileNotFoundException {
     std::string filename;
@@ -458,25 +498,87 @@ inline bool FileParser<Handler>::fill(Data& data) {
         return false;
     }
 
-    typename Handler::csv_row headers = handler.required_headers();
+    const std::vector<std::string> headers = handler.required_headers();
     if(!csv.validate(headers)) {
         LOG4CPLUS_FATAL(logger, "Error while reading " << csv.filename <<
                         " missing headers : " << csv.missing_headers(headers));
         throw InvalidHeaders(csv.filename);
     }
     handler.init(data);
+    read_rows(data, std::integral_constant<bool, Handler::parallel_parsing>());
+    handler.finish(data);
+
+    return true;
+}
 
+template <typename Handler>
+inline void FileParser<Handler>::read_rows(Data& data, std::false_type) {
     bool line_read = true;
     while(!csv.eof()) {
-        auto row = csv.next();
+        const auto& row = csv.next();
         if(!row.empty()) {
             handler.handle_line(data, row, line_read);
             line_read = false;
         }
     }
-    handler.finish(data);
+}
 
-    return true;
+/*
+ * The file is split in chunks of lines parsed by the threads. This thread links
+ * the parsed lines chunk after chunk, in the file order, so the result does not
+ * depend on the number of threads.
+ * The parsed lines own their objects until they are linked, so the chunks dropped
+ * on an error are freed.
+ */
+template <typename Handler>
+inline void FileParser<Handler>::read_rows(Data& data, std::true_type) {
+    using parsed_lines = std::vector<typename Handler::parsed_line>;
+    // several chunks by thread, so the linking starts early
+    auto chunks = csv.split(nb_threads * 4);
+    std::vector<std::promise<parsed_lines>> parsed(chunks.size());
+    std::vector<std::future<parsed_lines>> results;
+    for (auto& promise: parsed) { results.push_back(promise.get_future()); }
+
+    std::atomic<size_t> next_chunk(0);
+    auto worker = [&]() {
+        for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++) {
+            try {
+                parsed_lines lines;
+                while (! chunks[i].eof()) {
+                    const auto& row = chunks[i].next();
+                    if (! row.empty()) {
+                        lines.push_back(handler.parse_line(data, row));
+                    }
+                }
+                parsed[i].set_value(std::move(lines));
+            } catch (...) {
+                parsed[i].set_exception(std::current_exception());
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::min(nb_threads, chunks.size()); ++i) {
+        threads.emplace_back(worker);
+    }
+
+    std::exception_ptr error;
+    for (auto& result: results) {
+        try {
+            auto lines = result.get();
+            for (auto& line: lines) {
+                handler.link_line(data, line);
+            }
+        } catch (...) {
+            error = std::current_exception();
+            // the chunks left are not parsed
+            next_chunk = chunks.size();
+            break;
+        }
+    }
+    for (auto& thread: threads) { thread.join(); }
+    if (error) {
+        std::rethrow_exception(error);
+    }
 }
 
 template<typename T> bool
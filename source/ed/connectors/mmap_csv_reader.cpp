@@ -0,0 +1,274 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "mmap_csv_reader.h"
+#include <boost/algorithm/string/trim.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ed { namespace connectors {
+
+MmapCsvReader::MmapCsvReader(const std::string& filename, char separator, bool read_headers) :
+    filename(filename), separator(separator), rows(nullptr, nullptr, separator) {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) { return; }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return;
+    }
+    mapped_size = st.st_size;
+    if (mapped_size != 0) {
+        mapping = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = nullptr;
+            mapped_size = 0;
+            close(fd);
+            return;
+        }
+        // the file is read once from the beginning to the end
+        madvise(mapping, mapped_size, MADV_SEQUENTIAL);
+        begin = static_cast<const char*>(mapping);
+    }
+    close(fd);
+    init(read_headers);
+}
+
+MmapCsvReader::MmapCsvReader(std::stringstream& stream, char separator, bool read_headers) :
+    separator(separator), buffer(stream.str()), rows(nullptr, nullptr, separator) {
+    begin = buffer.data();
+    init(read_headers);
+}
+
+MmapCsvReader::~MmapCsvReader() {
+    if (mapping) {
+        munmap(mapping, mapped_size);
+    }
+}
+
+void MmapCsvReader::init(bool read_headers) {
+    opened = true;
+    end = begin + (mapping ? mapped_size : buffer.size());
+    rows.cur = begin;
+    rows.end = end;
+    // UTF-8 BOM
+    if (end - begin >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0) {
+        rows.cur += 3;
+    }
+    if (! read_headers) { return; }
+    const auto& header_row = next();
+    for (size_t i = 0; i < header_row.size(); ++i) {
+        headers[boost::algorithm::trim_copy(header_row[i].to_string())] = static_cast<int>(i);
+    }
+}
+
+// first separator or end of line from 'from', 'end' if there is none
+const char* MmapCsvReader::Chunk::find_delimiter(const char* from) const {
+#ifdef __SSE2__
+    const __m128i sep = _mm_set1_epi8(separator);
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    for (; end - from >= 16; from += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from));
+        const __m128i found = _mm_or_si128(_mm_cmpeq_epi8(chunk, sep),
+                                           _mm_or_si128(_mm_cmpeq_epi8(chunk, lf),
+                                                        _mm_cmpeq_epi8(chunk, cr)));
+        const int mask = _mm_movemask_epi8(found);
+        if (mask != 0) {
+            return from + __builtin_ctz(mask);
+        }
+    }
+#endif
+    while (from < end && *from != separator && *from != '\n' && *from != '\r') {
+        ++from;
+    }
+    return from;
+}
+
+// read the quoted field starting at 'from' (after the opening quote), return
+// the position after the closing quote
+const char* MmapCsvReader::Chunk::read_quoted(const char* from) {
+    const char* quote = static_cast<const char*>(std::memchr(from, '"', end - from));
+    if (quote == nullptr) {
+        // not closed, we take everything
+        row.emplace_back(from, end - from);
+        return end;
+    }
+    if (quote + 1 >= end || quote[1] != '"') {
+        row.emplace_back(from, quote - from);
+        return quote + 1;
+    }
+    // there are escaped quotes, the field needs to be copied
+    std::string field;
+    while (true) {
+        field.append(from, quote);
+        if (quote + 1 < end && quote[1] == '"') {
+            field.push_back('"');
+            from = quote + 2;
+            quote = static_cast<const char*>(std::memchr(from, '"', end - from));
+            if (quote != nullptr) { continue; }
+            field.append(from, end);
+            from = end;
+        } else {
+            from = quote + 1;
+        }
+        break;
+    }
+    unescaped.push_back(std::move(field));
+    row.emplace_back(unescaped.back());
+    return from;
+}
+
+const MmapCsvReader::row_type& MmapCsvReader::Chunk::next() {
+    row.clear();
+    unescaped.clear();
+    if (cur >= end) { return row; }
+    // an empty line gives an empty row
+    if (*cur == '\n' || *cur == '\r') {
+        cur += (*cur == '\r' && cur + 1 < end && cur[1] == '\n') ? 2 : 1;
+        return row;
+    }
+    while (true) {
+        const char* field_end;
+        if (*cur == '"') {
+            cur = read_quoted(cur + 1);
+            // garbage between the closing quote and the delimiter is ignored
+            field_end = find_delimiter(cur);
+        } else {
+            field_end = find_delimiter(cur);
+            row.emplace_back(cur, field_end - cur);
+        }
+        cur = field_end;
+        if (cur >= end) { break; }
+        if (*cur == separator) {
+            ++cur;
+            if (cur >= end) {
+                row.emplace_back();
+                break;
+            }
+            continue;
+        }
+        // end of line
+        cur += (*cur == '\r' && cur + 1 < end && cur[1] == '\n') ? 2 : 1;
+        break;
+    }
+    return row;
+}
+
+std::vector<MmapCsvReader::Chunk> MmapCsvReader::split(size_t nb_chunks) {
+    std::vector<Chunk> chunks;
+    const char* from = rows.cur;
+    const size_t chunk_size = (end - from) / std::max<size_t>(nb_chunks, 1) + 1;
+    // a line end between quotes is part of a field, so the quotes are
+    // counted from the beginning to cut only at the end of a row
+    bool in_quotes = false;
+    const char* scanned = from;
+    auto next_quote = [&](const char* limit) -> const char* {
+        if (scanned >= limit) { return nullptr; }
+        return static_cast<const char*>(std::memchr(scanned, '"', limit - scanned));
+    };
+    // as in Chunk::next, a quote opens a field only at its start, and "" is an escaped
+    // quote in a quoted field; the other quotes are part of the field
+    auto handle_quote = [&](const char* quote) {
+        if (in_quotes) {
+            if (quote + 1 < end && quote[1] == '"') {
+                scanned = quote + 2;
+                return;
+            }
+            in_quotes = false;
+        } else if (quote == begin || quote[-1] == separator || quote[-1] == '\n' || quote[-1] == '\r') {
+            in_quotes = true;
+        }
+        scanned = quote + 1;
+    };
+    while (from < end) {
+        const char* cut = end;
+        if (static_cast<size_t>(end - from) > chunk_size) {
+            const char* target = from + chunk_size;
+            while (const char* quote = next_quote(target)) {
+                handle_quote(quote);
+            }
+            scanned = std::max(scanned, target);
+            while (true) {
+                const char* quote = next_quote(end);
+                if (in_quotes) {
+                    if (quote == nullptr) { break; }
+                    handle_quote(quote);
+                    continue;
+                }
+                if (scanned >= end) { break; }
+                const char* lf = static_cast<const char*>(std::memchr(scanned, '\n', end - scanned));
+                if (lf == nullptr) { break; }
+                if (quote != nullptr && quote < lf) {
+                    handle_quote(quote);
+                    continue;
+                }
+                cut = lf + 1;
+                scanned = cut;
+                break;
+            }
+        }
+        chunks.emplace_back(from, cut, separator);
+        from = cut;
+    }
+    rows.cur = end;
+    return chunks;
+}
+
+int MmapCsvReader::get_pos_col(const std::string& name) const {
+    const auto it = headers.find(name);
+    return it == headers.end() ? -1 : it->second;
+}
+
+bool MmapCsvReader::validate(const std::vector<std::string>& mandatory_headers) const {
+    for (const auto& header: mandatory_headers) {
+        if (headers.find(header) == headers.end()) { return false; }
+    }
+    return true;
+}
+
+std::string MmapCsvReader::missing_headers(const std::vector<std::string>& mandatory_headers) const {
+    std::string result;
+    for (const auto& header: mandatory_headers) {
+        if (headers.find(header) == headers.end()) {
+            result += header + ", ";
+        }
+    }
+    return result;
+}
+
+}}
@@ -0,0 +1,119 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include <boost/utility/string_ref.hpp>
+#include <deque>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ed { namespace connectors {
+
+/**
+ * CSV reader on a memory mapped file, for the biggest files (stop_times.txt, trips.txt)
+ *
+ * The fields of a row reference the mapping: nothing is copied except the
+ * quoted fields containing escaped quotes. A row and its fields are only
+ * valid until the next call to next().
+ *
+ * The interface is the subset of CsvReader used by FileParser.
+ * The file must be in UTF-8 (a BOM is skipped).
+ */
+class MmapCsvReader {
+public:
+    using row_type = std::vector<boost::string_ref>;
+
+    /// consecutive whole lines of the file, parsed independently of the rest of the file
+    class Chunk {
+    public:
+        Chunk(const char* begin, const char* end, char separator) :
+            cur(begin), end(end), separator(separator) {}
+
+        bool eof() const { return cur >= end; }
+        const row_type& next();
+
+    private:
+        const char* cur;
+        const char* end;
+        char separator;
+        row_type row;
+        // the unescaped quoted fields of the current row, a deque to keep them in place
+        std::deque<std::string> unescaped;
+
+        const char* find_delimiter(const char* from) const;
+        const char* read_quoted(const char* from);
+
+        friend class MmapCsvReader;
+    };
+
+    std::string filename;
+
+    MmapCsvReader(const std::string& filename, char separator = ',', bool read_headers = false);
+    MmapCsvReader(std::stringstream& stream, char separator = ',', bool read_headers = false);
+    ~MmapCsvReader();
+    MmapCsvReader(const MmapCsvReader&) = delete;
+    MmapCsvReader& operator=(const MmapCsvReader&) = delete;
+
+    bool is_open() const { return opened; }
+    bool eof() const { return rows.eof(); }
+    /// the number of bytes of the file
+    size_t size() const { return end - begin; }
+
+    const row_type& next() { return rows.next(); }
+
+    /// split the rows not read yet in about nb_chunks chunks of the same size, in the file order
+    /// (the rows are then consumed, eof() is true)
+    std::vector<Chunk> split(size_t nb_chunks);
+
+    /// index of the column, -1 if there is no such column
+    int get_pos_col(const std::string& name) const;
+    bool validate(const std::vector<std::string>& mandatory_headers) const;
+    std::string missing_headers(const std::vector<std::string>& mandatory_headers) const;
+
+private:
+    char separator;
+    bool opened = false;
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    void* mapping = nullptr;
+    size_t mapped_size = 0;
+    // the content of a stream, the fields point into it
+    std::string buffer;
+
+    // the rows not read yet
+    Chunk rows;
+    std::unordered_map<std::string, int> headers;
+
+    void init(bool read_headers);
+};
+
+}}
@@ -0,0 +1,107 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "ed/connectors/mmap_csv_reader.h"
+#include "utils/csv.h"
+#include "utils/init.h"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/program_options.hpp>
+#include <iostream>
+
+namespace po = boost::program_options;
+namespace pt = boost::posix_time;
+
+/*
+ * Throughput of the csv readers of the connectors on a file
+ * (typically a stop_times.txt): CsvReader and MmapCsvReader
+ */
+
+struct Stats {
+    size_t nb_rows = 0;
+    size_t nb_fields = 0;
+    size_t nb_bytes = 0;
+};
+
+template <typename Reader>
+static void bench(const std::string& name, Reader& reader, size_t file_size) {
+    const auto start = pt::microsec_clock::local_time();
+    Stats stats;
+    while (! reader.eof()) {
+        const auto& row = reader.next();
+        if (row.empty()) { continue; }
+        ++stats.nb_rows;
+        stats.nb_fields += row.size();
+        for (const auto& field: row) { stats.nb_bytes += field.size(); }
+    }
+    const double duration = (pt::microsec_clock::local_time() - start).total_microseconds() / 1e6;
+    std::cout << name << ": " << stats.nb_rows << " rows, " << stats.nb_fields << " fields ("
+              << stats.nb_bytes << " bytes) in " << duration << "s, "
+              << stats.nb_rows / duration << " rows/s, "
+              << file_size / duration / (1024 * 1024) << " MB/s" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    navitia::init_app();
+    std::string file;
+    int iterations;
+    po::options_description desc("Options of the csv reading benchmark");
+    desc.add_options()
+        ("help,h", "Show this message")
+        ("file,f", po::value<std::string>(&file)->required(), "csv file to read")
+        ("iterations,i", po::value<int>(&iterations)->default_value(3), "number of reads of the file by reader");
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+        std::cout << desc << std::endl;
+        return 1;
+    }
+    po::notify(vm);
+
+    size_t file_size = 0;
+    {
+        ed::connectors::MmapCsvReader reader(file, ',', true);
+        if (! reader.is_open()) {
+            std::cerr << "impossible to read " << file << std::endl;
+            return 1;
+        }
+        file_size = reader.size();
+    }
+    for (int i = 0; i < iterations; ++i) {
+        {
+            CsvReader reader(file, ',', true);
+            bench("CsvReader", reader, file_size);
+        }
+        {
+            ed::connectors::MmapCsvReader reader(file, ',', true);
+            bench("MmapCsvReader", reader, file_size);
+        }
+    }
+    return 0;
+}
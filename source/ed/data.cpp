@@ -39,12 +39,26 @@ www.navitia.io
 #include <boost/range/algorithm/find_if.hpp>
 #include "type/datetime.h"
 #include <boost/range/algorithm/max_element.hpp>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
 
 
 
 namespace nt = navitia::type;
 namespace ed{
 
+// run one step of the data processing and log its duration
+template <typename F>
+static void timed_step(const std::string& step_name, F step) {
+    const auto start = boost::posix_time::microsec_clock::local_time();
+    step();
+    LOG4CPLUS_INFO(log4cplus::Logger::getInstance("log"), step_name << " took "
+                   << (boost::posix_time::microsec_clock::local_time() - start).total_milliseconds() << " ms");
+}
+
 void Data::sort(){
 #define SORT_AND_INDEX(type_name, collection_name) std::sort(collection_name.begin(), collection_name.end(), Less());\
     std::for_each(collection_name.begin(), collection_name.end(), Indexer<nt::idx_t>());
@@ -83,25 +97,43 @@ void Data::build_block_id() {
     /// Two vehicle_journeys with the same block_id vj1 are consecutive if
     /// the last arrival_time of vj1 <= to the departure_time of vj2
     std::sort(vehicle_journeys.begin(), vehicle_journeys.end(),
-              [this](const types::VehicleJourney* vj1, const types::VehicleJourney* vj2) {
-        if(vj1->block_id != vj2->block_id) {
-            return vj1->block_id < vj2->block_id;
-        } else {
-            auto offset1 = tz_wrapper.tz_handler.get_first_utc_offset(*vj1->validity_pattern);
-            auto offset2 = tz_wrapper.tz_handler.get_first_utc_offset(*vj2->validity_pattern);
+              [](const types::VehicleJourney* vj1, const types::VehicleJourney* vj2) {
+        return vj1->block_id < vj2->block_id;
+    });
 
-            // we don't want to link the splited vjs
-            if (offset1 != offset2) {
-                return offset1 < offset2;
-            }
-            else if (vj1->stop_time_list.empty() || vj2->stop_time_list.empty()) {
-                return vj1->stop_time_list.size() < vj2->stop_time_list.size();
-            } else {
-                return vj1->stop_time_list.front()->departure_time <
-                        vj2->stop_time_list.front()->departure_time;
+    // then each group of vjs sharing a block_id is sorted by utc offset and departure,
+    // the utc offset being computed only once per vj
+    std::unordered_map<const types::VehicleJourney*, int32_t> utc_offsets;
+    const auto by_offset_and_departure = [&utc_offsets](const types::VehicleJourney* vj1,
+                                                        const types::VehicleJourney* vj2) {
+        const auto offset1 = utc_offsets[vj1];
+        const auto offset2 = utc_offsets[vj2];
+
+        // we don't want to link the splited vjs
+        if (offset1 != offset2) {
+            return offset1 < offset2;
+        }
+        else if (vj1->stop_time_list.empty() || vj2->stop_time_list.empty()) {
+            return vj1->stop_time_list.size() < vj2->stop_time_list.size();
+        } else {
+            return vj1->stop_time_list.front()->departure_time <
+                    vj2->stop_time_list.front()->departure_time;
+        }
+    };
+    for (auto group_begin = vehicle_journeys.begin(); group_begin != vehicle_journeys.end();) {
+        const auto& block_id = (*group_begin)->block_id;
+        auto group_end = std::find_if(group_begin, vehicle_journeys.end(),
+                                      [&block_id](const types::VehicleJourney* vj) {
+            return vj->block_id != block_id;
+        });
+        if (std::distance(group_begin, group_end) > 1) {
+            for (auto it = group_begin; it != group_end; ++it) {
+                utc_offsets[*it] = tz_wrapper.tz_handler.get_first_utc_offset(*(*it)->validity_pattern);
             }
+            std::sort(group_begin, group_end, by_offset_and_departure);
         }
-    });
+        group_begin = group_end;
+    }
 
     types::VehicleJourney* prev_vj = nullptr;
     for (auto* vj : vehicle_journeys) {
@@ -119,8 +151,7 @@ void Data::build_block_id() {
                 if (vj->stop_time_list.front()->departure_time >= prev_vj->stop_time_list.back()->arrival_time) {
 
                     //we add another check that the vjs are on the same offset (that they are not the from vj split on different dst)
-                    if (tz_wrapper.tz_handler.get_first_utc_offset(*vj->validity_pattern) ==
-                            tz_wrapper.tz_handler.get_first_utc_offset(*prev_vj->validity_pattern)) {
+                    if (utc_offsets[vj] == utc_offsets[prev_vj]) {
                         prev_vj->next_vj = vj;
                         vj->prev_vj = prev_vj;
                     }
@@ -153,17 +184,25 @@ make_stop_area_stop_points_map(const std::vector<ed::types::StopPoint*>& stop_po
 
 
 types::ValidityPattern* Data::get_or_create_validity_pattern(const types::ValidityPattern& vp) {
-    auto find_vp_predicate = [&vp](types::ValidityPattern* vp2) {
-        return vp.days == vp2->days;
-    };
-    auto it = boost::find_if(validity_patterns,
-            find_vp_predicate);
-    if(it != validity_patterns.end()) {
-        return *(it);
-    } else {
-         validity_patterns.push_back(new types::ValidityPattern(vp));
-         return validity_patterns.back();
+    // validity patterns can have been added to the list since the last call, we index them
+    if (nb_indexed_validity_patterns > validity_patterns.size()) {
+        validity_patterns_by_days.clear();
+        nb_indexed_validity_patterns = 0;
     }
+    for (; nb_indexed_validity_patterns < validity_patterns.size(); ++nb_indexed_validity_patterns) {
+        auto* indexed_vp = validity_patterns[nb_indexed_validity_patterns];
+        // if several validity patterns have the same days, we keep the first one
+        validity_patterns_by_days.emplace(indexed_vp->days, indexed_vp);
+    }
+
+    auto it = validity_patterns_by_days.find(vp.days);
+    if (it != validity_patterns_by_days.end()) {
+        return it->second;
+    }
+    validity_patterns.push_back(new types::ValidityPattern(vp));
+    validity_patterns_by_days.emplace(vp.days, validity_patterns.back());
+    ++nb_indexed_validity_patterns;
+    return validity_patterns.back();
 }
 
 // Please not that VP is not in the list of validity_patterns
@@ -184,6 +223,9 @@ void Data::shift_vp_left(types::ValidityPattern& vp) {
             vp_->days <<= 1;
             vp_->beginning_date = begin_date;
         }
+        // all the days have changed, the index has to be rebuilt
+        validity_patterns_by_days.clear();
+        nb_indexed_validity_patterns = 0;
         vp.beginning_date = begin_date;
         vp.days <<= 1;
 
@@ -194,6 +236,10 @@ void Data::shift_vp_left(types::ValidityPattern& vp) {
 }
 
 void Data::shift_stop_times() {
+    // the days of the validity patterns may have been changed since the last indexation
+    validity_patterns_by_days.clear();
+    nb_indexed_validity_patterns = 0;
+
     for (auto vj : vehicle_journeys) {
         if (vj->stop_time_list.empty()) {
             continue;
@@ -243,13 +289,17 @@ void Data::shift_stop_times() {
     }
 }
 
-static bool compare(const std::pair<ed::types::StopArea*, size_t>& p1,
-                    const std::pair<ed::types::StopArea*, size_t>& p2){
-    return p1.second < p2.second;
+// the most frequent destination wins, the uri breaks the ties so the result does not depend on the memory layout
+static bool compare(const std::pair<ed::types::StopArea* const, size_t>& p1,
+                    const std::pair<ed::types::StopArea* const, size_t>& p2){
+    if (p1.second != p2.second) {
+        return p1.second < p2.second;
+    }
+    return p1.first->uri > p2.first->uri;
 }
 
 void Data::build_route_destination(){
-    std::unordered_map<ed::types::Route*, std::map<ed::types::StopArea*, size_t>> destinations;
+    std::unordered_map<ed::types::Route*, std::unordered_map<ed::types::StopArea*, size_t>> destinations;
     for (const auto* vj : vehicle_journeys) {
         if (! vj->route || vj->stop_time_list.empty()) { continue; }
         if (vj->route->destination) { continue; } // we have a destination, don't create one
@@ -267,21 +317,22 @@ void Data::build_route_destination(){
 }
 
 void Data::complete(){
-    build_block_id();
-    auto start = boost::posix_time::microsec_clock::local_time();
-    build_shape_from_prev();
-    LOG4CPLUS_INFO(log4cplus::Logger::getInstance("log"),
-                   "build_shape_from_prev took " << (boost::posix_time::microsec_clock::local_time() - start).total_milliseconds() << " ms");
-    pick_up_drop_of_on_borders();
+    timed_step("build_block_id", [&]() { build_block_id(); });
+    timed_step("build_shape_from_prev", [&]() { build_shape_from_prev(); });
+    timed_step("pick_up_drop_of_on_borders", [&]() { pick_up_drop_of_on_borders(); });
 
-    build_grid_validity_pattern();
-    build_associated_calendar();
+    timed_step("build_grid_validity_pattern", [&]() { build_grid_validity_pattern(); });
+    timed_step("build_associated_calendar", [&]() { build_associated_calendar(); });
 
-    shift_stop_times();
-    finalize_frequency();
+    timed_step("shift_stop_times", [&]() { shift_stop_times(); });
+    timed_step("finalize_frequency", [&]() { finalize_frequency(); });
 
     ::ed::normalize_uri(routes);
 
+    timed_step("build_default_connections", [&]() { build_default_connections(); });
+}
+
+void Data::build_default_connections() {
     // set StopPoint from old zonal ODT to is_zonal
     for (const auto* vj: vehicle_journeys) {
         using nt::VehicleJourneyType;
@@ -325,22 +376,27 @@ void Data::complete(){
 }
 
 void Data::clean() {
+    timed_step("clean vehicle_journeys", [&]() { clean_vehicle_journeys(); });
+    timed_step("clean stop_point_connections", [&]() { clean_stop_point_connections(); });
+}
+
+void Data::clean_vehicle_journeys() {
     auto logger = log4cplus::Logger::getInstance("log");
-    std::set<std::string> toErase;
+    std::unordered_set<const types::VehicleJourney*> toErase;
     int erase_emptiness = 0, erase_no_circulation = 0, erase_invalid_stoptimes = 0;
 
     for (auto* vj: vehicle_journeys) {
         if (vj_to_erase.count(vj)) {
-            toErase.insert(vj->uri);
+            toErase.insert(vj);
             continue;
         }
         if (vj->stop_time_list.empty()) {
-            toErase.insert(vj->uri);
+            toErase.insert(vj);
             ++erase_emptiness;
             continue;
         }
         if (vj->validity_pattern->days.none() && vj->adapted_validity_pattern->days.none()) {
-            toErase.insert(vj->uri);
+            toErase.insert(vj);
             ++erase_no_circulation;
             continue;
         }
@@ -349,7 +405,7 @@ void Data::clean() {
             return st->departure_time < 0 || st->arrival_time < 0 || st->boarding_time < 0 || st->alighting_time < 0;
         };
         if (std::any_of(vj->stop_time_list.begin(), vj->stop_time_list.end(), st_is_invalid)) {
-            toErase.insert(vj->uri);
+            toErase.insert(vj);
             ++erase_invalid_stoptimes;
         }
     }
@@ -357,8 +413,7 @@ void Data::clean() {
     std::vector<size_t> erasest;
 
     for(int i=stops.size()-1; i >=0;--i) {
-        auto it = toErase.find(stops[i]->vehicle_journey->uri);
-        if(it != toErase.end()) {
+        if (toErase.count(stops[i]->vehicle_journey)) {
             erasest.push_back(i);
         }
     }
@@ -378,8 +433,7 @@ void Data::clean() {
 
     erasest.clear();
     for(int i=vehicle_journeys.size()-1; i >= 0;--i){
-        auto it = toErase.find(vehicle_journeys[i]->uri);
-        if(it != toErase.end()) {
+        if (toErase.count(vehicle_journeys[i])) {
             erasest.push_back(i);
         }
     }
@@ -425,6 +479,10 @@ void Data::clean() {
                        << erase_no_circulation << " because they are never valid "
                        << " and " << erase_invalid_stoptimes << " because the stop times were negatives");
     }
+}
+
+void Data::clean_stop_point_connections() {
+    auto logger = log4cplus::Logger::getInstance("log");
     // Delete duplicate connections
     // Connections are sorted by departure,destination
     auto sort_function = [](types::StopPointConnection * spc1, types::StopPointConnection *spc2) {return spc1->uri < spc2->uri
@@ -433,7 +491,7 @@ void Data::clean() {
     auto unique_function = [](types::StopPointConnection * spc1, types::StopPointConnection *spc2) {return spc1->uri == spc2->uri;};
 
     std::sort(stop_point_connections.begin(), stop_point_connections.end(), sort_function);
-    num_elements = stop_point_connections.size();
+    const auto num_elements = stop_point_connections.size();
     auto it_end = std::unique(stop_point_connections.begin(), stop_point_connections.end(), unique_function);
     //@TODO : Attention, it's leaking, it should succeed in erasing objects
     //Ce qu'il y a dans la fin du vecteur apres unique n'est pas garanti, on ne peut pas itérer sur la suite pour effacer
@@ -514,34 +572,52 @@ create_shape(const nt::GeographicalCoord& from,
 }
 
 void Data::build_shape_from_prev() {
-    std::map<std::string, std::shared_ptr<types::Shape>> shape_cache;
+    // a geometry is computed only once for each (shape, previous stop point, stop point)
+    using ShapeKey = std::tuple<const nt::MultiLineString*, const types::StopPoint*, const types::StopPoint*>;
+    std::map<ShapeKey, size_t> shape_cache;
+    std::vector<ShapeKey> keys;
+    std::vector<std::pair<types::StopTime*, size_t>> stop_time_shapes;
     for (types::VehicleJourney* vj: vehicle_journeys) {
+        const auto& shape = find_or_default(vj->shape_id, shapes);
+        if (shape.empty()) { continue; }
         const types::StopPoint* prev_stop_point = nullptr;
         for (types::StopTime* stop_time: vj->stop_time_list) {
             if (prev_stop_point) {
-                const auto& shape = find_or_default(vj->shape_id, shapes);
-                if (! shape.empty()) {
-                    std::string key = (boost::format("%s|%s|%s")
-                            % vj->shape_id
-                            % prev_stop_point->uri
-                            % stop_time->stop_point->uri)
-                        .str();
-                    // we keep in cache the resulting geometry, so we don't have to re compute it later
-                    if(shape_cache.find(key) == shape_cache.end()){
-                        auto s = std::make_shared<types::Shape>(
-                                create_shape(
-                                             prev_stop_point->coord,
-                                             stop_time->stop_point->coord,
-                                             shape.front()));
-                        this->shapes_from_prev.push_back(s);
-                        shape_cache[key] = s;
-                    }
-                    stop_time->shape_from_prev = shape_cache[key];
+                const auto insert = shape_cache.emplace(ShapeKey(&shape, prev_stop_point, stop_time->stop_point),
+                                                        keys.size());
+                if (insert.second) {
+                    keys.push_back(insert.first->first);
                 }
+                stop_time_shapes.push_back({stop_time, insert.first->second});
             }
             prev_stop_point = stop_time->stop_point;
         }
     }
+
+    // the geometries are independent, we compute them in parallel
+    std::vector<std::shared_ptr<types::Shape>> computed_shapes(keys.size());
+    std::atomic<size_t> next_key(0);
+    const auto compute_shapes = [&]() {
+        for (size_t i = next_key++; i < keys.size(); i = next_key++) {
+            computed_shapes[i] = std::make_shared<types::Shape>(create_shape(std::get<1>(keys[i])->coord,
+                                                                             std::get<2>(keys[i])->coord,
+                                                                             std::get<0>(keys[i])->front()));
+        }
+    };
+    const size_t nb_threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), keys.size());
+    std::vector<std::future<void>> workers;
+    for (size_t i = 1; i < nb_threads; ++i) {
+        workers.push_back(std::async(std::launch::async, compute_shapes));
+    }
+    compute_shapes();
+    for (auto& worker: workers) {
+        worker.get();
+    }
+
+    shapes_from_prev.insert(shapes_from_prev.end(), computed_shapes.begin(), computed_shapes.end());
+    for (const auto& stop_time_shape: stop_time_shapes) {
+        stop_time_shape.first->shape_from_prev = computed_shapes[stop_time_shape.second];
+    }
 }
 
 void Data::pick_up_drop_of_on_borders() {
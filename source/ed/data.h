@@ -152,6 +152,10 @@ public:
 
     std::set<types::VehicleJourney*> vj_to_erase; //badly formated vj, to erase
 
+    // validity_patterns indexed by their days, lazily filled by get_or_create_validity_pattern
+    std::unordered_map<types::ValidityPattern::year_bitset, types::ValidityPattern*> validity_patterns_by_days;
+    size_t nb_indexed_validity_patterns = 0;
+
     std::map<ed::types::pt_object_header, std::map<std::string, std::string>> object_properties;
 
     std::map<ed::types::pt_object_header, std::map<std::string, std::vector<std::string>>> object_codes;
@@ -206,12 +210,15 @@ public:
     void complete();
 
     void build_route_destination();
+    void build_default_connections();
 
 
     /**
      * supprime les objets inutiles
      */
     void clean();
+    void clean_vehicle_journeys();
+    void clean_stop_point_connections();
 
     /**
      * Finalise les start_time et end_time des stop_times en frequence
@@ -32,6 +32,7 @@ www.navitia.io
 #define BOOST_TEST_MODULE ed_integration_tests
 #include <boost/test/unit_test.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/range/algorithm/sort.hpp>
 #include "utils/logger.h"
 #include "type/data.h"
 #include "type/pt_data.h"
@@ -389,3 +390,231 @@ BOOST_FIXTURE_TEST_CASE(ntfs_v5_test, ArgsFixture) {
 
     check_ntfs(data);
 }
+
+template <typename T>
+static std::map<std::string, const T*> by_uri(const std::vector<T*>& objs) {
+    std::map<std::string, const T*> res;
+    for (const auto* obj: objs) { res[obj->uri] = obj; }
+    return res;
+}
+
+template <typename T>
+static std::vector<std::string> uris(const std::vector<T*>& objs) {
+    std::vector<std::string> res;
+    for (const auto* obj: objs) { res.push_back(obj->uri); }
+    boost::sort(res);
+    return res;
+}
+
+template <typename T>
+static std::string uri_or_empty(const T* obj) {
+    return obj ? obj->uri : std::string();
+}
+
+// the order of the codes depends on the order of the rows in the database
+template <typename T>
+static nt::CodeContainer::Codes sorted_codes(const nt::Data& data, const T* obj) {
+    auto codes = data.pt_data->codes.get_codes(obj);
+    for (auto& code: codes) { boost::sort(code.second); }
+    return codes;
+}
+
+#define CHECK_SAME_URIS(collection) \
+    BOOST_CHECK_EQUAL_COLLECTIONS(uris(db_data.pt_data->collection).begin(), uris(db_data.pt_data->collection).end(), \
+                                  uris(direct_data.pt_data->collection).begin(), uris(direct_data.pt_data->collection).end())
+
+/*
+ * fusio2ed can write the data.nav without going through the database,
+ * the result must be the same as the one built by ed2nav
+ */
+BOOST_FIXTURE_TEST_CASE(ntfs_direct_test, ArgsFixture) {
+    nt::Data db_data, direct_data;
+    BOOST_REQUIRE(db_data.load(input_file_paths.at("ntfs_file")));
+    BOOST_REQUIRE(direct_data.load(input_file_paths.at("ntfs_direct_file")));
+
+    check_ntfs(direct_data);
+
+    BOOST_CHECK_EQUAL(db_data.meta->production_date, direct_data.meta->production_date);
+    BOOST_CHECK_EQUAL(db_data.meta->publisher_name, direct_data.meta->publisher_name);
+    BOOST_CHECK_EQUAL(db_data.meta->license, direct_data.meta->license);
+    BOOST_CHECK_EQUAL(db_data.pt_data->tz_manager.get_nb_timezones(),
+                      direct_data.pt_data->tz_manager.get_nb_timezones());
+
+    CHECK_SAME_URIS(networks);
+    CHECK_SAME_URIS(commercial_modes);
+    CHECK_SAME_URIS(physical_modes);
+    CHECK_SAME_URIS(companies);
+    CHECK_SAME_URIS(contributors);
+    CHECK_SAME_URIS(datasets);
+    CHECK_SAME_URIS(stop_areas);
+    CHECK_SAME_URIS(stop_points);
+    CHECK_SAME_URIS(lines);
+    CHECK_SAME_URIS(line_groups);
+    CHECK_SAME_URIS(routes);
+    CHECK_SAME_URIS(vehicle_journeys);
+    CHECK_SAME_URIS(calendars);
+    BOOST_CHECK_EQUAL(db_data.pt_data->meta_vjs.size(), direct_data.pt_data->meta_vjs.size());
+    BOOST_CHECK_EQUAL(db_data.pt_data->validity_patterns.size(), direct_data.pt_data->validity_patterns.size());
+    BOOST_CHECK_EQUAL(db_data.pt_data->stop_point_connections.size(),
+                      direct_data.pt_data->stop_point_connections.size());
+    BOOST_CHECK_EQUAL(db_data.pt_data->associated_calendars.size(),
+                      direct_data.pt_data->associated_calendars.size());
+    BOOST_CHECK_EQUAL(db_data.pt_data->nb_stop_times(), direct_data.pt_data->nb_stop_times());
+
+    // the coordinates are rounded to the micro degree in the database
+    const auto direct_sps = by_uri(direct_data.pt_data->stop_points);
+    for (const auto* sp: db_data.pt_data->stop_points) {
+        const auto* direct_sp = direct_sps.at(sp->uri);
+        BOOST_CHECK_CLOSE(sp->coord.lon(), direct_sp->coord.lon(), 1e-4);
+        BOOST_CHECK_CLOSE(sp->coord.lat(), direct_sp->coord.lat(), 1e-4);
+        BOOST_CHECK_EQUAL(sp->name, direct_sp->name);
+        BOOST_CHECK_EQUAL(sp->stop_area->uri, direct_sp->stop_area->uri);
+        BOOST_CHECK_EQUAL(sp->properties(), direct_sp->properties());
+        BOOST_CHECK_EQUAL(sorted_codes(db_data, sp), sorted_codes(direct_data, direct_sp));
+        BOOST_CHECK_EQUAL_COLLECTIONS(db_data.pt_data->comments.get(sp).begin(),
+                                      db_data.pt_data->comments.get(sp).end(),
+                                      direct_data.pt_data->comments.get(direct_sp).begin(),
+                                      direct_data.pt_data->comments.get(direct_sp).end());
+    }
+
+    const auto direct_sas = by_uri(direct_data.pt_data->stop_areas);
+    for (const auto* sa: db_data.pt_data->stop_areas) {
+        const auto* direct_sa = direct_sas.at(sa->uri);
+        BOOST_CHECK_CLOSE(sa->coord.lon(), direct_sa->coord.lon(), 1e-4);
+        BOOST_CHECK_CLOSE(sa->coord.lat(), direct_sa->coord.lat(), 1e-4);
+        BOOST_CHECK_EQUAL(sa->name, direct_sa->name);
+        BOOST_CHECK_EQUAL(sa->label, direct_sa->label);
+        BOOST_CHECK_EQUAL(sa->timezone, direct_sa->timezone);
+        BOOST_CHECK_EQUAL(sa->wheelchair_boarding, direct_sa->wheelchair_boarding);
+        BOOST_CHECK_EQUAL(sa->properties(), direct_sa->properties());
+        BOOST_CHECK_EQUAL(sorted_codes(db_data, sa), sorted_codes(direct_data, direct_sa));
+        BOOST_CHECK_EQUAL_COLLECTIONS(uris(sa->admin_list).begin(), uris(sa->admin_list).end(),
+                                      uris(direct_sa->admin_list).begin(), uris(direct_sa->admin_list).end());
+    }
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(uris(db_data.geo_ref->admins).begin(), uris(db_data.geo_ref->admins).end(),
+                                  uris(direct_data.geo_ref->admins).begin(), uris(direct_data.geo_ref->admins).end());
+    const auto direct_admins = by_uri(direct_data.geo_ref->admins);
+    for (const auto* admin: db_data.geo_ref->admins) {
+        const auto* direct_admin = direct_admins.at(admin->uri);
+        BOOST_CHECK_EQUAL(admin->insee, direct_admin->insee);
+        BOOST_CHECK_EQUAL_COLLECTIONS(uris(admin->main_stop_areas).begin(), uris(admin->main_stop_areas).end(),
+                                      uris(direct_admin->main_stop_areas).begin(),
+                                      uris(direct_admin->main_stop_areas).end());
+    }
+
+    const auto direct_networks = by_uri(direct_data.pt_data->networks);
+    for (const auto* network: db_data.pt_data->networks) {
+        const auto* direct_network = direct_networks.at(network->uri);
+        BOOST_CHECK_EQUAL(network->name, direct_network->name);
+        BOOST_CHECK_EQUAL(network->sort, direct_network->sort);
+        BOOST_CHECK_EQUAL(network->website, direct_network->website);
+        BOOST_CHECK_EQUAL(sorted_codes(db_data, network), sorted_codes(direct_data, direct_network));
+    }
+
+    const auto direct_companies = by_uri(direct_data.pt_data->companies);
+    for (const auto* company: db_data.pt_data->companies) {
+        const auto* direct_company = direct_companies.at(company->uri);
+        BOOST_CHECK_EQUAL(company->name, direct_company->name);
+        BOOST_CHECK_EQUAL(company->website, direct_company->website);
+        BOOST_CHECK_EQUAL(company->phone_number, direct_company->phone_number);
+    }
+
+    const auto direct_physical_modes = by_uri(direct_data.pt_data->physical_modes);
+    for (const auto* mode: db_data.pt_data->physical_modes) {
+        const auto* direct_mode = direct_physical_modes.at(mode->uri);
+        BOOST_CHECK_EQUAL(mode->name, direct_mode->name);
+        BOOST_CHECK(mode->co2_emission == direct_mode->co2_emission);
+    }
+
+    const auto direct_commercial_modes = by_uri(direct_data.pt_data->commercial_modes);
+    for (const auto* mode: db_data.pt_data->commercial_modes) {
+        BOOST_CHECK_EQUAL(mode->name, direct_commercial_modes.at(mode->uri)->name);
+    }
+
+    const auto direct_routes = by_uri(direct_data.pt_data->routes);
+    for (const auto* route: db_data.pt_data->routes) {
+        const auto* direct_route = direct_routes.at(route->uri);
+        BOOST_CHECK_EQUAL(route->name, direct_route->name);
+        BOOST_CHECK_EQUAL(route->line->uri, direct_route->line->uri);
+        BOOST_CHECK_EQUAL(route->direction_type, direct_route->direction_type);
+        BOOST_CHECK_EQUAL(uri_or_empty(route->destination), uri_or_empty(direct_route->destination));
+        BOOST_CHECK_EQUAL(sorted_codes(db_data, route), sorted_codes(direct_data, direct_route));
+    }
+
+    const auto direct_calendars = by_uri(direct_data.pt_data->calendars);
+    for (const auto* calendar: db_data.pt_data->calendars) {
+        const auto* direct_calendar = direct_calendars.at(calendar->uri);
+        BOOST_CHECK_EQUAL(calendar->name, direct_calendar->name);
+        BOOST_CHECK_EQUAL(calendar->week_pattern, direct_calendar->week_pattern);
+        BOOST_CHECK_EQUAL_COLLECTIONS(calendar->active_periods.begin(), calendar->active_periods.end(),
+                                      direct_calendar->active_periods.begin(),
+                                      direct_calendar->active_periods.end());
+        BOOST_CHECK_EQUAL(calendar->exceptions.size(), direct_calendar->exceptions.size());
+        BOOST_CHECK_EQUAL(calendar->validity_pattern.days, direct_calendar->validity_pattern.days);
+    }
+
+    // the connections have no stable uri, they are compared by their stop points
+    std::map<std::pair<std::string, std::string>, const nt::StopPointConnection*> direct_connections;
+    for (const auto* conn: direct_data.pt_data->stop_point_connections) {
+        direct_connections[{conn->departure->uri, conn->destination->uri}] = conn;
+    }
+    for (const auto* conn: db_data.pt_data->stop_point_connections) {
+        const auto* direct_conn = direct_connections.at({conn->departure->uri, conn->destination->uri});
+        BOOST_CHECK_EQUAL(conn->duration, direct_conn->duration);
+        BOOST_CHECK_EQUAL(conn->display_duration, direct_conn->display_duration);
+        BOOST_CHECK_EQUAL(conn->max_duration, direct_conn->max_duration);
+        BOOST_CHECK(conn->connection_type == direct_conn->connection_type);
+    }
+
+    const auto direct_lines = by_uri(direct_data.pt_data->lines);
+    for (const auto* line: db_data.pt_data->lines) {
+        const auto* direct_line = direct_lines.at(line->uri);
+        BOOST_CHECK_EQUAL(line->name, direct_line->name);
+        BOOST_CHECK_EQUAL(line->code, direct_line->code);
+        BOOST_CHECK_EQUAL(line->network->uri, direct_line->network->uri);
+        BOOST_CHECK_EQUAL(line->route_list.size(), direct_line->route_list.size());
+        BOOST_CHECK_EQUAL(line->calendar_list.size(), direct_line->calendar_list.size());
+        BOOST_CHECK_EQUAL(line->company_list.size(), direct_line->company_list.size());
+        BOOST_CHECK(line->properties == direct_line->properties);
+        BOOST_CHECK_EQUAL(sorted_codes(db_data, line), sorted_codes(direct_data, direct_line));
+    }
+
+    const auto& db_headsigns = db_data.pt_data->headsign_handler;
+    const auto& direct_headsigns = direct_data.pt_data->headsign_handler;
+    const auto direct_vjs = by_uri(direct_data.pt_data->vehicle_journeys);
+    for (const auto* vj: db_data.pt_data->vehicle_journeys) {
+        const auto* direct_vj = direct_vjs.at(vj->uri);
+        BOOST_CHECK_EQUAL(vj->name, direct_vj->name);
+        BOOST_CHECK_EQUAL(vj->route->uri, direct_vj->route->uri);
+        BOOST_CHECK_EQUAL(vj->physical_mode->uri, direct_vj->physical_mode->uri);
+        BOOST_CHECK_EQUAL(vj->meta_vj->uri, direct_vj->meta_vj->uri);
+        BOOST_CHECK_EQUAL(uri_or_empty(vj->company), uri_or_empty(direct_vj->company));
+        BOOST_CHECK_EQUAL(uri_or_empty(vj->dataset), uri_or_empty(direct_vj->dataset));
+        BOOST_CHECK_EQUAL(vj->odt_message, direct_vj->odt_message);
+        BOOST_CHECK(vj->vehicle_journey_type == direct_vj->vehicle_journey_type);
+        BOOST_CHECK_EQUAL(vj->base_validity_pattern()->days, direct_vj->base_validity_pattern()->days);
+        BOOST_CHECK_EQUAL(vj->vehicles(), direct_vj->vehicles());
+        BOOST_CHECK_EQUAL(bool(vj->prev_vj), bool(direct_vj->prev_vj));
+        BOOST_CHECK_EQUAL(bool(vj->next_vj), bool(direct_vj->next_vj));
+        BOOST_REQUIRE_EQUAL(vj->stop_time_list.size(), direct_vj->stop_time_list.size());
+        for (size_t i = 0; i < vj->stop_time_list.size(); ++i) {
+            const auto& st = vj->stop_time_list[i];
+            const auto& direct_st = direct_vj->stop_time_list[i];
+            BOOST_CHECK_EQUAL(st.arrival_time, direct_st.arrival_time);
+            BOOST_CHECK_EQUAL(st.departure_time, direct_st.departure_time);
+            BOOST_CHECK_EQUAL(st.boarding_time, direct_st.boarding_time);
+            BOOST_CHECK_EQUAL(st.alighting_time, direct_st.alighting_time);
+            BOOST_CHECK_EQUAL(st.properties, direct_st.properties);
+            BOOST_CHECK_EQUAL(st.local_traffic_zone, direct_st.local_traffic_zone);
+            BOOST_CHECK_EQUAL(st.stop_point->uri, direct_st.stop_point->uri);
+            BOOST_CHECK_EQUAL(db_headsigns.get_headsign(st), direct_headsigns.get_headsign(direct_st));
+            BOOST_CHECK_EQUAL(db_data.pt_data->comments.get(st).size(),
+                              direct_data.pt_data->comments.get(direct_st).size());
+        }
+    }
+
+    BOOST_CHECK_EQUAL(db_data.fare->fare_map.size(), direct_data.fare->fare_map.size());
+    BOOST_CHECK_EQUAL(db_data.fare->nb_transitions(), direct_data.fare->nb_transitions());
+    BOOST_CHECK_EQUAL(db_data.fare->od_tickets.size(), direct_data.fare->od_tickets.size());
+}
@@ -33,6 +33,7 @@ www.navitia.io
 #include "utils/timer.h"
 #include "utils/exception.h"
 #include "ed_reader.h"
+#include "find_admin_with_cities.h"
 #include "type/data.h"
 #include "utils/init.h"
 #include "utils/functions.h"
@@ -41,121 +42,11 @@ www.navitia.io
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/make_shared.hpp>
-#include <pqxx/pqxx>
 #include <iostream>
 #include <fstream>
 
 namespace po = boost::program_options;
 namespace pt = boost::posix_time;
-namespace georef = navitia::georef;
-
-// A functor that first asks to GeoRef the admins of coord, and, if
-// GeoRef found nothing, asks to the cities database.
-struct FindAdminWithCities {
-    typedef std::unordered_map<std::string, navitia::georef::Admin*> AdminMap;
-    typedef std::vector<georef::Admin*> result_type;
-
-    boost::shared_ptr<pqxx::connection> conn;
-    georef::GeoRef& georef;
-    AdminMap added_admins;
-    AdminMap insee_admins_map;
-    size_t nb_call = 0;
-    size_t nb_uninitialized = 0;
-    size_t nb_georef = 0;
-    std::map<size_t, size_t> cities_stats;// number of response for size of the result
-
-    FindAdminWithCities(const std::string& connection_string, georef::GeoRef& gr):
-        conn(boost::make_shared<pqxx::connection>(connection_string)),
-        georef(gr)
-        {}
-
-    FindAdminWithCities(const FindAdminWithCities&) = default;
-    FindAdminWithCities& operator=(const FindAdminWithCities&) = default;
-    ~FindAdminWithCities() {
-        if (nb_call == 0) return;
-
-        auto log = log4cplus::Logger::getInstance("ed2nav::FindAdminWithCities");
-        LOG4CPLUS_INFO(log, "FindAdminWithCities: " << nb_call << " calls");
-        LOG4CPLUS_INFO(log, "FindAdminWithCities: " << nb_uninitialized
-                       << " calls with uninitialized or zeroed coord");
-        LOG4CPLUS_INFO(log, "FindAdminWithCities: " << nb_georef << " GeoRef responses");
-        LOG4CPLUS_INFO(log, "FindAdminWithCities: " << added_admins.size() << " admins added using cities");
-        for (const auto& elt: cities_stats) {
-            LOG4CPLUS_INFO(log, "FindAdminWithCities: "
-                           << elt.second << " cities responses with "
-                           << elt.first << " admins.");
-        }
-        for (const auto& admin: added_admins) {
-            LOG4CPLUS_INFO(log, "FindAdminWithCities: "
-                           << "We have added the following admin: "
-                           << admin.second->label << " insee: "
-                           << admin.second->insee << " uri: "
-                           << admin.second->uri);
-        }
-    }
-
-    void init(){
-        for(auto* admin: georef.admins){
-            if(!admin->insee.empty()){
-                insee_admins_map[admin->insee] = admin;
-            }
-        }
-    }
-
-    result_type operator()(const navitia::type::GeographicalCoord& c) {
-        if(nb_call == 0){
-            init();
-        }
-        ++nb_call;
-
-        if (!c.is_initialized()) {++nb_uninitialized; return {};}
-
-        const auto &georef_res = georef.find_admins(c);
-        if (!georef_res.empty()) {++nb_georef; return georef_res;}
-
-        std::stringstream request;
-        request << "SELECT uri, name, insee, level, post_code, "
-                << "ST_X(coord::geometry) as lon, ST_Y(coord::geometry) as lat "
-                << "FROM administrative_regions "
-                << "WHERE ST_DWithin(ST_GeographyFromText('POINT("
-                << std::setprecision(16) << c.lon() << " " << c.lat() << ")'), boundary, 0.001)";
-        pqxx::work work(*conn);
-        pqxx::result result = work.exec(request);
-        result_type res;
-        for (auto it = result.begin(); it != result.end(); ++it) {
-            const std::string uri = it["uri"].as<std::string>();
-            const std::string insee = it["insee"].as<std::string>();
-            //we try to find the admin in georef by using it's insee code (only work in France)
-            navitia::georef::Admin* admin = nullptr;
-            if (!insee.empty()) { admin = find_or_default(insee, insee_admins_map);}
-            if (!admin) { admin = find_or_default(uri, added_admins);}
-            if (!admin) {
-                georef.admins.push_back(new navitia::georef::Admin());
-                admin = georef.admins.back();
-                admin->comment = "from cities";
-                admin->uri = uri;
-                it["name"].to(admin->name);
-                admin->insee = insee;
-                it["level"].to(admin->level);
-                admin->coord.set_lon(it["lon"].as<double>());
-                admin->coord.set_lat(it["lat"].as<double>());
-                admin->idx = georef.admins.size() - 1;
-                admin->from_original_dataset = false;
-                std::string postal_code;
-                it["post_code"].to(postal_code);
-
-                if(!postal_code.empty()){
-                    boost::split(admin->postal_codes, postal_code, boost::is_any_of("-"));
-                }
-                added_admins[uri] = admin;
-            }
-            res.push_back(admin);
-        }
-        ++cities_stats[res.size()];
-        return res;
-    }
-};
 
 int main(int argc, char * argv[])
 {
@@ -163,6 +54,7 @@ int main(int argc, char * argv[])
     auto logger = log4cplus::Logger::getInstance("log");
     std::string output, connection_string, region_name, cities_connection_string;
     double min_non_connected_graph_ratio;
+    size_t nb_connections;
     po::options_description desc("Allowed options");
     desc.add_options()
         ("help,h", "Show this message")
@@ -181,7 +73,10 @@ int main(int argc, char * argv[])
         ("connection-string", po::value<std::string>(&connection_string)->required(),
          "database connection parameters: host=localhost user=navitia dbname=navitia password=navitia")
         ("cities-connection-string", po::value<std::string>(&cities_connection_string)->default_value(""),
-         "cities database connection parameters: host=localhost user=navitia dbname=cities password=navitia");
+         "cities database connection parameters: host=localhost user=navitia dbname=cities password=navitia")
+        ("nb-connections", po::value<size_t>(&nb_connections)->default_value(0),
+         "number of other database connections fetching the biggest tables in parallel, "
+         "0 to read everything with one connection");
 
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -220,10 +115,10 @@ int main(int argc, char * argv[])
     //on init now pour le moment à now, à rendre paramétrable pour le debug
     now = start = pt::microsec_clock::local_time();
 
-    ed::EdReader reader(connection_string);
+    ed::EdReader reader(connection_string, nb_connections);
 
     if (!cities_connection_string.empty()) {
-        data.find_admins = FindAdminWithCities(cities_connection_string, *data.geo_ref);
+        data.find_admins = ed::FindAdminWithCities(cities_connection_string, *data.geo_ref);
     }
 
     try {
@@ -30,6 +30,7 @@ www.navitia.io
 
 #include "ed_persistor.h"
 #include "ed/connectors/fare_utils.h"
+#include "pg_binary_copy.h"
 
 #include <boost/geometry.hpp>
 
@@ -919,58 +920,51 @@ void EdPersistor::insert_shapes(const std::vector<std::shared_ptr<types::Shape>>
 }
 
 void EdPersistor::insert_stop_times(const std::vector<types::StopTime*>& stop_times){
-    std::vector<std::string> columns = {
+    // the stop times are the biggest table, they are inserted with a binary copy
+    // to avoid formating each value as a string
+    PgBinaryCopy copy(lotus.connection, "navitia.stop_time", {
         "id", "arrival_time", "departure_time", "local_traffic_zone", "odt",
         "pick_up_allowed", "drop_off_allowed", "is_frequency", "\"order\"", "stop_point_id",
         "shape_from_prev_id", "vehicle_journey_id", "date_time_estimated", "headsign",
-        "boarding_time", "alighting_time"};
-
-    this->lotus.prepare_bulk_insert("navitia.stop_time", columns);
+        "boarding_time", "alighting_time"});
     size_t inserted_count = 0;
-    size_t size_st = stop_times.size();
-    std::vector<std::string> values;
-    for(types::StopTime* stop : stop_times){
-        values.clear();
-        values.push_back(std::to_string(stop->idx));
-        values.push_back(std::to_string(stop->arrival_time));
-        values.push_back(std::to_string(stop->departure_time));
+    for(const types::StopTime* stop : stop_times){
+        copy.start_row();
+        copy.add_int8(stop->idx);
+        copy.add_int4(stop->arrival_time);
+        copy.add_int4(stop->departure_time);
         if(stop->local_traffic_zone != std::numeric_limits<uint16_t>::max()){
-            values.push_back(std::to_string(stop->local_traffic_zone));
+            copy.add_int4(stop->local_traffic_zone);
         }else{
-            values.push_back(lotus.null_value);
+            copy.add_null();
         }
-        values.push_back(std::to_string(stop->ODT));
-        values.push_back(std::to_string(stop->pick_up_allowed));
-        values.push_back(std::to_string(stop->drop_off_allowed));
-        values.push_back(std::to_string(stop->is_frequency));
-
-        values.push_back(std::to_string(stop->order));
-        values.push_back(std::to_string(stop->stop_point->idx));
+        copy.add_bool(stop->ODT);
+        copy.add_bool(stop->pick_up_allowed);
+        copy.add_bool(stop->drop_off_allowed);
+        copy.add_bool(stop->is_frequency);
+        copy.add_int4(stop->order);
+        copy.add_int8(stop->stop_point->idx);
         if (!stop->shape_from_prev) {
-            values.push_back(lotus.null_value);
+            copy.add_null();
         } else {
-            values.push_back(std::to_string(stop->shape_from_prev->idx));
+            copy.add_int8(stop->shape_from_prev->idx);
         }
-
         if(stop->vehicle_journey != NULL){
-            values.push_back(std::to_string(stop->vehicle_journey->idx));
+            copy.add_int8(stop->vehicle_journey->idx);
         }else{
-            values.push_back(lotus.null_value);
+            copy.add_null();
         }
-        values.push_back(std::to_string(stop->date_time_estimated));
-        values.push_back(stop->headsign);
-        values.push_back(std::to_string(stop->boarding_time));
-        values.push_back(std::to_string(stop->alighting_time));
+        copy.add_bool(stop->date_time_estimated);
+        copy.add_text(stop->headsign);
+        copy.add_int4(stop->boarding_time);
+        copy.add_int4(stop->alighting_time);
 
-        this->lotus.insert(values);
         ++inserted_count;
-        if(inserted_count % 150000 == 0) {
-            lotus.finish_bulk_insert();
-            LOG4CPLUS_INFO(logger, inserted_count<<"/"<< size_st <<" inserted stop times");
-            this->lotus.prepare_bulk_insert("navitia.stop_time", columns);
+        if(inserted_count % 1000000 == 0) {
+            LOG4CPLUS_INFO(logger, inserted_count<<"/"<< stop_times.size() <<" inserted stop times");
         }
     }
-    this->lotus.finish_bulk_insert();
+    copy.finish();
 }
 
 void EdPersistor::insert_vehicle_properties(const std::vector<types::VehicleJourney*>& vehicle_journeys){
@@ -36,6 +36,10 @@ www.navitia.io
 #include <boost/smart_ptr/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/range/algorithm/find.hpp>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 namespace ed{
 
 namespace bg = boost::gregorian;
@@ -49,10 +53,229 @@ namespace nf = navitia::fare;
 // collections don't have these methods.
 template<typename T> static void release(T& a) { T b; a.swap(b); }
 
+// The requests of the biggest tables. They do not depend on each other, so
+// they can be fetched by other connections while the main one is busy.
+namespace {
+const std::string admins_request = "SELECT id, name, uri, comment, insee, level, ST_X(coord::geometry) as lon, "
+        "ST_Y(coord::geometry) as lat "
+        "FROM georef.admin";
+const std::string object_codes_request = "select object_type_id, object_id, key, value from navitia.object_code";
+const std::string stop_areas_request = "SELECT sa.id as id, sa.name as name, sa.uri as uri, "
+        "sa.visible as visible, sa.timezone as timezone, "
+        "ST_X(sa.coord::geometry) as lon, ST_Y(sa.coord::geometry) as lat,"
+        "pr.wheelchair_boarding as wheelchair_boarding, pr.sheltered as sheltered,"
+        "pr.elevator as elevator, pr.escalator as escalator,"
+        "pr.bike_accepted as bike_accepted, pr.bike_depot as bike_depot,"
+        "pr.visual_announcement as visual_announcement,"
+        "pr.audible_announcement as audible_announcement,"
+        "pr.appropriate_escort as appropriate_escort,"
+        "pr.appropriate_signage as appropriate_signage "
+        "FROM navitia.stop_area as sa, navitia.properties  as pr "
+        "where sa.properties_id=pr.id ";
+const std::string stop_points_request = "SELECT sp.id as id, sp.name as name, sp.uri as uri, "
+        "ST_X(sp.coord::geometry) as lon, ST_Y(sp.coord::geometry) as lat,"
+        "sp.fare_zone as fare_zone, sp.stop_area_id as stop_area_id,"
+        "sp.platform_code as platform_code,"
+        "sp.is_zonal as is_zonal,"
+        "ST_AsText(sp.area) as area,"
+        "pr.wheelchair_boarding as wheelchair_boarding,"
+        "pr.sheltered as sheltered, pr.elevator as elevator,"
+        "pr.escalator as escalator, pr.bike_accepted as bike_accepted,"
+        "pr.bike_depot as bike_depot,"
+        "pr.visual_announcement as visual_announcement,"
+        "pr.audible_announcement as audible_announcement,"
+        "pr.appropriate_escort as appropriate_escort,"
+        "pr.appropriate_signage as appropriate_signage "
+        "FROM navitia.stop_point as sp, navitia.properties  as pr "
+        "where sp.properties_id=pr.id";
+const std::string routes_request = "SELECT id, name, uri, line_id, destination_stop_area_id,"
+        "ST_AsText(shape) AS shape, direction_type FROM navitia.route";
+const std::string validity_patterns_request = "SELECT id, days FROM navitia.validity_pattern";
+const std::string stop_point_connections_request = "SELECT conn.departure_stop_point_id as departure_stop_point_id,"
+        "conn.destination_stop_point_id as destination_stop_point_id,"
+        "conn.connection_type_id as connection_type_id,"
+        "conn.display_duration as display_duration, conn.duration as duration, "
+        "conn.max_duration as max_duration,"
+        "pr.wheelchair_boarding as wheelchair_boarding,"
+        "pr.sheltered as sheltered, pr.elevator as elevator,"
+        "pr.escalator as escalator, pr.bike_accepted as bike_accepted,"
+        "pr.bike_depot as bike_depot,"
+        "pr.visual_announcement as visual_announcement,"
+        "pr.audible_announcement as audible_announcement,"
+        "pr.appropriate_escort as appropriate_escort,"
+        "pr.appropriate_signage as appropriate_signage "
+        "FROM navitia.connection as conn, navitia.properties  as pr "
+        "where conn.properties_id=pr.id ";
+const std::string vehicle_journeys_request = "SELECT vj.id as id, vj.name as name, vj.uri as uri,"
+        "vj.company_id as company_id, "
+        "vj.validity_pattern_id as validity_pattern_id,"
+        "vj.physical_mode_id as physical_mode_id,"
+        "vj.route_id as route_id,"
+        "vj.adapted_validity_pattern_id as adapted_validity_pattern_id,"
+        "vj.theoric_vehicle_journey_id as theoric_vehicle_journey_id ,"
+        "vj.odt_type_id as odt_type_id, vj.odt_message as odt_message,"
+        "vj.next_vehicle_journey_id as next_vj_id,"
+        "vj.previous_vehicle_journey_id as prev_vj_id,"
+        "vj.start_time as start_time,"
+        "vj.end_time as end_time,"
+        "vj.headway_sec as headway_sec,"
+        "vj.is_frequency as is_frequency, "
+        "vj.meta_vj_name as meta_vj_name, "
+        "vj.vj_class as vj_class, "
+        "vj.dataset_id as dataset_id, "
+        "vp.wheelchair_accessible as wheelchair_accessible,"
+        "vp.bike_accepted as bike_accepted,"
+        "vp.air_conditioned as air_conditioned,"
+        "vp.visual_announcement as visual_announcement,"
+        "vp.audible_announcement as audible_announcement,"
+        "vp.appropriate_escort as appropriate_escort,"
+        "vp.appropriate_signage as appropriate_signage,"
+        "vp.school_vehicle as school_vehicle "
+        "FROM navitia.vehicle_journey as vj, navitia.vehicle_properties as vp "
+        "WHERE vj.vehicle_properties_id = vp.id";
+const std::string shapes_request = "SELECT id as id, ST_AsText(geom) as geom FROM navitia.shape";
+const std::string pt_object_comments_request = "SELECT object_type, object_id, comment_id FROM navitia.ptobject_comments;";
+const std::string pois_request = "SELECT poi.id, poi.weight, ST_X(poi.coord::geometry) as lon, "
+        "ST_Y(poi.coord::geometry) as lat, poi.visible as visible, "
+        "poi.name, poi.uri, poi.poi_type_id, poi.address_number, "
+        "poi.address_name FROM georef.poi poi, "
+        "georef.poi_type poi_type where poi.poi_type_id=poi_type.id;";
+const std::string ways_request = "SELECT id, name, uri, type FROM georef.way;";
+const std::string house_numbers_request = "SELECT way_id, ST_X(coord::geometry) as lon, ST_Y(coord::geometry) as lat, number, left_side FROM georef.house_number where way_id IS NOT NULL;";
+const std::string vertex_request = "select id, ST_X(coord::geometry) as lon, ST_Y(coord::geometry) as lat from georef.node;";
+const std::string rel_way_admin_request = "select admin_id, way_id from georef.rel_way_admin;";
+
+std::string graph_request(bool export_georef_edges_geometries) {
+    std::string request = "select e.source_node_id, target_node_id, e.way_id, "
+                          "ST_LENGTH(the_geog) AS leng, e.pedestrian_allowed as pede, "
+                          "e.cycles_allowed as bike,e.cars_allowed as car";
+    // Don't call ST_ASTEXT if not needed since it's slow
+    if(export_georef_edges_geometries) {
+        request += ", ST_ASTEXT(the_geog) AS geometry";
+    }
+    request += " from georef.edge e;";
+    return request;
+}
+}
+
+/*
+ * Threads executing a list of requests, each one with its own connection.
+ *
+ * All the transactions import the snapshot exported by the main one, so
+ * every table is read in the same state as if the main connection had read
+ * it. The results are kept until they are taken by EdReader::exec.
+ */
+struct EdReader::Prefetcher {
+    Prefetcher(const std::string& connection_string,
+               const std::string& snapshot,
+               const std::vector<std::string>& requests,
+               size_t nb_threads):
+        todo(requests.begin(), requests.end()),
+        expected(requests.begin(), requests.end()) {
+        for (size_t i = 0; i < nb_threads; ++i) {
+            threads.emplace_back([this, connection_string, snapshot]() {
+                this->worker(connection_string, snapshot);
+            });
+        }
+    }
+
+    ~Prefetcher() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            todo.clear();
+        }
+        for (auto& thread: threads) { thread.join(); }
+    }
+
+    // the result of the request, or none if it was not given to the prefetcher
+    boost::optional<pqxx::result> take(const std::string& request) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (! expected.erase(request)) { return boost::none; }
+        cond.wait(lock, [&]() { return error || results.count(request); });
+        if (error) { std::rethrow_exception(error); }
+        auto it = results.find(request);
+        pqxx::result result;
+        result.swap(it->second);
+        results.erase(it);
+        return result;
+    }
+
+private:
+    void worker(const std::string& connection_string, const std::string& snapshot) {
+        try {
+            pqxx::connection conn(connection_string);
+            pqxx::work work(conn, "prefetching ED");
+            work.exec("SET TRANSACTION ISOLATION LEVEL REPEATABLE READ");
+            work.exec("SET TRANSACTION SNAPSHOT " + work.quote(snapshot));
+            while (true) {
+                std::string request;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (todo.empty() || error) { return; }
+                    request = todo.front();
+                    todo.pop_front();
+                }
+                pqxx::result result = work.exec(request);
+                std::lock_guard<std::mutex> lock(mutex);
+                // swapped, as the reference count of a result is not thread safe
+                results[request].swap(result);
+                cond.notify_all();
+            }
+        } catch (const pqxx::pqxx_exception& e) {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = std::make_exception_ptr(navitia::exception(e.base().what()));
+            cond.notify_all();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = std::current_exception();
+            cond.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::string> todo;
+    std::set<std::string> expected;
+    std::map<std::string, pqxx::result> results;
+    std::exception_ptr error;
+    std::vector<std::thread> threads;
+};
+
+EdReader::~EdReader() {}
+
+pqxx::result EdReader::exec(pqxx::work& work, const std::string& request) {
+    if (prefetcher) {
+        if (auto result = prefetcher->take(request)) {
+            return *result;
+        }
+    }
+    return work.exec(request);
+}
+
 void EdReader::fill(navitia::type::Data& data, const double min_non_connected_graph_ratio, const bool export_georef_edges_geometries){
 
     pqxx::work work(*conn, "loading ED");
 
+    if (nb_connections > 0) {
+        // The snapshot must be the one of the main transaction, thus it is
+        // exported before any read. The requests are in the order they are
+        // used below.
+        work.exec("SET TRANSACTION ISOLATION LEVEL REPEATABLE READ");
+        const auto snapshot = work.exec("SELECT pg_export_snapshot()")[0][0].as<std::string>();
+        const std::vector<std::string> requests = {
+            stop_areas_request, stop_points_request, routes_request,
+            validity_patterns_request, pt_object_comments_request, shapes_request,
+            vehicle_journeys_request, admins_request, object_codes_request,
+            stop_point_connections_request, pois_request, ways_request,
+            house_numbers_request, vertex_request,
+            graph_request(export_georef_edges_geometries), rel_way_admin_request
+        };
+        LOG4CPLUS_INFO(log, "prefetching " << requests.size() << " tables with "
+                       << nb_connections << " connections on snapshot " << snapshot);
+        prefetcher = std::unique_ptr<Prefetcher>(
+                    new Prefetcher(connection_string, snapshot, requests, nb_connections));
+    }
+
     this->fill_vector_to_ignore(work, min_non_connected_graph_ratio);
     this->fill_meta(data, work);
     // TODO merge fill_feed_infos, fill_meta
@@ -124,18 +347,14 @@ void EdReader::fill(navitia::type::Data& data, const double min_non_connected_gr
     this->fill_transitions(data, work);
     this->fill_origin_destinations(data, work);
 
-
+    prefetcher.reset();
 
     check_coherence(data);
 }
 
 
 void EdReader::fill_admins(navitia::type::Data& nav_data, pqxx::work& work){
-    std::string request = "SELECT id, name, uri, comment, insee, level, ST_X(coord::geometry) as lon, "
-        "ST_Y(coord::geometry) as lat "
-        "FROM georef.admin";
-
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, admins_request);
     for(auto const_it = result.begin(); const_it != result.end(); ++const_it){
         navitia::georef::Admin * admin = new navitia::georef::Admin;
         const_it["comment"].to(admin->comment);
@@ -228,9 +447,7 @@ static void add_code(const Map& map, const PqxxIt& db_it, nt::Data& data) {
 }
 
 void EdReader::fill_object_codes(navitia::type::Data& data, pqxx::work& work){
-    std::string request = "select object_type_id, object_id, key, value from navitia.object_code";
-
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, object_codes_request);
     for(auto const_it = result.begin(); const_it != result.end(); ++const_it){
         nt::Type_e object_type_e = static_cast<nt::Type_e>(const_it["object_type_id"].as<int>());
         switch(object_type_e) {
@@ -452,20 +669,7 @@ void EdReader::fill_companies(nt::Data& data, pqxx::work& work){
 }
 
 void EdReader::fill_stop_areas(nt::Data& data, pqxx::work& work){
-    std::string request = "SELECT sa.id as id, sa.name as name, sa.uri as uri, "
-     "sa.visible as visible, sa.timezone as timezone, "
-     "ST_X(sa.coord::geometry) as lon, ST_Y(sa.coord::geometry) as lat,"
-     "pr.wheelchair_boarding as wheelchair_boarding, pr.sheltered as sheltered,"
-     "pr.elevator as elevator, pr.escalator as escalator,"
-     "pr.bike_accepted as bike_accepted, pr.bike_depot as bike_depot,"
-     "pr.visual_announcement as visual_announcement,"
-     "pr.audible_announcement as audible_announcement,"
-     "pr.appropriate_escort as appropriate_escort,"
-     "pr.appropriate_signage as appropriate_signage "
-     "FROM navitia.stop_area as sa, navitia.properties  as pr "
-     "where sa.properties_id=pr.id ";
-
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, stop_areas_request);
     for(auto const_it = result.begin(); const_it != result.end(); ++const_it){
         nt::StopArea* sa = new nt::StopArea();
         const_it["uri"].to(sa->uri);
@@ -513,24 +717,7 @@ void EdReader::fill_stop_areas(nt::Data& data, pqxx::work& work){
 }
 
 void EdReader::fill_stop_points(nt::Data& data, pqxx::work& work){
-    std::string request = "SELECT sp.id as id, sp.name as name, sp.uri as uri, "
-       "ST_X(sp.coord::geometry) as lon, ST_Y(sp.coord::geometry) as lat,"
-       "sp.fare_zone as fare_zone, sp.stop_area_id as stop_area_id,"
-       "sp.platform_code as platform_code,"
-       "sp.is_zonal as is_zonal,"
-       "ST_AsText(sp.area) as area,"
-       "pr.wheelchair_boarding as wheelchair_boarding,"
-       "pr.sheltered as sheltered, pr.elevator as elevator,"
-       "pr.escalator as escalator, pr.bike_accepted as bike_accepted,"
-       "pr.bike_depot as bike_depot,"
-       "pr.visual_announcement as visual_announcement,"
-       "pr.audible_announcement as audible_announcement,"
-       "pr.appropriate_escort as appropriate_escort,"
-       "pr.appropriate_signage as appropriate_signage "
-       "FROM navitia.stop_point as sp, navitia.properties  as pr "
-       "where sp.properties_id=pr.id";
-
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, stop_points_request);
     for(auto const_it = result.begin(); const_it != result.end(); ++const_it){
         nt::StopPoint* sp = new nt::StopPoint();
         const_it["uri"].to(sp->uri);
@@ -659,10 +846,7 @@ void EdReader::fill_line_groups(nt::Data& data, pqxx::work& work){
 
 
 void EdReader::fill_routes(nt::Data& data, pqxx::work& work){
-    std::string request = "SELECT id, name, uri, line_id, destination_stop_area_id,"
-        "ST_AsText(shape) AS shape, direction_type FROM navitia.route";
-
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, routes_request);
     for(auto const_it = result.begin(); const_it != result.end(); ++const_it){
         nt::Route* route = new nt::Route();
         const_it["uri"].to(route->uri);
@@ -686,9 +870,7 @@ void EdReader::fill_routes(nt::Data& data, pqxx::work& work){
 
 
 void EdReader::fill_validity_patterns(nt::Data& data, pqxx::work& work){
-    std::string request = "SELECT id, days FROM navitia.validity_pattern";
-
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, validity_patterns_request);
     for(auto const_it = result.begin(); const_it != result.end(); ++const_it){
         nt::ValidityPattern* validity_pattern = NULL;
         validity_pattern = new nt::ValidityPattern(data.meta->production_date.begin(), const_it["days"].as<std::string>());
@@ -703,23 +885,7 @@ void EdReader::fill_validity_patterns(nt::Data& data, pqxx::work& work){
 
 
 void EdReader::fill_stop_point_connections(nt::Data& data, pqxx::work& work){
-    std::string request = "SELECT conn.departure_stop_point_id as departure_stop_point_id,"
-        "conn.destination_stop_point_id as destination_stop_point_id,"
-        "conn.connection_type_id as connection_type_id,"
-        "conn.display_duration as display_duration, conn.duration as duration, "
-        "conn.max_duration as max_duration,"
-        "pr.wheelchair_boarding as wheelchair_boarding,"
-        "pr.sheltered as sheltered, pr.elevator as elevator,"
-        "pr.escalator as escalator, pr.bike_accepted as bike_accepted,"
-        "pr.bike_depot as bike_depot,"
-        "pr.visual_announcement as visual_announcement,"
-        "pr.audible_announcement as audible_announcement,"
-        "pr.appropriate_escort as appropriate_escort,"
-        "pr.appropriate_signage as appropriate_signage "
-        "FROM navitia.connection as conn, navitia.properties  as pr "
-        "where conn.properties_id=pr.id ";
-
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, stop_point_connections_request);
     for(auto const_it = result.begin(); const_it != result.end(); ++const_it){
         auto it_departure = stop_point_map.find(const_it["departure_stop_point_id"].as<idx_t>());
         auto it_destination = stop_point_map.find(const_it["destination_stop_point_id"].as<idx_t>());
@@ -773,35 +939,7 @@ void EdReader::fill_stop_point_connections(nt::Data& data, pqxx::work& work){
 }
 
 void EdReader::fill_vehicle_journeys(nt::Data& data, pqxx::work& work){
-    std::string request = "SELECT vj.id as id, vj.name as name, vj.uri as uri,"
-        "vj.company_id as company_id, "
-        "vj.validity_pattern_id as validity_pattern_id,"
-        "vj.physical_mode_id as physical_mode_id,"
-        "vj.route_id as route_id,"
-        "vj.adapted_validity_pattern_id as adapted_validity_pattern_id,"
-        "vj.theoric_vehicle_journey_id as theoric_vehicle_journey_id ,"
-        "vj.odt_type_id as odt_type_id, vj.odt_message as odt_message,"
-        "vj.next_vehicle_journey_id as next_vj_id,"
-        "vj.previous_vehicle_journey_id as prev_vj_id,"
-        "vj.start_time as start_time,"
-        "vj.end_time as end_time,"
-        "vj.headway_sec as headway_sec,"
-        "vj.is_frequency as is_frequency, "
-        "vj.meta_vj_name as meta_vj_name, "
-        "vj.vj_class as vj_class, "
-        "vj.dataset_id as dataset_id, "
-        "vp.wheelchair_accessible as wheelchair_accessible,"
-        "vp.bike_accepted as bike_accepted,"
-        "vp.air_conditioned as air_conditioned,"
-        "vp.visual_announcement as visual_announcement,"
-        "vp.audible_announcement as audible_announcement,"
-        "vp.appropriate_escort as appropriate_escort,"
-        "vp.appropriate_signage as appropriate_signage,"
-        "vp.school_vehicle as school_vehicle "
-        "FROM navitia.vehicle_journey as vj, navitia.vehicle_properties as vp "
-        "WHERE vj.vehicle_properties_id = vp.id";
-
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, vehicle_journeys_request);
     std::multimap<idx_t, nt::VehicleJourney*> prev_vjs, next_vjs;
     for (auto const_it = result.begin(); const_it != result.end(); ++const_it) {
 
@@ -1007,8 +1145,7 @@ void EdReader::fill_meta_vehicle_journeys(nt::Data& data, pqxx::work& work) {
 }
 
 void EdReader::fill_shapes(nt::Data&, pqxx::work& work) {
-    std::string request = "SELECT id as id, ST_AsText(geom) as geom FROM navitia.shape";
-    const pqxx::result result = work.exec(request);
+    const pqxx::result result = this->exec(work, shapes_request);
     for(auto const_it = result.begin(); const_it != result.end(); ++const_it) {
         auto shape = boost::make_shared<nt::LineString>();
         boost::geometry::read_wkt(const_it["geom"].as<std::string>("LINESTRING()"), *shape);
@@ -1148,8 +1285,7 @@ void EdReader::fill_comments(nt::Data& data, pqxx::work& work) {
         comments_by_id[const_it["id"].as<unsigned int>()] = boost::make_shared<std::string>(const_it["comment"].as<std::string>());
     }
 
-    std::string pt_object_comment_request = "SELECT object_type, object_id, comment_id FROM navitia.ptobject_comments;";
-    pqxx::result result = work.exec(pt_object_comment_request);
+    pqxx::result result = this->exec(work, pt_object_comments_request);
 
     size_t cpt_not_found(0);
     for(auto const_it = result.begin(); const_it != result.end(); ++const_it) {
@@ -1209,12 +1345,7 @@ void EdReader::fill_poi_types(navitia::type::Data& data, pqxx::work& work){
 }
 
 void EdReader::fill_pois(navitia::type::Data& data, pqxx::work& work){
-    std::string request = "SELECT poi.id, poi.weight, ST_X(poi.coord::geometry) as lon, "
-            "ST_Y(poi.coord::geometry) as lat, poi.visible as visible, "
-            "poi.name, poi.uri, poi.poi_type_id, poi.address_number, "
-            "poi.address_name FROM georef.poi poi, "
-            "georef.poi_type poi_type where poi.poi_type_id=poi_type.id;";
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, pois_request);
     for(auto const_it = result.begin(); const_it != result.end(); ++const_it){
         std::string string_number;
         int int_number;
@@ -1256,8 +1387,7 @@ void EdReader::fill_poi_properties(navitia::type::Data&, pqxx::work& work){
 }
 
 void EdReader::fill_ways(navitia::type::Data& data, pqxx::work& work){
-    std::string request = "SELECT id, name, uri, type FROM georef.way;";
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, ways_request);
     for (auto const_it = result.begin(); const_it != result.end(); ++const_it) {
         idx_t id = const_it["id"].as<idx_t>();
 
@@ -1276,8 +1406,7 @@ void EdReader::fill_ways(navitia::type::Data& data, pqxx::work& work){
 }
 
 void EdReader::fill_house_numbers(navitia::type::Data& data, pqxx::work& work){
-    std::string request = "SELECT way_id, ST_X(coord::geometry) as lon, ST_Y(coord::geometry) as lat, number, left_side FROM georef.house_number where way_id IS NOT NULL;";
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, house_numbers_request);
     for(auto const_it = result.begin(); const_it != result.end(); ++const_it){
         std::string string_number;
         const_it["number"].to(string_number);
@@ -1438,8 +1567,7 @@ void EdReader::fill_vector_to_ignore(pqxx::work& work, const double min_non_conn
 }
 
 void EdReader::fill_vertex(navitia::type::Data& data, pqxx::work& work) {
-    std::string request = "select id, ST_X(coord::geometry) as lon, ST_Y(coord::geometry) as lat from georef.node;";
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, vertex_request);
     uint64_t idx = 0;
     for(auto const_it = result.begin(); const_it != result.end(); ++const_it){
         auto id = const_it["id"].as<uint64_t>();
@@ -1473,15 +1601,7 @@ EdReader::get_duration (nt::Mode_e mode, float len, uint64_t source, uint64_t ta
 }
 
 void EdReader::fill_graph(navitia::type::Data& data, pqxx::work& work, bool export_georef_edges_geometries) {
-    std::string request = "select e.source_node_id, target_node_id, e.way_id, "
-                          "ST_LENGTH(the_geog) AS leng, e.pedestrian_allowed as pede, "
-                          "e.cycles_allowed as bike,e.cars_allowed as car";
-    // Don't call ST_ASTEXT if not needed since it's slow
-    if(export_georef_edges_geometries) {
-        request += ", ST_ASTEXT(the_geog) AS geometry";
-    }
-    request += " from georef.edge e;";
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, graph_request(export_georef_edges_geometries));
     size_t nb_edges_no_way = 0, nb_useless_edges = 0;
     size_t nb_walking_edges(0), nb_biking_edges(0), nb_driving_edges(0);
 
@@ -1803,8 +1923,7 @@ void EdReader::fill_rel_calendars_lines(navitia::type::Data& , pqxx::work& work)
 }
 
 void EdReader::build_rel_way_admin(navitia::type::Data&, pqxx::work& work){
-    std::string request = "select admin_id, way_id from georef.rel_way_admin;";
-    pqxx::result result = work.exec(request);
+    pqxx::result result = this->exec(work, rel_way_admin_request);
     for(auto const_it = result.begin(); const_it != result.end(); ++const_it){
         navitia::georef::Way* way = this->way_map[const_it["way_id"].as<idx_t>()];
         if (way != NULL){
@@ -37,6 +37,7 @@ www.navitia.io
 #include <boost/graph/connected_components.hpp>
 #include <pqxx/pqxx>
 #include <unordered_map>
+#include <memory>
 #include <algorithm>
 #include "utils/functions.h"
 
@@ -47,7 +48,10 @@ struct EdReader{
     std::unique_ptr<pqxx::connection> conn;
 
 
-    EdReader(const std::string& connection_string){
+    /// if nb_connections is not 0, that many other connections fetch the
+    /// biggest tables in parallel, on the same snapshot as conn
+    EdReader(const std::string& connection_string, size_t nb_connections = 0) :
+        connection_string(connection_string), nb_connections(nb_connections) {
         try{
             conn = std::unique_ptr<pqxx::connection>(new pqxx::connection(connection_string));
         }catch(const pqxx::pqxx_exception& e){
@@ -55,6 +59,7 @@ struct EdReader{
 
         }
     }
+    ~EdReader();
 
     void fill(navitia::type::Data& nav_data, const double min_non_connected_graph_ratio, const bool export_georef_edges_geometries);
 
@@ -63,6 +68,14 @@ struct EdReader{
     std::unordered_map<std::string, navitia::georef::Admin*> admin_by_insee_code;
 
 private:
+    struct Prefetcher;
+    std::string connection_string;
+    size_t nb_connections;
+    std::unique_ptr<Prefetcher> prefetcher;
+
+    /// execute the request, or take its result if the prefetcher was asked for it
+    pqxx::result exec(pqxx::work& work, const std::string& request);
+
     //map d'id en base vers le poiteur de l'objet instancié
     std::unordered_map<idx_t, navitia::type::Network*> network_map;
     std::unordered_map<idx_t, navitia::type::CommercialMode*> commercial_mode_map;
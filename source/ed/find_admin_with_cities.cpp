@@ -0,0 +1,130 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "find_admin_with_cities.h"
+#include "utils/functions.h"
+
+#include <boost/make_shared.hpp>
+#include <boost/algorithm/string.hpp>
+#include <iomanip>
+
+namespace ed{
+
+FindAdminWithCities::FindAdminWithCities(const std::string& connection_string, navitia::georef::GeoRef& gr):
+    conn(boost::make_shared<pqxx::connection>(connection_string)),
+    georef(gr)
+    {}
+
+FindAdminWithCities::~FindAdminWithCities() {
+    if (nb_call == 0) return;
+
+    auto log = log4cplus::Logger::getInstance("ed2nav::FindAdminWithCities");
+    LOG4CPLUS_INFO(log, "FindAdminWithCities: " << nb_call << " calls");
+    LOG4CPLUS_INFO(log, "FindAdminWithCities: " << nb_uninitialized
+                   << " calls with uninitialized or zeroed coord");
+    LOG4CPLUS_INFO(log, "FindAdminWithCities: " << nb_georef << " GeoRef responses");
+    LOG4CPLUS_INFO(log, "FindAdminWithCities: " << added_admins.size() << " admins added using cities");
+    for (const auto& elt: cities_stats) {
+        LOG4CPLUS_INFO(log, "FindAdminWithCities: "
+                       << elt.second << " cities responses with "
+                       << elt.first << " admins.");
+    }
+    for (const auto& admin: added_admins) {
+        LOG4CPLUS_INFO(log, "FindAdminWithCities: "
+                       << "We have added the following admin: "
+                       << admin.second->label << " insee: "
+                       << admin.second->insee << " uri: "
+                       << admin.second->uri);
+    }
+}
+
+void FindAdminWithCities::init(){
+    for(auto* admin: georef.admins){
+        if(!admin->insee.empty()){
+            insee_admins_map[admin->insee] = admin;
+        }
+    }
+}
+
+FindAdminWithCities::result_type
+FindAdminWithCities::operator()(const navitia::type::GeographicalCoord& c) {
+    if(nb_call == 0){
+        init();
+    }
+    ++nb_call;
+
+    if (!c.is_initialized()) {++nb_uninitialized; return {};}
+
+    const auto &georef_res = georef.find_admins(c);
+    if (!georef_res.empty()) {++nb_georef; return georef_res;}
+
+    std::stringstream request;
+    request << "SELECT uri, name, insee, level, post_code, "
+            << "ST_X(coord::geometry) as lon, ST_Y(coord::geometry) as lat "
+            << "FROM administrative_regions "
+            << "WHERE ST_DWithin(ST_GeographyFromText('POINT("
+            << std::setprecision(16) << c.lon() << " " << c.lat() << ")'), boundary, 0.001)";
+    pqxx::work work(*conn);
+    pqxx::result result = work.exec(request);
+    result_type res;
+    for (auto it = result.begin(); it != result.end(); ++it) {
+        const std::string uri = it["uri"].as<std::string>();
+        const std::string insee = it["insee"].as<std::string>();
+        //we try to find the admin in georef by using it's insee code (only work in France)
+        navitia::georef::Admin* admin = nullptr;
+        if (!insee.empty()) { admin = find_or_default(insee, insee_admins_map);}
+        if (!admin) { admin = find_or_default(uri, added_admins);}
+        if (!admin) {
+            georef.admins.push_back(new navitia::georef::Admin());
+            admin = georef.admins.back();
+            admin->comment = "from cities";
+            admin->uri = uri;
+            it["name"].to(admin->name);
+            admin->insee = insee;
+            it["level"].to(admin->level);
+            admin->coord.set_lon(it["lon"].as<double>());
+            admin->coord.set_lat(it["lat"].as<double>());
+            admin->idx = georef.admins.size() - 1;
+            admin->from_original_dataset = false;
+            std::string postal_code;
+            it["post_code"].to(postal_code);
+
+            if(!postal_code.empty()){
+                boost::split(admin->postal_codes, postal_code, boost::is_any_of("-"));
+            }
+            added_admins[uri] = admin;
+        }
+        res.push_back(admin);
+    }
+    ++cities_stats[res.size()];
+    return res;
+}
+
+}
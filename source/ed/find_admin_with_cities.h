@@ -0,0 +1,68 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include "georef/georef.h"
+
+#include <boost/shared_ptr.hpp>
+#include <pqxx/pqxx>
+#include <unordered_map>
+#include <map>
+
+namespace ed{
+
+// A functor that first asks to GeoRef the admins of coord, and, if
+// GeoRef found nothing, asks to the cities database.
+struct FindAdminWithCities {
+    typedef std::unordered_map<std::string, navitia::georef::Admin*> AdminMap;
+    typedef std::vector<navitia::georef::Admin*> result_type;
+
+    boost::shared_ptr<pqxx::connection> conn;
+    navitia::georef::GeoRef& georef;
+    AdminMap added_admins;
+    AdminMap insee_admins_map;
+    size_t nb_call = 0;
+    size_t nb_uninitialized = 0;
+    size_t nb_georef = 0;
+    std::map<size_t, size_t> cities_stats;// number of response for size of the result
+
+    FindAdminWithCities(const std::string& connection_string, navitia::georef::GeoRef& gr);
+
+    FindAdminWithCities(const FindAdminWithCities&) = default;
+    FindAdminWithCities& operator=(const FindAdminWithCities&) = default;
+    ~FindAdminWithCities();
+
+    void init();
+
+    result_type operator()(const navitia::type::GeographicalCoord& c);
+};
+
+}
@@ -42,6 +42,7 @@ www.navitia.io
 #include <boost/filesystem.hpp>
 #include "utils/exception.h"
 #include "ed_persistor.h"
+#include "nav_converter.h"
 #include "fare/fare.h"
 
 namespace po = boost::program_options;
@@ -53,7 +54,7 @@ int main(int argc, char * argv[])
     auto logger = log4cplus::Logger::getInstance("log");
 
     std::string input, date, connection_string,
-                fare_dir;
+                fare_dir, output, cities_connection_string;
     po::options_description desc("Allowed options");
     desc.add_options()
         ("help,h", "Show this message")
@@ -62,9 +63,15 @@ int main(int argc, char * argv[])
         ("version,v", "Show version")
         ("fare,f", po::value<std::string>(&fare_dir), "Directory of fare files")
         ("config-file", po::value<std::string>(), "Path to configuration file")
-        ("connection-string", po::value<std::string>(&connection_string)->required(),
+        ("connection-string", po::value<std::string>(&connection_string),
              "Database connection parameters: host=localhost "
-             "user=navitia dbname=navitia password=navitia");
+             "user=navitia dbname=navitia password=navitia")
+        ("output,o", po::value<std::string>(&output),
+             "Write directly a data.nav.lz4 file readable by kraken instead of "
+             "inserting in the database (no street network in this mode)")
+        ("cities-connection-string", po::value<std::string>(&cities_connection_string)->default_value(""),
+             "With --output, cities database connection parameters: host=localhost "
+             "user=navitia dbname=cities password=navitia");
 
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -85,7 +92,8 @@ int main(int argc, char * argv[])
         }
     }
 
-    if(vm.count("help") || !vm.count("input")) {
+    if(vm.count("help") || !vm.count("input")
+            || (!vm.count("connection-string") && !vm.count("output"))) {
         std::cout << "Reads and inserts in database fusio files" << std::endl;
         std::cout << desc <<  "\n";
         return 1;
@@ -173,8 +181,12 @@ int main(int argc, char * argv[])
     LOG4CPLUS_INFO(logger, "validity pattern : " << data.validity_patterns.size());
 
     start = pt::microsec_clock::local_time();
-    ed::EdPersistor p(connection_string);
-    p.persist(data);
+    if (output.empty()) {
+        ed::EdPersistor p(connection_string);
+        p.persist(data);
+    } else {
+        ed::save_as_nav(data, output, cities_connection_string);
+    }
     save = (pt::microsec_clock::local_time() - start).total_milliseconds();
 
     LOG4CPLUS_INFO(logger, "temps de traitement");
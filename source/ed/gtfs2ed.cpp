@@ -40,6 +40,7 @@ www.navitia.io
 #include <boost/filesystem.hpp>
 #include "utils/exception.h"
 #include "ed_persistor.h"
+#include "nav_converter.h"
 #include "utils/init.h"
 
 namespace po = boost::program_options;
@@ -50,7 +51,7 @@ int main(int argc, char * argv[])
     navitia::init_app();
     auto logger = log4cplus::Logger::getInstance("log");
 
-    std::string input, date, connection_string;
+    std::string input, date, connection_string, output, cities_connection_string;
     po::options_description desc("Allowed options");
     desc.add_options()
         ("help,h", "Show this message")
@@ -58,9 +59,15 @@ int main(int argc, char * argv[])
         ("input,i", po::value<std::string>(&input), "Input directory")
         ("version,v", "Show version")
         ("config-file", po::value<std::string>(), "Path to a config file")
-        ("connection-string", po::value<std::string>(&connection_string)->required(),
+        ("connection-string", po::value<std::string>(&connection_string),
             "Database connection parameters: host=localhost user=navitia"
-            " dbname=navitia password=navitia");
+            " dbname=navitia password=navitia")
+        ("output,o", po::value<std::string>(&output),
+            "Write directly a data.nav.lz4 file readable by kraken instead of"
+            " inserting in the database (no street network in this mode)")
+        ("cities-connection-string", po::value<std::string>(&cities_connection_string)->default_value(""),
+            "With --output, cities database connection parameters: host=localhost"
+            " user=navitia dbname=cities password=navitia");
 
 
     po::variables_map vm;
@@ -82,7 +89,8 @@ int main(int argc, char * argv[])
         }
     }
 
-    if(vm.count("help") || !vm.count("input")) {
+    if(vm.count("help") || !vm.count("input")
+            || (!vm.count("connection-string") && !vm.count("output"))) {
         std::cout << "Reads and inserts into a ed database gtfs files" << std::endl;
         std::cout << desc <<  "\n";
         return 1;
@@ -132,8 +140,12 @@ int main(int argc, char * argv[])
     LOG4CPLUS_INFO(logger, "validity pattern : " << data.validity_patterns.size());
 
     start = pt::microsec_clock::local_time();
-    ed::EdPersistor p(connection_string);
-    p.persist(data);
+    if (output.empty()) {
+        ed::EdPersistor p(connection_string);
+        p.persist(data);
+    } else {
+        ed::save_as_nav(data, output, cities_connection_string);
+    }
     save = (pt::microsec_clock::local_time() - start).total_milliseconds();
 
     LOG4CPLUS_INFO(logger, "temps de traitement");
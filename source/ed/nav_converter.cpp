@@ -0,0 +1,744 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "nav_converter.h"
+#include "find_admin_with_cities.h"
+#include "utils/functions.h"
+#include "utils/base64_encode.h"
+#include "utils/exception.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/range/algorithm/find.hpp>
+
+namespace ed{
+
+namespace bg = boost::gregorian;
+namespace bt = boost::posix_time;
+namespace nt = navitia::type;
+namespace nf = navitia::fare;
+
+void NavConverter::fill(const ed::Data& data, navitia::type::Data& nav_data){
+    this->fill_meta(data, nav_data);
+    this->fill_timezones(data, nav_data);
+    this->fill_networks(data, nav_data);
+    this->fill_commercial_modes(data, nav_data);
+    this->fill_physical_modes(data, nav_data);
+    this->fill_companies(data, nav_data);
+    this->fill_contributors(data, nav_data);
+    this->fill_datasets(data, nav_data);
+
+    this->fill_stop_areas(data, nav_data);
+    this->fill_stop_points(data, nav_data);
+
+    this->fill_lines(data, nav_data);
+    this->fill_line_groups(data, nav_data);
+    this->fill_routes(data, nav_data);
+    this->fill_validity_patterns(data, nav_data);
+
+    this->fill_vehicle_journeys(data, nav_data);
+    this->finish_stop_times(data, nav_data);
+    this->fill_comments(data, nav_data);
+
+    /// grid calendar
+    this->fill_calendars(data, nav_data);
+
+    /// meta vj associated calendars
+    this->fill_meta_vehicle_journeys(data, nav_data);
+
+    this->fill_object_codes(data, nav_data);
+    this->fill_stop_point_connections(data, nav_data);
+
+    this->fill_prices(data, nav_data);
+    this->fill_transitions(data, nav_data);
+    this->fill_origin_destinations(data, nav_data);
+}
+
+void NavConverter::fill_meta(const ed::Data& data, navitia::type::Data& nav_data){
+    if (data.meta.production_date.is_null()) {
+        throw navitia::exception("no production date, it's likely that no data have been read,"
+                                 " we cannot create a nav file");
+    }
+    nav_data.meta->production_date = data.meta.production_date;
+
+    nav_data.meta->publisher_name = data.feed_infos.at("feed_publisher_name");
+    nav_data.meta->publisher_url = data.feed_infos.at("feed_publisher_url");
+    nav_data.meta->license = data.feed_infos.at("feed_license");
+    const auto& creation_datetime = data.feed_infos.at("feed_creation_datetime");
+    if (! creation_datetime.empty()) {
+        try {
+            nav_data.meta->dataset_created_at = bt::from_iso_string(creation_datetime);
+        } catch(const std::out_of_range&) {
+            LOG4CPLUS_INFO(log,"feed_creation_datetime is not valid");
+        }
+    }
+}
+
+void NavConverter::fill_timezones(const ed::Data& data, navitia::type::Data& nav_data){
+    const auto& tz_handler = data.tz_wrapper.tz_handler;
+    timezone = nav_data.pt_data->tz_manager.get_or_create(tz_handler.tz_name,
+                                                         nav_data.meta->production_date.begin(),
+                                                         tz_handler.get_periods_and_shift());
+}
+
+void NavConverter::fill_networks(const ed::Data& data, navitia::type::Data& nav_data){
+    for (const types::Network* ed_network: data.networks) {
+        nt::Network* network = new nt::Network();
+        network->uri = navitia::encode_uri(ed_network->uri);
+        network->name = ed_network->name;
+        network->sort = ed_network->sort;
+        network->website = ed_network->website;
+        network->idx = nav_data.pt_data->networks.size();
+
+        nav_data.pt_data->networks.push_back(network);
+        this->network_map[ed_network] = network;
+    }
+}
+
+void NavConverter::fill_commercial_modes(const ed::Data& data, navitia::type::Data& nav_data){
+    for (const types::CommercialMode* ed_mode: data.commercial_modes) {
+        nt::CommercialMode* mode = new nt::CommercialMode();
+        mode->uri = navitia::encode_uri(ed_mode->uri);
+        mode->name = ed_mode->name;
+        mode->idx = nav_data.pt_data->commercial_modes.size();
+
+        nav_data.pt_data->commercial_modes.push_back(mode);
+        this->commercial_mode_map[ed_mode] = mode;
+    }
+}
+
+void NavConverter::fill_physical_modes(const ed::Data& data, navitia::type::Data& nav_data){
+    for (const types::PhysicalMode* ed_mode: data.physical_modes) {
+        nt::PhysicalMode* mode = new nt::PhysicalMode();
+        mode->uri = navitia::encode_uri(ed_mode->uri);
+        mode->name = ed_mode->name;
+        mode->co2_emission = ed_mode->co2_emission;
+        mode->idx = nav_data.pt_data->physical_modes.size();
+
+        nav_data.pt_data->physical_modes.push_back(mode);
+        this->physical_mode_map[ed_mode] = mode;
+    }
+}
+
+void NavConverter::fill_companies(const ed::Data& data, navitia::type::Data& nav_data){
+    for (const types::Company* ed_company: data.companies) {
+        nt::Company* company = new nt::Company();
+        company->uri = navitia::encode_uri(ed_company->uri);
+        company->name = ed_company->name;
+        company->website = ed_company->website;
+        company->idx = nav_data.pt_data->companies.size();
+
+        nav_data.pt_data->companies.push_back(company);
+        this->company_map[ed_company] = company;
+    }
+}
+
+void NavConverter::fill_contributors(const ed::Data& data, navitia::type::Data& nav_data){
+    for (const types::Contributor* ed_contributor: data.contributors) {
+        nt::Contributor* contributor = new nt::Contributor();
+        contributor->uri = navitia::encode_uri(ed_contributor->uri);
+        contributor->name = ed_contributor->name;
+        contributor->website = ed_contributor->website;
+        contributor->license = ed_contributor->license;
+        contributor->idx = nav_data.pt_data->contributors.size();
+
+        nav_data.pt_data->contributors.push_back(contributor);
+        this->contributor_map[ed_contributor] = contributor;
+    }
+}
+
+void NavConverter::fill_datasets(const ed::Data& data, navitia::type::Data& nav_data){
+    size_t nb_unknown_contributor(0);
+    for (const types::Dataset* ed_dataset: data.datasets) {
+        nt::Contributor* contributor = find_or_default(ed_dataset->contributor, contributor_map);
+        if (! contributor) {
+            LOG4CPLUS_TRACE(log, "impossible to find the contributor of the dataset " << ed_dataset->uri);
+            nb_unknown_contributor++;
+            continue;
+        }
+
+        nt::Dataset* dataset = new nt::Dataset();
+        dataset->uri = navitia::encode_uri(ed_dataset->uri);
+        dataset->desc = ed_dataset->desc;
+        dataset->system = ed_dataset->system;
+        dataset->validation_period = ed_dataset->validation_period;
+        dataset->contributor = contributor;
+        dataset->idx = nav_data.pt_data->datasets.size();
+
+        dataset->contributor->dataset_list.insert(dataset);
+        nav_data.pt_data->datasets.push_back(dataset);
+        this->dataset_map[ed_dataset] = dataset;
+    }
+    if (nb_unknown_contributor){
+        LOG4CPLUS_WARN(log, nb_unknown_contributor << "contributor not found for dataset");
+    }
+}
+
+void NavConverter::fill_stop_areas(const ed::Data& data, navitia::type::Data& nav_data){
+    for (const types::StopArea* ed_sa: data.stop_areas) {
+        nt::StopArea* sa = new nt::StopArea();
+        sa->uri = navitia::encode_uri(ed_sa->uri);
+        sa->name = ed_sa->name;
+        sa->timezone = ed_sa->time_zone_with_name.first;
+        sa->coord = ed_sa->coord;
+        sa->visible = ed_sa->visible;
+        sa->set_properties(ed_sa->properties());
+        sa->idx = nav_data.pt_data->stop_areas.size();
+
+        nav_data.pt_data->stop_areas.push_back(sa);
+        this->stop_area_map[ed_sa] = sa;
+    }
+}
+
+void NavConverter::fill_stop_points(const ed::Data& data, navitia::type::Data& nav_data){
+    for (const types::StopPoint* ed_sp: data.stop_points) {
+        nt::StopPoint* sp = new nt::StopPoint();
+        sp->uri = navitia::encode_uri(ed_sp->uri);
+        sp->name = ed_sp->name;
+        sp->fare_zone = ed_sp->fare_zone;
+        sp->platform_code = ed_sp->platform_code;
+        sp->is_zonal = ed_sp->is_zonal;
+        sp->coord = ed_sp->coord;
+        sp->set_properties(ed_sp->properties());
+        sp->stop_area = find_or_default(ed_sp->stop_area, stop_area_map);
+        if (sp->stop_area) {
+            sp->stop_area->stop_point_list.push_back(sp);
+        }
+        if (ed_sp->area && sp->is_zonal) {
+            nav_data.pt_data->stop_points_by_area.insert(*ed_sp->area, sp);
+        }
+        sp->idx = nav_data.pt_data->stop_points.size();
+
+        nav_data.pt_data->stop_points.push_back(sp);
+        this->stop_point_map[ed_sp] = sp;
+    }
+}
+
+void NavConverter::fill_lines(const ed::Data& data, navitia::type::Data& nav_data){
+    for (const types::Line* ed_line: data.lines) {
+        nt::Network* network = find_or_default(ed_line->network, network_map);
+        if (! network) {
+            // the line would not have been stored in the database either
+            LOG4CPLUS_INFO(log, "Line " + ed_line->uri + " ignored because it doesn't "
+                    "have any network");
+            continue;
+        }
+        nt::Line* line = new nt::Line();
+        line->uri = navitia::encode_uri(ed_line->uri);
+        line->name = ed_line->name;
+        line->code = ed_line->code;
+        line->color = ed_line->color;
+        line->text_color = ed_line->text_color;
+        line->sort = ed_line->sort;
+        line->opening_time = ed_line->opening_time;
+        line->closing_time = ed_line->closing_time;
+
+        line->network = network;
+        line->network->line_list.push_back(line);
+
+        line->commercial_mode = find_or_default(ed_line->commercial_mode, commercial_mode_map);
+        if (line->commercial_mode) {
+            line->commercial_mode->line_list.push_back(line);
+        }
+        line->shape = ed_line->shape;
+        line->idx = nav_data.pt_data->lines.size();
+
+        nav_data.pt_data->lines.push_back(line);
+        this->line_map[ed_line] = line;
+    }
+
+    // Add Object properties on lines
+    for (const auto& pt_property: data.object_properties) {
+        if (pt_property.first.type != nt::Type_e::Line) { continue; }
+        const auto* ed_line = static_cast<const types::Line*>(pt_property.first.pt_object);
+        nt::Line* line = find_or_default(ed_line, line_map);
+        if (! line) { continue; }
+        for (const auto& property: pt_property.second) {
+            line->properties[property.first] = property.second;
+        }
+    }
+}
+
+void NavConverter::fill_line_groups(const ed::Data& data, navitia::type::Data& nav_data){
+    for (const types::LineGroup* ed_line_group: data.line_groups) {
+        nt::LineGroup* line_group = new nt::LineGroup();
+        line_group->uri = navitia::encode_uri(ed_line_group->uri);
+        line_group->name = ed_line_group->name;
+        line_group->main_line = find_or_default(ed_line_group->main_line, line_map);
+        line_group->idx = nav_data.pt_data->line_groups.size();
+
+        nav_data.pt_data->line_groups.push_back(line_group);
+        this->line_group_map[ed_line_group] = line_group;
+    }
+
+    for (const auto& group_link: data.line_group_links) {
+        nt::LineGroup* line_group = find_or_default(group_link.line_group, line_group_map);
+        nt::Line* line = find_or_default(group_link.line, line_map);
+        if (line_group && line) {
+            line_group->line_list.push_back(line);
+            line->line_group_list.push_back(line_group);
+        }
+    }
+}
+
+void NavConverter::fill_routes(const ed::Data& data, navitia::type::Data& nav_data){
+    size_t nb_ignored(0);
+    for (const types::Route* ed_route: data.routes) {
+        nt::Line* line = find_or_default(ed_route->line, line_map);
+        if (! line) {
+            ++nb_ignored;
+            continue;
+        }
+        nt::Route* route = new nt::Route();
+        route->uri = navitia::encode_uri(ed_route->uri);
+        route->name = ed_route->name;
+        route->direction_type = ed_route->direction_type;
+        route->shape = ed_route->shape;
+
+        route->line = line;
+        route->line->route_list.push_back(route);
+        route->destination = find_or_default(ed_route->destination, stop_area_map);
+        route->idx = nav_data.pt_data->routes.size();
+
+        nav_data.pt_data->routes.push_back(route);
+        this->route_map[ed_route] = route;
+    }
+    if (nb_ignored) {
+        LOG4CPLUS_WARN(log, nb_ignored << " routes ignored because their line has been ignored");
+    }
+}
+
+void NavConverter::fill_validity_patterns(const ed::Data& data, navitia::type::Data& nav_data){
+    for (const types::ValidityPattern* ed_vp: data.validity_patterns) {
+        nt::ValidityPattern* validity_pattern = new nt::ValidityPattern(nav_data.meta->production_date.begin());
+        validity_pattern->days = ed_vp->days;
+        validity_pattern->idx = nav_data.pt_data->validity_patterns.size();
+
+        nav_data.pt_data->validity_patterns.push_back(validity_pattern);
+        this->validity_pattern_map[ed_vp] = validity_pattern;
+    }
+}
+
+void NavConverter::fill_vehicle_journeys(const ed::Data& data, navitia::type::Data& nav_data){
+    std::unordered_map<const types::Shape*, boost::shared_ptr<nt::LineString>> shapes_map;
+    for (const auto& ed_shape: data.shapes_from_prev) {
+        shapes_map[ed_shape.get()] = boost::make_shared<nt::LineString>(ed_shape->geom);
+    }
+
+    // the stop times are indexed by their order, as create_vj needs the whole list
+    std::unordered_map<const types::VehicleJourney*, std::vector<nt::StopTime>> sts_from_vj;
+    for (const types::StopTime* ed_st: data.stops) {
+        auto& sts = sts_from_vj[ed_st->vehicle_journey];
+        if (ed_st->order + 1 > sts.size()) {
+            sts.resize(ed_st->order + 1);
+        }
+        nt::StopTime& stop = sts[ed_st->order];
+
+        stop.arrival_time = ed_st->arrival_time;
+        stop.departure_time = ed_st->departure_time;
+        stop.boarding_time = ed_st->boarding_time;
+        stop.alighting_time = ed_st->alighting_time;
+        stop.local_traffic_zone = ed_st->local_traffic_zone;
+        stop.set_date_time_estimated(ed_st->date_time_estimated);
+        stop.set_odt(ed_st->ODT);
+        stop.set_pick_up_allowed(ed_st->pick_up_allowed);
+        stop.set_drop_off_allowed(ed_st->drop_off_allowed);
+        stop.set_is_frequency(ed_st->is_frequency);
+        stop.stop_point = find_or_default(ed_st->stop_point, stop_point_map);
+        if (ed_st->shape_from_prev) {
+            stop.shape_from_prev = shapes_map[ed_st->shape_from_prev.get()];
+        }
+    }
+
+    size_t nb_ignored(0);
+    std::vector<std::pair<const types::VehicleJourney*, nt::VehicleJourney*>> vj_links;
+    for (const types::VehicleJourney* ed_vj: data.vehicle_journeys) {
+        auto* route = find_or_default(ed_vj->route, route_map);
+        const auto* vp = find_or_default(ed_vj->validity_pattern, validity_pattern_map);
+        if (! route || ! vp) {
+            ++nb_ignored;
+            continue;
+        }
+        const std::string& mvj_name = ed_vj->meta_vj_name.empty() ? ed_vj->name : ed_vj->meta_vj_name;
+        auto mvj = nav_data.pt_data->meta_vjs.get_or_create(mvj_name);
+        const auto uri = navitia::encode_uri(ed_vj->uri);
+        nt::VehicleJourney* vj = nullptr;
+        if (ed_vj->is_frequency()) {
+            auto f_vj = mvj->create_frequency_vj(uri,
+                                                 ed_vj->realtime_level,
+                                                 *vp,
+                                                 route,
+                                                 std::move(sts_from_vj[ed_vj]),
+                                                 *nav_data.pt_data);
+            f_vj->start_time = ed_vj->start_time;
+            f_vj->end_time = ed_vj->end_time;
+            f_vj->headway_secs = ed_vj->headway_secs;
+            vj = f_vj;
+        } else {
+            vj = mvj->create_discrete_vj(uri,
+                                         ed_vj->realtime_level,
+                                         *vp,
+                                         route,
+                                         std::move(sts_from_vj[ed_vj]),
+                                         *nav_data.pt_data);
+        }
+        sts_from_vj.erase(ed_vj);
+        vj->name = ed_vj->name;
+        vj->odt_message = ed_vj->odt_message;
+        vj->vehicle_journey_type = ed_vj->vehicle_journey_type;
+        vj->physical_mode = find_or_default(ed_vj->physical_mode, physical_mode_map);
+        vj->company = find_or_default(ed_vj->company, company_map);
+
+        if (vj->company && vj->route->line){
+            if (boost::range::find(vj->route->line->company_list, vj->company)
+                == vj->route->line->company_list.end()) {
+                vj->route->line->company_list.push_back(vj->company);
+            }
+            if (boost::range::find(vj->company->line_list, vj->route->line)
+                == vj->company->line_list.end()) {
+                vj->company->line_list.push_back(vj->route->line);
+            }
+        }
+        vj->set_vehicles(ed_vj->vehicles());
+
+        nav_data.pt_data->headsign_handler.change_name_and_register_as_headsign(*vj, vj->name);
+
+        vj->dataset = find_or_default(ed_vj->dataset, dataset_map);
+        if (vj->dataset) {
+            vj->dataset->vehiclejourney_list.insert(vj);
+        }
+        vehicle_journey_map[ed_vj] = vj;
+        vj_links.emplace_back(ed_vj, vj);
+    }
+
+    for (const auto& ed_nav_vj: vj_links) {
+        ed_nav_vj.second->prev_vj = find_or_default(ed_nav_vj.first->prev_vj, vehicle_journey_map);
+        ed_nav_vj.second->next_vj = find_or_default(ed_nav_vj.first->next_vj, vehicle_journey_map);
+    }
+    if (nb_ignored) {
+        LOG4CPLUS_WARN(log, nb_ignored << " vehicle journeys ignored because their route or"
+                       " validity pattern has been ignored");
+    }
+}
+
+void NavConverter::finish_stop_times(const ed::Data& data, navitia::type::Data& nav_data) {
+    for (const types::StopTime* ed_st: data.stops) {
+        const nt::VehicleJourney* vj = find_or_default(ed_st->vehicle_journey, vehicle_journey_map);
+        if (! vj) { continue; }
+        const nt::StopTime& st = vj->stop_time_list.at(ed_st->order);
+
+        if (! ed_st->headsign.empty()) {
+            nav_data.pt_data->headsign_handler.affect_headsign_to_stop_time(st, ed_st->headsign);
+        }
+        const auto it_comments = data.stoptime_comments.find(ed_st);
+        if (it_comments == data.stoptime_comments.end()) { continue; }
+        for (const auto& comment_id: it_comments->second) {
+            const auto it = data.comment_by_id.find(comment_id);
+            if (it != data.comment_by_id.end()) {
+                nav_data.pt_data->comments.add(st, it->second);
+            }
+        }
+    }
+}
+
+template <typename Map>
+static size_t add_comments(nt::Data& nav_data, const nt::Header* ed_obj, const Map& map,
+                           const std::vector<const std::string*>& comments) {
+    using ed_type = typename Map::key_type;
+    const auto obj = find_or_default(static_cast<ed_type>(ed_obj), map);
+
+    if (! obj) { return 1; }
+
+    for (const auto* comment: comments) {
+        nav_data.pt_data->comments.add(obj, *comment);
+    }
+    return 0;
+}
+
+void NavConverter::fill_comments(const ed::Data& data, navitia::type::Data& nav_data) {
+    size_t cpt_not_found(0);
+    for (const auto& pt_obj_com: data.comments) {
+        std::vector<const std::string*> comments;
+        for (const auto& comment_id: pt_obj_com.second) {
+            const auto it = data.comment_by_id.find(comment_id);
+            if (it == data.comment_by_id.end()) {
+                LOG4CPLUS_WARN(log, "impossible to find comment " << comment_id << " skipping comment for "
+                               << pt_obj_com.first);
+                continue;
+            }
+            comments.push_back(&it->second);
+        }
+
+        const nt::Header* ed_obj = pt_obj_com.first.pt_object;
+        switch (pt_obj_com.first.type) {
+        case nt::Type_e::Route: cpt_not_found += add_comments(nav_data, ed_obj, route_map, comments); break;
+        case nt::Type_e::Line: cpt_not_found += add_comments(nav_data, ed_obj, line_map, comments); break;
+        case nt::Type_e::LineGroup: cpt_not_found += add_comments(nav_data, ed_obj, line_group_map, comments); break;
+        case nt::Type_e::StopArea: cpt_not_found += add_comments(nav_data, ed_obj, stop_area_map, comments); break;
+        case nt::Type_e::StopPoint: cpt_not_found += add_comments(nav_data, ed_obj, stop_point_map, comments); break;
+        case nt::Type_e::VehicleJourney:
+            cpt_not_found += add_comments(nav_data, ed_obj, vehicle_journey_map, comments);
+            break;
+        default:
+            LOG4CPLUS_WARN(log, "invalid type, skipping object comment: " << pt_obj_com.first);
+        }
+    }
+    if (cpt_not_found) {
+        LOG4CPLUS_WARN(log, cpt_not_found << " pt object not found for comments");
+    }
+}
+
+void NavConverter::fill_calendars(const ed::Data& data, navitia::type::Data& nav_data){
+    for (const types::Calendar* ed_cal: data.calendars) {
+        nt::Calendar* cal = new nt::Calendar(nav_data.meta->production_date.begin());
+        cal->name = ed_cal->name;
+        // the calendar uris are stored encoded in base64 in the ed database
+        cal->uri = navitia::base64_encode(ed_cal->uri);
+        cal->week_pattern = ed_cal->week_pattern;
+        cal->active_periods = ed_cal->period_list;
+        cal->exceptions = ed_cal->exceptions;
+        for (const types::Line* ed_line: ed_cal->line_list) {
+            nt::Line* line = find_or_default(ed_line, line_map);
+            if (line) {
+                line->calendar_list.push_back(cal);
+            }
+        }
+
+        nav_data.pt_data->calendars.push_back(cal);
+        this->calendar_map[ed_cal] = cal;
+    }
+}
+
+void NavConverter::fill_meta_vehicle_journeys(const ed::Data& data, navitia::type::Data& nav_data) {
+    for (const auto& name_meta_vj: data.meta_vj_map) {
+        nt::MetaVehicleJourney* meta_vj = nav_data.pt_data->meta_vjs.get_mut(name_meta_vj.first);
+        if (meta_vj == nullptr) {
+            LOG4CPLUS_WARN(log, "impossible to find metavj " << name_meta_vj.first
+                           << ", all its vehicle journeys have been ignored");
+            continue;
+        }
+
+        for (const auto& name_associated_calendar: name_meta_vj.second.associated_calendars) {
+            const types::AssociatedCalendar* ed_associated_calendar = name_associated_calendar.second;
+            nt::Calendar* calendar = find_or_default(ed_associated_calendar->calendar, calendar_map);
+            if (! calendar) {
+                LOG4CPLUS_ERROR(log, "Impossible to find the calendar " << ed_associated_calendar->calendar->uri
+                                << ", we won't add associated calendar");
+                continue;
+            }
+
+            auto& associated_calendar = associated_calendar_map[ed_associated_calendar];
+            if (! associated_calendar) {
+                associated_calendar = new nt::AssociatedCalendar();
+                associated_calendar->calendar = calendar;
+                associated_calendar->exceptions = ed_associated_calendar->exceptions;
+                nav_data.pt_data->associated_calendars.push_back(associated_calendar);
+            }
+            meta_vj->associated_calendars[calendar->uri] = associated_calendar;
+        }
+        meta_vj->tz_handler = timezone;
+    }
+}
+
+void NavConverter::fill_admin_stop_areas(const ed::Data& data, navitia::type::Data& nav_data) {
+    std::unordered_map<std::string, navitia::georef::Admin*> admin_by_insee_code;
+    for (auto* admin: nav_data.geo_ref->admins) {
+        if (! admin->insee.empty()) {
+            admin_by_insee_code[admin->insee] = admin;
+        }
+    }
+
+    std::unordered_map<navitia::georef::Admin*, std::vector<const nt::StopArea*>> main_stop_areas;
+    size_t nb_unknown_admin(0), nb_valid_admin(0);
+    for (const types::AdminStopArea* ed_asa: data.admin_stop_areas) {
+        auto* admin = find_or_default(ed_asa->admin, admin_by_insee_code);
+        if (! admin) {
+            nb_unknown_admin += ed_asa->stop_area.size();
+            continue;
+        }
+        for (const types::StopArea* ed_sa: ed_asa->stop_area) {
+            nt::StopArea* sa = find_or_default(ed_sa, stop_area_map);
+            if (sa) {
+                main_stop_areas[admin].push_back(sa);
+                nb_valid_admin++;
+            }
+        }
+    }
+    for (auto& admin_sas: main_stop_areas) {
+        admin_sas.first->main_stop_areas = std::move(admin_sas.second);
+    }
+    LOG4CPLUS_INFO(log, nb_valid_admin << " admin with at least one main stop");
+    if (nb_unknown_admin) {
+        LOG4CPLUS_WARN(log, nb_unknown_admin << " admin not found for admin main stops");
+    }
+}
+
+template <typename Map>
+static void add_codes(nt::Data& nav_data, const nt::Header* ed_obj, const Map& map,
+                      const std::map<std::string, std::vector<std::string>>& codes) {
+    using ed_type = typename Map::key_type;
+    const auto obj = find_or_default(static_cast<ed_type>(ed_obj), map);
+
+    if (! obj) { return; }
+
+    for (const auto& code: codes) {
+        for (const auto& value: code.second) {
+            nav_data.pt_data->codes.add(obj, code.first, value);
+        }
+    }
+}
+
+void NavConverter::fill_object_codes(const ed::Data& data, navitia::type::Data& nav_data){
+    for (const auto& object_codes: data.object_codes) {
+        const nt::Header* ed_obj = object_codes.first.pt_object;
+        if (ed_obj->idx == nt::invalid_idx) { continue; }
+        const auto& codes = object_codes.second;
+        switch (object_codes.first.type) {
+        case nt::Type_e::StopArea: add_codes(nav_data, ed_obj, stop_area_map, codes); break;
+        case nt::Type_e::Network: add_codes(nav_data, ed_obj, network_map, codes); break;
+        case nt::Type_e::Company: add_codes(nav_data, ed_obj, company_map, codes); break;
+        case nt::Type_e::Line: add_codes(nav_data, ed_obj, line_map, codes); break;
+        case nt::Type_e::Route: add_codes(nav_data, ed_obj, route_map, codes); break;
+        case nt::Type_e::VehicleJourney: add_codes(nav_data, ed_obj, vehicle_journey_map, codes); break;
+        case nt::Type_e::StopPoint: add_codes(nav_data, ed_obj, stop_point_map, codes); break;
+        case nt::Type_e::Calendar: add_codes(nav_data, ed_obj, calendar_map, codes); break;
+        default: break;
+        }
+    }
+}
+
+void NavConverter::fill_stop_point_connections(const ed::Data& data, navitia::type::Data& nav_data){
+    for (const types::StopPointConnection* ed_connection: data.stop_point_connections) {
+        nt::StopPoint* departure = find_or_default(ed_connection->departure, stop_point_map);
+        nt::StopPoint* destination = find_or_default(ed_connection->destination, stop_point_map);
+        if (! departure || ! destination) { continue; }
+
+        auto* stop_point_connection = new nt::StopPointConnection();
+        stop_point_connection->departure = departure;
+        stop_point_connection->destination = destination;
+        stop_point_connection->connection_type = ed_connection->connection_kind;
+        stop_point_connection->display_duration = ed_connection->display_duration;
+        stop_point_connection->duration = ed_connection->duration;
+        stop_point_connection->max_duration = ed_connection->max_duration;
+        stop_point_connection->set_properties(ed_connection->properties());
+
+        nav_data.pt_data->stop_point_connections.push_back(stop_point_connection);
+
+        //add the connection in the stop points
+        departure->stop_point_connection_list.push_back(stop_point_connection);
+        destination->stop_point_connection_list.push_back(stop_point_connection);
+    }
+}
+
+void NavConverter::fill_prices(const ed::Data& data, navitia::type::Data& nav_data) {
+    for (const auto& ticket_it: data.fare_map) {
+        const nf::DateTicket& tickets = ticket_it.second;
+        if (tickets.tickets.empty()) { continue; }
+
+        // the ticket caption and comment are only stored once for all the dated tickets
+        const auto& first_ticket = tickets.tickets.front().ticket;
+        nf::DateTicket& date_ticket = nav_data.fare->fare_map[ticket_it.first];
+        for (const auto& dated_ticket: tickets.tickets) {
+            nf::Ticket ticket;
+            ticket.key = dated_ticket.ticket.key;
+            ticket.caption = first_ticket.caption;
+            ticket.comment = first_ticket.comment;
+            ticket.currency = dated_ticket.ticket.currency;
+            ticket.value.value = dated_ticket.ticket.value.value;
+
+            date_ticket.add(dated_ticket.validity_period.begin(), dated_ticket.validity_period.end(), ticket);
+        }
+    }
+}
+
+void NavConverter::fill_transitions(const ed::Data& data, navitia::type::Data& nav_data) {
+    //we build the transition graph
+    std::map<nf::State, nf::Fare::vertex_t> state_map;
+    nf::State begin; // Start is an empty node (and the node is already is the fare graph, since it has been added in the constructor with the default ticket)
+    state_map[begin] = nav_data.fare->begin_v;
+
+    auto get_vertex = [&](const nf::State& state) {
+        const auto it = state_map.find(state);
+        if (it != state_map.end()) { return it->second; }
+        const auto v = boost::add_vertex(state, nav_data.fare->g);
+        state_map[state] = v;
+        return v;
+    };
+
+    // the transitions with a ticket are stored first in the database, we keep the same order
+    for (const bool with_ticket: {true, false}) {
+        for (const auto& transition_tuple: data.transitions) {
+            const nf::Transition& transition = std::get<2>(transition_tuple);
+            if (transition.ticket_key.empty() == with_ticket) { continue; }
+
+            const auto start_v = get_vertex(std::get<0>(transition_tuple));
+            const auto end_v = get_vertex(std::get<1>(transition_tuple));
+
+            //add the edge to the fare graph
+            boost::add_edge(start_v, end_v, transition, nav_data.fare->g);
+        }
+    }
+}
+
+void NavConverter::fill_origin_destinations(const ed::Data& data, navitia::type::Data& nav_data) {
+    for (const auto& origin_ticket: data.od_tickets) {
+        for (const auto& destination_ticket: origin_ticket.second) {
+            for (const auto& ticket: destination_ticket.second) {
+                nav_data.fare->od_tickets[origin_ticket.first][destination_ticket.first].push_back(ticket);
+            }
+        }
+    }
+}
+
+void save_as_nav(const ed::Data& data, const std::string& output, const std::string& cities_connection_string) {
+    auto logger = log4cplus::Logger::getInstance("log");
+    navitia::type::Data nav_data;
+
+    if (! cities_connection_string.empty()) {
+        nav_data.find_admins = FindAdminWithCities(cities_connection_string, *nav_data.geo_ref);
+    }
+
+    auto start = bt::microsec_clock::local_time();
+    NavConverter converter;
+    converter.fill(data, nav_data);
+    LOG4CPLUS_INFO(logger, "conversion to nav done in "
+                   << (bt::microsec_clock::local_time() - start).total_milliseconds() << "ms");
+
+    nav_data.complete();
+    converter.fill_admin_stop_areas(data, nav_data);
+    nav_data.meta->publication_date = bt::microsec_clock::local_time();
+
+    start = bt::microsec_clock::local_time();
+    nav_data.save(output);
+    LOG4CPLUS_INFO(logger, "data saved in " << output << " in "
+                   << (bt::microsec_clock::local_time() - start).total_milliseconds() << "ms");
+}
+
+}//namespace
@@ -0,0 +1,129 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include "data.h"
+#include "type/data.h"
+#include "utils/logger.h"
+
+#include <unordered_map>
+
+namespace ed{
+
+/**
+ * Builds a navitia::type::Data directly from the ed::Data filled by a connector
+ *
+ * It is the in-process equivalent of EdPersistor::persist followed by EdReader::fill:
+ * the objects get the same transformations as if they had gone through the ed database
+ * (encoded uris, lines without network ignored, ...), so the resulting data.nav is the
+ * one ed2nav would have built from the same files.
+ *
+ * Only the public transport data are converted, there is no street network nor poi.
+ */
+struct NavConverter{
+
+    void fill(const ed::Data& data, navitia::type::Data& nav_data);
+
+    /**
+     * Sets the main stop areas of the admins given by the dataset
+     *
+     * The admins only exist once nav_data is completed (they come from find_admins),
+     * so it must be called after navitia::type::Data::complete. For those admins,
+     * the main stop areas of the dataset replace the ones deduced from the stop points.
+     */
+    void fill_admin_stop_areas(const ed::Data& data, navitia::type::Data& nav_data);
+
+private:
+    template<typename Ed, typename Nav>
+    using PtrMap = std::unordered_map<const Ed*, Nav*>;
+
+    //map from the ed objects to the objects built in nav_data
+    PtrMap<types::Network, nt::Network> network_map;
+    PtrMap<types::CommercialMode, nt::CommercialMode> commercial_mode_map;
+    PtrMap<types::PhysicalMode, nt::PhysicalMode> physical_mode_map;
+    PtrMap<types::Company, nt::Company> company_map;
+    PtrMap<types::Contributor, nt::Contributor> contributor_map;
+    PtrMap<types::Dataset, nt::Dataset> dataset_map;
+    PtrMap<types::StopArea, nt::StopArea> stop_area_map;
+    PtrMap<types::StopPoint, nt::StopPoint> stop_point_map;
+    PtrMap<types::Line, nt::Line> line_map;
+    PtrMap<types::LineGroup, nt::LineGroup> line_group_map;
+    PtrMap<types::Route, nt::Route> route_map;
+    PtrMap<types::ValidityPattern, nt::ValidityPattern> validity_pattern_map;
+    PtrMap<types::VehicleJourney, nt::VehicleJourney> vehicle_journey_map;
+    PtrMap<types::Calendar, nt::Calendar> calendar_map;
+    PtrMap<types::AssociatedCalendar, nt::AssociatedCalendar> associated_calendar_map;
+
+    //there is only one timezone in ed
+    const nt::TimeZoneHandler* timezone = nullptr;
+
+    void fill_meta(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_timezones(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_networks(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_commercial_modes(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_physical_modes(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_companies(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_contributors(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_datasets(const ed::Data& data, navitia::type::Data& nav_data);
+
+    void fill_stop_areas(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_stop_points(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_lines(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_line_groups(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_routes(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_validity_patterns(const ed::Data& data, navitia::type::Data& nav_data);
+
+    void fill_vehicle_journeys(const ed::Data& data, navitia::type::Data& nav_data);
+    void finish_stop_times(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_comments(const ed::Data& data, navitia::type::Data& nav_data);
+
+    void fill_calendars(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_meta_vehicle_journeys(const ed::Data& data, navitia::type::Data& nav_data);
+
+    void fill_object_codes(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_stop_point_connections(const ed::Data& data, navitia::type::Data& nav_data);
+
+    void fill_prices(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_transitions(const ed::Data& data, navitia::type::Data& nav_data);
+    void fill_origin_destinations(const ed::Data& data, navitia::type::Data& nav_data);
+
+    log4cplus::Logger log = log4cplus::Logger::getInstance("log");
+};
+
+/**
+ * Converts the ed::Data, completes it and saves it as a data.nav file
+ *
+ * If cities_connection_string is not empty, the cities database is used to find the
+ * admins of the stop areas, like ed2nav does.
+ */
+void save_as_nav(const ed::Data& data, const std::string& output, const std::string& cities_connection_string);
+
+}
@@ -29,6 +29,7 @@ www.navitia.io
 */
 
 #include "osm2ed.h"
+#include "osm_pbf_reader.h"
 #include <stdio.h>
 #include <queue>
 
@@ -83,7 +84,7 @@ void ReadRelationsVisitor::relation_callback(uint64_t osm_id, const CanalTP::Tag
                 break;
             case OSMPBF::Relation_MemberType::Relation_MemberType_NODE:
                 if (ref.role == "admin_centre" || ref.role == "admin_center") {
-                    cache.nodes.insert(OSMNode(ref.member_id));
+                    cache.nodes.add(ref.member_id);
                 }
                 break;
             case OSMPBF::Relation_MemberType::Relation_MemberType_RELATION:
@@ -178,12 +179,9 @@ void ReadWaysVisitor::way_callback(uint64_t osm_id, const CanalTP::Tags &tags,
         it_way = cache.ways.insert(OSMWay(osm_id, properties, name)).first;
     }
     for (auto osm_id : nodes_refs) {
-        auto v = cache.nodes.insert(OSMNode(osm_id));
-        if (is_street && !v.second) {
-            v.first->set_used_more_than_once();
-        }
+        cache.nodes.add(osm_id, is_street);
         if (it_way != cache.ways.end()) {
-            it_way->add_node(v.first);
+            it_way->node_ids.push_back(osm_id);
         }
     }
 }
@@ -193,9 +191,9 @@ void ReadWaysVisitor::way_callback(uint64_t osm_id, const CanalTP::Tags &tags,
  */
 void ReadNodesVisitor::node_callback(uint64_t osm_id, double lon, double lat,
         const CanalTP::Tags& ) {
-    auto node_it = cache.nodes.find(OSMNode(osm_id));
-    if (node_it != cache.nodes.end()) {
-        node_it->set_coord(lon, lat);
+    const auto node = cache.nodes.find(osm_id);
+    if (node != OSMNodeStore::npos) {
+        cache.nodes.set_coord(node, lon, lat);
     }
 }
 
@@ -245,12 +243,12 @@ const OSMRelation* OSMCache::match_coord_admin(const double lon, const double la
 void OSMCache::match_nodes_admin() {
     auto logger = log4cplus::Logger::getInstance("log");
     size_t count_matches = 0;
-    for (const auto& node : nodes) {
-        if (!node.is_defined() || node.admin) {
+    for (OSMNodeStore::idx_t node = 0; node < nodes.size(); ++node) {
+        if (!nodes.is_defined(node) || nodes.admin(node)) {
             continue;
         }
-        node.admin = match_coord_admin(node.lon(), node.lat());
-        if (node.admin != nullptr) {
+        nodes.set_admin(node, match_coord_admin(nodes.lon(node), nodes.lat(node)));
+        if (nodes.admin(node) != nullptr) {
             ++ count_matches;
         }
     }
@@ -258,6 +256,21 @@ void OSMCache::match_nodes_admin() {
     LOG4CPLUS_INFO(logger, "" << count_matches << "/" << nodes.size() << " nodes with an admin");
 }
 
+/*
+ * Once all the ways are read, the store of the needed nodes is complete,
+ * we replace the osm ids of the nodes of the ways by their index in the store
+ */
+void OSMCache::resolve_way_nodes() {
+    nodes.finalize();
+    for (const auto& way : ways) {
+        way.nodes.reserve(way.node_ids.size());
+        for (const auto osm_id : way.node_ids) {
+            way.add_node(nodes, nodes.find(osm_id));
+        }
+        std::vector<uint64_t>().swap(way.node_ids);
+    }
+}
+
 /*
  * Insert nodes into the database
  */
@@ -266,11 +279,11 @@ void OSMCache::insert_nodes() {
     this->lotus.prepare_bulk_insert("georef.node", {"id","coord"});
     size_t n_inserted = 0;
     const size_t max_n_inserted = 200000;
-    for(const auto& node : nodes){
-        if (!node.is_defined() || !node.is_used()) {
+    for (OSMNodeStore::idx_t node = 0; node < nodes.size(); ++node) {
+        if (!nodes.is_defined(node) || !nodes.is_used(node)) {
             continue;
         }
-        this->lotus.insert({std::to_string(node.osm_id), node.to_geographic_point()});
+        this->lotus.insert({std::to_string(nodes.osm_id(node)), nodes.to_geographic_point(node)});
         ++n_inserted;
         if ((n_inserted % max_n_inserted) == 0) {
             lotus.finish_bulk_insert();
@@ -327,24 +340,24 @@ void OSMCache::insert_edges() {
     size_t n_inserted = 0;
     const size_t max_n_inserted = 20000;
     for (const auto& way : ways) {
-        std::set<OSMNode>::iterator prev_node = nodes.end();
+        auto prev_node = OSMNodeStore::npos;
         const auto ref_way_id = way.way_ref == nullptr ? way.osm_id : way.way_ref->osm_id;
-        for (const auto& node : way.nodes) {
-            if (!node->is_defined()) {
+        for (const auto node : way.nodes) {
+            if (!nodes.is_defined(node)) {
                 continue;
             }
-            if ((node->is_used_more_than_once() && prev_node != nodes.end())
-                    || (node == way.nodes.back() && prev_node != nodes.end())) {
+            if ((nodes.is_used_more_than_once(node) && prev_node != OSMNodeStore::npos)
+                    || (node == way.nodes.back() && prev_node != OSMNodeStore::npos)) {
                 // If a node is used more than once, it is an intersection,
                 // hence it's a node of the street network graph
                 // If a node is only used by one way we can simplify the and reduce the number of edges, we don't need
                 // to have the perfect representation of the way on the graph, but we have the correct representation
                 // in the linestring
-                coords.push_back({node->lon(), node->lat()});
+                coords.push_back({nodes.lon(node), nodes.lat(node)});
                 wkt.str("");
                 wkt << boost::geometry::wkt(coords);
-                lotus.insert({std::to_string(prev_node->osm_id),
-                        std::to_string(node->osm_id), std::to_string(ref_way_id),
+                lotus.insert({std::to_string(nodes.osm_id(prev_node)),
+                        std::to_string(nodes.osm_id(node)), std::to_string(ref_way_id),
                         wkt.str(), std::to_string(way.properties[OSMWay::FOOT_FWD]),
                         std::to_string(way.properties[OSMWay::CYCLE_FWD]),
                         std::to_string(way.properties[OSMWay::CAR_FWD])});
@@ -354,19 +367,19 @@ void OSMCache::insert_edges() {
                 std::reverse(coords.begin(), coords.end());
                 wkt.str("");
                 wkt << boost::geometry::wkt(coords);
-                lotus.insert({std::to_string(node->osm_id),
-                        std::to_string(prev_node->osm_id), std::to_string(ref_way_id),
+                lotus.insert({std::to_string(nodes.osm_id(node)),
+                        std::to_string(nodes.osm_id(prev_node)), std::to_string(ref_way_id),
                         wkt.str(), std::to_string(way.properties[OSMWay::FOOT_BWD]),
                         std::to_string(way.properties[OSMWay::CYCLE_BWD]),
                         std::to_string(way.properties[OSMWay::CAR_BWD])});
-                prev_node = nodes.end();
+                prev_node = OSMNodeStore::npos;
                 n_inserted = n_inserted + 2;
             }
-            if (prev_node == nodes.end()) {
+            if (prev_node == OSMNodeStore::npos) {
                 coords.clear();
                 prev_node = node;
             }
-            coords.push_back({node->lon(), node->lat()});
+            coords.push_back({nodes.lon(node), nodes.lat(node)});
         }
         if ((n_inserted % max_n_inserted) == 0) {
             lotus.finish_bulk_insert();
@@ -460,12 +473,6 @@ void OSMCache::insert_rel_way_admins() {
     auto logger = log4cplus::Logger::getInstance("log");
 }
 
-std::string OSMNode::to_geographic_point() const{
-    std::stringstream geog;
-    geog << std::setprecision(10)<<"POINT("<< coord_to_string() <<")";
-    return geog.str();
-}
-
 /*
  * We build a map that have for key the way name, and for value
  * a map admin->vector of way
@@ -482,19 +489,19 @@ void OSMCache::build_way_map() {
                min_lat = max_double;
         std::set<const OSMRelation*> admins;
         for (auto node : way_it->nodes) {
-            if (!node->admin) {
+            if (!nodes.admin(node)) {
                 continue;
             }
-            admins.insert(node->admin);
-            if (!node->is_defined()) {
+            admins.insert(nodes.admin(node));
+            if (!nodes.is_defined(node)) {
                 continue;
             }
-            max_lon = max_lon >= max_double ? node->lon() :
-                                             std::max(max_lon, node->lon());
-            max_lat = max_lat >= max_double ? node->lat() :
-                                             std::max(max_lat, node->lat());
-            min_lon = std::min(min_lon, node->lon());
-            min_lat = std::min(min_lat, node->lat());
+            max_lon = max_lon >= max_double ? nodes.lon(node) :
+                                             std::max(max_lon, nodes.lon(node));
+            max_lat = max_lat >= max_double ? nodes.lat(node) :
+                                             std::max(max_lat, nodes.lat(node));
+            min_lon = std::min(min_lon, nodes.lon(node));
+            min_lat = std::min(min_lat, nodes.lat(node));
         }
         way_admin_map[way_it->name][admins].insert(way_it);
         bg::simplify(way_it->ls, way_it->ls, 0.5);
@@ -567,10 +574,10 @@ void OSMRelation::build_polygon(OSMCache& cache) const {
         explored_ids.insert(ref->member_id);
         polygon_type tmp_polygon;
         for (auto node : it_first_way->nodes) {
-            if (!node->is_defined()) {
+            if (!cache.nodes.is_defined(node)) {
                 continue;
             }
-            const auto p = point(float(node->lon()), float(node->lat()));
+            const auto p = point(float(cache.nodes.lon(node)), float(cache.nodes.lat(node)));
             tmp_polygon.outer().push_back(p);
         }
 
@@ -597,10 +604,10 @@ void OSMRelation::build_polygon(OSMCache& cache) const {
                 boost::reverse(next_way->nodes);
             }
             for (auto node : next_way->nodes) {
-                if (!node->is_defined()) {
+                if (!cache.nodes.is_defined(node)) {
                     continue;
                 }
-                const auto p = point(float(node->lon()), float(node->lat()));
+                const auto p = point(float(cache.nodes.lon(node)), float(cache.nodes.lat(node)));
                 tmp_polygon.outer().push_back(p);
             }
             next_node = next_way->nodes.back();
@@ -616,11 +623,12 @@ void OSMRelation::build_polygon(OSMCache& cache) const {
                 if (! is_outer_way(r)) { continue; }
                 auto it_way = cache.ways.find(r.member_id);
                 if (it_way == cache.ways.end()) { continue; }
-                for (const auto& node: it_way->nodes) {
-                    if (node->osm_id != next_node->osm_id && node->almost_equal(*next_node)) {
+                for (const auto node: it_way->nodes) {
+                    if (node != next_node && cache.nodes.almost_equal(node, next_node)) {
                         LOG4CPLUS_WARN(log, "Impossible to close the boundary of the admin " << name << " (osmid= "
-                                       << osm_id << "). The end node " << node->osm_id << " is almost the same as "
-                                       << next_node->osm_id << " it's likely that they are wrong duplicate");
+                                       << osm_id << "). The end node " << cache.nodes.osm_id(node)
+                                       << " is almost the same as " << cache.nodes.osm_id(next_node)
+                                       << " it's likely that they are wrong duplicate");
                         break;
                     }
                 }
@@ -661,15 +669,15 @@ OSMRelation::OSMRelation(const u_int64_t osm_id,
 void OSMRelation::build_geometry(OSMCache& cache) const {
     for (CanalTP::Reference ref : references) {
         if (ref.member_type == OSMPBF::Relation_MemberType::Relation_MemberType_NODE) {
-            auto node_it = cache.nodes.find(ref.member_id);
-            if (node_it == cache.nodes.end()) {
+            const auto node = cache.nodes.find(ref.member_id);
+            if (node == OSMNodeStore::npos) {
                 continue;
             }
-            if (!node_it->is_defined()) {
+            if (!cache.nodes.is_defined(node)) {
                 continue;
             }
             if (ref.role == "admin_centre") {
-                set_centre(float(node_it->lon()), float(node_it->lat()));
+                set_centre(float(cache.nodes.lon(node)), float(cache.nodes.lat(node)));
                 break;
             }
         }
@@ -697,19 +705,19 @@ void PoiHouseNumberVisitor::way_callback(uint64_t osm_id, const CanalTP::Tags &t
     }
     polygon_type tmp_polygon;
     for (auto ref : refs) {
-        auto node_it = cache.nodes.find(OSMNode(ref));
-        if (node_it == cache.nodes.end() || !node_it->is_defined()) {
+        const auto node = cache.nodes.find(ref);
+        if (node == OSMNodeStore::npos || !cache.nodes.is_defined(node)) {
             continue;
         }
-        const auto p = point(float(node_it->lon()), float(node_it->lat()));
+        const auto p = point(float(cache.nodes.lon(node)), float(cache.nodes.lat(node)));
         tmp_polygon.outer().push_back(p);
     }
     if (tmp_polygon.outer().size() <= 2) {
         for (auto ref_id : refs) {
-            auto node_it = cache.nodes.find(OSMNode(ref_id));
-            if (node_it != cache.nodes.end() && node_it->is_defined()) {
-                this->fill_housenumber(osm_id, tags, node_it->lon(), node_it->lat());
-                this->fill_poi(osm_id, tags, node_it->lon(), node_it->lat(), OsmObjectType::Way);
+            const auto node = cache.nodes.find(ref_id);
+            if (node != OSMNodeStore::npos && cache.nodes.is_defined(node)) {
+                this->fill_housenumber(osm_id, tags, cache.nodes.lon(node), cache.nodes.lat(node));
+                this->fill_poi(osm_id, tags, cache.nodes.lon(node), cache.nodes.lat(node), OsmObjectType::Way);
                 break;
             }
         }
@@ -784,7 +792,7 @@ const OSMWay* PoiHouseNumberVisitor::find_way_without_name(const double lon, con
     cache.way_tree.Search(search_rect.min, search_rect.max, callback, &res_tree);
     point p(lon, lat);
     for(auto way_it : res_tree) {
-        auto admins = way_it->admins();
+        auto admins = way_it->admins(cache.nodes);
         if (admins.find(admin) != admins.end()) {
             const auto tmp_dist = way_it->distance(p);
             ++ cache.NB_PROJ;
@@ -933,14 +941,14 @@ void PoiHouseNumberVisitor::fill_poi(const u_int64_t osm_id, const CanalTP::Tags
 void OSMCache::flag_nodes() {
     for (const auto& way : ways) {
         for (const auto node: way.nodes) {
-            if(node->is_defined()) {
-                node->set_first_or_last();
+            if(nodes.is_defined(node)) {
+                nodes.set_first_or_last(node);
                 break;
             }
         }
         for (auto it=way.nodes.rbegin(); it!=way.nodes.rend(); ++it) {
-            if ((*it)->is_defined()) {
-                (*it)->set_first_or_last();
+            if (nodes.is_defined(*it)) {
+                nodes.set_first_or_last(*it);
                 break;
             }
         }
@@ -949,11 +957,26 @@ void OSMCache::flag_nodes() {
 
 }}
 
+/*
+ * Runs a step of osm2ed and logs its duration and the memory used by the nodes,
+ * to benchmark the import of a pbf
+ */
+template<typename F>
+static void run_step(const std::string& name, const ed::connectors::OSMCache& cache, F f) {
+    auto logger = log4cplus::Logger::getInstance("log");
+    const auto begin = pt::microsec_clock::local_time();
+    f();
+    LOG4CPLUS_INFO(logger, name << " done in " << (pt::microsec_clock::local_time() - begin).total_milliseconds()
+                   << "ms, " << cache.nodes.size() << " nodes using "
+                   << cache.nodes.memory_footprint() / (1024 * 1024) << "MB");
+}
+
 int main(int argc, char** argv) {
     navitia::init_app();
     auto logger = log4cplus::Logger::getInstance("log");
     pt::ptime start;
-    std::string input, connection_string, json_poi_types;
+    std::string input, connection_string, json_poi_types, nodes_spill_dir;
+    size_t nb_threads;
 
     po::options_description desc("Allowed options");
     desc.add_options()
@@ -966,7 +989,12 @@ int main(int argc, char** argv) {
              "Database connection parameters: host=localhost user=navitia"
              " dbname=navitia password=navitia")
         ("poi-type,p", po::value<std::string>(&json_poi_types),
-                       "a json string describing poi_types and rules to build them from OSM tags");
+                       "a json string describing poi_types and rules to build them from OSM tags")
+        ("nodes-spill-dir", po::value<std::string>(&nodes_spill_dir),
+                            "if given, the nodes are stored in memory mapped files in this directory, "
+                            "to import big extracts with less memory")
+        ("nb-threads", po::value<size_t>(&nb_threads)->default_value(0),
+                       "number of threads decoding the pbf file, 0 to use all the cores");
 
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -1015,17 +1043,30 @@ int main(int argc, char** argv) {
 
     ed::connectors::OSMCache cache(connection_string);
     ed::connectors::ReadRelationsVisitor relations_visitor(cache);
-    CanalTP::read_osm_pbf(input, relations_visitor);
+    run_step("reading relations", cache, [&]() {
+        ed::connectors::read_osm_pbf(input, relations_visitor, ed::connectors::pbf_relations, nb_threads);
+    });
     ed::connectors::ReadWaysVisitor ways_visitor(cache, poi_params);
-    CanalTP::read_osm_pbf(input, ways_visitor);
+    run_step("reading ways", cache, [&]() {
+        ed::connectors::read_osm_pbf(input, ways_visitor, ed::connectors::pbf_ways, nb_threads);
+    });
+    run_step("resolving nodes of ways", cache, [&]() {
+        cache.resolve_way_nodes();
+        if (vm.count("nodes-spill-dir")) {
+            cache.nodes.spill(nodes_spill_dir);
+        }
+    });
     ed::connectors::ReadNodesVisitor node_visitor(cache);
-    CanalTP::read_osm_pbf(input, node_visitor);
+    // only the coordinates of the nodes are needed, their tags are not decoded
+    run_step("reading nodes", cache, [&]() {
+        ed::connectors::read_osm_pbf(input, node_visitor, ed::connectors::pbf_nodes, nb_threads);
+    });
     cache.build_relations_geometries();
-    cache.match_nodes_admin();
+    run_step("matching admins of nodes", cache, [&]() { cache.match_nodes_admin(); });
     cache.build_way_map();
     cache.fusion_ways();
     cache.flag_nodes();
-    cache.insert_nodes();
+    run_step("inserting nodes", cache, [&]() { cache.insert_nodes(); });
     cache.insert_ways();
     cache.insert_edges();
     cache.insert_relations();
@@ -1035,8 +1076,14 @@ int main(int argc, char** argv) {
     ed::Georef data;
     ed::connectors::PoiHouseNumberVisitor poi_visitor(persistor, cache, data,
                                                       persistor.parse_pois, poi_params);
-    CanalTP::read_osm_pbf(input, poi_visitor);
-    poi_visitor.finish();
+    // the pois and house numbers need the coordinates of all the nodes and the fusioned ways,
+    // they can't be read in the same pass as the nodes
+    run_step("reading pois and house numbers", cache, [&]() {
+        ed::connectors::read_osm_pbf(input, poi_visitor,
+                                     ed::connectors::pbf_nodes | ed::connectors::pbf_node_tags
+                                     | ed::connectors::pbf_ways, nb_threads);
+        poi_visitor.finish();
+    });
     LOG4CPLUS_INFO(logger, "compute bounding shape");
     persistor.compute_bounding_shape();
     persistor.insert_metadata_georef();
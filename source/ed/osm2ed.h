@@ -42,6 +42,7 @@ www.navitia.io
 #include <boost/geometry/multi/geometries/multi_polygon.hpp>
 #include <boost/geometry/multi/geometries/multi_point.hpp>
 #include "third_party/RTree/RTree.h"
+#include "ed/osm_node_store.h"
 
 namespace bg = boost::geometry;
 typedef bg::model::point<double, 2, bg::cs::cartesian> point;
@@ -57,82 +58,6 @@ namespace ed { namespace connectors {
 struct OSMRelation;
 struct OSMCache;
 
-struct OSMNode {
-    static const uint USED_MORE_THAN_ONCE = 0,
-                      FIRST_OR_LAST = 1;
-    uint64_t osm_id = std::numeric_limits<uint64_t>::max();
-    // these attributes are mutable because this object would be use in a set, and
-    // all object in a set are const, since these attributes are not used in the key we can modify them
-
-    // We use int32_t to save memory, these are coordinates *  factor
-    mutable int32_t ilon = std::numeric_limits<int32_t>::max(),
-                    ilat = std::numeric_limits<int32_t>::max();
-    mutable const OSMRelation* admin = nullptr;
-    static constexpr double factor = 1e6;
-
-    OSMNode(uint64_t osm_id) : osm_id(osm_id) {}
-
-    bool operator<(const OSMNode& other) const {
-        return this->osm_id < other.osm_id;
-    }
-
-    bool almost_equal(const OSMNode& other) const {
-        // check if the nodes are quite at the same location
-        auto distance = 10; // about 0.5m
-        return std::abs(this->ilon - other.ilon) < distance && std::abs(this->ilat - other.ilat) < distance;
-    }
-
-    // Even if it's const, it modifies the variable used_more_than_once,
-    // cause it's mutable, and doesn't affect the operator <
-    void set_used_more_than_once() const {
-        this->properties[USED_MORE_THAN_ONCE] = true;
-    }
-
-    bool is_defined() const {
-        return ilon != std::numeric_limits<int32_t>::max() &&
-            ilat != std::numeric_limits<int32_t>::max();
-    }
-
-    bool is_used_more_than_once() const {
-        return this->properties[USED_MORE_THAN_ONCE];
-    }
-
-    bool is_used() const {
-        return is_used_more_than_once() || is_first_or_last();
-    }
-
-    bool is_first_or_last() const {
-        return this->properties[FIRST_OR_LAST];
-    }
-
-    void set_first_or_last() const {
-        this->properties[FIRST_OR_LAST] = true;
-    }
-
-    void set_coord(double lon, double lat) const{
-        this->ilon = lon * factor;
-        this->ilat = lat * factor;
-    }
-
-    double lon() const {
-        return double(this->ilon) / factor;
-    }
-
-    double lat() const {
-        return double(this->ilat) / factor;
-    }
-
-    std::string coord_to_string() const {
-        std::stringstream geog;
-        geog << std::setprecision(10) << lon() << " " << lat();
-        return geog.str();
-    }
-    std::string to_geographic_point() const;
-private:
-    mutable std::bitset<2> properties = 0;
-};
-
-
 struct OSMRelation {
     const u_int64_t osm_id;
     CanalTP::References references;
@@ -181,7 +106,9 @@ struct OSMWay {
     /// Properties of a way : can we use it
     mutable std::bitset<8> properties;
     mutable std::string name = "";
-    mutable std::vector<std::set<OSMNode>::const_iterator> nodes;
+    // osm ids of the nodes, only while reading the ways, see OSMCache::resolve_way_nodes()
+    mutable std::vector<uint64_t> node_ids;
+    mutable std::vector<OSMNodeStore::idx_t> nodes;
     mutable ls_type ls;
     mutable const OSMWay* way_ref = nullptr;
 
@@ -190,10 +117,10 @@ struct OSMWay {
             const std::string& name) :
         osm_id(osm_id), properties(properties), name(name) {}
 
-    void add_node(std::set<OSMNode>::const_iterator node) const {
+    void add_node(const OSMNodeStore& store, const OSMNodeStore::idx_t node) const {
         nodes.push_back(node);
-        if (node->is_defined()) {
-            ls.push_back(point(node->lon(), node->lat()));
+        if (store.is_defined(node)) {
+            ls.push_back(point(store.lon(node), store.lat(node)));
         }
     }
 
@@ -209,11 +136,11 @@ struct OSMWay {
         this->name = name;
     }
 
-    std::string coord_to_string() const {
+    std::string coord_to_string(const OSMNodeStore& store) const {
         std::stringstream geog;
         geog << std::setprecision(10);
         for(auto node : nodes) {
-            geog << node->coord_to_string();
+            geog << store.coord_to_string(node);
         }
         return geog.str();
     }
@@ -230,11 +157,11 @@ struct OSMWay {
         return bg::distance(p, ls);
     }
 
-    std::set<const OSMRelation*> admins() const {
+    std::set<const OSMRelation*> admins(const OSMNodeStore& store) const {
         std::set<const OSMRelation*> result;
         for(auto node : nodes) {
-            if (node->admin != nullptr) {
-                result.insert(node->admin);
+            if (store.admin(node) != nullptr) {
+                result.insert(store.admin(node));
             }
         }
         return result;
@@ -284,7 +211,7 @@ typedef std::pair<admin_type, double> admin_distance;
 
 struct OSMCache {
     std::set<OSMRelation> relations;
-    std::set<OSMNode> nodes;
+    OSMNodeStore nodes;
     std::set<OSMWay> ways;
     std::set<AssociateStreetRelation> associated_streets;
     std::unordered_map<std::string, rel_ways> way_admin_map;
@@ -300,6 +227,7 @@ struct OSMCache {
     void build_relations_geometries();
     const OSMRelation* match_coord_admin(const double lon, const double lat);
     void match_nodes_admin();
+    void resolve_way_nodes();
     void insert_nodes();
     void insert_ways();
     void insert_edges();
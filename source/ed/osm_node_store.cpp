@@ -0,0 +1,219 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "osm_node_store.h"
+#include "utils/exception.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace ed { namespace connectors {
+
+constexpr OSMNodeStore::idx_t OSMNodeStore::npos;
+constexpr double OSMNodeStore::factor;
+constexpr uint8_t OSMNodeStore::USED_MORE_THAN_ONCE;
+constexpr uint8_t OSMNodeStore::FIRST_OR_LAST;
+
+template<typename T>
+void OSMNodeStore::Array<T>::assign(std::vector<T>&& v) {
+    values = std::move(v);
+    data = values.data();
+    size = values.size();
+}
+
+template<typename T>
+void OSMNodeStore::Array<T>::spill(const std::string& directory) {
+    if (size == 0 || mapped_size != 0) { return; }
+    std::string path = directory + "/osm2ed_nodes_XXXXXX";
+    const int fd = mkstemp(&path[0]);
+    if (fd == -1) {
+        throw navitia::exception("impossible to create a temporary file in " + directory);
+    }
+    // the file is removed when unmapped
+    unlink(path.c_str());
+    const size_t nb_bytes = size * sizeof(T);
+    if (ftruncate(fd, nb_bytes) != 0) {
+        close(fd);
+        throw navitia::exception("impossible to resize the temporary file " + path);
+    }
+    void* mapping = mmap(nullptr, nb_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw navitia::exception("impossible to map the temporary file " + path);
+    }
+    std::memcpy(mapping, values.data(), nb_bytes);
+    std::vector<T>().swap(values);
+    data = static_cast<T*>(mapping);
+    mapped_size = nb_bytes;
+}
+
+template<typename T>
+OSMNodeStore::Array<T>::~Array() {
+    if (mapped_size != 0) {
+        munmap(data, mapped_size);
+    }
+}
+
+template struct OSMNodeStore::Array<uint64_t>;
+template struct OSMNodeStore::Array<int32_t>;
+template struct OSMNodeStore::Array<uint32_t>;
+template struct OSMNodeStore::Array<uint8_t>;
+
+OSMNodeStore::~OSMNodeStore() {}
+
+void OSMNodeStore::add(const uint64_t osm_id, const bool is_street) {
+    if (finalized) {
+        throw navitia::exception("OSMNodeStore: impossible to add a node after finalize");
+    }
+    buffer.push_back(osm_id << 1 | uint64_t(is_street));
+    // the buffer is merged when it's as big as the store, so each id is merged a
+    // logarithmic number of times
+    if (buffer.size() >= std::max(max_buffer_size, ids.size)) {
+        merge_buffer();
+    }
+}
+
+void OSMNodeStore::merge_buffer() {
+    if (buffer.empty()) { return; }
+    // stable, to keep the insertion order of an id
+    std::stable_sort(buffer.begin(), buffer.end(), [](const uint64_t a, const uint64_t b) {
+        return (a >> 1) < (b >> 1);
+    });
+
+    std::vector<uint64_t> new_ids;
+    std::vector<uint8_t> new_flags;
+    new_ids.reserve(ids.size + buffer.size());
+    new_flags.reserve(ids.size + buffer.size());
+    size_t i = 0, j = 0;
+    while (i < ids.size || j < buffer.size()) {
+        uint64_t id;
+        uint8_t flag = 0;
+        if (j == buffer.size() || (i < ids.size && ids[i] <= buffer[j] >> 1)) {
+            id = ids[i];
+            flag = flags[i];
+            ++i;
+        } else {
+            // first use of the node
+            id = buffer[j] >> 1;
+            ++j;
+        }
+        // the next uses of the node
+        for (; j < buffer.size() && buffer[j] >> 1 == id; ++j) {
+            if (buffer[j] & 1) {
+                flag |= USED_MORE_THAN_ONCE;
+            }
+        }
+        new_ids.push_back(id);
+        new_flags.push_back(flag);
+    }
+    std::vector<uint64_t>().swap(buffer);
+    ids.assign(std::move(new_ids));
+    flags.assign(std::move(new_flags));
+}
+
+void OSMNodeStore::finalize() {
+    if (finalized) { return; }
+    merge_buffer();
+    if (ids.size >= npos) {
+        throw navitia::exception("OSMNodeStore: too many nodes");
+    }
+    ids.values.shrink_to_fit();
+    ids.data = ids.values.data();
+    flags.values.shrink_to_fit();
+    flags.data = flags.values.data();
+    ilons.assign(std::vector<int32_t>(ids.size, std::numeric_limits<int32_t>::max()));
+    ilats.assign(std::vector<int32_t>(ids.size, std::numeric_limits<int32_t>::max()));
+    admins.assign(std::vector<uint32_t>(ids.size, 0));
+    finalized = true;
+}
+
+void OSMNodeStore::spill(const std::string& directory) {
+    ids.spill(directory);
+    ilons.spill(directory);
+    ilats.spill(directory);
+    flags.spill(directory);
+    admins.spill(directory);
+}
+
+OSMNodeStore::idx_t OSMNodeStore::find(const uint64_t osm_id) const {
+    const auto it = std::lower_bound(ids.begin(), ids.end(), osm_id);
+    if (it == ids.end() || *it != osm_id) {
+        return npos;
+    }
+    return idx_t(it - ids.begin());
+}
+
+size_t OSMNodeStore::memory_footprint() const {
+    return sizeof(*this)
+        + buffer.capacity() * sizeof(uint64_t)
+        + ids.values.capacity() * sizeof(uint64_t)
+        + ilons.values.capacity() * sizeof(int32_t)
+        + ilats.values.capacity() * sizeof(int32_t)
+        + flags.values.capacity() * sizeof(uint8_t)
+        + admins.values.capacity() * sizeof(uint32_t)
+        + admin_list.capacity() * sizeof(const OSMRelation*);
+}
+
+bool OSMNodeStore::almost_equal(const idx_t idx1, const idx_t idx2) const {
+    auto distance = 10; // about 0.5m
+    return std::abs(ilons[idx1] - ilons[idx2]) < distance && std::abs(ilats[idx1] - ilats[idx2]) < distance;
+}
+
+std::string OSMNodeStore::coord_to_string(const idx_t idx) const {
+    std::stringstream geog;
+    geog << std::setprecision(10) << lon(idx) << " " << lat(idx);
+    return geog.str();
+}
+
+std::string OSMNodeStore::to_geographic_point(const idx_t idx) const {
+    std::stringstream geog;
+    geog << std::setprecision(10) << "POINT(" << coord_to_string(idx) << ")";
+    return geog.str();
+}
+
+void OSMNodeStore::set_admin(const idx_t idx, const OSMRelation* admin) {
+    if (admin == nullptr) {
+        admins[idx] = 0;
+        return;
+    }
+    const auto inserted = admin_indexes.insert({admin, uint32_t(admin_list.size())});
+    if (inserted.second) {
+        admin_list.push_back(admin);
+    }
+    admins[idx] = inserted.first->second;
+}
+
+}}
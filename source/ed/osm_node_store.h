@@ -0,0 +1,141 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ed { namespace connectors {
+
+struct OSMRelation;
+
+/*
+ * Compact store of the OSM nodes needed by osm2ed
+ *
+ * The nodes are stored in sorted arrays: the osm ids, and for each node its coordinates
+ * (int32 lon/lat * factor), its flags and the index of its admin. It's 21 bytes by node
+ * (measured with memory_footprint() on 10M nodes), where a std::set<OSMNode> needs more
+ * than 64 bytes.
+ *
+ * The store is filled in 2 steps:
+ *  - the needed osm ids are added (in any order, several times), they are buffered and
+ *    regularly merged in the sorted arrays,
+ *  - after finalize(), the nodes are accessed by their index, find() giving the index of an osm id.
+ *
+ * The arrays can be moved to memory mapped files with spill(), the kernel is then able to
+ * write them back to the disk instead of swapping.
+ */
+struct OSMNodeStore {
+    using idx_t = uint32_t;
+    static constexpr idx_t npos = std::numeric_limits<idx_t>::max();
+    static constexpr double factor = 1e6;
+
+    explicit OSMNodeStore(size_t max_buffer_size = 1 << 24): max_buffer_size(max_buffer_size) {}
+    OSMNodeStore(const OSMNodeStore&) = delete;
+    OSMNodeStore& operator=(const OSMNodeStore&) = delete;
+    ~OSMNodeStore();
+
+    // A node used by a street is used more than once if it is not its first use,
+    // as std::set<OSMNode>::insert would have found it.
+    void add(const uint64_t osm_id, const bool is_street = false);
+    // Merges the buffered ids, no add() is possible after
+    void finalize();
+    void spill(const std::string& directory);
+
+    // npos if the node is not in the store
+    idx_t find(const uint64_t osm_id) const;
+    size_t size() const { return ids.size; }
+    size_t memory_footprint() const;
+
+    uint64_t osm_id(const idx_t idx) const { return ids[idx]; }
+
+    void set_coord(const idx_t idx, const double lon, const double lat) {
+        ilons[idx] = lon * factor;
+        ilats[idx] = lat * factor;
+    }
+    bool is_defined(const idx_t idx) const {
+        return ilons[idx] != std::numeric_limits<int32_t>::max() &&
+            ilats[idx] != std::numeric_limits<int32_t>::max();
+    }
+    double lon(const idx_t idx) const { return double(ilons[idx]) / factor; }
+    double lat(const idx_t idx) const { return double(ilats[idx]) / factor; }
+    // check if the nodes are quite at the same location
+    bool almost_equal(const idx_t idx1, const idx_t idx2) const;
+    std::string coord_to_string(const idx_t idx) const;
+    std::string to_geographic_point(const idx_t idx) const;
+
+    bool is_used_more_than_once(const idx_t idx) const { return flags[idx] & USED_MORE_THAN_ONCE; }
+    bool is_first_or_last(const idx_t idx) const { return flags[idx] & FIRST_OR_LAST; }
+    void set_first_or_last(const idx_t idx) { flags[idx] |= FIRST_OR_LAST; }
+    bool is_used(const idx_t idx) const { return is_used_more_than_once(idx) || is_first_or_last(idx); }
+
+    const OSMRelation* admin(const idx_t idx) const { return admin_list[admins[idx]]; }
+    void set_admin(const idx_t idx, const OSMRelation* admin);
+
+private:
+    static constexpr uint8_t USED_MORE_THAN_ONCE = 1, FIRST_OR_LAST = 2;
+
+    // An array in memory, or in a memory mapped file after spill
+    template<typename T> struct Array {
+        std::vector<T> values;
+        T* data = nullptr;
+        size_t size = 0;
+        size_t mapped_size = 0;
+
+        T& operator[](const size_t i) { return data[i]; }
+        const T& operator[](const size_t i) const { return data[i]; }
+        const T* begin() const { return data; }
+        const T* end() const { return data + size; }
+        void assign(std::vector<T>&& v);
+        void spill(const std::string& directory);
+        ~Array();
+    };
+
+    void merge_buffer();
+
+    size_t max_buffer_size;
+    bool finalized = false;
+    // osm_id << 1 | is_street, in insertion order
+    std::vector<uint64_t> buffer;
+
+    Array<uint64_t> ids;
+    Array<int32_t> ilons;
+    Array<int32_t> ilats;
+    Array<uint8_t> flags;
+    // admins[idx] is the index of the admin of the node in admin_list, 0 for none
+    Array<uint32_t> admins;
+    std::vector<const OSMRelation*> admin_list = {nullptr};
+    std::unordered_map<const OSMRelation*, uint32_t> admin_indexes;
+};
+
+}}
@@ -0,0 +1,263 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "osm_pbf_reader.h"
+#include "utils/exception.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <zlib.h>
+
+namespace ed { namespace connectors {
+
+// same limits as the osm pbf specification
+static const uint32_t max_blob_header_size = 64 * 1024;
+static const int32_t max_uncompressed_blob_size = 32 * 1024 * 1024;
+
+PbfDecoder::PbfDecoder(const std::string& filename, const uint8_t elements, size_t nb_threads) :
+        file(filename, std::ios::binary), elements(elements) {
+    if (! file) {
+        throw navitia::exception("impossible to open " + filename);
+    }
+    if (nb_threads == 0) {
+        nb_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    max_in_flight = 2 * nb_threads;
+    for (size_t i = 0; i < nb_threads; ++i) {
+        workers.emplace_back([this]() { this->work(); });
+    }
+}
+
+PbfDecoder::~PbfDecoder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    task_cv.notify_all();
+    for (auto& worker: workers) {
+        worker.join();
+    }
+}
+
+/*
+ * Reads the next OSMData blob of the file, returns false at the end of the file
+ */
+bool PbfDecoder::read_blob(std::string& blob) {
+    while (true) {
+        uint32_t header_size = 0;
+        file.read(reinterpret_cast<char*>(&header_size), sizeof(header_size));
+        if (file.gcount() == 0 && file.eof()) {
+            return false;
+        }
+        if (file.gcount() != sizeof(header_size)) {
+            throw navitia::exception("pbf file truncated");
+        }
+        header_size = ntohl(header_size);
+        if (header_size > max_blob_header_size) {
+            throw navitia::exception("invalid pbf blob header size: " + std::to_string(header_size));
+        }
+        std::string buffer(header_size, '\0');
+        file.read(&buffer[0], header_size);
+        OSMPBF::BlobHeader header;
+        if (uint32_t(file.gcount()) != header_size || ! header.ParseFromString(buffer)) {
+            throw navitia::exception("invalid pbf blob header");
+        }
+        if (header.datasize() < 0 || header.datasize() > max_uncompressed_blob_size) {
+            throw navitia::exception("invalid pbf blob size: " + std::to_string(header.datasize()));
+        }
+        blob.resize(header.datasize());
+        file.read(&blob[0], header.datasize());
+        if (file.gcount() != header.datasize()) {
+            throw navitia::exception("pbf file truncated");
+        }
+        // the OSMHeader blob (and the unknown ones) have no element
+        if (header.type() == "OSMData") {
+            return true;
+        }
+    }
+}
+
+template<typename Group>
+static CanalTP::Tags get_tags(const Group& group, const OSMPBF::StringTable& strings) {
+    CanalTP::Tags tags;
+    for (int i = 0; i < group.keys_size(); ++i) {
+        tags[strings.s(group.keys(i))] = strings.s(group.vals(i));
+    }
+    return tags;
+}
+
+std::unique_ptr<PbfBlock> PbfDecoder::decode(const std::string& raw_blob, const uint8_t elements) {
+    OSMPBF::Blob blob;
+    if (! blob.ParseFromString(raw_blob)) {
+        throw navitia::exception("invalid pbf blob");
+    }
+    std::string inflated;
+    const std::string* data = nullptr;
+    if (blob.has_raw()) {
+        data = &blob.raw();
+    } else if (blob.has_zlib_data()) {
+        if (blob.raw_size() < 0 || blob.raw_size() > max_uncompressed_blob_size) {
+            throw navitia::exception("invalid pbf blob raw size: " + std::to_string(blob.raw_size()));
+        }
+        inflated.resize(blob.raw_size());
+        uLongf size = blob.raw_size();
+        const auto& zlib_data = blob.zlib_data();
+        if (uncompress(reinterpret_cast<Bytef*>(&inflated[0]), &size,
+                       reinterpret_cast<const Bytef*>(zlib_data.data()), zlib_data.size()) != Z_OK
+                || size != uLongf(blob.raw_size())) {
+            throw navitia::exception("impossible to inflate a pbf blob");
+        }
+        data = &inflated;
+    } else {
+        throw navitia::exception("unsupported compression of a pbf blob");
+    }
+
+    OSMPBF::PrimitiveBlock primitive_block;
+    if (! primitive_block.ParseFromString(*data)) {
+        throw navitia::exception("invalid pbf primitive block");
+    }
+    const auto& strings = primitive_block.stringtable();
+    const int64_t granularity = primitive_block.granularity();
+    const int64_t lon_offset = primitive_block.lon_offset();
+    const int64_t lat_offset = primitive_block.lat_offset();
+    const auto lon = [&](int64_t v) { return 1e-9 * (lon_offset + granularity * v); };
+    const auto lat = [&](int64_t v) { return 1e-9 * (lat_offset + granularity * v); };
+    const bool with_node_tags = elements & pbf_node_tags;
+
+    std::unique_ptr<PbfBlock> block(new PbfBlock());
+    for (const auto& group: primitive_block.primitivegroup()) {
+        if (elements & pbf_nodes) {
+            for (const auto& node: group.nodes()) {
+                block->nodes.push_back({uint64_t(node.id()), lon(node.lon()), lat(node.lat()),
+                                        with_node_tags ? get_tags(node, strings) : CanalTP::Tags()});
+            }
+            // dense nodes are delta coded, their tags are (key, val)* 0 for each node
+            const auto& dense = group.dense();
+            int64_t id = 0, ilon = 0, ilat = 0;
+            int kv = 0;
+            for (int i = 0; i < dense.id_size(); ++i) {
+                id += dense.id(i);
+                ilon += dense.lon(i);
+                ilat += dense.lat(i);
+                block->nodes.push_back({uint64_t(id), lon(ilon), lat(ilat), CanalTP::Tags()});
+                for (; kv + 1 < dense.keys_vals_size() && dense.keys_vals(kv) != 0; kv += 2) {
+                    if (with_node_tags) {
+                        block->nodes.back().tags[strings.s(dense.keys_vals(kv))] =
+                            strings.s(dense.keys_vals(kv + 1));
+                    }
+                }
+                ++kv;
+            }
+        }
+        if (elements & pbf_ways) {
+            for (const auto& way: group.ways()) {
+                block->ways.push_back({uint64_t(way.id()), get_tags(way, strings), {}});
+                auto& refs = block->ways.back().refs;
+                refs.reserve(way.refs_size());
+                int64_t ref = 0;
+                for (int i = 0; i < way.refs_size(); ++i) {
+                    ref += way.refs(i);
+                    refs.push_back(uint64_t(ref));
+                }
+            }
+        }
+        if (elements & pbf_relations) {
+            for (const auto& relation: group.relations()) {
+                block->relations.push_back({uint64_t(relation.id()), get_tags(relation, strings), {}});
+                auto& refs = block->relations.back().refs;
+                refs.reserve(relation.memids_size());
+                int64_t member_id = 0;
+                for (int i = 0; i < relation.memids_size(); ++i) {
+                    member_id += relation.memids(i);
+                    refs.push_back(CanalTP::Reference(relation.types(i), uint64_t(member_id),
+                                                      strings.s(relation.roles_sid(i))));
+                }
+            }
+        }
+    }
+    return block;
+}
+
+void PbfDecoder::work() {
+    while (true) {
+        std::pair<size_t, std::string> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            task_cv.wait(lock, [this]() { return stopping || ! tasks.empty(); });
+            if (stopping) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        Result result;
+        try {
+            result.block = decode(task.second, elements);
+        } catch (...) {
+            result.error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            results[task.first] = std::move(result);
+        }
+        result_cv.notify_all();
+    }
+}
+
+std::unique_ptr<PbfBlock> PbfDecoder::next() {
+    while (! eof && nb_read - nb_delivered < max_in_flight) {
+        std::string blob;
+        if (! read_blob(blob)) {
+            eof = true;
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace_back(nb_read, std::move(blob));
+        }
+        ++nb_read;
+        task_cv.notify_one();
+    }
+    if (nb_delivered == nb_read) {
+        return nullptr;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    result_cv.wait(lock, [this]() { return results.count(nb_delivered) > 0; });
+    auto it = results.find(nb_delivered);
+    Result result = std::move(it->second);
+    results.erase(it);
+    ++nb_delivered;
+    if (result.error) {
+        std::rethrow_exception(result.error);
+    }
+    return std::move(result.block);
+}
+
+}}
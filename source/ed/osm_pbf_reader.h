@@ -0,0 +1,157 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include "third_party/osmpbfreader/osmpbfreader.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ed { namespace connectors {
+
+/*
+ * Kinds of OSM elements decoded by a pass on a pbf file.
+ * The elements a pass does not need are not decoded at all, and the tags of
+ * the nodes (the biggest part of a pbf) can be skipped when only the
+ * coordinates are needed.
+ */
+enum PbfElements : uint8_t {
+    pbf_nodes = 1,
+    pbf_node_tags = 2,
+    pbf_ways = 4,
+    pbf_relations = 8,
+    pbf_all = pbf_nodes | pbf_node_tags | pbf_ways | pbf_relations
+};
+
+struct PbfNode {
+    uint64_t osm_id;
+    double lon;
+    double lat;
+    CanalTP::Tags tags;
+};
+
+struct PbfWay {
+    uint64_t osm_id;
+    CanalTP::Tags tags;
+    std::vector<uint64_t> refs;
+};
+
+struct PbfRelation {
+    uint64_t osm_id;
+    CanalTP::Tags tags;
+    CanalTP::References refs;
+};
+
+/*
+ * Elements of a decoded OSMData blob, in the order of the blob for each kind
+ */
+struct PbfBlock {
+    std::vector<PbfNode> nodes;
+    std::vector<PbfWay> ways;
+    std::vector<PbfRelation> relations;
+};
+
+/*
+ * Decodes a pbf file with a pool of threads
+ *
+ * The calling thread reads the blobs from the file, the threads of the pool
+ * inflate and parse them, and next() gives the decoded blocks in the order of
+ * the file. At most 2 blobs by thread are in flight, to bound the memory.
+ */
+struct PbfDecoder {
+    PbfDecoder(const std::string& filename, const uint8_t elements, size_t nb_threads = 0);
+    PbfDecoder(const PbfDecoder&) = delete;
+    PbfDecoder& operator=(const PbfDecoder&) = delete;
+    ~PbfDecoder();
+
+    // the next decoded block, nullptr at the end of the file
+    std::unique_ptr<PbfBlock> next();
+
+    // decodes an OSMData blob, exposed for the tests
+    static std::unique_ptr<PbfBlock> decode(const std::string& blob, const uint8_t elements);
+
+private:
+    struct Result {
+        std::unique_ptr<PbfBlock> block;
+        std::exception_ptr error;
+    };
+
+    bool read_blob(std::string& blob);
+    void work();
+
+    std::ifstream file;
+    const uint8_t elements;
+    size_t max_in_flight;
+    size_t nb_read = 0;
+    size_t nb_delivered = 0;
+    bool eof = false;
+
+    std::mutex mutex;
+    std::condition_variable task_cv;
+    std::condition_variable result_cv;
+    std::deque<std::pair<size_t, std::string>> tasks;
+    std::map<size_t, Result> results;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+/*
+ * Same as CanalTP::read_osm_pbf, but the blobs are decoded by several threads.
+ * The callbacks of the visitor are called by the calling thread, in the order
+ * of the file (for each blob, the nodes, then the ways, then the relations),
+ * so the visitor doesn't need to be thread safe.
+ */
+template<typename Visitor>
+void read_osm_pbf(const std::string& filename, Visitor& visitor,
+                  const uint8_t elements = pbf_all, const size_t nb_threads = 0) {
+    PbfDecoder decoder(filename, elements, nb_threads);
+    while (const auto block = decoder.next()) {
+        for (const auto& node: block->nodes) {
+            visitor.node_callback(node.osm_id, node.lon, node.lat, node.tags);
+        }
+        for (const auto& way: block->ways) {
+            visitor.way_callback(way.osm_id, way.tags, way.refs);
+        }
+        for (const auto& relation: block->relations) {
+            visitor.relation_callback(relation.osm_id, relation.tags, relation.refs);
+        }
+    }
+}
+
+}}
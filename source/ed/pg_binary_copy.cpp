@@ -0,0 +1,92 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "pg_binary_copy.h"
+#include "utils/exception.h"
+
+#include <boost/algorithm/string/join.hpp>
+
+namespace ed {
+
+PgBinaryCopy::PgBinaryCopy(PGconn* connection, const std::string& table,
+                           const std::vector<std::string>& columns, const size_t flush_size) :
+        connection(connection), table(table), flush_size(flush_size), nb_columns(uint16_t(columns.size())) {
+    const std::string request = "COPY " + table + " (" + boost::algorithm::join(columns, ", ")
+        + ") FROM STDIN WITH (FORMAT binary)";
+    PGresult* res = PQexec(connection, request.c_str());
+    const auto status = PQresultStatus(res);
+    PQclear(res);
+    if (status != PGRES_COPY_IN) {
+        throw navitia::exception("impossible to start the copy in " + table + ": "
+                                 + PQerrorMessage(connection));
+    }
+    buffer.reserve(flush_size + flush_size / 2);
+    add_header();
+}
+
+PgBinaryCopy::~PgBinaryCopy() {
+    if (! finished) {
+        // the transaction is in error after that, it will be rollbacked
+        PQputCopyEnd(connection, "copy cancelled");
+        PQclear(PQgetResult(connection));
+    }
+}
+
+void PgBinaryCopy::flush() {
+    if (buffer.empty()) {
+        return;
+    }
+    if (PQputCopyData(connection, buffer.data(), int(buffer.size())) != 1) {
+        throw navitia::exception("impossible to copy data in " + table + ": " + PQerrorMessage(connection));
+    }
+    buffer.clear();
+}
+
+size_t PgBinaryCopy::finish() {
+    add_trailer();
+    flush();
+    finished = true;
+    if (PQputCopyEnd(connection, nullptr) != 1) {
+        throw navitia::exception("impossible to end the copy in " + table + ": " + PQerrorMessage(connection));
+    }
+    PGresult* res = PQgetResult(connection);
+    const auto status = PQresultStatus(res);
+    PQclear(res);
+    // the copy has only one result, but the api needs to be read until a nullptr
+    while ((res = PQgetResult(connection)) != nullptr) {
+        PQclear(res);
+    }
+    if (status != PGRES_COMMAND_OK) {
+        throw navitia::exception("copy in " + table + " failed: " + PQerrorMessage(connection));
+    }
+    return nb_rows;
+}
+
+}
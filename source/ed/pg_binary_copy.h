@@ -0,0 +1,128 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <postgresql/libpq-fe.h>
+
+namespace ed {
+
+/*
+ * Encodes rows in the binary format of the postgres COPY:
+ * for each row the number of fields, then for each field its size (-1 for null)
+ * and its value in network byte order.
+ * The types must be exactly the ones of the columns (int8 for a bigint, int4 for an integer...).
+ *
+ * The buffer is reused between the flushes, so there is no allocation by row.
+ */
+struct PgBinaryEncoder {
+    std::string buffer;
+
+    void start_row(const uint16_t nb_fields) { add_raw(htons(nb_fields)); }
+    void add_null() { add_raw(htonl(uint32_t(-1))); }
+    void add_bool(const bool value) {
+        add_raw(htonl(1));
+        buffer.push_back(value ? 1 : 0);
+    }
+    void add_int2(const int16_t value) {
+        add_raw(htonl(2));
+        add_raw(htons(uint16_t(value)));
+    }
+    void add_int4(const int32_t value) {
+        add_raw(htonl(4));
+        add_raw(htonl(uint32_t(value)));
+    }
+    void add_int8(const int64_t value) {
+        add_raw(htonl(8));
+        add_raw(htonl(uint32_t(uint64_t(value) >> 32)));
+        add_raw(htonl(uint32_t(value)));
+    }
+    void add_text(const std::string& value) {
+        add_raw(htonl(uint32_t(value.size())));
+        buffer.append(value);
+    }
+
+    // the header and the trailer of a binary copy
+    void add_header() {
+        buffer.append("PGCOPY\n\377\r\n\0", 11);
+        add_raw(htonl(0)); // flags
+        add_raw(htonl(0)); // size of the header extension
+    }
+    void add_trailer() { add_raw(htons(uint16_t(-1))); }
+
+private:
+    template<typename T>
+    void add_raw(const T value) {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+};
+
+/*
+ * Bulk insert in a table with COPY ... FROM STDIN (FORMAT binary)
+ *
+ * The rows are encoded with the PgBinaryEncoder methods between start_row() calls,
+ * and sent to postgres each time the buffer is bigger than flush_size.
+ * The copy uses the given connection, so it is in its current transaction.
+ * If finish() is not called (an exception is raised while encoding the rows), the copy is
+ * cancelled by the destructor.
+ */
+struct PgBinaryCopy: PgBinaryEncoder {
+    PgBinaryCopy(PGconn* connection, const std::string& table, const std::vector<std::string>& columns,
+                 const size_t flush_size = 1024 * 1024);
+    PgBinaryCopy(const PgBinaryCopy&) = delete;
+    PgBinaryCopy& operator=(const PgBinaryCopy&) = delete;
+    ~PgBinaryCopy();
+
+    void start_row() {
+        if (buffer.size() >= flush_size) {
+            flush();
+        }
+        PgBinaryEncoder::start_row(nb_columns);
+        ++nb_rows;
+    }
+    // ends the copy, returns the number of inserted rows
+    size_t finish();
+
+private:
+    void flush();
+
+    PGconn* connection;
+    const std::string table;
+    const size_t flush_size;
+    const uint16_t nb_columns;
+    size_t nb_rows = 0;
+    bool finished = false;
+};
+
+}
@@ -34,6 +34,9 @@ www.navitia.io
 #define BOOST_TEST_MODULE test_ed
 #include <boost/test/unit_test.hpp>
 #include <string>
+#include <fstream>
+#include <tuple>
+#include <boost/algorithm/string.hpp>
 #include "conf.h"
 #include "ed/build_helper.h"
 #include "utils/csv.h"
@@ -915,3 +918,57 @@ BOOST_AUTO_TEST_CASE(parse_gtfs_revision_201502){
     BOOST_CHECK_EQUAL(data.vehicle_journeys[0]->accessible(has_vehicleproperties.vehicles()), true);
 }
 
+
+/*
+ * the stop times are parsed by several threads, the result must not depend on their number
+ */
+BOOST_AUTO_TEST_CASE(parallel_stop_times_parsing) {
+    const std::string path = std::string(navitia::config::fixtures_dir) + gtfs_path + "_google_example_no_dst";
+
+    // the stop times of the fixture copied many times, with other stop_sequence
+    std::stringstream content;
+    std::ifstream file(path + "/stop_times.txt");
+    std::string header, line;
+    std::getline(file, header);
+    std::vector<std::vector<std::string>> lines;
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields;
+        boost::algorithm::split(fields, line, boost::is_any_of(","));
+        lines.push_back(fields);
+    }
+    content << header << "\n";
+    const size_t nb_copies = 50;
+    for (size_t i = 1; i <= nb_copies; ++i) {
+        for (auto fields: lines) {
+            fields[4] = std::to_string(i * 100 + std::stoi(fields[4]));
+            content << boost::algorithm::join(fields, ",") << "\n";
+        }
+    }
+
+    using stop_time_desc = std::tuple<size_t, std::string, std::string, int, int, int>;
+    auto parse = [&](size_t nb_threads) {
+        ed::Data data;
+        ed::connectors::GtfsParser parser(path);
+        parser.fill(data);
+        const size_t nb_stops = data.stops.size();
+        std::stringstream sstream(content.str());
+        ed::connectors::FileParser<ed::connectors::StopTimeGtfsHandler> file_parser(parser.gtfs_data, sstream);
+        file_parser.nb_threads = nb_threads;
+        file_parser.fill(data);
+
+        std::vector<stop_time_desc> res;
+        for (size_t i = nb_stops; i < data.stops.size(); ++i) {
+            const auto* st = data.stops[i];
+            BOOST_CHECK_EQUAL(st->idx, i);
+            res.emplace_back(st->idx, st->vehicle_journey->uri, st->stop_point->uri,
+                             st->order, st->arrival_time, st->departure_time);
+        }
+        return res;
+    };
+    const auto sequential = parse(1);
+    BOOST_REQUIRE_EQUAL(sequential.size(), nb_copies * lines.size());
+    for (size_t nb_threads: {2, 3, 8}) {
+        const auto parallel = parse(nb_threads);
+        BOOST_CHECK(parallel == sequential);
+    }
+}
@@ -0,0 +1,133 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_ed
+#include <boost/test/unit_test.hpp>
+#include "ed/connectors/mmap_csv_reader.h"
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+using ed::connectors::MmapCsvReader;
+
+static std::vector<std::string> to_strings(const MmapCsvReader::row_type& row) {
+    std::vector<std::string> res;
+    for (const auto& field: row) { res.push_back(field.to_string()); }
+    return res;
+}
+
+#define CHECK_ROW(row, ...) { \
+    const std::vector<std::string> expected = __VA_ARGS__; \
+    const auto fields = to_strings(row); \
+    BOOST_CHECK_EQUAL_COLLECTIONS(fields.begin(), fields.end(), expected.begin(), expected.end()); \
+}
+
+BOOST_AUTO_TEST_CASE(mmap_csv_headers) {
+    std::stringstream ss;
+    ss << "\xEF\xBB\xBFtrip_id, stop_id ,stop_sequence\r\nt1,sp1,1\r\n";
+    MmapCsvReader reader(ss, ',', true);
+    BOOST_CHECK(reader.is_open());
+    BOOST_CHECK_EQUAL(reader.get_pos_col("trip_id"), 0);
+    BOOST_CHECK_EQUAL(reader.get_pos_col("stop_id"), 1);
+    BOOST_CHECK_EQUAL(reader.get_pos_col("stop_sequence"), 2);
+    BOOST_CHECK_EQUAL(reader.get_pos_col("pickup_type"), -1);
+    BOOST_CHECK(reader.validate({"trip_id", "stop_id"}));
+    BOOST_CHECK(! reader.validate({"trip_id", "arrival_time"}));
+    BOOST_CHECK_EQUAL(reader.missing_headers({"trip_id", "arrival_time"}), "arrival_time, ");
+
+    CHECK_ROW(reader.next(), {"t1", "sp1", "1"});
+    BOOST_CHECK(reader.eof());
+    BOOST_CHECK(reader.next().empty());
+}
+
+BOOST_AUTO_TEST_CASE(mmap_csv_fields) {
+    std::stringstream ss;
+    ss << "a,,c\n"
+       << "\n"
+       << "\"with,separator\",\"with \"\"quotes\"\"\",\"multi\nline\"\n"
+       << "a very long field to be scanned by more than one block,b,\n"
+       << "last";
+    MmapCsvReader reader(ss);
+    CHECK_ROW(reader.next(), {"a", "", "c"});
+    BOOST_CHECK(reader.next().empty());
+    CHECK_ROW(reader.next(), {"with,separator", "with \"quotes\"", "multi\nline"});
+    CHECK_ROW(reader.next(), {"a very long field to be scanned by more than one block", "b", ""});
+    CHECK_ROW(reader.next(), {"last"});
+    BOOST_CHECK(reader.eof());
+}
+
+BOOST_AUTO_TEST_CASE(mmap_csv_file) {
+    const auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    {
+        std::ofstream file(path.string());
+        file << "route_id,service_id,trip_id\n"
+             << "r1,s1,t1\n"
+             << "r1,s2,t2\n";
+    }
+    {
+        MmapCsvReader reader(path.string(), ',', true);
+        BOOST_REQUIRE(reader.is_open());
+        BOOST_CHECK_EQUAL(reader.get_pos_col("trip_id"), 2);
+        CHECK_ROW(reader.next(), {"r1", "s1", "t1"});
+        CHECK_ROW(reader.next(), {"r1", "s2", "t2"});
+        BOOST_CHECK(reader.eof());
+    }
+    boost::filesystem::remove(path);
+
+    MmapCsvReader missing(path.string(), ',', true);
+    BOOST_CHECK(! missing.is_open());
+    BOOST_CHECK(missing.eof());
+}
+
+// the chunks are cut at the end of a row, a quote only opens a field at its start
+BOOST_AUTO_TEST_CASE(mmap_csv_split) {
+    std::stringstream ss;
+    ss << "trip_id,stop_id,stop_sequence\n";
+    std::vector<std::vector<std::string>> expected;
+    for (int i = 0; i < 100; ++i) {
+        const auto nb = std::to_string(i);
+        ss << "t" << nb << ",s\"p" << nb << "," << nb << "\n"
+           << "\"t" << nb << "\n\"\"\",\"sp,\"" << nb << "," << nb << "\n";
+        expected.push_back({"t" + nb, "s\"p" + nb, nb});
+        expected.push_back({"t" + nb + "\n\"", "sp,", nb});
+    }
+    for (const size_t nb_chunks: {1, 2, 7, 50, 1000}) {
+        std::stringstream copy(ss.str());
+        MmapCsvReader reader(copy, ',', true);
+        std::vector<std::vector<std::string>> rows;
+        for (auto& chunk: reader.split(nb_chunks)) {
+            while (! chunk.eof()) {
+                const auto& row = chunk.next();
+                if (! row.empty()) { rows.push_back(to_strings(row)); }
+            }
+        }
+        BOOST_CHECK(rows == expected);
+    }
+}
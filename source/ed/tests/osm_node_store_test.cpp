@@ -0,0 +1,112 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_ed
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include "ed/osm_node_store.h"
+
+using ed::connectors::OSMNodeStore;
+
+/*
+ * The flags must be the same as with a std::set<OSMNode>: a node is used more than once
+ * if a street uses it after a first use (by a relation, a way or a street)
+ */
+BOOST_AUTO_TEST_CASE(node_store_flags) {
+    // tiny buffer to test the merges
+    OSMNodeStore store(2);
+    store.add(42);         // admin centre
+    store.add(10, true);   // street
+    store.add(42, true);   // street using the admin centre
+    store.add(11, false);  // poi way
+    store.add(11, true);   // street using a node of the poi
+    store.add(12, true);   // street
+    store.add(12, false);  // poi using a node of a street
+    store.add(13, true);
+    store.add(13, true);   // same street twice
+    store.add(10, false);
+    store.finalize();
+
+    BOOST_REQUIRE_EQUAL(store.size(), 5);
+    BOOST_CHECK_EQUAL(store.find(9), OSMNodeStore::npos);
+    BOOST_CHECK_EQUAL(store.find(43), OSMNodeStore::npos);
+    const auto n10 = store.find(10), n11 = store.find(11), n12 = store.find(12),
+               n13 = store.find(13), n42 = store.find(42);
+    BOOST_CHECK_EQUAL(store.osm_id(n10), 10);
+    BOOST_CHECK_EQUAL(store.osm_id(n42), 42);
+    BOOST_CHECK(n10 < n11 && n11 < n12 && n12 < n13 && n13 < n42);
+
+    BOOST_CHECK(! store.is_used_more_than_once(n10));
+    BOOST_CHECK(store.is_used_more_than_once(n11));
+    BOOST_CHECK(! store.is_used_more_than_once(n12));
+    BOOST_CHECK(store.is_used_more_than_once(n13));
+    BOOST_CHECK(store.is_used_more_than_once(n42));
+
+    BOOST_CHECK(! store.is_used(n10));
+    store.set_first_or_last(n10);
+    BOOST_CHECK(store.is_first_or_last(n10));
+    BOOST_CHECK(store.is_used(n10));
+    BOOST_CHECK(! store.is_used_more_than_once(n10));
+
+    BOOST_CHECK_THROW(store.add(14), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(node_store_coords_and_spill) {
+    OSMNodeStore store;
+    for (uint64_t id = 1000; id > 0; --id) {
+        store.add(id * 3);
+    }
+    store.finalize();
+    BOOST_REQUIRE_EQUAL(store.size(), 1000);
+
+    const auto node = store.find(300);
+    BOOST_REQUIRE(node != OSMNodeStore::npos);
+    BOOST_CHECK(! store.is_defined(node));
+    store.set_coord(node, 2.37, 48.84);
+    BOOST_CHECK(store.is_defined(node));
+    BOOST_CHECK_CLOSE(store.lon(node), 2.37, 0.0001);
+    BOOST_CHECK_CLOSE(store.lat(node), 48.84, 0.0001);
+    store.set_coord(store.find(303), 2.370001, 48.840001);
+    BOOST_CHECK(store.almost_equal(node, store.find(303)));
+    store.set_coord(store.find(306), 2.38, 48.84);
+    BOOST_CHECK(! store.almost_equal(node, store.find(306)));
+
+    const auto memory = store.memory_footprint();
+    store.spill(boost::filesystem::temp_directory_path().string());
+    BOOST_CHECK(store.memory_footprint() < memory);
+    // the data are still there and can be modified
+    BOOST_CHECK_EQUAL(store.find(300), node);
+    BOOST_CHECK_EQUAL(store.osm_id(store.find(3000)), 3000);
+    BOOST_CHECK_CLOSE(store.lon(node), 2.37, 0.0001);
+    store.set_coord(node, 2.5, 48.5);
+    BOOST_CHECK_CLOSE(store.lat(node), 48.5, 0.0001);
+    BOOST_CHECK(store.admin(node) == nullptr);
+}
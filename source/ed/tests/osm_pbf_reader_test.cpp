@@ -0,0 +1,231 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_ed
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include "ed/osm_pbf_reader.h"
+#include "utils/exception.h"
+
+#include <arpa/inet.h>
+#include <zlib.h>
+
+namespace ec = ed::connectors;
+
+namespace {
+
+struct RecordingVisitor {
+    std::vector<std::string> calls;
+    std::vector<ec::PbfNode> nodes;
+    std::vector<ec::PbfWay> ways;
+    std::vector<ec::PbfRelation> relations;
+
+    void node_callback(uint64_t osm_id, double lon, double lat, const CanalTP::Tags& tags) {
+        calls.push_back("n" + std::to_string(osm_id));
+        nodes.push_back({osm_id, lon, lat, tags});
+    }
+    void way_callback(uint64_t osm_id, const CanalTP::Tags& tags, const std::vector<uint64_t>& refs) {
+        calls.push_back("w" + std::to_string(osm_id));
+        ways.push_back({osm_id, tags, refs});
+    }
+    void relation_callback(uint64_t osm_id, const CanalTP::Tags& tags, const CanalTP::References& refs) {
+        calls.push_back("r" + std::to_string(osm_id));
+        relations.push_back({osm_id, tags, refs});
+    }
+};
+
+void write_blob(std::ofstream& out, const std::string& type, const std::string& data, const bool compressed) {
+    OSMPBF::Blob blob;
+    if (compressed) {
+        std::string zlib_data(compressBound(data.size()), '\0');
+        uLongf size = zlib_data.size();
+        BOOST_REQUIRE_EQUAL(compress(reinterpret_cast<Bytef*>(&zlib_data[0]), &size,
+                                     reinterpret_cast<const Bytef*>(data.data()), data.size()), Z_OK);
+        zlib_data.resize(size);
+        blob.set_zlib_data(zlib_data);
+        blob.set_raw_size(data.size());
+    } else {
+        blob.set_raw(data);
+    }
+    const std::string blob_data = blob.SerializeAsString();
+    OSMPBF::BlobHeader header;
+    header.set_type(type);
+    header.set_datasize(blob_data.size());
+    const std::string header_data = header.SerializeAsString();
+    const uint32_t header_size = htonl(header_data.size());
+    out.write(reinterpret_cast<const char*>(&header_size), sizeof(header_size));
+    out << header_data << blob_data;
+}
+
+/*
+ * A block with 3 dense nodes starting at first_id (the second one is tagged),
+ * a way on these nodes and a relation on the way and the first node
+ */
+std::string make_block(const int64_t first_id) {
+    OSMPBF::PrimitiveBlock block;
+    auto* strings = block.mutable_stringtable();
+    for (const auto& s: {"", "highway", "primary", "type", "boundary", "outer", "admin_centre"}) {
+        strings->add_s(s);
+    }
+    block.set_granularity(100);
+    block.set_lon_offset(1000);
+
+    auto* dense = block.add_primitivegroup()->mutable_dense();
+    int64_t prev_id = 0, prev_lon = 0, prev_lat = 0;
+    for (int64_t i = 0; i < 3; ++i) {
+        const int64_t id = first_id + i, lon = 20000000 + i * 1000, lat = 48000000 - i;
+        dense->add_id(id - prev_id);
+        dense->add_lon(lon - prev_lon);
+        dense->add_lat(lat - prev_lat);
+        prev_id = id; prev_lon = lon; prev_lat = lat;
+        if (i == 1) {
+            dense->add_keys_vals(1);
+            dense->add_keys_vals(2);
+        }
+        dense->add_keys_vals(0);
+    }
+
+    auto* way = block.add_primitivegroup()->add_ways();
+    way->set_id(first_id);
+    way->add_keys(1);
+    way->add_vals(2);
+    int64_t prev_ref = 0;
+    for (int64_t ref: {first_id + 2, first_id, first_id + 1}) {
+        way->add_refs(ref - prev_ref);
+        prev_ref = ref;
+    }
+
+    auto* relation = block.add_primitivegroup()->add_relations();
+    relation->set_id(first_id);
+    relation->add_keys(3);
+    relation->add_vals(4);
+    relation->add_memids(first_id);
+    relation->add_types(OSMPBF::Relation::WAY);
+    relation->add_roles_sid(5);
+    relation->add_memids(0);
+    relation->add_types(OSMPBF::Relation::NODE);
+    relation->add_roles_sid(6);
+    return block.SerializeAsString();
+}
+
+struct PbfFixture {
+    const std::string filename = (boost::filesystem::temp_directory_path()
+                                  / boost::filesystem::unique_path("%%%%-%%%%.osm.pbf")).string();
+    const size_t nb_blocks = 20;
+    PbfFixture() {
+        std::ofstream out(filename, std::ios::binary);
+        write_blob(out, "OSMHeader", OSMPBF::HeaderBlock().SerializeAsString(), true);
+        for (size_t i = 0; i < nb_blocks; ++i) {
+            write_blob(out, "OSMData", make_block(100 * (i + 1)), i % 2 == 0);
+        }
+    }
+    ~PbfFixture() { boost::filesystem::remove(filename); }
+};
+
+}
+
+/*
+ * whatever the number of threads, the callbacks are called in the order of the file
+ */
+BOOST_FIXTURE_TEST_CASE(pbf_callbacks_in_file_order, PbfFixture) {
+    for (size_t nb_threads: {1, 4}) {
+        RecordingVisitor visitor;
+        ec::read_osm_pbf(filename, visitor, ec::pbf_all, nb_threads);
+
+        BOOST_REQUIRE_EQUAL(visitor.calls.size(), nb_blocks * 5);
+        for (size_t i = 0; i < nb_blocks; ++i) {
+            const auto id = std::to_string(100 * (i + 1));
+            const auto id1 = std::to_string(100 * (i + 1) + 1);
+            const auto id2 = std::to_string(100 * (i + 1) + 2);
+            BOOST_CHECK_EQUAL(visitor.calls[5 * i], "n" + id);
+            BOOST_CHECK_EQUAL(visitor.calls[5 * i + 1], "n" + id1);
+            BOOST_CHECK_EQUAL(visitor.calls[5 * i + 2], "n" + id2);
+            BOOST_CHECK_EQUAL(visitor.calls[5 * i + 3], "w" + id);
+            BOOST_CHECK_EQUAL(visitor.calls[5 * i + 4], "r" + id);
+        }
+
+        const auto& node = visitor.nodes[1];
+        BOOST_CHECK_CLOSE(node.lon, 2.000101, 1e-6);
+        BOOST_CHECK_CLOSE(node.lat, 4.7999999, 1e-6);
+        BOOST_REQUIRE_EQUAL(node.tags.size(), 1);
+        BOOST_CHECK_EQUAL(node.tags.at("highway"), "primary");
+        BOOST_CHECK(visitor.nodes[0].tags.empty());
+        BOOST_CHECK(visitor.nodes[2].tags.empty());
+
+        const auto& way = visitor.ways[0];
+        BOOST_CHECK_EQUAL(way.tags.at("highway"), "primary");
+        BOOST_CHECK((way.refs == std::vector<uint64_t>{102, 100, 101}));
+
+        const auto& relation = visitor.relations[0];
+        BOOST_CHECK_EQUAL(relation.tags.at("type"), "boundary");
+        BOOST_REQUIRE_EQUAL(relation.refs.size(), 2);
+        BOOST_CHECK_EQUAL(relation.refs[0].member_type, OSMPBF::Relation::WAY);
+        BOOST_CHECK_EQUAL(relation.refs[0].member_id, 100);
+        BOOST_CHECK_EQUAL(relation.refs[0].role, "outer");
+        BOOST_CHECK_EQUAL(relation.refs[1].member_type, OSMPBF::Relation::NODE);
+        BOOST_CHECK_EQUAL(relation.refs[1].member_id, 100);
+        BOOST_CHECK_EQUAL(relation.refs[1].role, "admin_centre");
+    }
+}
+
+/*
+ * the elements not needed by a pass are not decoded
+ */
+BOOST_FIXTURE_TEST_CASE(pbf_elements_filter, PbfFixture) {
+    RecordingVisitor relations_visitor;
+    ec::read_osm_pbf(filename, relations_visitor, ec::pbf_relations, 2);
+    BOOST_CHECK(relations_visitor.nodes.empty());
+    BOOST_CHECK(relations_visitor.ways.empty());
+    BOOST_CHECK_EQUAL(relations_visitor.relations.size(), nb_blocks);
+
+    RecordingVisitor nodes_visitor;
+    ec::read_osm_pbf(filename, nodes_visitor, ec::pbf_nodes, 2);
+    BOOST_CHECK_EQUAL(nodes_visitor.nodes.size(), nb_blocks * 3);
+    BOOST_CHECK(nodes_visitor.ways.empty());
+    BOOST_CHECK(nodes_visitor.relations.empty());
+    for (const auto& node: nodes_visitor.nodes) {
+        BOOST_CHECK(node.tags.empty());
+    }
+    BOOST_CHECK_CLOSE(nodes_visitor.nodes[1].lon, 2.000101, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(pbf_invalid_file) {
+    const auto filename = (boost::filesystem::temp_directory_path()
+                           / boost::filesystem::unique_path("%%%%-%%%%.osm.pbf")).string();
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << "not a pbf file";
+    }
+    RecordingVisitor visitor;
+    BOOST_CHECK_THROW(ec::read_osm_pbf(filename, visitor), navitia::exception);
+    boost::filesystem::remove(filename);
+    BOOST_CHECK_THROW(ec::read_osm_pbf(filename, visitor), navitia::exception);
+}
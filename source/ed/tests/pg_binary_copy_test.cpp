@@ -0,0 +1,69 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_ed
+#include <boost/test/unit_test.hpp>
+#include "ed/pg_binary_copy.h"
+
+static std::string bytes(std::initializer_list<int> l) {
+    std::string res;
+    for (auto c: l) { res.push_back(char(c)); }
+    return res;
+}
+
+BOOST_AUTO_TEST_CASE(binary_copy_header_and_trailer) {
+    ed::PgBinaryEncoder encoder;
+    encoder.add_header();
+    BOOST_CHECK_EQUAL(encoder.buffer, std::string("PGCOPY\n\377\r\n\0", 11) + bytes({0, 0, 0, 0, 0, 0, 0, 0}));
+    encoder.buffer.clear();
+    encoder.add_trailer();
+    BOOST_CHECK_EQUAL(encoder.buffer, bytes({0xff, 0xff}));
+}
+
+BOOST_AUTO_TEST_CASE(binary_copy_row) {
+    ed::PgBinaryEncoder encoder;
+    encoder.start_row(6);
+    encoder.add_int8(0x0102030405060708);
+    encoder.add_int4(-2);
+    encoder.add_int2(258);
+    encoder.add_bool(true);
+    encoder.add_null();
+    encoder.add_text("bob");
+
+    const auto expected = bytes({0, 6,
+                                 0, 0, 0, 8, 1, 2, 3, 4, 5, 6, 7, 8,
+                                 0, 0, 0, 4, 0xff, 0xff, 0xff, 0xfe,
+                                 0, 0, 0, 2, 1, 2,
+                                 0, 0, 0, 1, 1,
+                                 0xff, 0xff, 0xff, 0xff,
+                                 0, 0, 0, 3, 'b', 'o', 'b'});
+    BOOST_CHECK_EQUAL(encoder.buffer, expected);
+}
@@ -285,3 +285,57 @@ BOOST_AUTO_TEST_CASE(shift_after_freq) {
     BOOST_CHECK_EQUAL(vj->start_time, 0);
     BOOST_CHECK_EQUAL(vj->end_time, 1000);
 }
+
+// the vjs shifted on the same days must share the same validity pattern,
+// even when the beginning date of the validity patterns has been changed
+BOOST_AUTO_TEST_CASE(shift_share_validity_patterns) {
+    ed::Data d;
+    d.meta.production_date = {boost::gregorian::date(2014, 10, 9), boost::gregorian::date(2015, 10, 9)};
+    auto make_vp = [&](const std::vector<boost::gregorian::date>& dates) {
+        auto vp = new ed::types::ValidityPattern();
+        vp->beginning_date = d.meta.production_date.begin();
+        for (const auto& date: dates) { vp->add(date); }
+        d.validity_patterns.push_back(vp);
+        return vp;
+    };
+    auto add_vj = [&](ed::types::ValidityPattern* vp, int departure) {
+        auto vj = new ed::types::VehicleJourney();
+        vj->uri = "vj:" + std::to_string(d.vehicle_journeys.size());
+        vj->validity_pattern = vp;
+        d.vehicle_journeys.push_back(vj);
+        auto st = new ed::types::StopTime();
+        vj->stop_time_list.push_back(st);
+        st->arrival_time = departure;
+        st->departure_time = departure;
+        st->alighting_time = departure;
+        st->boarding_time = departure;
+        return vj;
+    };
+    auto vp = make_vp({boost::gregorian::date(2014, 10, 9), boost::gregorian::date(2014, 10, 10)});
+    auto shifted_vp = make_vp({boost::gregorian::date(2014, 10, 10), boost::gregorian::date(2014, 10, 11)});
+    auto first_day_vp = make_vp({boost::gregorian::date(2014, 10, 9)});
+
+    // this one changes the beginning date of all the validity patterns
+    auto first_day_vj = add_vj(first_day_vp, -50000);
+    std::vector<ed::types::VehicleJourney*> vjs;
+    for (int i = 0; i < 3; ++i) {
+        vjs.push_back(add_vj(shifted_vp, -50000));
+        vjs.push_back(add_vj(vp, 50000));
+    }
+
+    d.shift_stop_times();
+
+    BOOST_CHECK_EQUAL(d.validity_patterns.size(), 4);
+    BOOST_CHECK_EQUAL(first_day_vj->validity_pattern->beginning_date, boost::gregorian::date(2014, 10, 8));
+    BOOST_CHECK(first_day_vj->validity_pattern->check(boost::gregorian::date(2014, 10, 8)));
+    BOOST_CHECK(!first_day_vj->validity_pattern->check(boost::gregorian::date(2014, 10, 9)));
+    // the shifted vjs now run on the days of the other vjs
+    for (const auto* vj: vjs) {
+        BOOST_CHECK_EQUAL(vj->validity_pattern, vp);
+    }
+    BOOST_CHECK_EQUAL(vp->beginning_date, boost::gregorian::date(2014, 10, 8));
+    BOOST_CHECK(!vp->check(boost::gregorian::date(2014, 10, 8)));
+    BOOST_CHECK(vp->check(boost::gregorian::date(2014, 10, 9)));
+    BOOST_CHECK(vp->check(boost::gregorian::date(2014, 10, 10)));
+    BOOST_CHECK(!vp->check(boost::gregorian::date(2014, 10, 11)));
+}
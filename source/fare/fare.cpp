@@ -32,8 +32,12 @@ www.navitia.io
 
 #include <boost/foreach.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/algorithm/cxx11/any_of.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/optional.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <unordered_map>
+#include <tuple>
 
 #include "type/datetime.h"
 
@@ -125,121 +129,497 @@ std::string comp_to_string(const Comp_e comp) {
     }
 }
 
-results Fare::compute_fare(const routing::Path& path) const {
+template<class T> bool compare(const T& a, const T& b, Comp_e comp);
+
+/*
+ * The fare graph compiled for compute_fare
+ *
+ * The states and the transitions are checked again and again for each section of
+ * each journey. They are compiled once: the strings compared case insensitively are
+ * upper cased, the numbers of the conditions are parsed and the tickets are resolved
+ * in the fare_map. The transitions are indexed by the mode of their target state, so
+ * for a section only the transitions towards a state accepting it are looked at.
+ */
+struct CompiledFare {
+    typedef Fare::vertex_t vertex_t;
+
+    /// network, mode and line of a section, upper cased
+    struct Features {
+        std::string network;
+        std::string mode;
+        std::string line;
+
+        Features() {}
+        explicit Features(const SectionKey& section):
+            network(boost::to_upper_copy(section.network)),
+            mode(boost::to_upper_copy(section.mode)),
+            line(boost::to_upper_copy(section.line)) {}
+    };
+
+    struct StateFilter {
+        // upper cased, empty if the state accepts any value
+        std::string mode;
+        std::string network;
+        std::string line;
+        std::string ticket;
+
+        explicit StateFilter(const State& state):
+            mode(boost::to_upper_copy(state.mode)),
+            network(boost::to_upper_copy(state.network)),
+            line(boost::to_upper_copy(state.line)),
+            ticket(state.ticket) {}
+
+        bool accepts(const Features& features) const {
+            return (mode.empty() || mode == features.mode)
+                && (network.empty() || network == features.network)
+                && (line.empty() || line == features.line);
+        }
+    };
+
+    struct ConditionCheck {
+        enum class Kind { zone, stop_area, duration, nb_changes, ticket, ignored };
+        Kind kind = Kind::ignored;
+        Comp_e comparaison = Comp_e::True;
+        std::string value; // upper cased for the stop areas
+        int number = 0; // duration in seconds or number of changes
+    };
+
+    struct CompiledTransition {
+        vertex_t source;
+        vertex_t target;
+        const Transition* transition;
+        // nullptr if the ticket is not in the fare_map
+        const DateTicket* date_ticket = nullptr;
+        std::vector<ConditionCheck> start_checks;
+        std::vector<ConditionCheck> end_checks;
+        // a condition cannot be compiled, Transition::valid is used
+        bool not_compiled = false;
+
+        bool valid(const SectionKey& section, const std::string& start_stop_area,
+                   const std::string& dest_stop_area, const Label& label) const;
+    };
+
+    std::vector<StateFilter> states;
+    // in the order of boost::edges, the order in which the labels were always built
+    std::vector<CompiledTransition> transitions;
+    std::vector<std::vector<size_t>> transitions_by_target;
+    std::unordered_map<std::string, std::vector<vertex_t>> targets_by_mode;
+    std::vector<vertex_t> targets_of_any_mode;
+    // a duration is checked on a transition leaving the start label, whose start_time is 0:
+    // the fare then depends on the time of the day of the first section
+    bool reads_time_of_day = false;
+
+    explicit CompiledFare(const Fare& fare);
+
+    /// the transitions towards a state accepting the section, in the order of the graph
+    std::vector<const CompiledTransition*> transitions_towards(const Features& section) const;
+
+    /// the source state of a transition accepts the label, the labels being all
+    /// built on the section with the given features
+    bool accepts(vertex_t source, const Features& label_features, const Label& label) const;
+};
+
+static CompiledFare::ConditionCheck compile_condition(const Condition& cond, bool is_start_condition) {
+    CompiledFare::ConditionCheck check;
+    check.comparaison = cond.comparaison;
+    check.value = cond.value;
+    if (cond.key == "zone") {
+        check.kind = CompiledFare::ConditionCheck::Kind::zone;
+    } else if (cond.key == "stoparea") {
+        check.kind = CompiledFare::ConditionCheck::Kind::stop_area;
+        check.value = boost::to_upper_copy(cond.value);
+    } else if (cond.key == "duration") {
+        check.kind = CompiledFare::ConditionCheck::Kind::duration;
+        // Dans le fichier CSV, on rentre le temps en minutes, en interne on travaille en secondes
+        check.number = boost::lexical_cast<int>(cond.value) * 60;
+    } else if (is_start_condition && cond.key == "nb_changes") {
+        check.kind = CompiledFare::ConditionCheck::Kind::nb_changes;
+        check.number = boost::lexical_cast<int>(cond.value);
+    } else if (is_start_condition && cond.key == "ticket") {
+        check.kind = CompiledFare::ConditionCheck::Kind::ticket;
+    }
+    return check;
+}
+
+CompiledFare::CompiledFare(const Fare& fare) {
+    const auto& g = fare.g;
+    for (vertex_t v = 0; v < boost::num_vertices(g); ++v) {
+        states.emplace_back(g[v]);
+        if (states.back().mode.empty()) {
+            targets_of_any_mode.push_back(v);
+        } else {
+            targets_by_mode[states.back().mode].push_back(v);
+        }
+    }
+    transitions_by_target.resize(states.size());
+    BOOST_FOREACH(Fare::edge_t e, boost::edges(g)) {
+        CompiledTransition compiled;
+        compiled.source = boost::source(e, g);
+        compiled.target = boost::target(e, g);
+        compiled.transition = &g[e];
+        if (! compiled.transition->ticket_key.empty()) {
+            const auto it = fare.fare_map.find(compiled.transition->ticket_key);
+            if (it != fare.fare_map.end()) { compiled.date_ticket = &it->second; }
+        }
+        try {
+            for (const auto& cond: compiled.transition->start_conditions) {
+                compiled.start_checks.push_back(compile_condition(cond, true));
+            }
+            for (const auto& cond: compiled.transition->end_conditions) {
+                compiled.end_checks.push_back(compile_condition(cond, false));
+            }
+        } catch (const boost::bad_lexical_cast&) {
+            compiled.not_compiled = true;
+        }
+        if (compiled.source == fare.begin_v) {
+            const auto is_duration = [](const ConditionCheck& check) {
+                return check.kind == ConditionCheck::Kind::duration;
+            };
+            reads_time_of_day = reads_time_of_day || compiled.not_compiled
+                || boost::algorithm::any_of(compiled.start_checks, is_duration)
+                || boost::algorithm::any_of(compiled.end_checks, is_duration);
+        }
+        transitions_by_target[compiled.target].push_back(transitions.size());
+        transitions.push_back(std::move(compiled));
+    }
+}
+
+std::vector<const CompiledFare::CompiledTransition*>
+CompiledFare::transitions_towards(const Features& section) const {
+    std::vector<size_t> idx;
+    auto add_target = [&](vertex_t v) {
+        if (! states[v].accepts(section)) { return; }
+        idx.insert(idx.end(), transitions_by_target[v].begin(), transitions_by_target[v].end());
+    };
+    for (const auto v: targets_of_any_mode) { add_target(v); }
+    const auto it = targets_by_mode.find(section.mode);
+    if (it != targets_by_mode.end()) {
+        for (const auto v: it->second) { add_target(v); }
+    }
+    std::sort(idx.begin(), idx.end());
+
+    std::vector<const CompiledTransition*> res;
+    res.reserve(idx.size());
+    for (const auto i: idx) { res.push_back(&transitions[i]); }
+    return res;
+}
+
+bool CompiledFare::accepts(vertex_t source, const Features& label_features, const Label& label) const {
+    const auto& state = states[source];
+    if (! state.accepts(label_features)) { return false; }
+    if (state.ticket.empty()) { return true; }
+    return ! label.tickets.empty() && boost::iequals(state.ticket, label.tickets.back().caption);
+}
+
+bool CompiledFare::CompiledTransition::valid(const SectionKey& section,
+                                             const std::string& start_stop_area,
+                                             const std::string& dest_stop_area,
+                                             const Label& label) const {
+    if (not_compiled) { return transition->valid(section, label); }
+
+    if (label.tickets.size() == 0 && transition->ticket_key == ""
+            && transition->global_condition != Transition::GlobalCondition::with_changes) {
+        return false;
+    }
+    if (label.current_type == Ticket::ODFare
+            && transition->global_condition != Transition::GlobalCondition::with_changes) {
+        return false;
+    }
+    using Kind = ConditionCheck::Kind;
+    for (const auto& check: start_checks) {
+        switch (check.kind) {
+        case Kind::zone:
+            if (check.value != section.start_zone) { return false; }
+            break;
+        case Kind::stop_area:
+            if (check.value != start_stop_area) { return false; }
+            break;
+        case Kind::duration:
+            if (! compare(section.duration_at_begin(label.start_time), check.number, check.comparaison)) {
+                return false;
+            }
+            break;
+        case Kind::nb_changes:
+            if (! compare(label.nb_changes, check.number, check.comparaison)) { return false; }
+            break;
+        case Kind::ticket:
+            if (label.tickets.size() > 0) {
+                if (! compare(label.tickets.back().key, check.value, check.comparaison)) { return false; }
+            }
+            break;
+        case Kind::ignored:
+            break;
+        }
+    }
+    for (const auto& check: end_checks) {
+        switch (check.kind) {
+        case Kind::zone:
+            if (check.value != section.dest_zone) { return false; }
+            break;
+        case Kind::stop_area:
+            if (check.value != dest_stop_area) { return false; }
+            break;
+        case Kind::duration:
+            if (! compare(section.duration_at_end(label.start_time), check.number, check.comparaison)) {
+                return false;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<const CompiledFare> CompiledFareCache::get(const Fare& fare) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (! compiled) {
+        const auto start = boost::posix_time::microsec_clock::universal_time();
+        compiled = std::make_shared<const CompiledFare>(fare);
+        LOG4CPLUS_INFO(log4cplus::Logger::getInstance("log"), "fare graph compiled ("
+                       << compiled->transitions.size() << " transitions) in "
+                       << (boost::posix_time::microsec_clock::universal_time() - start).total_milliseconds()
+                       << "ms");
+    }
+    return compiled;
+}
+
+void CompiledFareCache::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    compiled.reset();
+}
+
+// the result of the cheapest label
+// if 2 label have the same cost, we take the one with the least number of tickets
+static results best_result(const std::vector<Label>& labels) {
     results res;
+    boost::optional<Label> best_label;
+    for(const Label& label : labels) {
+        if(!best_label || label < (*best_label)) {
+            res.tickets = label.tickets;
+            res.not_found = (label.nb_undefined_sub_cost != 0);
+            res.total = label.cost;
+            best_label = label;
+        }
+    }
+    return res;
+}
+
+results Fare::compute_fare(const routing::Path& path) const {
     int nb_nodes = boost::num_vertices(g);
 
     if (nb_nodes < 2) {
         LOG4CPLUS_TRACE(logger, "no fare data loaded, cannot compute fare");
-        return res;
+        return results();
     }
+    const auto compiled_fare = compiled.get(*this);
+
     std::vector< std::vector<Label> > labels(nb_nodes);
     // Start label
     labels[0].push_back(Label());
+    // all the labels are built on the previous section (or are the start label)
+    boost::optional<SectionKey> previous_section;
     size_t section_idx(0);
 
-    for (auto item : path.items) {
+    for (const auto& item : path.items) {
         if (item.type != routing::ItemType::public_transport) {
             section_idx++;
             continue;
         }
 
         SectionKey section_key(item, section_idx++);
+        labels = next_labels(*compiled_fare, labels, previous_section.get_ptr(), section_key);
+        previous_section = section_key;
+    }
 
-        std::vector<std::vector<Label>> new_labels(nb_nodes);
-        try {
-            BOOST_FOREACH(edge_t e, boost::edges(g)) {
-                vertex_t u = boost::source(e,g);
-                vertex_t v = boost::target(e,g);
-                if (! valid(g[v], section_key))
-                    continue;
-
-                for (const Label& label: labels[u]) {
-                    Ticket ticket;
-                    const Transition& transition = g[e];
-                    if (valid(g[u], label) && transition.valid(section_key, label)) {
-                        if (transition.ticket_key != "") {
-                            bool ticket_found = false; //TODO refactor this, optional is way better
-                            auto it = fare_map.find(transition.ticket_key);
-                            try {
-                                if (it != fare_map.end()) {
-                                    ticket = it->second.get_fare(section_key.date);
-                                    ticket_found = true;
-                                }
-                            }
-                            catch(no_ticket) { //the ticket_found bool is still false
-                            }
-                            if (! ticket_found) {
-                                ticket = make_default_ticket();
-                            }
-                        }
-                        if (transition.global_condition == Transition::GlobalCondition::exclusive)
-                            throw ticket;
-                        else if(transition.global_condition == Transition::GlobalCondition::with_changes) {
-                            ticket.type = Ticket::ODFare;
-                        }
-                        Label next = next_label(label, ticket, section_key);
-
-                        // we process the OD ticket: case where we'll not use this ticket anymore
-                        if (label.current_type == Ticket::ODFare || ticket.type == Ticket::ODFare) {
-                            try {
-                                Ticket ticket_od;
-                                ticket_od = get_od(next, section_key).get_fare(section_key.date);
-                                if(label.tickets.size() > 0 && label.current_type == Ticket::ODFare)
-                                    ticket_od.sections = label.tickets.back().sections;
-
-                                ticket_od.sections.push_back(section_key);
-                                Label n = next;
-                                n.cost += ticket_od.value;
-                                n.tickets.back() = ticket_od;
-                                n.current_type = Ticket::FlatFare;
-
-                                new_labels[0].push_back(n);
-                            } catch (no_ticket) {
-                                LOG4CPLUS_WARN(logger, "Unable to get the OD ticket SA=" << next.stop_area
-                                               << ", zone=" << next.zone
-                                               << ", section start_zone=" << section_key.start_zone
-                                               << ", dest_zone=" << section_key.dest_zone
-                                               << ", start_sa=" << section_key.start_stop_area
-                                               << ", dest_sa=" << section_key.dest_stop_area
-                                               << ", mode=" << section_key.mode);
-                            }
-                        } else {
-                            new_labels[0].push_back(next);
-                        }
-                        new_labels[v].push_back(next);
-                    }
-                }
+    return best_result(labels.at(0));
+}
+
+std::vector<results> Fare::compute_fares(const std::vector<routing::Path>& paths) const {
+    int nb_nodes = boost::num_vertices(g);
+
+    if (nb_nodes < 2) {
+        LOG4CPLUS_TRACE(logger, "no fare data loaded, cannot compute fare");
+        return std::vector<results>(paths.size());
+    }
+    const auto compiled_fare = compiled.get(*this);
+
+    // The labels only depend on the sections already taken, so the journeys are
+    // first gathered in a trie of their sections: the journeys sharing their first
+    // sections share the propagation of the labels on them.
+    // The times of the sections are only read as durations since the ticket was bought,
+    // which only depend on the times modulo a day relatively to each other. The sections
+    // are thus keyed with their times from the start of the first section of the
+    // journey, so the journeys taking the same lines at another time share their labels.
+    // For that, the labels of a branch are built with the times of the journey that
+    // created it, on sections numbered by their rank in the journey. The sections of
+    // the tickets are set back to the ones of each journey at the end.
+    // Node 0 is the root, before the first section
+    struct Node {
+        size_t parent = 0;
+        boost::optional<SectionKey> section;
+        uint32_t origin = 0; // start of the first section of the branch
+        size_t nb_pending = 0; // children and journeys still to compute from its labels
+        std::vector<size_t> ending_paths;
+    };
+    const uint32_t day = 24 * 3600;
+    const auto time_from = [&](uint32_t origin, uint32_t time) { return (time + day - origin) % day; };
+    std::vector<Node> nodes(1);
+    std::map<std::pair<size_t, SectionKey>, size_t> children;
+    std::vector<std::vector<SectionKey>> path_sections(paths.size());
+    for (size_t path_idx = 0; path_idx < paths.size(); ++path_idx) {
+        auto& sections = path_sections[path_idx];
+        size_t node = 0;
+        size_t section_idx(0);
+        uint32_t origin = 0;
+        for (const auto& item : paths[path_idx].items) {
+            if (item.type != routing::ItemType::public_transport) {
+                section_idx++;
+                continue;
             }
-        }
-        // exclusive segment, we have to use that ticket
-        catch(const Ticket& ticket) {
-            LOG4CPLUS_TRACE(logger, "\texclusive section for fare");
-            new_labels.clear();
-            new_labels.resize(nb_nodes);
-            for (Label label : labels.at(0)) {
-                new_labels.at(0).push_back(next_label(label, ticket, section_key));
+            sections.emplace_back(item, section_idx++);
+            SectionKey section_key = sections.back();
+            section_key.path_item_idx = sections.size() - 1;
+            if (sections.size() == 1 && ! compiled_fare->reads_time_of_day) {
+                origin = section_key.start_time;
+            }
+            SectionKey trie_key = section_key;
+            trie_key.start_time = time_from(origin, section_key.start_time);
+            trie_key.dest_time = time_from(origin, section_key.dest_time);
+            const auto inserted = children.insert({{node, trie_key}, nodes.size()});
+            if (inserted.second) {
+                const uint32_t branch_origin = node == 0 ? origin : nodes[node].origin;
+                nodes[node].nb_pending++;
+                nodes.emplace_back();
+                nodes.back().parent = node;
+                nodes.back().origin = branch_origin;
+                section_key.start_time = (branch_origin + trie_key.start_time) % day;
+                section_key.dest_time = (branch_origin + trie_key.dest_time) % day;
+                nodes.back().section = section_key;
             }
+            node = inserted.first->second;
         }
-        labels = std::move(new_labels);
-
+        nodes[node].nb_pending++;
+        nodes[node].ending_paths.push_back(path_idx);
     }
 
-    // We look for the cheapest label
-    // if 2 label have the same cost, we take the one with the least number of tickets
-    boost::optional<Label> best_label;
-    for(const Label& label : labels.at(0)) {
-        if(!best_label || label < (*best_label)) {
-            res.tickets = label.tickets;
-            res.not_found = (label.nb_undefined_sub_cost != 0);
-            res.total = label.cost;
-            best_label = label;
+    // a node is always after its parent, the labels of a node are released as soon
+    // as all the nodes built from them and the journeys ending on it are computed
+    std::vector<results> res(paths.size());
+    std::vector<std::vector<std::vector<Label>>> node_labels(nodes.size());
+    node_labels[0].resize(nb_nodes);
+    node_labels[0][0].push_back(Label());
+    auto release = [&](size_t node) {
+        if (--nodes[node].nb_pending == 0) {
+            std::vector<std::vector<Label>>().swap(node_labels[node]);
+        }
+    };
+    for (size_t node = 0; node < nodes.size(); ++node) {
+        if (node != 0) {
+            const size_t parent = nodes[node].parent;
+            node_labels[node] = next_labels(*compiled_fare, node_labels[parent],
+                                            nodes[parent].section.get_ptr(), *nodes[node].section);
+            release(parent);
+        }
+        if (! nodes[node].ending_paths.empty()) {
+            const auto best = best_result(node_labels[node].at(0));
+            for (const size_t path_idx: nodes[node].ending_paths) {
+                res[path_idx] = best;
+                for (auto& ticket: res[path_idx].tickets) {
+                    for (auto& section: ticket.sections) {
+                        section = path_sections[path_idx].at(section.path_item_idx);
+                    }
+                }
+                release(node);
+            }
         }
     }
 
+    LOG4CPLUS_TRACE(logger, "fares of " << paths.size() << " journeys computed with "
+                    << nodes.size() - 1 << " label propagations");
     return res;
 }
 
+std::vector<std::vector<Label>> Fare::next_labels(const CompiledFare& compiled_fare,
+                                                  const std::vector<std::vector<Label>>& labels,
+                                                  const SectionKey* previous_section,
+                                                  const SectionKey& section_key) const {
+    const size_t nb_nodes = labels.size();
+    // all the labels are built on the previous section (or are the start label)
+    const CompiledFare::Features label_features = previous_section ?
+        CompiledFare::Features(*previous_section) : CompiledFare::Features();
+    const CompiledFare::Features section_features(section_key);
+    const auto start_stop_area = boost::to_upper_copy(section_key.start_stop_area);
+    const auto dest_stop_area = boost::to_upper_copy(section_key.dest_stop_area);
+
+    std::vector<std::vector<Label>> new_labels(nb_nodes);
+    boost::optional<Ticket> exclusive_ticket;
+    for (const auto* transition: compiled_fare.transitions_towards(section_features)) {
+        const vertex_t u = transition->source;
+        const vertex_t v = transition->target;
+        for (const Label& label: labels[u]) {
+            if (! compiled_fare.accepts(u, label_features, label)
+                    || ! transition->valid(section_key, start_stop_area, dest_stop_area, label)) {
+                continue;
+            }
+            Ticket ticket;
+            if (transition->transition->ticket_key != "") {
+                const Ticket* fare_ticket = transition->date_ticket ?
+                    transition->date_ticket->find_fare(section_key.date) : nullptr;
+                ticket = fare_ticket ? *fare_ticket : make_default_ticket();
+            }
+            if (transition->transition->global_condition == Transition::GlobalCondition::exclusive) {
+                exclusive_ticket = ticket;
+                break;
+            } else if (transition->transition->global_condition == Transition::GlobalCondition::with_changes) {
+                ticket.type = Ticket::ODFare;
+            }
+            Label next = next_label(label, ticket, section_key);
+
+            // we process the OD ticket: case where we'll not use this ticket anymore
+            if (label.current_type == Ticket::ODFare || ticket.type == Ticket::ODFare) {
+                const auto od = get_od(next, section_key);
+                const Ticket* od_fare = od ? od->find_fare(section_key.date) : nullptr;
+                if (od_fare) {
+                    Ticket ticket_od = *od_fare;
+                    if(label.tickets.size() > 0 && label.current_type == Ticket::ODFare)
+                        ticket_od.sections = label.tickets.back().sections;
+
+                    ticket_od.sections.push_back(section_key);
+                    Label n = next;
+                    n.cost += ticket_od.value;
+                    n.tickets.back() = ticket_od;
+                    n.current_type = Ticket::FlatFare;
+
+                    new_labels[0].push_back(n);
+                } else {
+                    LOG4CPLUS_WARN(logger, "Unable to get the OD ticket SA=" << next.stop_area
+                                   << ", zone=" << next.zone
+                                   << ", section start_zone=" << section_key.start_zone
+                                   << ", dest_zone=" << section_key.dest_zone
+                                   << ", start_sa=" << section_key.start_stop_area
+                                   << ", dest_sa=" << section_key.dest_stop_area
+                                   << ", mode=" << section_key.mode);
+                }
+            } else {
+                new_labels[0].push_back(next);
+            }
+            new_labels[v].push_back(next);
+        }
+        if (exclusive_ticket) { break; }
+    }
+    // exclusive segment, we have to use that ticket
+    if (exclusive_ticket) {
+        LOG4CPLUS_TRACE(logger, "\texclusive section for fare");
+        new_labels.clear();
+        new_labels.resize(nb_nodes);
+        for (Label label : labels.at(0)) {
+            new_labels.at(0).push_back(next_label(label, *exclusive_ticket, section_key));
+        }
+    }
+    return new_labels;
+}
+
 
 void DateTicket::add(boost::gregorian::date begin, boost::gregorian::date end, const Ticket& ticket){
     tickets.push_back(PeriodTicket(greg::date_period(begin, end), ticket));
@@ -275,6 +655,14 @@ template<class T> bool compare(const T& a, const T& b, Comp_e comp) {
     }
 }
 
+bool SectionKey::operator<(const SectionKey& other) const {
+    return std::tie(network, start_stop_area, dest_stop_area, line, start_time, dest_time,
+                    start_zone, dest_zone, mode, date, path_item_idx)
+        < std::tie(other.network, other.start_stop_area, other.dest_stop_area, other.line,
+                   other.start_time, other.dest_time, other.start_zone, other.dest_zone,
+                   other.mode, other.date, other.path_item_idx);
+}
+
 int SectionKey::duration_at_begin(int ticket_start_time) const {
     if (ticket_start_time < boost::lexical_cast<int>(start_time))
         return start_time - ticket_start_time;
@@ -290,12 +678,18 @@ int SectionKey::duration_at_end(int ticket_start_time) const {
 }
 
 Ticket DateTicket::get_fare(boost::gregorian::date date) const {
+    if (const Ticket* ticket = find_fare(date)) {
+        return *ticket;
+    }
+    throw no_ticket();
+}
+
+const Ticket* DateTicket::find_fare(boost::gregorian::date date) const {
     for (const auto& dticket : tickets) {
         if (dticket.validity_period.contains(date))
-            return dticket.ticket;
+            return &dticket.ticket;
     }
-
-    throw no_ticket();
+    return nullptr;
 }
 
 DateTicket DateTicket::operator +(const DateTicket& other) const{
@@ -371,7 +765,7 @@ get_od_dest(const OD_map& od_map, const OD_key& sa, const OD_key& mode, const OD
     return od_t;
 }
 
-DateTicket Fare::get_od(const Label& label, const SectionKey& section) const {
+boost::optional<DateTicket> Fare::get_od(const Label& label, const SectionKey& section) const {
     OD_key o_sa(OD_key::StopArea, label.stop_area);
     OD_key o_mode(OD_key::Mode, label.mode);
     OD_key o_zone(OD_key::Zone, label.zone);
@@ -402,7 +796,7 @@ DateTicket Fare::get_od(const Label& label, const SectionKey& section) const {
         }
     }
     if (! od) {
-        throw no_ticket();
+        return boost::none;
     }
 
     // We create a new ticket, sum of all atomic elements
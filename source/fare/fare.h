@@ -39,6 +39,9 @@ www.navitia.io
 #include <boost/date_time/gregorian/greg_serialize.hpp>
 #include "utils/serialization_vector.h"
 #include <boost/serialization/utility.hpp>
+#include <boost/optional.hpp>
+#include <memory>
+#include <mutex>
 
 namespace navitia { namespace fare {
 
@@ -142,6 +145,9 @@ struct DateTicket {
     /// Retourne le tarif à une date données
     Ticket get_fare(boost::gregorian::date date) const;
 
+    /// fare at the given date, nullptr if there is none (get_fare throws no_ticket)
+    const Ticket* find_fare(boost::gregorian::date date) const;
+
     /// Ajoute une nouvelle période
     void add(boost::gregorian::date begin_date, boost::gregorian::date end_date, const Ticket& ticket);
 
@@ -280,6 +286,8 @@ struct SectionKey {
     size_t path_item_idx;
 
     SectionKey(const routing::PathItem& path_item, const size_t idx);
+    /// on all the fields, the fare of a section depends only on them
+    bool operator<(const SectionKey& other) const;
     int duration_at_begin(int ticket_start_time) const;
     int duration_at_end(int ticket_start_time) const;
 };
@@ -328,6 +336,27 @@ struct results {
     bool not_found = true;
 };
 
+struct Fare;
+struct CompiledFare;
+
+/** The compiled fare graph of a Fare, built at its first use
+ *
+ * It points into the graph and the fare_map of its Fare, so it is neither copied
+ * nor serialized, and the Fare must not be modified once a fare has been computed.
+ */
+struct CompiledFareCache {
+    CompiledFareCache() = default;
+    CompiledFareCache(const CompiledFareCache&) {}
+    CompiledFareCache& operator=(const CompiledFareCache&) { reset(); return *this; }
+
+    std::shared_ptr<const CompiledFare> get(const Fare& fare) const;
+    void reset();
+
+private:
+    mutable std::mutex mutex;
+    mutable std::shared_ptr<const CompiledFare> compiled;
+};
+
 /// Contient l'ensemble du système tarifaire
 struct Fare {
     /// Map qui associe les clefs de tarifs aux tarifs
@@ -348,6 +377,11 @@ struct Fare {
     /// Retourne une liste de billets à acheter
     results compute_fare(const routing::Path& path) const;
 
+    /// Same as compute_fare for all the journeys of a response, in the same order
+    /// The labels built on the first sections shared by several journeys are computed once,
+    /// as are the ones of journeys taking the same sections at another time of the day
+    std::vector<results> compute_fares(const std::vector<routing::Path>& paths) const;
+
     template<class Archive> void save(Archive & ar, const unsigned int) const {
         ar & fare_map & od_tickets & g;
     }
@@ -355,17 +389,26 @@ struct Fare {
     template<class Archive> void load(Archive & ar, const unsigned int) {
         // boost adjacency load does not seems to empty the graph, hence there was a memory leak
         g.clear();
+        compiled.reset();
         ar & fare_map & od_tickets & g;
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 
     size_t nb_transitions() const;
 private:
-    /// Retourne le ticket OD qui va bien ou lève une exception no_ticket si on ne trouve pas
-    DateTicket get_od(const Label& label, const SectionKey& section) const;
+    /// Retourne le ticket OD qui va bien, none si on ne le trouve pas
+    boost::optional<DateTicket> get_od(const Label& label, const SectionKey& section) const;
 
     void add_default_ticket();
 
+    /// Propagate the labels of the previous section (none for the start label) on a section
+    std::vector<std::vector<Label>> next_labels(const CompiledFare& compiled_fare,
+                                                const std::vector<std::vector<Label>>& labels,
+                                                const SectionKey* previous_section,
+                                                const SectionKey& section_key) const;
+
+    CompiledFareCache compiled;
+
     log4cplus::Logger logger = log4cplus::Logger::getInstance("log");
 };
 
@@ -0,0 +1,210 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "fare/fare.h"
+#include "ed/connectors/fare_parser.h"
+#include "type/type.h"
+#include "utils/init.h"
+#include "utils/functions.h"
+#include "conf.h"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/program_options.hpp>
+#include <iostream>
+#include <random>
+
+namespace po = boost::program_options;
+namespace pt = boost::posix_time;
+namespace nt = navitia::type;
+namespace nf = navitia::fare;
+
+/*
+ * Time of the fare computation of many generated journeys on the fare model of the
+ * tests (fixtures/fare), with the networks, stop areas, lines and zones of the tests
+ */
+
+struct Params {
+    std::string fare_dir;
+    size_t nb_journeys;
+    size_t max_nb_sections;
+};
+
+static nf::Fare load_fare(const std::string& fare_dir) {
+    ed::Data ed_data;
+    ed::connectors::fare_parser parser(ed_data, fare_dir + "/idf.fares", fare_dir + "/prix.csv",
+                                       fare_dir + "/tarifs_od.csv");
+    parser.load();
+
+    nf::Fare fare;
+    fare.od_tickets = ed_data.od_tickets;
+    for (const auto& f: ed_data.fare_map) {
+        fare.fare_map.insert(f);
+    }
+    std::map<nf::State, nf::Fare::vertex_t> state_map;
+    state_map[nf::State()] = fare.begin_v;
+    auto get_vertex = [&](const nf::State& state) {
+        const auto it = state_map.find(state);
+        if (it != state_map.end()) { return it->second; }
+        const auto v = boost::add_vertex(state, fare.g);
+        state_map[state] = v;
+        return v;
+    };
+    for (const auto& transition: ed_data.transitions) {
+        boost::add_edge(get_vertex(std::get<0>(transition)), get_vertex(std::get<1>(transition)),
+                        std::get<2>(transition), fare.g);
+    }
+    return fare;
+}
+
+struct JourneyGenerator {
+    const Params& params;
+    std::mt19937 gen{42};
+    const boost::gregorian::date date{2011, 7, 1};
+
+    // the objects of the generated journeys, kept for the whole benchmark
+    std::vector<std::unique_ptr<nt::StopArea>> stop_areas;
+    std::vector<std::unique_ptr<nt::StopPoint>> stop_points;
+    std::vector<std::unique_ptr<nt::Network>> networks;
+    std::vector<std::unique_ptr<nt::Line>> lines;
+    std::vector<std::unique_ptr<nt::Route>> routes;
+    std::vector<std::unique_ptr<nt::PhysicalMode>> modes;
+    std::vector<std::unique_ptr<nt::DiscreteVehicleJourney>> vjs;
+    std::map<const nt::VehicleJourney*, std::unique_ptr<nt::StopTime>> stop_times;
+
+    explicit JourneyGenerator(const Params& params): params(params) {
+        for (const auto* uri: {"ratp", "filbleu", "56", "sncf"}) {
+            networks.push_back(std::make_unique<nt::Network>());
+            networks.back()->uri = uri;
+        }
+        for (const auto* uri: {"metro", "bus", "tramway", "rapidtransit", "localtrain"}) {
+            modes.push_back(std::make_unique<nt::PhysicalMode>());
+            modes.back()->uri = uri;
+        }
+        for (const auto* uri: {"8711388", "8727141", "8770870", "8775890", "8739300", "8775499",
+                               "8738287", "8739315", "nation", "montparnasse", "mantes", "paris"}) {
+            stop_areas.push_back(std::make_unique<nt::StopArea>());
+            stop_areas.back()->uri = uri;
+            for (const auto* zone: {"1", "3", "4"}) {
+                stop_points.push_back(std::make_unique<nt::StopPoint>());
+                stop_points.back()->stop_area = stop_areas.back().get();
+                stop_points.back()->fare_zone = zone;
+            }
+        }
+        for (const auto* uri: {"filnav31", "800:t4", "rer b", "100110007:7", "filgato-2", "phebus"}) {
+            for (const auto& network: networks) {
+                lines.push_back(std::make_unique<nt::Line>());
+                lines.back()->uri = uri;
+                lines.back()->network = network.get();
+                routes.push_back(std::make_unique<nt::Route>());
+                routes.back()->line = lines.back().get();
+                for (const auto& mode: modes) {
+                    vjs.push_back(std::make_unique<nt::DiscreteVehicleJourney>());
+                    vjs.back()->route = routes.back().get();
+                    vjs.back()->physical_mode = mode.get();
+                }
+            }
+        }
+    }
+
+    size_t random(size_t max) {
+        return std::uniform_int_distribution<size_t>(0, max - 1)(gen);
+    }
+
+    navitia::routing::Path journey() {
+        navitia::routing::Path path;
+        int time = 6 * 3600 + int(random(12 * 3600));
+        for (size_t nb_sections = 1 + random(params.max_nb_sections); nb_sections > 0; --nb_sections) {
+            navitia::routing::PathItem item(navitia::routing::ItemType::public_transport,
+                                            pt::ptime(date, pt::seconds(time)),
+                                            pt::ptime(date, pt::seconds(time + 300 + int(random(3000)))));
+            time = (item.arrival - pt::ptime(date)).total_seconds() + int(random(600));
+            item.stop_points.push_back(stop_points[random(stop_points.size())].get());
+            item.stop_points.push_back(stop_points[random(stop_points.size())].get());
+            item.stop_times.push_back(&stop_time(vjs[random(vjs.size())].get()));
+            path.items.push_back(item);
+        }
+        return path;
+    }
+
+    // a stop time giving its vj to the sections
+    const nt::StopTime& stop_time(nt::VehicleJourney* vj) {
+        auto it = stop_times.find(vj);
+        if (it == stop_times.end()) {
+            it = stop_times.emplace(vj, std::make_unique<nt::StopTime>()).first;
+            it->second->vehicle_journey = vj;
+        }
+        return *it->second;
+    }
+};
+
+int main(int argc, char** argv) {
+    navitia::init_app();
+    Params params;
+    po::options_description desc("Options of the fare computation benchmark");
+    desc.add_options()
+        ("help,h", "Show this message")
+        ("fare_dir,f", po::value<std::string>(&params.fare_dir)->default_value(
+             std::string(navitia::config::fixtures_dir) + "/fare"),
+         "directory of the fare files (idf.fares, prix.csv and tarifs_od.csv)")
+        ("journeys,j", po::value<size_t>(&params.nb_journeys)->default_value(10000), "number of journeys")
+        ("sections,s", po::value<size_t>(&params.max_nb_sections)->default_value(4),
+         "maximum number of public transport sections by journey");
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+        std::cout << desc << std::endl;
+        return 1;
+    }
+    po::notify(vm);
+
+    const auto fare = load_fare(params.fare_dir);
+    std::cout << fare.nb_transitions() << " transitions, " << fare.fare_map.size() << " tickets" << std::endl;
+
+    JourneyGenerator generator(params);
+    std::vector<navitia::routing::Path> journeys;
+    for (size_t i = 0; i < params.nb_journeys; ++i) {
+        journeys.push_back(generator.journey());
+    }
+
+    // the first computation compiles the fare graph
+    auto start = pt::microsec_clock::universal_time();
+    fare.compute_fare(journeys.front());
+    std::cout << "first computation: "
+              << (pt::microsec_clock::universal_time() - start).total_microseconds() << "us" << std::endl;
+
+    size_t nb_found = 0;
+    start = pt::microsec_clock::universal_time();
+    for (const auto& journey: journeys) {
+        if (! fare.compute_fare(journey).not_found) { ++nb_found; }
+    }
+    const double duration = (pt::microsec_clock::universal_time() - start).total_microseconds() / 1e6;
+    std::cout << "compute_fare: " << journeys.size() << " journeys in " << duration << "s ("
+              << journeys.size() / duration << " journeys/s), " << nb_found << " with a fare" << std::endl;
+    return 0;
+}
@@ -39,6 +39,7 @@ www.navitia.io
 #include <boost/spirit/include/qi_lit.hpp>
 #include <boost/spirit/include/phoenix_core.hpp>
 #include <boost/spirit/include/phoenix_operator.hpp>
+#include <tuple>
 
 struct logger_initialized {
     logger_initialized()   { init_logger(); }
@@ -652,3 +653,153 @@ BOOST_AUTO_TEST_CASE(test_without_file_load_and_unknown_fare) {
     BOOST_REQUIRE_EQUAL(res.tickets.size(), 1);
     BOOST_CHECK_EQUAL(res.tickets.at(0).key, make_default_ticket().key);
 }
+
+// the compiled fare graph points into its fare, a copy of the fare compiles its own graph
+BOOST_AUTO_TEST_CASE(compiled_fare_not_shared_by_copies) {
+    Fare fare;
+    boost::gregorian::date start_date(boost::gregorian::from_undelimited_string("20110101"));
+    boost::gregorian::date end_date(boost::gregorian::from_undelimited_string("20350101"));
+    fare.fare_map["price1"].add(start_date, end_date, Ticket("price1", "Ticket vj 1", 100, "125"));
+
+    Transition transition;
+    transition.ticket_key = "price1";
+    State end;
+    end.mode = "Metro";
+    auto end_v = boost::add_vertex(end, fare.g);
+    boost::add_edge(fare.begin_v, end_v, transition, fare.g);
+
+    // the modes are compared case insensitively
+    std::vector<std::string> keys;
+    keys.push_back("ratp;nation;montparnasse;FILGATO-2;2011|12|01;04|40;04|50;1;1;metro");
+    results res = fare.compute_fare(string_to_path(keys));
+    BOOST_REQUIRE_EQUAL(res.tickets.size(), 1);
+    BOOST_CHECK_EQUAL(res.tickets.at(0).key, "price1");
+    BOOST_CHECK_EQUAL(res.total, 100);
+
+    Fare other_fare = fare;
+    other_fare.fare_map["price1"] = DateTicket();
+    other_fare.fare_map["price1"].add(start_date, end_date, Ticket("price1", "Ticket vj 1", 150, "125"));
+    res = other_fare.compute_fare(string_to_path(keys));
+    BOOST_REQUIRE_EQUAL(res.tickets.size(), 1);
+    BOOST_CHECK_EQUAL(res.total, 150);
+
+    res = fare.compute_fare(string_to_path(keys));
+    BOOST_CHECK_EQUAL(res.total, 100);
+}
+
+// the fares computed for all the journeys of a response, sharing their first sections or not,
+// are the ones given journey by journey by the fare computation of the fixtures
+BOOST_FIXTURE_TEST_CASE(compute_fares_of_several_journeys, fare_load_fixture) {
+    const std::vector<std::vector<std::string>> journeys = {
+        {"ratp;8739300;FILGATO-2;8775890;2011|12|01;04|40;04|50;4;1;rapidtransit",
+         "ratp;nation;montparnasse;FILGATO-2;2011|12|01;04|40;04|50;1;1;metro",
+         "ratp;8775890;FILGATO-2;8775499;2011|12|01;04|40;04|50;1;5;rapidtransit"},
+        // same first sections
+        {"ratp;8739300;FILGATO-2;8775890;2011|12|01;04|40;04|50;4;1;rapidtransit",
+         "ratp;nation;montparnasse;FILGATO-2;2011|12|01;04|40;04|50;1;1;metro"},
+        {"ratp;8739300;FILGATO-2;8775890;2011|12|01;04|40;04|50;4;1;rapidtransit",
+         "ratp;nation;montparnasse;FILGATO-2;2011|12|01;04|40;04|50;1;1;bus",
+         "ratp;8775890;FILGATO-2;8775499;2011|12|01;04|40;04|50;1;5;rapidtransit"},
+        {"ratp;8739300;FILGATO-2;8775890;2011|12|01;04|40;04|50;4;1;rapidtransit",
+         "ratp;nation;montparnasse;FILGATO-2;2011|12|01;04|40;04|50;1;1;metro",
+         "ratp;8775890;FILGATO-2;8775499;2011|12|01;04|40;04|50;1;5;rapidtransit"},
+        // OD and exclusive sections
+        {";bled_paumé;bus_magique;8711388;2011|07|31;09|28;09|39;4;4;Bus",
+         ";8711388;800:T4;8727141;2011|07|31;09|40;09|50;4;4;tramway",
+         ";8727141;RER B;8770870;2011|07|31;09|28;09|39;4;4;RapidTransit"},
+        {";bled_paumé;bus_magique;8711388;2011|07|31;09|28;09|39;4;4;Bus",
+         ";paris;098098001:1;areoport;2011|07|31;09|28;09|39;4;4;Bus"},
+        {";bled_paumé;bus_magique;8711388;2011|07|31;09|28;09|39;4;4;Bus"},
+        {}
+    };
+    // for each journey, the key, the value and the sections of each ticket
+    using ExpectedTicket = std::tuple<std::string, int, std::vector<size_t>>;
+    const std::vector<std::vector<ExpectedTicket>> expected_tickets = {
+        {ExpectedTicket{"30", 960, {0, 1, 2}}},
+        {ExpectedTicket{"130", 320, {0, 1}}},
+        {ExpectedTicket{"130", 320, {0}}, ExpectedTicket{"tickett", 170, {1}}, ExpectedTicket{"144", 700, {2}}},
+        {ExpectedTicket{"30", 960, {0, 1, 2}}},
+        {ExpectedTicket{"tickett", 170, {0, 1}}, ExpectedTicket{"12", 470, {2}}},
+        {ExpectedTicket{"tickett", 170, {0}}, ExpectedTicket{"098:1", 1150, {1}}},
+        {ExpectedTicket{"tickett", 170, {0}}},
+        {}
+    };
+    const std::vector<int> expected_totals = {960, 320, 1190, 960, 640, 1320, 170, 0};
+
+    std::vector<navitia::routing::Path> paths;
+    for (const auto& journey: journeys) {
+        paths.push_back(string_to_path(journey));
+    }
+
+    const auto all_res = f.compute_fares(paths);
+    BOOST_REQUIRE_EQUAL(all_res.size(), paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        BOOST_CHECK(! all_res[i].not_found);
+        BOOST_CHECK_EQUAL(all_res[i].total, expected_totals[i]);
+        BOOST_REQUIRE_EQUAL(all_res[i].tickets.size(), expected_tickets[i].size());
+        for (size_t t = 0; t < expected_tickets[i].size(); ++t) {
+            const auto& ticket = all_res[i].tickets[t];
+            BOOST_CHECK_EQUAL(ticket.key, std::get<0>(expected_tickets[i][t]));
+            BOOST_CHECK_EQUAL(ticket.value, std::get<1>(expected_tickets[i][t]));
+            std::vector<size_t> sections;
+            for (const auto& section: ticket.sections) {
+                sections.push_back(section.path_item_idx);
+            }
+            const auto& expected_sections = std::get<2>(expected_tickets[i][t]);
+            BOOST_CHECK_EQUAL_COLLECTIONS(sections.begin(), sections.end(),
+                                          expected_sections.begin(), expected_sections.end());
+        }
+
+        // and the same as the ones computed journey by journey
+        const auto res = f.compute_fare(paths[i]);
+        BOOST_CHECK_EQUAL(res.total, expected_totals[i]);
+        BOOST_CHECK_EQUAL(res.tickets.size(), expected_tickets[i].size());
+    }
+}
+
+// the journeys taking the same sections at other times share their labels,
+// but the sections of their tickets are their own
+BOOST_FIXTURE_TEST_CASE(compute_fares_of_journeys_at_several_times, fare_load_fixture) {
+    const std::vector<std::vector<std::string>> journeys = {
+        {"ratp;8739300;FILGATO-2;8775890;2011|12|01;04|40;04|50;4;1;rapidtransit",
+         "ratp;nation;montparnasse;FILGATO-2;2011|12|01;04|55;05|05;1;1;bus"},
+        {"ratp;8739300;FILGATO-2;8775890;2011|12|01;05|40;05|50;4;1;rapidtransit",
+         "ratp;nation;montparnasse;FILGATO-2;2011|12|01;05|55;06|05;1;1;bus"},
+        // the bus ticket is no longer valid after 90 minutes
+        {"Filbleu;FILURSE-2;FILNav31;FILGATO-2;2011|07|01;02|50;03|30;1;1;tramway",
+         "Filbleu;FILURSE-2;FILNav31;FILGATO-2;2011|07|01;03|30;04|20;1;1;bus"},
+        {"Filbleu;FILURSE-2;FILNav31;FILGATO-2;2011|07|01;03|50;04|30;1;1;tramway",
+         "Filbleu;FILURSE-2;FILNav31;FILGATO-2;2011|07|01;04|30;05|20;1;1;bus"},
+        {"Filbleu;FILURSE-2;FILNav31;FILGATO-2;2011|07|01;03|50;04|30;1;1;tramway",
+         "Filbleu;FILURSE-2;FILNav31;FILGATO-2;2011|07|01;05|30;05|40;1;1;bus"},
+    };
+    std::vector<navitia::routing::Path> paths;
+    for (const auto& journey: journeys) {
+        paths.push_back(string_to_path(journey));
+    }
+
+    const auto all_res = f.compute_fares(paths);
+    BOOST_REQUIRE_EQUAL(all_res.size(), paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        const auto res = f.compute_fare(paths[i]);
+        BOOST_CHECK_EQUAL(all_res[i].total, res.total);
+        BOOST_REQUIRE_EQUAL(all_res[i].tickets.size(), res.tickets.size());
+        for (size_t t = 0; t < res.tickets.size(); ++t) {
+            BOOST_CHECK_EQUAL(all_res[i].tickets[t].key, res.tickets[t].key);
+            BOOST_REQUIRE_EQUAL(all_res[i].tickets[t].sections.size(), res.tickets[t].sections.size());
+            for (size_t s = 0; s < res.tickets[t].sections.size(); ++s) {
+                BOOST_CHECK_EQUAL(all_res[i].tickets[t].sections[s].path_item_idx,
+                                  res.tickets[t].sections[s].path_item_idx);
+                BOOST_CHECK_EQUAL(all_res[i].tickets[t].sections[s].start_time,
+                                  res.tickets[t].sections[s].start_time);
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(all_res[0].total, 490);
+    BOOST_CHECK_EQUAL(all_res[1].total, 490);
+    BOOST_REQUIRE_EQUAL(all_res[1].tickets.size(), 2);
+    BOOST_CHECK_EQUAL(all_res[1].tickets[0].sections.at(0).start_time, 5 * 3600 + 40 * 60);
+    BOOST_CHECK_EQUAL(all_res[2].tickets.size(), 1);
+    BOOST_CHECK_EQUAL(all_res[3].tickets.size(), 1);
+    BOOST_CHECK_EQUAL(all_res[4].tickets.size(), 2);
+}
@@ -267,8 +267,9 @@ struct GeoRef {
     void init();
 
     template<class Archive> void save(Archive & ar, const unsigned int) const {
-        ar & ways & way_map & graph & offsets & fl_admin & fl_way & pl & projected_stop_points
-                & admins & admin_map &  pois & fl_poi & poitypes & poitype_map & poi_map & synonyms
+        // the autocomplete indexes are serialized in their own section, cf Data::serialize_section
+        ar & ways & way_map & graph & offsets & pl & projected_stop_points
+                & admins & admin_map &  pois & poitypes & poitype_map & poi_map & synonyms
                 & ghostwords & poi_proximity_list & nb_vertex_by_mode;
     }
 
@@ -276,8 +277,8 @@ struct GeoRef {
         // La désérialisation d'une boost adjacency list ne vide pas le graphe
         // On avait donc une fuite de mémoire
         graph.clear();
-        ar & ways & way_map & graph & offsets & fl_admin & fl_way & pl & projected_stop_points
-                & admins & admin_map & pois & fl_poi & poitypes & poitype_map & poi_map & synonyms
+        ar & ways & way_map & graph & offsets & pl & projected_stop_points
+                & admins & admin_map & pois & poitypes & poitype_map & poi_map & synonyms
                 & ghostwords & poi_proximity_list & nb_vertex_by_mode;
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
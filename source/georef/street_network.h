@@ -110,6 +110,25 @@ struct RoutingElement {
         routing_status(routing_status){}
 };
 
+/// Visitor counting the vertices examined by the dijkstra, the events are forwarded to the given visitor
+template<typename Visitor>
+struct counting_visitor {
+    Visitor visitor;
+    uint64_t* nb_examined;
+    counting_visitor(const Visitor& visitor, uint64_t& nb_examined): visitor(visitor), nb_examined(&nb_examined) {}
+
+    template<typename V, typename G> void initialize_vertex(V u, const G& g) { visitor.initialize_vertex(u, g); }
+    template<typename V, typename G> void discover_vertex(V u, const G& g) { visitor.discover_vertex(u, g); }
+    template<typename V, typename G> void examine_vertex(V u, const G& g) {
+        ++ *nb_examined;
+        visitor.examine_vertex(u, g);
+    }
+    template<typename E, typename G> void examine_edge(E e, const G& g) { visitor.examine_edge(e, g); }
+    template<typename E, typename G> void edge_relaxed(E e, const G& g) { visitor.edge_relaxed(e, g); }
+    template<typename E, typename G> void edge_not_relaxed(E e, const G& g) { visitor.edge_not_relaxed(e, g); }
+    template<typename V, typename G> void finish_vertex(V u, const G& g) { visitor.finish_vertex(u, g); }
+};
+
 struct PathFinder {
     const GeoRef & geo_ref;
 
@@ -138,6 +157,9 @@ struct PathFinder {
     /// Color map for the dijkstra shortest path (to avoid extra alloc)
     boost::two_bit_color_map<> color;
 
+    /// Number of vertices visited by the dijkstras since the last reset, for the metrics of kraken
+    uint64_t nb_visited_vertices = 0;
+
     PathFinder(const GeoRef& geo_ref);
 
     /**
@@ -189,7 +211,7 @@ struct PathFinder {
                 std::less<navitia::time_duration>(),
                 SpeedDistanceCombiner(speed_factor), //we multiply the edge duration by a speed factor
                 navitia::seconds(0),
-                visitor,
+                counting_visitor<Visitor>(visitor, nb_visited_vertices),
                 color,
                 &index_in_heap_map[0]
                 );
@@ -39,6 +39,7 @@ www.navitia.io
 #include <boost/range/algorithm/for_each.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/range/algorithm_ext/erase.hpp>
+#include <boost/range/algorithm/sort.hpp>
 #include <boost/container/flat_set.hpp>
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <algorithm>
@@ -139,17 +140,35 @@ static std::string concatenate_impact_uris(const nt::MetaVehicleJourney& mvj) {
     return impacts_uris.str();
 }
 
+// the vj list of the physical mode is shared by the meta vjs, with a
+// staging it is completed by the merge
+static void link_physical_mode(nt::VehicleJourney* vj) {
+    if (nt::RealtimeStaging::current()) { return; }
+    vj->physical_mode->vehicle_journey_list.push_back(vj);
+}
+
+using meta_vj_set = std::set<nt::MetaVehicleJourney*>;
+
 struct add_impacts_visitor : public apply_impacts_visitor {
+    // if set, the impact is only applied on these meta vjs
+    const meta_vj_set* only_meta_vjs;
+
     add_impacts_visitor(const boost::shared_ptr<nt::disruption::Impact>& impact,
-            nt::PT_Data& pt_data, const nt::MetaData& meta, nt::RTLevel l) :
-        apply_impacts_visitor(impact, pt_data, meta, "add", l) {}
+            nt::PT_Data& pt_data, const nt::MetaData& meta, nt::RTLevel l,
+            const meta_vj_set* only_meta_vjs = nullptr) :
+        apply_impacts_visitor(impact, pt_data, meta, "add", l), only_meta_vjs(only_meta_vjs) {}
 
     ~add_impacts_visitor() {}
     add_impacts_visitor(const add_impacts_visitor&) = default;
 
     using apply_impacts_visitor::operator();
 
+    bool is_filtered_out(nt::MetaVehicleJourney* mvj) const {
+        return only_meta_vjs && ! only_meta_vjs->count(mvj);
+    }
+
     void operator()(nt::MetaVehicleJourney* mvj, nt::Route* r = nullptr) {
+        if (is_filtered_out(mvj)) { return; }
         log_start_action(mvj->uri);
         if (impact->severity->effect == nt::disruption::Effect::NO_SERVICE) {
             LOG4CPLUS_TRACE(log, "canceling " << mvj->uri);
@@ -198,7 +217,7 @@ struct add_impacts_visitor : public apply_impacts_visitor {
                 vj->physical_mode = pt_data.physical_modes[0];
                 vj->name = new_vj_uri;
             }
-            vj->physical_mode->vehicle_journey_list.push_back(vj);
+            link_physical_mode(vj);
             // we need to associate the stoptimes to the created vj
             for (auto& stu: impact->aux_info.stop_times) {
                 stu.stop_time.vehicle_journey = vj;
@@ -232,6 +251,7 @@ struct add_impacts_visitor : public apply_impacts_visitor {
             const auto* vj = impacted_vj.vj;
             auto& new_vp = impacted_vj.new_vp;
             const auto& stop_points_section = impacted_vj.impacted_stops;
+            if (is_filtered_out(vj->meta_vj)) { continue; }
 
             for (const auto& st : vj->stop_time_list) {
                 // stop is ignored if its stop_point is not in impacted_stops
@@ -283,7 +303,7 @@ struct add_impacts_visitor : public apply_impacts_visitor {
             /*
              * Properties manually added to guarantee the good behavior for raptor and consistency.
              * */
-            new_vj->physical_mode->vehicle_journey_list.push_back(new_vj);
+            link_physical_mode(new_vj);
             new_vj->company = vj->company;
             new_vj->vehicle_journey_type = vj->vehicle_journey_type;
             new_vj->odt_message = vj->odt_message;
@@ -304,12 +324,25 @@ struct add_impacts_visitor : public apply_impacts_visitor {
         // Get all impacted VJs and compute the corresponding base_canceled vp
         std::vector<std::pair<const nt::VehicleJourney*, nt::ValidityPattern>> vj_vp_pairs;
 
+        // when the impact is only re-applied on some meta vjs, we only look at their vjs
+        // (in the same order as pt_data.vehicle_journeys to create the same vjs)
+        std::vector<nt::VehicleJourney*> filtered_vjs;
+        if (only_meta_vjs) {
+            for (auto* mvj: *only_meta_vjs) {
+                mvj->for_all_vjs([&](nt::VehicleJourney& vj) { filtered_vjs.push_back(&vj); });
+            }
+            boost::sort(filtered_vjs, [](const nt::VehicleJourney* lhs, const nt::VehicleJourney* rhs) {
+                return lhs->idx < rhs->idx;
+            });
+        }
+        const auto& candidate_vjs = only_meta_vjs ? filtered_vjs : pt_data.vehicle_journeys;
+
         /*
          * In this loop, we'are going to find all Vjs that are impacted by the closure of the stop point
          * and the validity pattern of the new Vj to be created in the next step
          *
          * */
-        for (const auto* vj: pt_data.vehicle_journeys) {
+        for (const auto* vj: candidate_vjs) {
 
             /*
              * Pre-filtering by validity pattern, which allows us to check if the vj is impacted quickly
@@ -447,7 +480,7 @@ struct add_impacts_visitor : public apply_impacts_visitor {
             /*
              * Properties manually added to guarantee the good behavior for raptor and consistency.
              * */
-            new_vj->physical_mode->vehicle_journey_list.push_back(new_vj);
+            link_physical_mode(new_vj);
             new_vj->company = vj->company;
             new_vj->vehicle_journey_type = vj->vehicle_journey_type;
             new_vj->odt_message = vj->odt_message;
@@ -475,13 +508,14 @@ static bool is_modifying_effect(nt::disruption::Effect e) {
 }
 
 void apply_impact(boost::shared_ptr<nt::disruption::Impact> impact,
-                         nt::PT_Data& pt_data, const nt::MetaData& meta) {
+                  nt::PT_Data& pt_data, const nt::MetaData& meta,
+                  const meta_vj_set* only_meta_vjs = nullptr) {
     if (! is_modifying_effect(impact->severity->effect)) {
         return;
     }
     LOG4CPLUS_TRACE(log4cplus::Logger::getInstance("log"), "Adding impact: " << impact->uri);
 
-    add_impacts_visitor v(impact, pt_data, meta, impact->disruption->rt_level);
+    add_impacts_visitor v(impact, pt_data, meta, impact->disruption->rt_level, only_meta_vjs);
     boost::for_each(impact->mut_informed_entities(), boost::apply_visitor(v));
     LOG4CPLUS_TRACE(log4cplus::Logger::getInstance("log"), impact->uri << " impact added");
 }
@@ -496,17 +530,28 @@ static auto comp = [](const impact_sptr& lhs, const impact_sptr& rhs){
     return lhs->uri < rhs->uri;
 };
 
+static void unlink_meta_vj(nt::disruption::Impact& impact, const nt::MetaVehicleJourney* mvj) {
+    boost::range::remove_erase(impact.impacted_meta_vjs, mvj);
+}
+
 struct delete_impacts_visitor : public apply_impacts_visitor {
     size_t nb_vj_reassigned = 0;
     std::set<impact_sptr, decltype(comp)> disruptions_collection{comp};
+    // the meta vjs reset to their base state, the other disruptions are re-applied only on them
+    meta_vj_set reset_meta_vjs;
     delete_impacts_visitor(boost::shared_ptr<nt::disruption::Impact> impact,
             nt::PT_Data& pt_data, const nt::MetaData& meta, nt::RTLevel l) :
         apply_impacts_visitor(impact, pt_data, meta, "delete", l) {}
 
     ~delete_impacts_visitor() override {
+        if (reset_meta_vjs.empty()) { return; }
+        std::set<const nt::disruption::Disruption*> reapplied_disruptions;
         for (const auto& i : disruptions_collection) {
-            if (i) {
-                apply_disruption(*i->disruption, pt_data, meta);
+            if (! i || ! reapplied_disruptions.insert(i->disruption).second) { continue; }
+            LOG4CPLUS_TRACE(log, "re-applying disruption " << i->disruption->uri
+                            << " on " << reset_meta_vjs.size() << " meta vjs");
+            for (const auto& disruption_impact: i->disruption->get_impacts()) {
+                apply_impact(disruption_impact, pt_data, meta, &reset_meta_vjs);
             }
         }
     }
@@ -536,6 +581,7 @@ struct delete_impacts_visitor : public apply_impacts_visitor {
         boost::for_each(mvj->get_rt_vj(), set_empty_vp);
 
         const auto& impact = this->impact;
+        unlink_meta_vj(*impact, mvj);
         boost::range::remove_erase_if(mvj->impacted_by,
             [&impact](const boost::weak_ptr<nt::disruption::Impact>& i) {
                 auto spt = i.lock();
@@ -549,26 +595,28 @@ struct delete_impacts_visitor : public apply_impacts_visitor {
         
         for(const auto& wptr: impacted_by_moved) {
             if (auto share_ptr = wptr.lock()){
+                // the impact will link the meta vj again when re-applied
+                unlink_meta_vj(*share_ptr, mvj);
                 disruptions_collection.insert(share_ptr);
             }
         }
+        reset_meta_vjs.insert(mvj);
         // we check if we now have useless vehicle_journeys to cleanup
         mvj->clean_up_useless_vjs(pt_data);
     }
 
+    // reset the meta vjs impacted by the impact, found with its reverse index
+    void reset_impacted_meta_vjs() {
+        // the visit of a meta vj removes it from the index, so we iterate on a copy
+        const auto impacted_meta_vjs = impact->impacted_meta_vjs;
+        for (auto* mvj: impacted_meta_vjs) {
+            (*this)(mvj);
+        }
+    }
+
     void operator()(nt::StopPoint* stop_point) {
         stop_point->remove_impact(impact);
-        auto find_impact = [&](const boost::weak_ptr<nt::disruption::Impact>& weak_ptr) {
-            if (auto i = weak_ptr.lock()){
-                return i->uri == impact->uri;
-            }
-            return false;
-        };
-        for (auto& mvj: pt_data.meta_vjs) {
-            if (std::any_of(std::begin(mvj->impacted_by), std::end(mvj->impacted_by), find_impact)) {
-                (*this)(mvj.get());
-            };
-        }
+        reset_impacted_meta_vjs();
     }
 
     void operator()(nt::StopArea* stop_area) {
@@ -594,17 +642,7 @@ struct delete_impacts_visitor : public apply_impacts_visitor {
     }
 
     void operator()(nt::disruption::LineSection&) {
-        auto find_impact = [&](const boost::weak_ptr<nt::disruption::Impact>& weak_ptr) {
-            if (auto i = weak_ptr.lock()){
-                return i->uri == impact->uri;
-            }
-            return false;
-        };
-        for (auto& mvj: pt_data.meta_vjs) {
-            if (std::any_of(std::begin(mvj->impacted_by), std::end(mvj->impacted_by), find_impact)) {
-                (*this)(mvj.get());
-            };
-        }
+        reset_impacted_meta_vjs();
     }
 };
 
@@ -620,6 +658,13 @@ void delete_impact(boost::shared_ptr<nt::disruption::Impact> impact,
     LOG4CPLUS_DEBUG(log, impact.get()->uri << " deleted");
 }
 
+// the holder is shared by the threads applying the realtime of independent meta vjs
+std::unique_ptr<nt::disruption::Disruption> pop_disruption(nt::disruption::DisruptionHolder& holder,
+                                                           const std::string& disruption_id) {
+    const auto lock = nt::RealtimeStaging::lock_shared();
+    return holder.pop_disruption(disruption_id);
+}
+
 } // anonymous namespace
 
 void delete_disruption(const std::string& disruption_id,
@@ -631,12 +676,15 @@ void delete_disruption(const std::string& disruption_id,
     nt::disruption::DisruptionHolder& holder = pt_data.disruption_holder;
 
     // the disruption is deleted by RAII
-    if (auto disruption = holder.pop_disruption(disruption_id)) {
+    if (auto disruption = pop_disruption(holder, disruption_id)) {
         for (const auto& impact : disruption->get_impacts()) {
             delete_impact(impact, pt_data, meta);
         }
     }
-    holder.clean_weak_impacts();
+    // with a staging, the holder is cleaned once all the threads are done
+    if (! nt::RealtimeStaging::current()) {
+        holder.clean_weak_impacts();
+    }
     LOG4CPLUS_DEBUG(log, "disruption " << disruption_id << " deleted");
 }
 
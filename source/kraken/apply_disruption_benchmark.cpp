@@ -0,0 +1,175 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "kraken/apply_disruption.h"
+#include "ed/build_helper.h"
+#include "type/data.h"
+#include "type/pt_data.h"
+#include "utils/init.h"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/program_options.hpp>
+#include <iostream>
+#include <random>
+
+namespace po = boost::program_options;
+namespace pt = boost::posix_time;
+namespace nt = navitia::type;
+
+/*
+ * Time of the application, update and deletion of many concurrent disruptions
+ * (cancellations of meta vjs and closures of stop points) on a generated dataset
+ */
+
+struct Params {
+    size_t nb_lines;
+    size_t nb_vjs_by_line;
+    size_t nb_stops_by_line;
+    size_t nb_disruptions;
+    size_t nb_updates;
+    double stop_closure_ratio;
+};
+
+static std::string stop_uri(size_t line, size_t stop) {
+    return "L" + std::to_string(line) + "_S" + std::to_string(stop);
+}
+
+static std::string vj_uri(size_t line, size_t vj) {
+    return "vj:L" + std::to_string(line) + "-" + std::to_string(vj);
+}
+
+struct DisruptionGenerator {
+    const Params& params;
+    ed::builder& b;
+    std::mt19937 gen{42};
+    const pt::ptime begin{boost::gregorian::date(2016, 1, 1)};
+
+    DisruptionGenerator(const Params& params, ed::builder& b): params(params), b(b) {}
+
+    size_t random(size_t max) {
+        return std::uniform_int_distribution<size_t>(0, max - 1)(gen);
+    }
+
+    // half of the disruptions are on the first line, to have a busy line
+    size_t random_line() {
+        return random(2) ? 0 : random(params.nb_lines);
+    }
+
+    const nt::disruption::Disruption& create(const std::string& uri) {
+        const auto day = pt::hours(24 * random(7));
+        auto impacter = b.impact(nt::RTLevel::Adapted, uri);
+        impacter.severity(nt::disruption::Effect::NO_SERVICE);
+        if (random(1000) < params.stop_closure_ratio * 1000) {
+            const auto start = begin + day + pt::hours(6 + random(12));
+            impacter.on(nt::Type_e::StopPoint, stop_uri(random_line(), random(params.nb_stops_by_line)))
+                    .application_periods(pt::time_period(start, pt::hours(2)));
+        } else {
+            impacter.on(nt::Type_e::MetaVehicleJourney, vj_uri(random_line(), random(params.nb_vjs_by_line)))
+                    .application_periods(pt::time_period(begin + day, pt::hours(24)));
+        }
+        return impacter.get_disruption();
+    }
+};
+
+template<typename F>
+static void bench(const std::string& name, const ed::builder& b, size_t nb_actions, F fun) {
+    const auto start = pt::microsec_clock::universal_time();
+    fun();
+    const double duration = (pt::microsec_clock::universal_time() - start).total_microseconds() / 1e6;
+    std::cout << name << ": " << nb_actions << " disruptions in " << duration << "s ("
+              << nb_actions / duration << " disruptions/s), "
+              << b.data->pt_data->vehicle_journeys.size() << " vjs" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    navitia::init_app();
+    Params params;
+    po::options_description desc("Options of the disruption application benchmark");
+    desc.add_options()
+        ("help,h", "Show this message")
+        ("lines,l", po::value<size_t>(&params.nb_lines)->default_value(50), "number of lines")
+        ("vjs,v", po::value<size_t>(&params.nb_vjs_by_line)->default_value(100), "number of vjs by line")
+        ("stops,s", po::value<size_t>(&params.nb_stops_by_line)->default_value(20), "number of stops by line")
+        ("disruptions,d", po::value<size_t>(&params.nb_disruptions)->default_value(5000),
+         "number of concurrent disruptions")
+        ("updates,u", po::value<size_t>(&params.nb_updates)->default_value(200),
+         "number of disruptions updated (deleted and applied again)")
+        ("stop_closure_ratio,r", po::value<double>(&params.stop_closure_ratio)->default_value(0.2),
+         "ratio of stop point closures among the disruptions, the others are cancellations");
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+        std::cout << desc << std::endl;
+        return 1;
+    }
+    po::notify(vm);
+
+    ed::builder b("20160101");
+    for (size_t l = 0; l < params.nb_lines; ++l) {
+        for (size_t v = 0; v < params.nb_vjs_by_line; ++v) {
+            auto vj = b.vj("L" + std::to_string(l));
+            vj.uri(vj_uri(l, v));
+            const int start = 5 * 3600 + int(v) * 600;
+            for (size_t s = 0; s < params.nb_stops_by_line; ++s) {
+                vj(stop_uri(l, s), start + int(s) * 120);
+            }
+        }
+    }
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+    b.data->build_uri();
+    std::cout << b.data->pt_data->vehicle_journeys.size() << " vjs, "
+              << b.data->pt_data->stop_points.size() << " stop points" << std::endl;
+
+    auto& pt_data = *b.data->pt_data;
+    const auto& meta = *b.data->meta;
+    DisruptionGenerator generator(params, b);
+    auto disruption_uri = [](size_t i) { return "disruption:" + std::to_string(i); };
+
+    bench("apply", b, params.nb_disruptions, [&]() {
+        for (size_t i = 0; i < params.nb_disruptions; ++i) {
+            navitia::apply_disruption(generator.create(disruption_uri(i)), pt_data, meta);
+        }
+    });
+    bench("update", b, params.nb_updates, [&]() {
+        for (size_t i = 0; i < params.nb_updates; ++i) {
+            // like for a chaos update, the disruption is deleted then applied again
+            const auto uri = disruption_uri(generator.random(params.nb_disruptions));
+            navitia::delete_disruption(uri, pt_data, meta);
+            navitia::apply_disruption(generator.create(uri), pt_data, meta);
+        }
+    });
+    bench("delete", b, params.nb_disruptions, [&]() {
+        for (size_t i = 0; i < params.nb_disruptions; ++i) {
+            navitia::delete_disruption(disruption_uri(i), pt_data, meta);
+        }
+    });
+    return 0;
+}
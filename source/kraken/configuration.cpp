@@ -69,6 +69,16 @@ po::options_description get_options_description(const boost::optional<std::strin
              po::value<bool>()->default_value(*display_contributors) : po::value<bool>()->default_value(false),
          "display all contributors in feed publishers")
         ("GENERAL.raptor_cache_size", po::value<int>()->default_value(10), "maximum number of stored raptor caches")
+        ("GENERAL.lazy_sections", po::value<std::vector<std::string>>(),
+         "sections of the data loaded at their first use (autocomplete, fare)")
+        ("GENERAL.skipped_sections", po::value<std::vector<std::string>>(),
+         "sections of the data never loaded (autocomplete, fare)")
+        ("GENERAL.departure_snapshot_cache_size", po::value<int>()->default_value(0),
+         "maximum number of stored daily departure snapshots (one by stop area and day), 0 to disable them")
+        ("GENERAL.enable_pb_fragment_cache", po::value<bool>()->default_value(false),
+         "keep the static parts of the protobuf of the lines, routes, networks and stop areas between the requests")
+        ("GENERAL.metrics_socket", po::value<std::string>(),
+         "zmq socket answering the metrics of kraken in the prometheus text format, disabled if not set")
         ("GENERAL.log_level", po::value<std::string>(), "log level of kraken")
         ("GENERAL.log_format", po::value<std::string>()->default_value("[%D{%y-%m-%d %H:%M:%S,%q}] [%p] [%x] - %m %b:%L  %n"), "log format")
 
@@ -213,6 +223,47 @@ size_t Configuration::raptor_cache_size() const{
     return size_t(raptor_cache_size);
 }
 
+size_t Configuration::departure_snapshot_cache_size() const{
+    if (! vm.count("GENERAL.departure_snapshot_cache_size")) {
+        return 0;
+    }
+    int departure_snapshot_cache_size = vm["GENERAL.departure_snapshot_cache_size"].as<int>();
+    if (departure_snapshot_cache_size < 0) {
+        throw std::invalid_argument("departure_snapshot_cache_size must be positive");
+    }
+    return size_t(departure_snapshot_cache_size);
+}
+
+bool Configuration::enable_pb_fragment_cache() const{
+    if (! vm.count("GENERAL.enable_pb_fragment_cache")) {
+        return false;
+    }
+    return vm["GENERAL.enable_pb_fragment_cache"].as<bool>();
+}
+
+navitia::type::SectionsLoading Configuration::sections_loading() const{
+    navitia::type::SectionsLoading result;
+    for (const auto& option: {std::make_pair("GENERAL.lazy_sections", navitia::type::SectionLoading::Lazy),
+                              std::make_pair("GENERAL.skipped_sections", navitia::type::SectionLoading::Skip)}) {
+        if (! vm.count(option.first)) { continue; }
+        for (const auto& name: vm[option.first].as<std::vector<std::string>>()) {
+            const auto section = navitia::type::data_section_from_string(name);
+            if (section == navitia::type::DataSection::Main) {
+                throw std::invalid_argument("the main section is always loaded");
+            }
+            result[section] = option.second;
+        }
+    }
+    return result;
+}
+
+boost::optional<std::string> Configuration::metrics_socket_path() const{
+    boost::optional<std::string> result;
+    if (this->vm.count("GENERAL.metrics_socket") > 0) {
+        result = this->vm["GENERAL.metrics_socket"].as<std::string>();
+    }
+    return result;
+}
 boost::optional<std::string> Configuration::log_level() const{
     boost::optional<std::string> result;
     if (this->vm.count("GENERAL.log_level") > 0) {
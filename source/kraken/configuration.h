@@ -31,6 +31,7 @@ www.navitia.io
 #pragma once
 #include <boost/program_options.hpp>
 #include <boost/optional.hpp>
+#include "type/data_sections.h"
 
 namespace navitia { namespace kraken{
 
@@ -60,7 +61,11 @@ namespace navitia { namespace kraken{
             int kirin_retry_timeout() const;
             bool display_contributors() const;
             size_t raptor_cache_size() const;
+            size_t departure_snapshot_cache_size() const;
+            bool enable_pb_fragment_cache() const;
+            navitia::type::SectionsLoading sections_loading() const;
             int slow_request_duration() const;
+            boost::optional<std::string> metrics_socket_path() const;
             boost::optional<std::string> log_level() const;
             boost::optional<std::string> log_format() const;
 
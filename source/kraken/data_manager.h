@@ -32,6 +32,7 @@ www.navitia.io
 
 #include "utils/timer.h"
 #include "utils/exception.h"
+#include "type/data_sections.h"
 #ifndef NO_FORCE_MEMORY_RELEASE
 //by default we force the release of the memory after the reload of the data
 #include "gperftools/malloc_extension.h"
@@ -40,8 +41,18 @@ www.navitia.io
 #include <memory>
 #include <iostream>
 #include <atomic>
+#include <list>
+#include <vector>
+#include <limits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <future>
 #include <boost/make_shared.hpp>
 #include <boost/optional.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 template<typename Data>
 void data_deleter(const Data* data){
@@ -53,11 +64,56 @@ void data_deleter(const Data* data){
 #endif
 }
 
+/**
+ * Hand the Data over from the maintenance thread to the workers.
+ *
+ * The workers pin the current Data through a Reader: pinning only publishes the
+ * current epoch in the reader's own slot, it does not touch the shared refcount.
+ * When a new Data is set, the old one is retired and a background thread drops
+ * it once no reader is still pinned on an older epoch, so the (long) destruction
+ * of a Data and the release of the memory never happen on a worker.
+ *
+ * A reader can give a warm up function: it is called, for all the readers in
+ * parallel, with each new Data before it is published.
+ *
+ * get_data() is still available for the maintenance thread and the tests: it
+ * returns a shared_ptr that keeps the Data alive as long as it is held.
+ */
 template<typename Data>
 class DataManager{
+    static constexpr size_t idle = std::numeric_limits<size_t>::max();
+
+    struct Retired {
+        boost::shared_ptr<const Data> data;
+        size_t epoch;
+    };
+
     boost::shared_ptr<const Data> current_data;
+    std::atomic<const Data*> current_raw;
+    std::atomic_size_t epoch;
     std::atomic_size_t data_identifier;
 
+    // the readers' slots hold the epoch they are pinned on, or idle.
+    // Each slot has its own cache line, so the pins of the workers do not invalidate
+    // each other's lines
+    struct alignas(64) Slot {
+        std::atomic_size_t epoch;
+        explicit Slot(size_t epoch): epoch(epoch) {}
+    };
+    static_assert(sizeof(Slot) == 64, "a slot must fill a cache line");
+    std::list<Slot> slots;
+    std::vector<Retired> retired;
+    std::mutex mutex;
+    std::condition_variable retired_cv;
+    std::condition_variable released_cv;
+    size_t nb_releasing = 0;
+    bool stopping = false;
+    std::thread releaser;
+
+    std::list<std::function<void(const Data&)>> warm_ups;
+    std::mutex warm_up_mutex;
+
+    std::function<void(const boost::posix_time::time_duration&)> swap_observer;
 
 private:
     boost::shared_ptr<Data> create_data(size_t id){
@@ -68,37 +124,194 @@ private:
         return boost::shared_ptr<const Data>(d, data_deleter<Data>);
     }
 
+    // oldest epoch a reader is pinned on, must be called with the mutex held
+    size_t oldest_pinned_epoch() const {
+        size_t oldest = idle;
+        for (const auto& slot: slots) {
+            oldest = std::min(oldest, slot.epoch.load());
+        }
+        return oldest;
+    }
+
+    void release_loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (! stopping) {
+            if (retired.empty()) {
+                retired_cv.wait(lock);
+                continue;
+            }
+            const auto oldest = oldest_pinned_epoch();
+            std::vector<boost::shared_ptr<const Data>> to_release;
+            auto it = retired.begin();
+            while (it != retired.end()) {
+                if (it->epoch <= oldest) {
+                    to_release.push_back(std::move(it->data));
+                    it = retired.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (! to_release.empty()) {
+                // the destruction of a Data is long, we do not want to block the readers' registration
+                ++ nb_releasing;
+                lock.unlock();
+                to_release.clear();
+                lock.lock();
+                -- nb_releasing;
+                released_cv.notify_all();
+            } else {
+                // a reader is still on an old epoch, its requests are short so we just poll
+                retired_cv.wait_for(lock, std::chrono::milliseconds(10));
+            }
+        }
+    }
+
+    void warm_up(const Data& data) {
+        std::lock_guard<std::mutex> lock(warm_up_mutex);
+        if (warm_ups.empty()) { return; }
+        time_it("Warm up of the readers: ", [&]() {
+            std::vector<std::future<void>> futures;
+            for (const auto& warm_up: warm_ups) {
+                futures.push_back(std::async(std::launch::async, [&]() { warm_up(data); }));
+            }
+            for (auto& future: futures) { future.wait(); }
+            for (auto& future: futures) { future.get(); }
+        });
+    }
+
 public:
+    /**
+     * A reader is owned by one worker thread and must not outlive the DataManager.
+     *
+     * Usage:
+     *   DataManager<Data>::Reader reader(data_manager);
+     *   {
+     *       const auto data = reader.pin();
+     *       // use *data, it stays valid until data is destroyed
+     *   }
+     */
+    class Reader {
+        DataManager& manager;
+        typename std::list<Slot>::iterator slot;
+        boost::optional<typename std::list<std::function<void(const Data&)>>::iterator> warm_up;
+    public:
+        class Pin {
+            const Data* data;
+            std::atomic_size_t* slot;
+        public:
+            Pin(const Data* data, std::atomic_size_t* slot): data(data), slot(slot) {}
+            Pin(Pin&& other): data(other.data), slot(other.slot) { other.slot = nullptr; }
+            Pin(const Pin&) = delete;
+            Pin& operator=(const Pin&) = delete;
+            ~Pin() { if (slot) { slot->store(idle); } }
+            const Data& operator*() const { return *data; }
+            const Data* operator->() const { return data; }
+            const Data* get() const { return data; }
+        };
+
+        explicit Reader(DataManager& manager, std::function<void(const Data&)> warm_up_fun = {}):
+                manager(manager) {
+            if (warm_up_fun) {
+                std::lock_guard<std::mutex> lock(manager.warm_up_mutex);
+                warm_up = manager.warm_ups.insert(manager.warm_ups.end(), std::move(warm_up_fun));
+            }
+            std::lock_guard<std::mutex> lock(manager.mutex);
+            slot = manager.slots.emplace(manager.slots.end(), idle);
+        }
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        ~Reader() {
+            if (warm_up) {
+                std::lock_guard<std::mutex> lock(manager.warm_up_mutex);
+                manager.warm_ups.erase(*warm_up);
+            }
+            std::lock_guard<std::mutex> lock(manager.mutex);
+            manager.slots.erase(slot);
+            manager.retired_cv.notify_all();
+        }
+
+        // only one Pin of a Reader can be alive at a time
+        Pin pin() {
+            // the epoch is published before reading the pointer: if we read the old
+            // pointer, the releaser will see our slot and keep the old Data alive
+            slot->epoch.store(manager.epoch.load());
+            return Pin(manager.current_raw.load(), &slot->epoch);
+        }
+    };
 
     DataManager() : current_data(create_data(0)){
+        current_raw = current_data.get();
+        epoch = 0;
         data_identifier = 0;
+        releaser = std::thread(&DataManager::release_loop, this);
+    }
+
+    ~DataManager() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        retired_cv.notify_all();
+        releaser.join();
     }
 
     void set_data(const Data* d) { set_data(create_ptr(d)); }
     void set_data(boost::shared_ptr<const Data>&& data) {
         if (!data) { throw navitia::exception("Giving a null Data to DataManager::set_data"); }
-        data->is_connected_to_rabbitmq = current_data->is_connected_to_rabbitmq.load();
-        current_data = std::move(data);
+        const auto start = boost::posix_time::microsec_clock::universal_time();
+        warm_up(*data);
+        auto old_data = boost::atomic_load(&current_data);
+        data->is_connected_to_rabbitmq = old_data->is_connected_to_rabbitmq.load();
+        current_raw.store(data.get());
+        boost::atomic_store(&current_data, boost::shared_ptr<const Data>(std::move(data)));
+        // readers pinned on an epoch older than this one may still use old_data
+        const size_t retired_epoch = ++epoch;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            retired.push_back({std::move(old_data), retired_epoch});
+        }
+        retired_cv.notify_all();
+        if (swap_observer) {
+            swap_observer(boost::posix_time::microsec_clock::universal_time() - start);
+        }
+    }
+
+    /// Called by set_data with the duration of the publication of each new Data, warm up
+    /// included. Must be set before any Data is set.
+    void set_swap_observer(std::function<void(const boost::posix_time::time_duration&)> observer) {
+        swap_observer = std::move(observer);
     }
-    boost::shared_ptr<const Data> get_data() const { return current_data; }
+    boost::shared_ptr<const Data> get_data() const { return boost::atomic_load(&current_data); }
     boost::shared_ptr<Data> get_data_clone() {
         ++ data_identifier;
         auto data = create_data(data_identifier.load());
-        time_it("Clone data: ", [&]() { data->clone_from(*current_data); });
+        time_it("Clone data: ", [&]() { data->clone_from(*get_data()); });
         return std::move(data);
     }
 
+    // block until all the retired Data have been handed to the releaser thread and dropped
+    void wait_for_release() {
+        std::unique_lock<std::mutex> lock(mutex);
+        released_cv.wait(lock, [&]() { return (retired.empty() && nb_releasing == 0) || stopping; });
+    }
+
     bool load(const std::string& database,
               const boost::optional<std::string>& chaos_database = boost::none,
               const std::vector<std::string>& contributors = {},
-              const size_t raptor_cache_size = 10){
+              const size_t raptor_cache_size = 10,
+              const size_t departure_snapshot_cache_size = 0,
+              const navitia::type::SectionsLoading& sections_loading = {}){
         bool success;
         ++ data_identifier;
         auto data = create_data(data_identifier.load());
-        success = data->load(database, chaos_database, contributors, raptor_cache_size);
+        success = data->load(database, chaos_database, contributors, raptor_cache_size,
+                             departure_snapshot_cache_size, sections_loading);
         if (success) {
             set_data(std::move(data));
         }
         return success;
     }
 };
+
+template<typename Data>
+constexpr size_t DataManager<Data>::idle;
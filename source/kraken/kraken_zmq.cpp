@@ -86,6 +86,10 @@ int main(int argn, char** argv){
     }
 
     DataManager<navitia::type::Data> data_manager;
+    navitia::Metrics metrics;
+    data_manager.set_swap_observer([&metrics](const boost::posix_time::time_duration& duration) {
+        metrics.record_data_swap(duration);
+    });
 
     auto logger = log4cplus::Logger::getInstance("startup");
     LOG4CPLUS_INFO(logger, "starting kraken: " << navitia::config::project_version);
@@ -109,7 +113,14 @@ int main(int argn, char** argv){
     // Launch pool of worker threads
     LOG4CPLUS_INFO(logger, "starting workers threads");
     for(int thread_nbr = 0; thread_nbr < nb_threads; ++thread_nbr) {
-        threads.create_thread(std::bind(&doWork, std::ref(context), std::ref(data_manager), conf));
+        threads.create_thread(std::bind(&doWork, std::ref(context), std::ref(data_manager),
+                                        std::ref(metrics), conf));
+    }
+
+    if (const auto metrics_socket = conf.metrics_socket_path()) {
+        LOG4CPLUS_INFO(logger, "serving the metrics on " << *metrics_socket);
+        threads.create_thread(std::bind(&serve_metrics, std::ref(context), std::ref(data_manager),
+                                        std::cref(metrics), *metrics_socket));
     }
 
     // Connect worker threads to client threads via a queue
@@ -37,6 +37,7 @@ www.navitia.io
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include "kraken/configuration.h"
 #include "type/meta_data.h"
+#include "kraken/metrics.h"
 #include <log4cplus/ndc.h>
 
 
@@ -63,14 +64,19 @@ static void respond(zmq::socket_t& socket,
 namespace pt = boost::posix_time;
 inline void doWork(zmq::context_t& context,
                    DataManager<navitia::type::Data>& data_manager,
+                   navitia::Metrics& metrics,
                    navitia::kraken::Configuration conf) {
     auto logger = log4cplus::Logger::getInstance("worker");
+    auto& thread_metrics = metrics.register_thread();
 
     zmq::socket_t socket (context, ZMQ_REQ);
     socket.connect("inproc://workers");
     bool run = true;
     //Here we create the worker
     navitia::Worker w(conf);
+    // the planner of the worker is built before a new data is published
+    DataManager<navitia::type::Data>::Reader data_reader(data_manager,
+            [&w](const navitia::type::Data& data) { w.warm_up(data); });
     z_send(socket, "READY");
     auto slow_request_duration = pt::milliseconds(conf.slow_request_duration());
     while(run) {
@@ -105,7 +111,8 @@ inline void doWork(zmq::context_t& context,
         if(api != pbnavitia::METADATAS){
             LOG4CPLUS_DEBUG(logger, "receive request: " << pb_req.DebugString());
         }
-        const auto data = data_manager.get_data();
+        // the data is pinned until the end of the request
+        const auto data = data_reader.pin();
         try {
             w.dispatch(pb_req, *data);
             if(api != pbnavitia::METADATAS){
@@ -125,6 +132,8 @@ inline void doWork(zmq::context_t& context,
         }
         respond(socket, address, w.pb_creator.get_response());
         auto duration = pt::microsec_clock::universal_time() - start;
+        thread_metrics.record_request(api, duration);
+        w.report_metrics(thread_metrics);
         if(duration >= slow_request_duration){
             LOG4CPLUS_WARN(logger, "slow request! duration: " << duration.total_milliseconds()
                                 << "ms request: " << pb_req.DebugString());
@@ -133,3 +142,35 @@ inline void doWork(zmq::context_t& context,
         }
     }
 }
+
+/// Answer each request on the metrics socket with the metrics in the prometheus text format
+inline void serve_metrics(zmq::context_t& context,
+                          DataManager<navitia::type::Data>& data_manager,
+                          const navitia::Metrics& metrics,
+                          const std::string& socket_path) {
+    auto logger = log4cplus::Logger::getInstance("metrics");
+
+    zmq::socket_t socket(context, ZMQ_REP);
+    try {
+        socket.bind(socket_path.c_str());
+    } catch (const zmq::error_t& e) {
+        LOG4CPLUS_ERROR(logger, "unable to bind the metrics socket " << socket_path << ": " << e.what());
+        return;
+    }
+    DataManager<navitia::type::Data>::Reader data_reader(data_manager);
+    while (true) {
+        zmq::message_t request;
+        try {
+            socket.recv(&request);
+        } catch (const zmq::error_t&) {
+            // interrupted by a signal
+            continue;
+        }
+        std::string response;
+        {
+            const auto data = data_reader.pin();
+            response = metrics.to_prometheus(data.get());
+        }
+        z_send(socket, response);
+    }
+}
@@ -35,6 +35,7 @@ www.navitia.io
 #include "realtime.h"
 #include "type/task.pb.h"
 #include "type/pt_data.h"
+#include "type/pb_fragment_cache.h"
 #include <boost/algorithm/string/join.hpp>
 #include <boost/optional.hpp>
 #include <sys/stat.h>
@@ -42,6 +43,8 @@ www.navitia.io
 #include <SimpleAmqpClient/Envelope.h>
 #include <chrono>
 #include <thread>
+#include <future>
+#include <atomic>
 #include "utils/get_hostname.h"
 
 namespace nt = navitia::type;
@@ -57,10 +60,13 @@ void MaintenanceWorker::load(){
     auto chaos_database = conf.chaos_database();
     auto contributors = conf.rt_topics();
     LOG4CPLUS_INFO(logger, "Loading database from file: " + database);
-    if(this->data_manager.load(database, chaos_database, contributors, conf.raptor_cache_size())){
+    if(this->data_manager.load(database, chaos_database, contributors, conf.raptor_cache_size(),
+                               conf.departure_snapshot_cache_size(), conf.sections_loading())){
         auto data = data_manager.get_data();
         data->is_realtime_loaded = false;
         data->meta->instance_name = conf.instance_name();
+        // the clones of the data keep this setting
+        data->pb_fragment_cache->set_enabled(conf.enable_pb_fragment_cache());
     }
     load_realtime();
 }
@@ -156,17 +162,54 @@ void MaintenanceWorker::handle_task_in_batch(const std::vector<AmqpClient::Envel
 }
 
 
+/*
+ * Parse the feed messages of the envelopes with several threads, the big
+ * full network updates take a noticeable time to decode.
+ * Return false if one of the messages is not valid.
+ */
+static bool parse_feed_messages(const std::vector<AmqpClient::Envelope::ptr_t>& envelopes,
+                                std::vector<transit_realtime::FeedMessage>& feed_messages) {
+    feed_messages.resize(envelopes.size());
+    const size_t nb_threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                               envelopes.size());
+    std::atomic_size_t next(0);
+    std::vector<std::future<bool>> workers;
+    for (size_t i = 0; i < nb_threads; ++i) {
+        workers.push_back(std::async(std::launch::async, [&]() {
+            bool valid = true;
+            for (size_t idx = next++; idx < envelopes.size(); idx = next++) {
+                assert(envelopes[idx]);
+                valid &= feed_messages[idx].ParseFromString(envelopes[idx]->Message()->Body());
+            }
+            return valid;
+        }));
+    }
+    bool valid = true;
+    for (auto& worker: workers) {
+        valid &= worker.get();
+    }
+    return valid;
+}
+
 void MaintenanceWorker::handle_rt_in_batch(const std::vector<AmqpClient::Envelope::ptr_t>& envelopes){
     boost::shared_ptr<nt::Data> data{};
     pt::ptime begin = pt::microsec_clock::universal_time();
-    for (auto& envelope: envelopes) {
-        LOG4CPLUS_DEBUG(logger, "realtime info received!");
-        assert(envelope);
-        transit_realtime::FeedMessage feed_message;
-        if(! feed_message.ParseFromString(envelope->Message()->Body())){
-            LOG4CPLUS_WARN(logger, "protobuf not valid!");
-            return;
-        }
+    LOG4CPLUS_DEBUG(logger, envelopes.size() << " realtime info received!");
+    std::vector<transit_realtime::FeedMessage> feed_messages;
+    if (! parse_feed_messages(envelopes, feed_messages)) {
+        LOG4CPLUS_WARN(logger, "protobuf not valid!");
+        return;
+    }
+
+    // the consecutive trip updates are applied together, the meta vjs in parallel
+    std::vector<TripUpdateEntity> trip_updates;
+    const size_t nb_threads = std::max(1u, std::thread::hardware_concurrency());
+    auto apply_trip_updates = [&]() {
+        if (trip_updates.empty()) { return; }
+        handle_realtime(trip_updates, *data, nb_threads);
+        trip_updates.clear();
+    };
+    for (const auto& feed_message: feed_messages) {
         LOG4CPLUS_TRACE(logger, "received entity: " << feed_message.DebugString());
         for(const auto& entity: feed_message.entity()){
             if (!data) {
@@ -175,26 +218,30 @@ void MaintenanceWorker::handle_rt_in_batch(const std::vector<AmqpClient::Envelop
                 LOG4CPLUS_INFO(logger, "data copied in " << (data->last_rt_data_loaded - begin));
             }
             if (entity.is_deleted()) {
+                apply_trip_updates();
                 LOG4CPLUS_DEBUG(logger, "deletion of disruption " << entity.id());
                 delete_disruption(entity.id(), *data->pt_data, *data->meta);
             } else if(entity.HasExtension(chaos::disruption)) {
+                apply_trip_updates();
                 LOG4CPLUS_DEBUG(logger, "add/update of disruption " << entity.id());
                 make_and_apply_disruption(entity.GetExtension(chaos::disruption), *data->pt_data, *data->meta);
             } else if(entity.has_trip_update()) {
                 LOG4CPLUS_DEBUG(logger, "RT trip update" << entity.id());
-                handle_realtime(entity.id(),
-                                navitia::from_posix_timestamp(feed_message.header().timestamp()),
-                                entity.trip_update(),
-                                *data);
+                trip_updates.push_back({entity.id(),
+                                        navitia::from_posix_timestamp(feed_message.header().timestamp()),
+                                        &entity.trip_update()});
             } else {
                 LOG4CPLUS_WARN(logger, "unsupported gtfs rt feed");
             }
         }
     }
+    apply_trip_updates();
     if (data) {
         data->pt_data->clean_weak_impacts();
         LOG4CPLUS_INFO(logger, "rebuilding data raptor");
-        data->build_raptor(conf.raptor_cache_size());
+        data->build_raptor(conf.raptor_cache_size(), conf.departure_snapshot_cache_size());
+        // data is a clone of the current data, only the indexes of the vjs have changed
+        data->build_ptref_indexes(*data_manager.get_data());
         data_manager.set_data(std::move(data));
         LOG4CPLUS_INFO(logger, "data updated " << envelopes.size() << " disrutpion applied in "
                                                << pt::microsec_clock::universal_time() - begin);
@@ -0,0 +1,255 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "metrics.h"
+#include "type/data.h"
+#include "type/pb_fragment_cache.h"
+#include "routing/dataraptor.h"
+#include "routing/next_stop_time.h"
+#include "routing/departure_snapshot.h"
+#include "ptreferential/query_plan.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <tuple>
+
+namespace navitia {
+
+constexpr size_t Histogram::sub_bucket_bits;
+constexpr size_t Histogram::max_value_bits;
+constexpr uint64_t Histogram::max_value;
+constexpr size_t Histogram::nb_buckets;
+
+// the values under linear_limit have their own bucket
+static constexpr uint64_t linear_limit = uint64_t(1) << (Histogram::sub_bucket_bits + 1);
+static constexpr uint64_t nb_sub_buckets = uint64_t(1) << Histogram::sub_bucket_bits;
+
+Histogram::Histogram(): counts(nb_buckets) {}
+
+size_t Histogram::bucket_index(uint64_t value) {
+    value = std::min(value, max_value);
+    if (value < linear_limit) { return value; }
+    // position of the highest bit, at least sub_bucket_bits + 1
+    const size_t exponent = 63 - __builtin_clzll(value);
+    const size_t shift = exponent - sub_bucket_bits;
+    return linear_limit + (exponent - sub_bucket_bits - 1) * nb_sub_buckets
+        + ((value >> shift) & (nb_sub_buckets - 1));
+}
+
+uint64_t Histogram::lowest_value(size_t index) {
+    if (index < linear_limit) { return index; }
+    const size_t k = index - linear_limit;
+    const size_t shift = k / nb_sub_buckets + 1;
+    return (nb_sub_buckets + k % nb_sub_buckets) << shift;
+}
+
+uint64_t Histogram::highest_value(size_t index) {
+    if (index < linear_limit) { return index; }
+    const size_t shift = (index - linear_limit) / nb_sub_buckets + 1;
+    return lowest_value(index) + (uint64_t(1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value) {
+    counts[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(std::min(value, max_value), std::memory_order_relaxed);
+}
+
+void Histogram::record(const boost::posix_time::time_duration& duration) {
+    record(duration.is_negative() ? 0 : uint64_t(duration.total_microseconds()));
+}
+
+void Histogram::add_to(Snapshot& snapshot) const {
+    for (size_t i = 0; i < nb_buckets; ++i) {
+        const uint64_t nb = counts[i].load(std::memory_order_relaxed);
+        snapshot.counts[i] += nb;
+        snapshot.count += nb;
+    }
+    snapshot.sum += sum.load(std::memory_order_relaxed);
+}
+
+Histogram::Snapshot::Snapshot(): counts(nb_buckets, 0) {}
+
+uint64_t Histogram::Snapshot::value_at_quantile(double quantile) const {
+    if (count == 0) { return 0; }
+    const auto rank = std::max<uint64_t>(1, uint64_t(std::ceil(quantile * count)));
+    uint64_t nb_lower = 0;
+    for (size_t i = 0; i < nb_buckets; ++i) {
+        nb_lower += counts[i];
+        if (nb_lower >= rank) { return highest_value(i); }
+    }
+    return max_value;
+}
+
+static const google::protobuf::EnumValueDescriptor* api_value(pbnavitia::API api) {
+    return pbnavitia::API_descriptor()->FindValueByNumber(api);
+}
+
+ThreadMetrics::ThreadMetrics(): durations_by_api(pbnavitia::API_descriptor()->value_count()) {}
+
+ThreadMetrics::~ThreadMetrics() {
+    for (auto& histogram: durations_by_api) {
+        delete histogram.load();
+    }
+}
+
+void ThreadMetrics::record_request(pbnavitia::API api, const boost::posix_time::time_duration& duration) {
+    const auto* value = api_value(api);
+    if (! value) { return; }
+    auto& slot = durations_by_api[value->index()];
+    // only this thread writes the slot
+    Histogram* histogram = slot.load(std::memory_order_relaxed);
+    if (! histogram) {
+        histogram = new Histogram();
+        slot.store(histogram, std::memory_order_release);
+    }
+    histogram->record(duration);
+}
+
+const Histogram* ThreadMetrics::request_durations(pbnavitia::API api) const {
+    const auto* value = api_value(api);
+    if (! value) { return nullptr; }
+    return durations_by_api[value->index()].load(std::memory_order_acquire);
+}
+
+ThreadMetrics& Metrics::register_thread() {
+    std::lock_guard<std::mutex> lock(mutex);
+    threads.emplace_back();
+    return threads.back();
+}
+
+void Metrics::record_data_swap(const boost::posix_time::time_duration& duration) {
+    data_swap_durations.record(duration);
+}
+
+static void write_summary(std::ostream& os,
+                          const std::string& name,
+                          const std::string& labels,
+                          const Histogram::Snapshot& snapshot) {
+    const std::string sep = labels.empty() ? "" : ",";
+    for (const double quantile: {0.5, 0.9, 0.99, 0.999}) {
+        os << name << "{" << labels << sep << "quantile=\"" << quantile << "\"} "
+           << snapshot.value_at_quantile(quantile) / 1e6 << "\n";
+    }
+    const std::string braced_labels = labels.empty() ? "" : "{" + labels + "}";
+    os << name << "_sum" << braced_labels << " " << snapshot.sum / 1e6 << "\n";
+    os << name << "_count" << braced_labels << " " << snapshot.count << "\n";
+}
+
+static void write_header(std::ostream& os, const std::string& name,
+                         const std::string& type, const std::string& help) {
+    os << "# HELP " << name << " " << help << "\n";
+    os << "# TYPE " << name << " " << type << "\n";
+}
+
+std::string Metrics::to_prometheus(const type::Data* data) const {
+    std::ostringstream os;
+    os.precision(12);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    write_header(os, "kraken_request_duration_seconds", "summary",
+                 "Duration of the requests processed by the workers, by api");
+    const auto* api_descriptor = pbnavitia::API_descriptor();
+    for (int i = 0; i < api_descriptor->value_count(); ++i) {
+        const auto api = pbnavitia::API(api_descriptor->value(i)->number());
+        Histogram::Snapshot snapshot;
+        for (const auto& thread: threads) {
+            if (const auto* histogram = thread.request_durations(api)) {
+                histogram->add_to(snapshot);
+            }
+        }
+        if (snapshot.count == 0) { continue; }
+        write_summary(os, "kraken_request_duration_seconds",
+                      "api=\"" + api_descriptor->value(i)->name() + "\"", snapshot);
+    }
+
+    uint64_t nb_raptor_rounds = 0;
+    uint64_t nb_improved_labels = 0;
+    uint64_t nb_visited_vertices = 0;
+    uint64_t nb_pb_fragment_calls = 0;
+    uint64_t nb_pb_fragment_cache_miss = 0;
+    for (const auto& thread: threads) {
+        nb_raptor_rounds += thread.nb_raptor_rounds.load(std::memory_order_relaxed);
+        nb_improved_labels += thread.nb_improved_labels.load(std::memory_order_relaxed);
+        nb_visited_vertices += thread.nb_visited_vertices.load(std::memory_order_relaxed);
+        nb_pb_fragment_calls += thread.nb_pb_fragment_calls.load(std::memory_order_relaxed);
+        nb_pb_fragment_cache_miss += thread.nb_pb_fragment_cache_miss.load(std::memory_order_relaxed);
+    }
+    write_header(os, "kraken_raptor_rounds_total", "counter", "Number of rounds of the RAPTOR computations");
+    os << "kraken_raptor_rounds_total " << nb_raptor_rounds << "\n";
+    write_header(os, "kraken_raptor_improved_labels_total", "counter",
+                 "Number of labels improved by the RAPTOR computations");
+    os << "kraken_raptor_improved_labels_total " << nb_improved_labels << "\n";
+    write_header(os, "kraken_street_network_visited_vertices_total", "counter",
+                 "Number of vertices visited by the street network computations");
+    os << "kraken_street_network_visited_vertices_total " << nb_visited_vertices << "\n";
+
+    write_header(os, "kraken_data_swap_duration_seconds", "summary",
+                 "Duration of the publication of a new data, warm up of the workers included");
+    Histogram::Snapshot data_swaps;
+    data_swap_durations.add_to(data_swaps);
+    write_summary(os, "kraken_data_swap_duration_seconds", "", data_swaps);
+
+    if (data) {
+        // the caches are owned by the data, their figures start again at each data swap
+        std::vector<std::tuple<std::string, size_t, size_t>> caches;
+        if (data->dataRaptor && data->dataRaptor->cached_next_st_manager) {
+            const auto& cache = *data->dataRaptor->cached_next_st_manager;
+            caches.emplace_back("next_stop_time", cache.get_nb_calls(), cache.get_nb_cache_miss());
+        }
+        if (data->dataRaptor && data->dataRaptor->departure_snapshots) {
+            const auto& cache = *data->dataRaptor->departure_snapshots;
+            caches.emplace_back("departure_snapshot", cache.get_nb_calls(), cache.get_nb_cache_miss());
+        }
+        if (data->ptref_plan_cache) {
+            const auto& cache = *data->ptref_plan_cache;
+            caches.emplace_back("ptref_plan", cache.get_nb_calls(), cache.get_nb_cache_miss());
+        }
+        // counted by the workers, so it is not reset by a data swap
+        caches.emplace_back("pb_fragment", nb_pb_fragment_calls, nb_pb_fragment_cache_miss);
+        write_header(os, "kraken_cache_calls_total", "counter", "Number of calls to the caches of the data");
+        for (const auto& cache: caches) {
+            os << "kraken_cache_calls_total{cache=\"" << std::get<0>(cache) << "\"} " << std::get<1>(cache) << "\n";
+        }
+        write_header(os, "kraken_cache_misses_total", "counter", "Number of misses of the caches of the data");
+        for (const auto& cache: caches) {
+            os << "kraken_cache_misses_total{cache=\"" << std::get<0>(cache) << "\"} " << std::get<2>(cache) << "\n";
+        }
+        if (data->dataRaptor && data->dataRaptor->departure_snapshots) {
+            write_header(os, "kraken_departure_snapshots_memory_bytes", "gauge",
+                         "Memory used by the daily departure snapshots of the data");
+            os << "kraken_departure_snapshots_memory_bytes "
+               << data->dataRaptor->departure_snapshots->memory_footprint() << "\n";
+        }
+    }
+    return os.str();
+}
+
+}
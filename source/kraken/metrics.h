@@ -0,0 +1,143 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include "type/request.pb.h"
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace navitia {
+namespace type {
+class Data;
+}
+
+/**
+ * Distribution of durations in microseconds, with a bounded relative error (a HDR histogram)
+ *
+ * The values under 64 have their own bucket, then each power of 2 is split in 32
+ * buckets, so a value is known at 1/32 of its magnitude. The values are bounded to
+ * max_value (about 19 hours).
+ *
+ * A histogram has a single writer, but can be read by any thread while it is written.
+ */
+class Histogram {
+public:
+    static constexpr size_t sub_bucket_bits = 5;
+    static constexpr size_t max_value_bits = 36;
+    static constexpr uint64_t max_value = (uint64_t(1) << max_value_bits) - 1;
+    static constexpr size_t nb_buckets = (size_t(1) << (sub_bucket_bits + 1))
+        + (max_value_bits - sub_bucket_bits - 1) * (size_t(1) << sub_bucket_bits);
+
+    struct Snapshot {
+        std::vector<uint64_t> counts;
+        uint64_t count = 0;
+        uint64_t sum = 0;
+
+        Snapshot();
+        /// smallest value such that at least quantile * count values are lower or equal,
+        /// up to the precision of the histogram
+        uint64_t value_at_quantile(double quantile) const;
+    };
+
+    Histogram();
+    void record(uint64_t value);
+    void record(const boost::posix_time::time_duration& duration);
+    void add_to(Snapshot& snapshot) const;
+
+    static size_t bucket_index(uint64_t value);
+    static uint64_t lowest_value(size_t index);
+    static uint64_t highest_value(size_t index);
+
+private:
+    std::vector<std::atomic<uint64_t>> counts;
+    std::atomic<uint64_t> sum{0};
+};
+
+/**
+ * Metrics of a worker thread, only written by this thread
+ *
+ * The writes are relaxed atomic operations on the thread's own counters, so
+ * recording a request never waits for the other workers nor for the reader.
+ */
+class ThreadMetrics {
+public:
+    std::atomic<uint64_t> nb_raptor_rounds{0};
+    std::atomic<uint64_t> nb_improved_labels{0};
+    std::atomic<uint64_t> nb_visited_vertices{0};
+    std::atomic<uint64_t> nb_pb_fragment_calls{0};
+    std::atomic<uint64_t> nb_pb_fragment_cache_miss{0};
+
+    ThreadMetrics();
+    ~ThreadMetrics();
+    ThreadMetrics(const ThreadMetrics&) = delete;
+    ThreadMetrics& operator=(const ThreadMetrics&) = delete;
+
+    void record_request(pbnavitia::API api, const boost::posix_time::time_duration& duration);
+
+    /// nullptr if no request has been recorded for the api
+    const Histogram* request_durations(pbnavitia::API api) const;
+
+private:
+    // by index of the api in its enum, allocated at the first request of the api
+    std::vector<std::atomic<Histogram*>> durations_by_api;
+};
+
+/**
+ * Metrics of kraken, aggregated on demand in the prometheus text format
+ *
+ * Each worker thread gets its own ThreadMetrics, the durations of the data swaps
+ * are recorded by the maintenance thread.
+ */
+class Metrics {
+public:
+    /// the returned metrics live as long as this object
+    ThreadMetrics& register_thread();
+
+    /// must only be called by one thread
+    void record_data_swap(const boost::posix_time::time_duration& duration);
+
+    /// data, if given, is used for the figures of its caches
+    std::string to_prometheus(const type::Data* data = nullptr) const;
+
+private:
+    mutable std::mutex mutex;
+    std::list<ThreadMetrics> threads;
+    Histogram data_swap_durations;
+};
+
+}
@@ -39,7 +39,11 @@ www.navitia.io
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/optional.hpp>
+#include <atomic>
 #include <chrono>
+#include <exception>
+#include <future>
+#include <unordered_map>
 
 namespace navitia {
 
@@ -142,6 +146,7 @@ make_severity(const std::string& id,
               nt::disruption::Effect effect,
               const boost::posix_time::ptime& timestamp,
               nt::disruption::DisruptionHolder& holder) {
+    const auto lock = nt::RealtimeStaging::lock_shared();
     auto& weak_severity = holder.severities[id];
     if (auto severity = weak_severity.lock()) { return severity; }
 
@@ -201,6 +206,12 @@ static nt::disruption::StopTimeUpdate::Status get_status(const transit_realtime:
     }
 }
 
+// the holder is shared by the threads applying the realtime of independent meta vjs
+static nt::disruption::Disruption& make_disruption(const std::string& id, nt::disruption::DisruptionHolder& holder) {
+    const auto lock = nt::RealtimeStaging::lock_shared();
+    return holder.make_disruption(id, type::RTLevel::RealTime);
+}
+
 static const type::disruption::Disruption*
 create_disruption(const std::string& id,
                   const boost::posix_time::ptime& timestamp,
@@ -217,7 +228,7 @@ create_disruption(const std::string& id,
     const auto& mvj = *data.pt_data->meta_vjs.get_mut(trip_update.trip().trip_id());
 
     delete_disruption(id, *data.pt_data, *data.meta);
-    auto& disruption = holder.make_disruption(id, type::RTLevel::RealTime);
+    auto& disruption = make_disruption(id, holder);
     disruption.reference = disruption.uri;
     disruption.publication_period = data.meta->production_period();
     disruption.created_at = timestamp;
@@ -353,6 +364,7 @@ create_disruption(const std::string& id,
                     nd::make_pt_obj(nt::Type_e::MetaVehicleJourney, trip_update.trip().trip_id(), *data.pt_data),
                     impact, data.meta->production_date, nt::RTLevel::RealTime);
         // messages
+        const auto lock = nt::RealtimeStaging::lock_shared();
         disruption.add_impact(std::move(impact), holder);
     }
     // localization
@@ -394,4 +406,132 @@ void handle_realtime(const std::string& id,
     apply_disruption(*disruption, *data.pt_data, *data.meta);
 }
 
+
+namespace {
+
+struct MetaVjTripUpdates {
+    nt::MetaVehicleJourney* meta_vj;
+    std::vector<const TripUpdateEntity*> trip_updates;
+    bool independent = true;
+    explicit MetaVjTripUpdates(nt::MetaVehicleJourney* meta_vj): meta_vj(meta_vj) {}
+};
+
+bool is_only_on_meta_vj(const nd::Impact& impact, const nt::MetaVehicleJourney* meta_vj) {
+    for (const auto& entity: impact.informed_entities()) {
+        const auto* informed_meta_vj = boost::get<nt::MetaVehicleJourney*>(&entity);
+        if (! informed_meta_vj || *informed_meta_vj != meta_vj) { return false; }
+    }
+    return true;
+}
+
+// The impacts on the meta vj are applied again when its disruptions are replaced,
+// they must only be on this meta vj for it to be applied in parallel of the others.
+bool has_only_own_impacts(const nt::MetaVehicleJourney& meta_vj) {
+    for (const auto& weak_impact: meta_vj.impacted_by) {
+        const auto impact = weak_impact.lock();
+        if (impact && ! is_only_on_meta_vj(*impact, &meta_vj)) { return false; }
+    }
+    return true;
+}
+
+}
+
+void handle_realtime(const std::vector<TripUpdateEntity>& trip_updates,
+                     const type::Data& data,
+                     size_t nb_threads) {
+    if (nb_threads <= 1) {
+        for (const auto& trip_update: trip_updates) {
+            handle_realtime(trip_update.id, trip_update.timestamp, *trip_update.trip_update, data);
+        }
+        return;
+    }
+    auto log = log4cplus::Logger::getInstance("realtime");
+    auto& pt_data = *data.pt_data;
+
+    // grouped by meta vj, in the order of their first trip update
+    std::vector<MetaVjTripUpdates> groups;
+    std::unordered_map<const nt::MetaVehicleJourney*, size_t> group_by_meta_vj;
+    std::unordered_map<std::string, size_t> group_by_id;
+    // for each trip update, its group, none for the unknown vjs
+    std::vector<boost::optional<size_t>> group_of_trip_update;
+    for (const auto& trip_update: trip_updates) {
+        auto* meta_vj = pt_data.meta_vjs.get_mut(trip_update.trip_update->trip().trip_id());
+        if (! meta_vj) {
+            // handle_realtime only logs them
+            group_of_trip_update.push_back(boost::none);
+            continue;
+        }
+        const size_t group_idx = group_by_meta_vj.emplace(meta_vj, groups.size()).first->second;
+        if (group_idx == groups.size()) { groups.emplace_back(meta_vj); }
+        groups[group_idx].trip_updates.push_back(&trip_update);
+        group_of_trip_update.push_back(group_idx);
+        // a disruption replaced by the trip updates of two meta vjs links them
+        const size_t id_group_idx = group_by_id.emplace(trip_update.id, group_idx).first->second;
+        if (id_group_idx != group_idx) {
+            groups[group_idx].independent = groups[id_group_idx].independent = false;
+        }
+        // as does a replaced disruption on another object
+        const auto* disruption = pt_data.disruption_holder.get_disruption(trip_update.id);
+        if (! disruption) { continue; }
+        for (const auto& impact: disruption->get_impacts()) {
+            for (const auto& entity: impact->informed_entities()) {
+                const auto* informed_meta_vj = boost::get<nt::MetaVehicleJourney*>(&entity);
+                if (informed_meta_vj && *informed_meta_vj == meta_vj) { continue; }
+                groups[group_idx].independent = false;
+                if (! informed_meta_vj) { continue; }
+                const auto it = group_by_meta_vj.find(*informed_meta_vj);
+                if (it != group_by_meta_vj.end()) { groups[it->second].independent = false; }
+            }
+        }
+    }
+    std::vector<const MetaVjTripUpdates*> independent_groups;
+    for (auto& group: groups) {
+        group.independent = group.independent && has_only_own_impacts(*group.meta_vj);
+        if (group.independent) { independent_groups.push_back(&group); }
+    }
+    LOG4CPLUS_DEBUG(log, trip_updates.size() << " trip updates on " << groups.size() << " meta vjs, "
+                    << independent_groups.size() << " applied in parallel");
+
+    // the threads only read the index of the validity patterns of the pt_data
+    pt_data.index_validity_patterns();
+    std::mutex shared_mutex;
+    std::vector<std::unique_ptr<nt::RealtimeStaging>> stagings;
+    for (const auto* group: independent_groups) {
+        stagings.push_back(std::make_unique<nt::RealtimeStaging>(*group->meta_vj, shared_mutex));
+    }
+    std::atomic_size_t next(0);
+    std::vector<std::future<void>> workers;
+    for (size_t i = 0; i < std::min(nb_threads, independent_groups.size()); ++i) {
+        workers.push_back(std::async(std::launch::async, [&]() {
+            for (size_t idx = next++; idx < independent_groups.size(); idx = next++) {
+                nt::RealtimeStaging::Scope scope(*stagings[idx]);
+                for (const auto* trip_update: independent_groups[idx]->trip_updates) {
+                    handle_realtime(trip_update->id, trip_update->timestamp, *trip_update->trip_update, data);
+                }
+            }
+        }));
+    }
+    std::exception_ptr error;
+    for (auto& worker: workers) {
+        try {
+            worker.get();
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+    // merged in the order of the groups, so that the vjs are in the same order at each run
+    for (auto& staging: stagings) {
+        staging->merge(pt_data);
+    }
+    pt_data.disruption_holder.clean_weak_impacts();
+    if (error) { std::rethrow_exception(error); }
+
+    // the other trip updates may depend on each other, they are applied in their order
+    for (size_t i = 0; i < trip_updates.size(); ++i) {
+        const auto& group_idx = group_of_trip_update[i];
+        if (group_idx && groups[*group_idx].independent) { continue; }
+        handle_realtime(trip_updates[i].id, trip_updates[i].timestamp, *trip_updates[i].trip_update, data);
+    }
+}
+
 }
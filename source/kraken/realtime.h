@@ -40,4 +40,23 @@ void handle_realtime(const std::string& id,
                      const transit_realtime::TripUpdate&,
                      const type::Data&);
 
+/// A trip update, with the id of its feed entity and the timestamp of its feed message
+struct TripUpdateEntity {
+    std::string id;
+    boost::posix_time::ptime timestamp;
+    const transit_realtime::TripUpdate* trip_update;
+};
+
+/**
+ * Apply a batch of trip updates, as handle_realtime on each of them in their order.
+ *
+ * The trip updates are grouped by meta vj, and the groups of the meta vjs that are only
+ * impacted by themselves are applied by nb_threads threads, each group with its own
+ * type::RealtimeStaging, merged when all the threads are done. The other groups are
+ * then applied by the current thread.
+ */
+void handle_realtime(const std::vector<TripUpdateEntity>& trip_updates,
+                     const type::Data&,
+                     size_t nb_threads);
+
 }
@@ -2255,3 +2255,113 @@ BOOST_AUTO_TEST_CASE(test_indexes_after_applying_disruption) {
     BOOST_REQUIRE_EQUAL(resp.vehicle_journeys(5).uri(), "vj:2:Adapted:1:Disruption_C:Disruption_D");
 
 }
+
+/*
+ * The impacts keep the list of the meta vjs they impact, the deletion of a disruption
+ * only resets these meta vjs and re-applies the other disruptions on them only
+ */
+BOOST_AUTO_TEST_CASE(delete_disruption_with_impacted_meta_vjs_index) {
+    ed::builder b("20160101");
+
+    b.sa("S1")("S1");
+    b.sa("S2")("S2");
+    b.sa("S3")("S3");
+
+    b.vj("A").uri("vj:A-1")("S1", "08:00"_t)("S2", "09:00"_t);
+    b.vj("A").uri("vj:A-2")("S1", "10:00"_t)("S2", "11:00"_t);
+    b.vj("B").uri("vj:B-1")("S3", "08:00"_t)("S2", "09:00"_t);
+
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+    b.data->build_uri();
+
+    const auto* mvj_A1 = b.data->pt_data->meta_vjs["vj:A-1"];
+    const auto* mvj_A2 = b.data->pt_data->meta_vjs["vj:A-2"];
+    const auto* mvj_B1 = b.data->pt_data->meta_vjs["vj:B-1"];
+
+    const auto& s1_closed = b.impact(nt::RTLevel::Adapted, "S1_closed")
+                              .severity(nt::disruption::Effect::NO_SERVICE)
+                              .on(nt::Type_e::StopPoint, "S1")
+                              .application_periods(btp("20160101T000000"_dt, "20160101T235900"_dt))
+                              .get_disruption();
+    navitia::apply_disruption(s1_closed, *b.data->pt_data, *b.data->meta);
+
+    const auto& a2_canceled = b.impact(nt::RTLevel::Adapted, "A2_canceled")
+                              .severity(nt::disruption::Effect::NO_SERVICE)
+                              .on(nt::Type_e::MetaVehicleJourney, "vj:A-2")
+                              .application_periods(btp("20160101T000000"_dt, "20160101T235900"_dt))
+                              .get_disruption();
+    navitia::apply_disruption(a2_canceled, *b.data->pt_data, *b.data->meta);
+
+    const auto& b1_canceled = b.impact(nt::RTLevel::Adapted, "B1_canceled")
+                              .severity(nt::disruption::Effect::NO_SERVICE)
+                              .on(nt::Type_e::MetaVehicleJourney, "vj:B-1")
+                              .application_periods(btp("20160101T000000"_dt, "20160101T235900"_dt))
+                              .get_disruption();
+    navitia::apply_disruption(b1_canceled, *b.data->pt_data, *b.data->meta);
+
+    const auto s1_impact = s1_closed.get_impacts().at(0);
+    const auto a2_impact = a2_canceled.get_impacts().at(0);
+    const auto b1_impact = b1_canceled.get_impacts().at(0);
+    BOOST_CHECK_EQUAL(s1_impact->impacted_meta_vjs.size(), 2);
+    BOOST_REQUIRE_EQUAL(a2_impact->impacted_meta_vjs.size(), 1);
+    BOOST_CHECK_EQUAL(a2_impact->impacted_meta_vjs.at(0), mvj_A2);
+    BOOST_REQUIRE_EQUAL(b1_impact->impacted_meta_vjs.size(), 1);
+    BOOST_CHECK_EQUAL(b1_impact->impacted_meta_vjs.at(0), mvj_B1);
+    BOOST_CHECK_EQUAL(mvj_A1->get_adapted_vj().size(), 1);
+
+    const auto& empty_vp = navitia::type::ValidityPattern::year_bitset();
+    const auto* vj_B1 = mvj_B1->get_base_vj().at(0).get();
+    BOOST_CHECK_EQUAL(vj_B1->adapted_validity_pattern()->days, empty_vp);
+
+    navitia::delete_disruption("S1_closed", *b.data->pt_data, *b.data->meta);
+
+    // vj:A-1 is back to its base schedule
+    const auto* vj_A1 = mvj_A1->get_base_vj().at(0).get();
+    BOOST_CHECK_EQUAL(vj_A1->adapted_validity_pattern()->days, vj_A1->base_validity_pattern()->days);
+    BOOST_CHECK(mvj_A1->impacted_by.empty());
+    // vj:A-2 has been reset, its cancellation has been re-applied
+    const auto* vj_A2 = mvj_A2->get_base_vj().at(0).get();
+    BOOST_CHECK_EQUAL(vj_A2->adapted_validity_pattern()->days, empty_vp);
+    BOOST_REQUIRE_EQUAL(a2_impact->impacted_meta_vjs.size(), 1);
+    BOOST_CHECK_EQUAL(a2_impact->impacted_meta_vjs.at(0), mvj_A2);
+    // vj:B-1 has not been touched
+    BOOST_CHECK_EQUAL(vj_B1->adapted_validity_pattern()->days, empty_vp);
+    BOOST_REQUIRE_EQUAL(b1_impact->impacted_meta_vjs.size(), 1);
+    BOOST_CHECK_EQUAL(mvj_B1->impacted_by.size(), 1);
+}
+
+/*
+ * The validity patterns are shared through get_or_create_validity_pattern and the
+ * ones not used anymore after the deletion of a disruption are deleted by clean_weak_impacts
+ */
+BOOST_FIXTURE_TEST_CASE(unused_validity_patterns_cleaned, SimpleDataset) {
+    auto& pt_data = *b.data->pt_data;
+    BOOST_REQUIRE_EQUAL(pt_data.validity_patterns.size(), 1);
+    auto* base_vp = pt_data.validity_patterns[0];
+    BOOST_CHECK_EQUAL(pt_data.get_or_create_validity_pattern(*base_vp), base_vp);
+
+    const auto& disrup = b.impact(nt::RTLevel::RealTime, "A1_canceled")
+                     .severity(nt::disruption::Effect::NO_SERVICE)
+                     .on(nt::Type_e::MetaVehicleJourney, "vj:A-1")
+                     .application_periods(btp("20150928T000000"_dt, "20150928T240000"_dt))
+                     .get_disruption();
+    apply(disrup);
+    BOOST_REQUIRE_EQUAL(pt_data.validity_patterns.size(), 2);
+    const auto* vj = pt_data.vehicle_journeys_map.at("vj:A-1");
+    auto* canceled_vp = vj->rt_validity_pattern();
+    BOOST_CHECK_EQUAL(pt_data.get_or_create_validity_pattern(*canceled_vp), canceled_vp);
+
+    // nothing is deleted while the validity patterns are used
+    pt_data.clean_weak_impacts();
+    BOOST_CHECK_EQUAL(pt_data.validity_patterns.size(), 2);
+
+    navitia::delete_disruption("A1_canceled", pt_data, *b.data->meta);
+    pt_data.clean_weak_impacts();
+    BOOST_REQUIRE_EQUAL(pt_data.validity_patterns.size(), 1);
+    BOOST_CHECK_EQUAL(pt_data.validity_patterns[0], base_vp);
+    BOOST_CHECK_EQUAL(base_vp->idx, 0);
+    BOOST_CHECK_EQUAL(vj->rt_validity_pattern(), base_vp);
+    BOOST_CHECK_EQUAL(pt_data.get_or_create_validity_pattern(*base_vp), base_vp);
+}
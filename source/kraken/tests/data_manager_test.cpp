@@ -35,29 +35,34 @@ www.navitia.io
 
 #include "kraken/data_manager.h"
 #include <atomic>
+#include <thread>
 
 //mock of navitia::type::Data class
 class Data{
     public:
-        bool load(const std::string&,
-                  const boost::optional<std::string>&,
-                  const std::vector<std::string>&,
-                  const size_t) {
+        // the mock accepts whatever DataManager::load gives after the database
+        template<typename... Args>
+        bool load(const std::string&, const Args&...) {
             return load_status;
         }
         mutable std::atomic<bool> is_connected_to_rabbitmq;
         static bool load_status;
         static bool destructor_called;
+        static std::thread::id destructor_thread;
         size_t data_identifier;
 
         Data(size_t data_identifier=0):
             data_identifier(data_identifier)
         {is_connected_to_rabbitmq = false;}
 
-        ~Data(){Data::destructor_called = true;}
+        ~Data(){
+            Data::destructor_called = true;
+            Data::destructor_thread = std::this_thread::get_id();
+        }
 };
 bool Data::load_status = true;
 bool Data::destructor_called = false;
+std::thread::id Data::destructor_thread;
 
 struct fixture{
     fixture(){
@@ -107,8 +112,80 @@ BOOST_AUTO_TEST_CASE(destructor_called){
         BOOST_CHECK_EQUAL(Data::destructor_called, false);
         first_data = boost::shared_ptr<Data>();
     }
+    data_manager.wait_for_release();
     BOOST_CHECK_EQUAL(Data::destructor_called, true);
     BOOST_CHECK(data_manager.get_data());
 }
 
+BOOST_AUTO_TEST_CASE(reader_pin){
+    DataManager<Data> data_manager;
+    DataManager<Data>::Reader reader(data_manager);
+    {
+        const auto pinned = reader.pin();
+        BOOST_CHECK_EQUAL(pinned.get(), data_manager.get_data().get());
+    }
+    BOOST_CHECK_EQUAL(Data::destructor_called, false);
+}
+
+BOOST_AUTO_TEST_CASE(pinned_data_released_in_background){
+    DataManager<Data> data_manager;
+    DataManager<Data>::Reader reader(data_manager);
+    std::thread::id worker_id;
+    {
+        auto first_pin = reader.pin();
+        const Data* first_data = first_pin.get();
+        BOOST_CHECK(data_manager.load(""));
+        // the old data is still pinned, it must not be destroyed
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        BOOST_CHECK_EQUAL(Data::destructor_called, false);
+        BOOST_CHECK_EQUAL(first_data->data_identifier, 0);
+        // the pin is released by another thread, like a worker at the end of a request
+        std::thread worker([&]() {
+            worker_id = std::this_thread::get_id();
+            auto pin = std::move(first_pin);
+        });
+        worker.join();
+    }
+    data_manager.wait_for_release();
+    BOOST_CHECK_EQUAL(Data::destructor_called, true);
+    BOOST_CHECK(Data::destructor_thread != std::this_thread::get_id());
+    BOOST_CHECK(Data::destructor_thread != worker_id);
+
+    // a new pin sees the new data
+    const auto second_pin = reader.pin();
+    BOOST_CHECK_EQUAL(second_pin->data_identifier, 1);
+}
+
+BOOST_AUTO_TEST_CASE(readers_warmed_up_before_publication){
+    DataManager<Data> data_manager;
+    // Boost.Test assertions are not thread safe, the warm ups only count
+    std::atomic<int> nb_warm_ups(0);
+    std::atomic<int> nb_published_before_warm_up(0);
+    auto warm_up = [&](const Data& data) {
+        if (data_manager.get_data().get() == &data) { ++ nb_published_before_warm_up; }
+        ++ nb_warm_ups;
+    };
+    DataManager<Data>::Reader first_reader(data_manager, warm_up);
+    DataManager<Data>::Reader second_reader(data_manager, warm_up);
+    DataManager<Data>::Reader reader_without_warm_up(data_manager);
+    BOOST_CHECK(data_manager.load(""));
+    BOOST_CHECK_EQUAL(nb_warm_ups, 2);
+    BOOST_CHECK_EQUAL(nb_published_before_warm_up, 0);
+    BOOST_CHECK_EQUAL(data_manager.get_data()->data_identifier, 1);
+}
+
+BOOST_AUTO_TEST_CASE(swap_observed){
+    DataManager<Data> data_manager;
+    std::vector<boost::posix_time::time_duration> swaps;
+    data_manager.set_swap_observer([&](const boost::posix_time::time_duration& duration) {
+        swaps.push_back(duration);
+    });
+    BOOST_CHECK(data_manager.load(""));
+    Data::load_status = false;
+    BOOST_CHECK(! data_manager.load(""));
+    Data::load_status = true;
+    BOOST_REQUIRE_EQUAL(swaps.size(), 1);
+    BOOST_CHECK(! swaps.front().is_negative());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,132 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE metrics_test
+#include <boost/test/unit_test.hpp>
+
+#include "kraken/metrics.h"
+#include "type/data.h"
+#include "routing/dataraptor.h"
+#include "routing/departure_snapshot.h"
+#include "utils/functions.h"
+#include <limits>
+#include <thread>
+
+using namespace navitia;
+namespace pt = boost::posix_time;
+
+BOOST_AUTO_TEST_CASE(histogram_buckets) {
+    for (uint64_t value = 0; value < 10000000; value += 1 + value / 100) {
+        const auto index = Histogram::bucket_index(value);
+        BOOST_REQUIRE_LT(index, Histogram::nb_buckets);
+        BOOST_REQUIRE_LE(Histogram::lowest_value(index), value);
+        BOOST_REQUIRE_LE(value, Histogram::highest_value(index));
+        // 1/32 of the value
+        BOOST_REQUIRE_LE((Histogram::highest_value(index) - Histogram::lowest_value(index)) * 32, value);
+    }
+    for (size_t index = 0; index + 1 < Histogram::nb_buckets; ++index) {
+        BOOST_REQUIRE_EQUAL(Histogram::highest_value(index) + 1, Histogram::lowest_value(index + 1));
+    }
+    BOOST_CHECK_EQUAL(Histogram::bucket_index(std::numeric_limits<uint64_t>::max()), Histogram::nb_buckets - 1);
+    BOOST_CHECK_EQUAL(Histogram::highest_value(Histogram::nb_buckets - 1), Histogram::max_value);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_quantiles) {
+    Histogram histogram;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        histogram.record(value * 1000);
+    }
+    Histogram::Snapshot snapshot;
+    histogram.add_to(snapshot);
+    BOOST_CHECK_EQUAL(snapshot.count, 1000);
+    BOOST_CHECK_EQUAL(snapshot.sum, 500500000);
+    for (const double quantile: {0.5, 0.9, 0.99}) {
+        const double expected = quantile * 1000000;
+        const auto value = snapshot.value_at_quantile(quantile);
+        BOOST_CHECK_GE(value, expected);
+        BOOST_CHECK_LE(value, expected * (1 + 1. / 32));
+    }
+    BOOST_CHECK_EQUAL(Histogram::Snapshot().value_at_quantile(0.5), 0);
+}
+
+BOOST_AUTO_TEST_CASE(requests_of_all_the_threads_aggregated) {
+    Metrics metrics;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&]() {
+            auto& thread_metrics = metrics.register_thread();
+            for (int i = 1; i <= 1000; ++i) {
+                thread_metrics.record_request(pbnavitia::PLANNER, pt::milliseconds(i));
+                thread_metrics.nb_raptor_rounds.fetch_add(3, std::memory_order_relaxed);
+                thread_metrics.nb_pb_fragment_calls.fetch_add(2, std::memory_order_relaxed);
+                thread_metrics.nb_pb_fragment_cache_miss.fetch_add(1, std::memory_order_relaxed);
+            }
+            thread_metrics.record_request(pbnavitia::places, pt::milliseconds(2));
+        });
+    }
+    // the metrics can be read while they are written
+    metrics.to_prometheus();
+    for (auto& thread: threads) { thread.join(); }
+    metrics.record_data_swap(pt::seconds(2));
+
+    const auto text = metrics.to_prometheus();
+    BOOST_CHECK(text.find("kraken_request_duration_seconds_count{api=\"PLANNER\"} 4000\n") != std::string::npos);
+    BOOST_CHECK(text.find("kraken_request_duration_seconds_count{api=\"places\"} 4\n") != std::string::npos);
+    // 2ms, up to the precision of the histogram
+    BOOST_CHECK(text.find("kraken_request_duration_seconds{api=\"places\",quantile=\"0.5\"} 0.0020")
+                != std::string::npos);
+    // no line for the apis without requests
+    BOOST_CHECK(text.find("api=\"STATUS\"") == std::string::npos);
+    BOOST_CHECK(text.find("kraken_raptor_rounds_total 12000\n") != std::string::npos);
+    BOOST_CHECK(text.find("kraken_data_swap_duration_seconds_sum 2\n") != std::string::npos);
+    BOOST_CHECK(text.find("kraken_data_swap_duration_seconds_count 1\n") != std::string::npos);
+    // no data, no cache
+    BOOST_CHECK(text.find("kraken_cache_calls_total") == std::string::npos);
+
+    type::Data data;
+    const auto text_with_data = metrics.to_prometheus(&data);
+    BOOST_CHECK(text_with_data.find("kraken_cache_calls_total{cache=\"pb_fragment\"} 8000\n") != std::string::npos);
+    BOOST_CHECK(text_with_data.find("kraken_cache_misses_total{cache=\"pb_fragment\"} 4000\n") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(caches_of_the_data) {
+    Metrics metrics;
+    type::Data data;
+    const auto text = metrics.to_prometheus(&data);
+    BOOST_CHECK(text.find("kraken_cache_calls_total{cache=\"ptref_plan\"} 0\n") != std::string::npos);
+    BOOST_CHECK(text.find("kraken_cache_misses_total{cache=\"pb_fragment\"} 0\n") != std::string::npos);
+    // the snapshots are disabled by default
+    BOOST_CHECK(text.find("kraken_departure_snapshots_memory_bytes") == std::string::npos);
+
+    data.dataRaptor->departure_snapshots = std::make_unique<routing::DepartureSnapshotManager>(10);
+    BOOST_CHECK(metrics.to_prometheus(&data).find("kraken_departure_snapshots_memory_bytes 0\n")
+                != std::string::npos);
+}
@@ -42,6 +42,10 @@ www.navitia.io
 #include "kraken/apply_disruption.h"
 #include "disruption/traffic_reports_api.h"
 #include "type/pb_converter.h"
+#include <boost/algorithm/string/join.hpp>
+#include <boost/range/algorithm/count_if.hpp>
+#include <boost/range/algorithm/sort.hpp>
+#include <boost/range/algorithm/unique.hpp>
 
 struct logger_initialized {
     logger_initialized()   { init_logger(); }
@@ -2049,3 +2053,141 @@ BOOST_AUTO_TEST_CASE(train_delayed_and_on_time) {
     BOOST_CHECK_EQUAL(res.journeys_size(), 1);
     BOOST_CHECK_EQUAL(res.impacts_size(), 1);
 }
+
+// the state of the pt_data modified by the realtime, independent of the order of the vjs
+static std::string realtime_state(const nt::PT_Data& pt_data) {
+    std::vector<std::string> vjs;
+    for (size_t i = 0; i < pt_data.vehicle_journeys.size(); ++i) {
+        const auto* vj = pt_data.vehicle_journeys[i];
+        BOOST_CHECK_EQUAL(vj->idx, i);
+        BOOST_CHECK_EQUAL(pt_data.vehicle_journeys_map.at(vj->uri), vj);
+        std::stringstream ss;
+        ss << vj->uri << " route " << vj->route->uri
+           << " mode " << (vj->physical_mode ? vj->physical_mode->uri : "none");
+        for (const auto l: navitia::enum_range<nt::RTLevel>()) {
+            ss << " vp " << vj->validity_patterns[l]->days.to_string();
+        }
+        for (const auto& st: vj->stop_time_list) {
+            ss << " " << st.stop_point->uri << " " << st.arrival_time << " " << st.departure_time
+               << " " << st.pick_up_allowed() << st.drop_off_allowed();
+        }
+        std::vector<std::string> impacts;
+        for (const auto& impact: vj->meta_vj->impacted_by) {
+            if (const auto i = impact.lock()) { impacts.push_back(i->uri); }
+        }
+        boost::sort(impacts);
+        ss << " impacts " << boost::algorithm::join(impacts, ",");
+        std::vector<std::string> headsign_vjs;
+        for (const auto* headsign_vj: pt_data.headsign_handler.get_vj_from_headsign(vj->name)) {
+            headsign_vjs.push_back(headsign_vj->uri);
+        }
+        boost::sort(headsign_vjs);
+        ss << " headsign " << boost::algorithm::join(headsign_vjs, ",");
+        vjs.push_back(ss.str());
+    }
+    boost::sort(vjs);
+
+    std::vector<std::string> route_vjs;
+    for (const auto* route: pt_data.routes) {
+        for (const auto* vj: route->discrete_vehicle_journey_list) { route_vjs.push_back(vj->uri); }
+    }
+    boost::sort(route_vjs);
+    std::vector<std::string> mode_vjs;
+    for (const auto* mode: pt_data.physical_modes) {
+        for (const auto* vj: mode->vehicle_journey_list) { mode_vjs.push_back(vj->uri); }
+    }
+    boost::sort(mode_vjs);
+    std::vector<std::string> vps;
+    for (const auto* vp: pt_data.validity_patterns) { vps.push_back(vp->days.to_string()); }
+    boost::sort(vps);
+
+    return boost::algorithm::join(vjs, "\n")
+        + "\nroutes " + boost::algorithm::join(route_vjs, ",")
+        + "\nmodes " + boost::algorithm::join(mode_vjs, ",")
+        + "\nnb vps " + std::to_string(vps.size()) + " " + std::to_string(boost::distance(boost::unique(vps)))
+        + "\nnb disruptions " + std::to_string(pt_data.disruption_holder.nb_disruptions())
+        + " nb impacts " + std::to_string(boost::count_if(pt_data.disruption_holder.get_weak_impacts(),
+                                          [](const boost::weak_ptr<nt::disruption::Impact>& i) {
+                                              return ! i.expired();
+                                          }));
+}
+
+/*
+ * A batch of trip updates must give the same data when the meta vjs are applied in
+ * parallel than when all the trip updates are applied one by one
+ */
+BOOST_AUTO_TEST_CASE(trip_updates_applied_in_parallel) {
+    using btp = boost::posix_time::time_period;
+    auto make_builder = []() -> std::unique_ptr<ed::builder> {
+        auto b = std::make_unique<ed::builder>("20150928");
+        for (int i = 1; i <= 8; ++i) {
+            const auto uri = "vj:" + std::to_string(i);
+            b->vj(i % 2 ? "A" : "B", "111111", "", true, uri)
+                ("stop1", "08:00"_t + i * "00:10"_t)("stop2", "09:00"_t + i * "00:10"_t)
+                ("stop3", "10:00"_t + i * "00:10"_t);
+        }
+        b->data->build_uri();
+        // vj:5 and vj:6 are impacted by a disruption shared with the other vjs of the stop,
+        // vj:7 by a disruption only on itself
+        const auto& on_stop = b->impact(nt::RTLevel::Adapted, "on_stop")
+                .severity(nt::disruption::Effect::NO_SERVICE)
+                .on(nt::Type_e::StopPoint, "stop3")
+                .application_periods(btp("20150929T104500"_dt, "20150929T110500"_dt))
+                .get_disruption();
+        navitia::apply_disruption(on_stop, *b->data->pt_data, *b->data->meta);
+        const auto& on_vj = b->impact(nt::RTLevel::RealTime, "on_vj")
+                .severity(nt::disruption::Effect::NO_SERVICE)
+                .on(nt::Type_e::MetaVehicleJourney, "vj:7")
+                .application_periods(btp("20150930T000000"_dt, "20150930T240000"_dt))
+                .get_disruption();
+        navitia::apply_disruption(on_vj, *b->data->pt_data, *b->data->meta);
+        return b;
+    };
+
+    auto delay = [](const std::string& vj_uri, const std::string& date, int i, int minutes)
+            -> transit_realtime::TripUpdate {
+        const auto day = boost::gregorian::from_undelimited_string(date);
+        const auto at = [&](const std::string& hour) {
+            return navitia::to_posix_timestamp(pt::ptime(day, pt::duration_from_string(hour))
+                                               + pt::minutes(10 * i + minutes));
+        };
+        return ntest::make_delay_message(vj_uri, date, {
+                DelayedTimeStop("stop1", at("08:00")).delay(pt::minutes(minutes)),
+                DelayedTimeStop("stop2", at("09:00")).delay(pt::minutes(minutes)),
+                DelayedTimeStop("stop3", at("10:00")).delay(pt::minutes(minutes))});
+    };
+    const std::vector<std::pair<std::string, transit_realtime::TripUpdate>> messages = {
+        {"d1", delay("vj:1", "20150928", 1, 5)},
+        {"d2", make_cancellation_message("vj:2", "20150928")},
+        {"d3", delay("vj:3", "20150929", 3, 10)},
+        // updated twice in the batch, the vj of the first update is deleted
+        {"d1", delay("vj:1", "20150928", 1, 15)},
+        {"d4", delay("vj:4", "20150928", 4, 20)},
+        {"d5", delay("vj:5", "20150929", 5, 5)},
+        {"d6", make_cancellation_message("vj:6", "20150928")},
+        {"d7", delay("vj:7", "20150928", 7, 5)},
+        // the disruption only on vj:7 is applied again on the update
+        {"d7", delay("vj:7", "20150928", 7, 10)},
+        // the same disruption on two vjs
+        {"d8", delay("vj:8", "20150928", 8, 5)},
+        {"d8", delay("vj:4", "20150929", 4, 5)},
+        {"d4", make_cancellation_message("vj:4", "20150930")},
+        {"unknown", make_cancellation_message("vj:unknown", "20150928")},
+    };
+    std::vector<navitia::TripUpdateEntity> trip_updates;
+    for (const auto& message: messages) {
+        trip_updates.push_back({message.first, timestamp, &message.second});
+    }
+
+    auto serial = make_builder();
+    navitia::handle_realtime(trip_updates, *serial->data, 1);
+    auto parallel = make_builder();
+    navitia::handle_realtime(trip_updates, *parallel->data, 4);
+
+    const auto serial_state = realtime_state(*serial->data->pt_data);
+    BOOST_CHECK_EQUAL(realtime_state(*parallel->data->pt_data), serial_state);
+    // the realtime has been applied
+    BOOST_CHECK(serial_state.find("vj:1:modified:") != std::string::npos);
+    BOOST_CHECK(serial_state.find("vj:3:modified:") != std::string::npos);
+    BOOST_CHECK_GT(parallel->data->pt_data->vehicle_journeys.size(), 8);
+}
@@ -331,17 +331,50 @@ void Worker::init_worker_data(const navitia::type::Data* data,
                               const pt::time_period action_period,
                               const bool disable_geojson,
                               const bool disable_feedpublisher){
-    //@TODO should be done in data_manager
     if(data->data_identifier != this->last_data_identifier || !planner){
-        planner = std::make_unique<routing::RAPTOR>(*data);
-        street_network_worker = std::make_unique<georef::StreetNetwork>(*data->geo_ref);
+        if (planner) {
+            // the buffers of the previous planner are reused, it is dropped with its data
+            auto previous_planner = std::move(planner);
+            planner = std::make_unique<routing::RAPTOR>(*data, std::move(*previous_planner));
+            LOG4CPLUS_DEBUG(logger, "Recycle the planner");
+        } else {
+            planner = std::make_unique<routing::RAPTOR>(*data);
+            LOG4CPLUS_INFO(logger, "Instanciate planner");
+        }
+        std::lock_guard<std::mutex> lock(warm_up_mutex);
+        if (warmed_street_network && warmed_data_identifier == data->data_identifier) {
+            street_network_worker = std::move(warmed_street_network);
+            LOG4CPLUS_DEBUG(logger, "Use the warmed up street network");
+        } else {
+            street_network_worker = std::make_unique<georef::StreetNetwork>(*data->geo_ref);
+        }
         this->last_data_identifier = data->data_identifier;
-        LOG4CPLUS_INFO(logger, "Instanciate planner");        
     }
     this->pb_creator.init(data, now, action_period, disable_geojson, disable_feedpublisher);
 }
 
 
+void Worker::warm_up(const nt::Data& data) {
+    auto start = pt::microsec_clock::universal_time();
+    {
+        std::lock_guard<std::mutex> lock(warm_up_mutex);
+        warmed_street_network.reset();
+    }
+    try {
+        auto new_street_network = std::make_unique<georef::StreetNetwork>(*data.geo_ref);
+
+        std::lock_guard<std::mutex> lock(warm_up_mutex);
+        warmed_street_network = std::move(new_street_network);
+        warmed_data_identifier = data.data_identifier;
+    } catch (const std::exception& e) {
+        // the worker will build its street network on its first request
+        LOG4CPLUS_WARN(logger, "warm up of the worker failed: " << e.what());
+        return;
+    }
+    LOG4CPLUS_INFO(logger, "worker warmed up in "
+                   << (pt::microsec_clock::universal_time() - start).total_milliseconds() << "ms");
+}
+
 void Worker::autocomplete(const pbnavitia::PlacesRequest & request) {
     const auto* data = this->pb_creator.data;
     navitia::autocomplete::autocomplete(this->pb_creator, request.q(),
@@ -999,6 +1032,26 @@ void Worker::direct_path(const pbnavitia::Request& request) {
 }
 
 
+void Worker::report_metrics(ThreadMetrics& metrics) {
+    if (planner) {
+        metrics.nb_raptor_rounds.fetch_add(planner->stats.nb_rounds, std::memory_order_relaxed);
+        metrics.nb_improved_labels.fetch_add(planner->stats.nb_improved_labels, std::memory_order_relaxed);
+        planner->stats = routing::RAPTOR::Stats();
+    }
+    if (street_network_worker) {
+        for (auto* path_finder: {&street_network_worker->departure_path_finder,
+                                 &street_network_worker->arrival_path_finder,
+                                 &street_network_worker->direct_path_finder}) {
+            metrics.nb_visited_vertices.fetch_add(path_finder->nb_visited_vertices, std::memory_order_relaxed);
+            path_finder->nb_visited_vertices = 0;
+        }
+    }
+    metrics.nb_pb_fragment_calls.fetch_add(pb_creator.nb_fragment_calls, std::memory_order_relaxed);
+    metrics.nb_pb_fragment_cache_miss.fetch_add(pb_creator.nb_fragment_cache_miss, std::memory_order_relaxed);
+    pb_creator.nb_fragment_calls = 0;
+    pb_creator.nb_fragment_cache_miss = 0;
+}
+
 void Worker::dispatch(const pbnavitia::Request& request, const nt::Data& data) {
     bool disable_geojson = get_geojson_state(request);
     boost::posix_time::ptime current_datetime = bt::from_time_t(request._current_datetime());
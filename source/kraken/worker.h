@@ -45,9 +45,11 @@ namespace routing{
 #include "utils/logger.h"
 #include "kraken/configuration.h"
 #include "type/pb_converter.h"
+#include "kraken/metrics.h"
 
 #include <memory>
 #include <limits>
+#include <mutex>
 
 namespace navitia {
 
@@ -79,6 +81,11 @@ class Worker {
         size_t last_data_identifier = std::numeric_limits<size_t>::max();// to check that data did not change, do not use directly
         boost::posix_time::ptime last_load_at;
 
+        // state built by warm_up for a data that is not yet published, taken by init_worker_data
+        std::mutex warm_up_mutex;
+        std::unique_ptr<navitia::georef::StreetNetwork> warmed_street_network;
+        size_t warmed_data_identifier = std::numeric_limits<size_t>::max();
+
     public:
         navitia::PbCreator pb_creator;
 
@@ -89,6 +96,20 @@ class Worker {
 
         void dispatch(const pbnavitia::Request& request, const nt::Data& data);
 
+        /**
+         * Build the street network for a new data, before it is published, so that
+         * the first request on it does not pay for it.
+         * Called by the DataManager from another thread.
+         *
+         * The planner is not built here: it would double the memory of the labels
+         * while the previous one is still used. It is rebuilt on the swap, from the
+         * buffers of the previous one.
+         */
+        void warm_up(const nt::Data& data);
+
+        /// Add the work done by the planner and the street network since the last call to the metrics
+        void report_metrics(ThreadMetrics& metrics);
+
     private:
         void init_worker_data(const navitia::type::Data* data,
                               const pt::ptime now,
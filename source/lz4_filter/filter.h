@@ -37,6 +37,17 @@ www.navitia.io
 #include <boost/iostreams/write.hpp>
 #include <boost/iostreams/read.hpp>
 #include <boost/cstdint.hpp>
+#include <boost/crc.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 typedef std::exception LZ4Exception;
 
@@ -135,3 +146,332 @@ public:
     }
 };
 
+
+/**
+ * Framed LZ4 format, used for big files like the data.nav:
+ *
+ *  header: "NLZ4" | uint32 version | uint32 block size
+ *  blocks: uint32 compressed size | uint32 raw size | uint32 crc32 of the raw data | compressed data
+ *  end:    uint32 0
+ *
+ * The blocks are big (4 MB by default) and independent, so they are compressed and
+ * decompressed in parallel by a pool of threads, the stream itself being read and
+ * written in order by the calling thread.
+ */
+namespace lz4_frame {
+
+const char magic[4] = {'N', 'L', 'Z', '4'};
+const uint32_t version = 1;
+const uint32_t default_block_size = 4 * 1024 * 1024;
+
+inline size_t default_nb_threads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+inline uint32_t checksum(const std::vector<char>& data) {
+    boost::crc_32_type crc;
+    crc.process_bytes(data.data(), data.size());
+    return crc.checksum();
+}
+
+/// true if the stream starts with a framed LZ4 header, the stream position is left unchanged
+inline bool is_framed(std::istream& is) {
+    const auto pos = is.tellg();
+    char header[sizeof(magic)] = {};
+    is.read(header, sizeof(header));
+    const bool res = is.gcount() == sizeof(header) && std::equal(header, header + sizeof(header), magic);
+    is.clear(is.rdstate() & ~(std::ios::failbit | std::ios::eofbit));
+    is.seekg(pos);
+    return res;
+}
+
+/// Fixed set of threads running the (de)compression tasks
+class WorkerPool {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::packaged_task<void()>> tasks;
+    bool stopped = false;
+    std::vector<std::thread> threads;
+
+    void work() {
+        for (;;) {
+            std::packaged_task<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]() { return stopped || ! tasks.empty(); });
+                if (tasks.empty()) { return; }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    explicit WorkerPool(size_t nb_threads) {
+        for (size_t i = 0; i < nb_threads; ++i) {
+            threads.emplace_back([this]() { work(); });
+        }
+    }
+
+    /// the pending tasks are dropped, their futures are broken
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+            tasks.clear();
+        }
+        cv.notify_all();
+        for (auto& thread: threads) { thread.join(); }
+    }
+
+    std::future<void> submit(std::function<void()> f) {
+        std::packaged_task<void()> task(std::move(f));
+        auto res = task.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        cv.notify_one();
+        return res;
+    }
+};
+
+struct Block {
+    std::vector<char> raw;
+    std::vector<char> compressed;
+    uint32_t checksum = 0;
+    size_t consumed = 0; // number of raw bytes already given to the reader
+    bool ready = false;
+    std::future<void> done;
+};
+
+/// the blocks in flight are declared before the pool, so the threads are joined before they are destroyed
+struct State {
+    std::deque<std::unique_ptr<Block>> blocks;
+    size_t max_blocks;
+    WorkerPool pool;
+    bool header_done = false;
+    bool end_reached = false;
+
+    explicit State(size_t nb_threads): max_blocks(2 * nb_threads), pool(nb_threads) {}
+
+    void wait_front() {
+        auto& block = *blocks.front();
+        if (! block.ready) {
+            block.done.get();
+            block.ready = true;
+        }
+    }
+};
+
+template<typename Sink>
+void write_all(Sink& dest, const char* data, std::streamsize size) {
+    if (boost::iostreams::write(dest, data, size) != size) {
+        throw std::runtime_error("lz4 frame: unable to write");
+    }
+}
+
+template<typename Sink>
+void write_uint32(Sink& dest, uint32_t value) {
+    write_all(dest, reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<typename Source>
+void read_all(Source& src, char* data, std::streamsize size) {
+    std::streamsize done = 0;
+    while (done < size) {
+        const auto read_size = boost::iostreams::read(src, data + done, size - done);
+        if (read_size <= 0) { throw std::runtime_error("lz4 frame: truncated stream"); }
+        done += read_size;
+    }
+}
+
+template<typename Source>
+uint32_t read_uint32(Source& src) {
+    uint32_t value = 0;
+    read_all(src, reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+}
+
+} // namespace lz4_frame
+
+/**
+ * Compression filter writing the framed LZ4 format
+ *
+ * The data are gathered in blocks of block_size bytes, each full block being compressed
+ * by a worker while the next one is filled. The filter must be closed to write the last block.
+ */
+class LZ4FrameCompressor : public boost::iostreams::multichar_output_filter {
+    uint32_t block_size;
+    size_t nb_threads;
+    std::shared_ptr<lz4_frame::State> state;
+    std::unique_ptr<lz4_frame::Block> current;
+
+    template<typename Sink>
+    void write_front(Sink& dest) {
+        state->wait_front();
+        const auto& block = *state->blocks.front();
+        lz4_frame::write_uint32(dest, block.compressed.size());
+        lz4_frame::write_uint32(dest, block.raw.size());
+        lz4_frame::write_uint32(dest, block.checksum);
+        lz4_frame::write_all(dest, block.compressed.data(), block.compressed.size());
+        state->blocks.pop_front();
+    }
+
+    template<typename Sink>
+    void submit_current(Sink& dest) {
+        auto* block = current.get();
+        block->done = state->pool.submit([block]() {
+            block->checksum = lz4_frame::checksum(block->raw);
+            block->compressed.resize(LZ4_compressBound(block->raw.size()));
+            const int size = LZ4_compress_default(block->raw.data(), block->compressed.data(),
+                                                  block->raw.size(), block->compressed.size());
+            if (size <= 0) { throw std::runtime_error("lz4 frame: compression failed"); }
+            block->compressed.resize(size);
+        });
+        state->blocks.push_back(std::move(current));
+        // we write the finished blocks as soon as possible, and wait when too many are in flight
+        while (! state->blocks.empty() &&
+               (state->blocks.size() > state->max_blocks ||
+                state->blocks.front()->done.wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+            write_front(dest);
+        }
+    }
+
+    template<typename Sink>
+    void start(Sink& dest) {
+        state = std::make_shared<lz4_frame::State>(nb_threads);
+        lz4_frame::write_all(dest, lz4_frame::magic, sizeof(lz4_frame::magic));
+        lz4_frame::write_uint32(dest, lz4_frame::version);
+        lz4_frame::write_uint32(dest, block_size);
+    }
+
+public:
+    /**
+     * @param block_size size of the uncompressed blocks
+     * @param nb_threads number of compression threads, 0 to use one per core
+     */
+    LZ4FrameCompressor(uint32_t block_size = lz4_frame::default_block_size, size_t nb_threads = 0):
+        block_size(block_size), nb_threads(nb_threads ? nb_threads : lz4_frame::default_nb_threads()) {}
+
+    // boost::iostreams copies the filters when pushing them, a copy starts a new stream
+    LZ4FrameCompressor(const LZ4FrameCompressor& other):
+        block_size(other.block_size), nb_threads(other.nb_threads) {}
+
+    template<typename Sink>
+    std::streamsize write(Sink& dest, const char* src, std::streamsize size) {
+        if (! state) { start(dest); }
+        std::streamsize done = 0;
+        while (done < size) {
+            if (! current) {
+                current.reset(new lz4_frame::Block());
+                current->raw.reserve(block_size);
+            }
+            const auto nb = std::min<std::streamsize>(size - done, block_size - current->raw.size());
+            current->raw.insert(current->raw.end(), src + done, src + done + nb);
+            done += nb;
+            if (current->raw.size() == block_size) { submit_current(dest); }
+        }
+        return size;
+    }
+
+    template<typename Sink>
+    void close(Sink& dest) {
+        if (! state) { start(dest); }
+        if (current && ! current->raw.empty()) { submit_current(dest); }
+        current.reset();
+        while (! state->blocks.empty()) { write_front(dest); }
+        lz4_frame::write_uint32(dest, 0);
+        state.reset();
+    }
+};
+
+/**
+ * Decompression filter reading the framed LZ4 format
+ *
+ * The next blocks are read ahead and decompressed by the workers while the
+ * current one is consumed. The checksum of each block is checked.
+ */
+class LZ4FrameDecompressor : public boost::iostreams::multichar_input_filter {
+    size_t nb_threads;
+    std::shared_ptr<lz4_frame::State> state;
+    uint32_t block_size = 0;
+
+    template<typename Source>
+    void start(Source& src) {
+        state = std::make_shared<lz4_frame::State>(nb_threads);
+        char header[sizeof(lz4_frame::magic)];
+        lz4_frame::read_all(src, header, sizeof(header));
+        if (! std::equal(header, header + sizeof(header), lz4_frame::magic)) {
+            throw std::runtime_error("lz4 frame: invalid header");
+        }
+        if (lz4_frame::read_uint32(src) != lz4_frame::version) {
+            throw std::runtime_error("lz4 frame: unknown version");
+        }
+        block_size = lz4_frame::read_uint32(src);
+    }
+
+    template<typename Source>
+    void read_block(Source& src) {
+        const auto compressed_size = lz4_frame::read_uint32(src);
+        if (compressed_size == 0) {
+            state->end_reached = true;
+            return;
+        }
+        const auto raw_size = lz4_frame::read_uint32(src);
+        if (raw_size > block_size || compressed_size > uint32_t(LZ4_compressBound(block_size))) {
+            throw std::runtime_error("lz4 frame: invalid block size");
+        }
+        std::unique_ptr<lz4_frame::Block> block(new lz4_frame::Block());
+        block->checksum = lz4_frame::read_uint32(src);
+        block->compressed.resize(compressed_size);
+        lz4_frame::read_all(src, block->compressed.data(), compressed_size);
+        block->raw.resize(raw_size);
+        auto* b = block.get();
+        block->done = state->pool.submit([b]() {
+            const int size = LZ4_decompress_safe(b->compressed.data(), b->raw.data(),
+                                                 b->compressed.size(), b->raw.size());
+            if (size < 0 || size_t(size) != b->raw.size()) {
+                throw std::runtime_error("lz4 frame: corrupted block");
+            }
+            if (lz4_frame::checksum(b->raw) != b->checksum) {
+                throw std::runtime_error("lz4 frame: checksum mismatch");
+            }
+            b->compressed = std::vector<char>();
+        });
+        state->blocks.push_back(std::move(block));
+    }
+
+public:
+    /// @param nb_threads number of decompression threads, 0 to use one per core
+    LZ4FrameDecompressor(size_t nb_threads = 0):
+        nb_threads(nb_threads ? nb_threads : lz4_frame::default_nb_threads()) {}
+
+    LZ4FrameDecompressor(const LZ4FrameDecompressor& other): nb_threads(other.nb_threads) {}
+
+    template<typename Source>
+    std::streamsize read(Source& src, char* dest, std::streamsize size) {
+        if (! state) { start(src); }
+        std::streamsize done = 0;
+        while (done < size) {
+            while (! state->end_reached && state->blocks.size() < state->max_blocks) {
+                read_block(src);
+            }
+            if (state->blocks.empty()) { break; }
+            state->wait_front();
+            auto& block = *state->blocks.front();
+            const auto nb = std::min<std::streamsize>(size - done, block.raw.size() - block.consumed);
+            std::copy(block.raw.data() + block.consumed, block.raw.data() + block.consumed + nb, dest + done);
+            block.consumed += nb;
+            done += nb;
+            if (block.consumed == block.raw.size()) { state->blocks.pop_front(); }
+        }
+        return done ? done : -1;
+    }
+
+    template<typename Source>
+    void close(Source&) {
+        state.reset();
+    }
+};
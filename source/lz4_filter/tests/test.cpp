@@ -36,6 +36,8 @@ www.navitia.io
 #include <boost/iostreams/device/file_descriptor.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <sstream>
 #include <string>
 
 
@@ -98,3 +100,71 @@ BOOST_AUTO_TEST_CASE(big_string_compression){
     }
     BOOST_CHECK_EQUAL(str, result);
 }
+
+static std::string frame_compress(const std::string& str, uint32_t block_size, size_t nb_threads) {
+    std::stringstream ss;
+    boost::iostreams::filtering_streambuf<boost::iostreams::output> out;
+    out.push(LZ4FrameCompressor(block_size, nb_threads), 100, 100);
+    out.push(ss);
+    out.sputn(str.data(), str.size());
+    out.pop();
+    return ss.str();
+}
+
+static std::string frame_decompress(const std::string& compressed, size_t nb_threads) {
+    std::stringstream ss(compressed);
+    BOOST_REQUIRE(lz4_frame::is_framed(ss));
+    boost::iostreams::filtering_streambuf<boost::iostreams::input> in;
+    in.push(LZ4FrameDecompressor(nb_threads), 100, 100);
+    in.push(ss);
+    std::string result;
+    char buffer[1000];
+    for (auto size = in.sgetn(buffer, sizeof(buffer)); size > 0; size = in.sgetn(buffer, sizeof(buffer))) {
+        result.append(buffer, size);
+    }
+    return result;
+}
+
+BOOST_AUTO_TEST_CASE(frame_compression){
+    std::string str = "foobariozafiozehfuiozefuigaezgfuzegfpuzheuerfhzeupgf";
+    for (int i = 0; i < 10; i++) {
+        str += str + std::to_string(i);
+    }
+    // small blocks, so there are several blocks in flight
+    for (size_t nb_threads: {1, 2, 4}) {
+        BOOST_CHECK_EQUAL(frame_decompress(frame_compress(str, 1000, nb_threads), nb_threads), str);
+    }
+    BOOST_CHECK_EQUAL(frame_decompress(frame_compress(str, 1000, 3), 2), str);
+    BOOST_CHECK_EQUAL(frame_decompress(frame_compress(str, lz4_frame::default_block_size, 2), 2), str);
+    BOOST_CHECK_EQUAL(frame_decompress(frame_compress("", 1000, 2), 2), "");
+}
+
+BOOST_AUTO_TEST_CASE(frame_corrupted_block){
+    std::string str = "foobariozafiozehfuiozefuigaezgfuzegfpuzheuerfhzeupgf";
+    for (int i = 0; i < 10; i++) {
+        str += str + std::to_string(i);
+    }
+    auto compressed = frame_compress(str, 1000, 2);
+    compressed[compressed.size() / 2] ^= 0x5;
+    BOOST_CHECK_THROW(frame_decompress(compressed, 2), std::exception);
+
+    compressed = frame_compress(str, 1000, 2);
+    compressed.resize(compressed.size() - 10);
+    BOOST_CHECK_THROW(frame_decompress(compressed, 2), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(frame_detection){
+    {
+        boost::iostreams::filtering_ostream out;
+        out.push(LZ4Compressor());
+        out.push(boost::iostreams::file_sink("my_file.lz4"));
+        out << "foo";
+    }
+    std::ifstream legacy("my_file.lz4", std::ios::binary);
+    BOOST_CHECK(! lz4_frame::is_framed(legacy));
+    BOOST_CHECK_EQUAL(legacy.tellg(), 0);
+
+    std::stringstream too_short("NL");
+    BOOST_CHECK(! lz4_frame::is_framed(too_short));
+    BOOST_CHECK_EQUAL(too_short.tellg(), 0);
+}
@@ -0,0 +1,164 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "attribute_index.h"
+#include "type/data.h"
+#include "type/pt_data.h"
+
+#include <boost/range/algorithm/sort.hpp>
+
+namespace navitia { namespace ptref {
+
+void AttributeIndex::add(const std::string& value, const type::idx_t idx) {
+    by_value[value].insert(idx);
+    sorted.emplace_back(value, idx);
+}
+
+void AttributeIndex::finalize() {
+    boost::sort(sorted);
+    sorted.shrink_to_fit();
+}
+
+type::Indexes AttributeIndex::find(const Operator_e op, const std::string& value, const size_t nb_obj) const {
+    type::Indexes res;
+    const auto cmp = [](const std::pair<std::string, type::idx_t>& p, const std::string& v) {
+        return p.first < v;
+    };
+    const auto rcmp = [](const std::string& v, const std::pair<std::string, type::idx_t>& p) {
+        return v < p.first;
+    };
+    auto begin = sorted.begin();
+    auto end = sorted.end();
+    switch (op) {
+    case EQ: {
+        const auto it = by_value.find(value);
+        if (it != by_value.end()) { res = it->second; }
+        return res;
+    }
+    case NEQ: {
+        const auto it = by_value.find(value);
+        res.reserve(nb_obj);
+        for (type::idx_t idx = 0; idx < nb_obj; ++idx) {
+            if (it != by_value.end() && it->second.count(idx)) { continue; }
+            res.insert(res.end(), idx);
+        }
+        return res;
+    }
+    case LT: end = std::lower_bound(sorted.begin(), sorted.end(), value, cmp); break;
+    case LEQ: end = std::upper_bound(sorted.begin(), sorted.end(), value, rcmp); break;
+    case GT: begin = std::upper_bound(sorted.begin(), sorted.end(), value, rcmp); break;
+    case GEQ: begin = std::lower_bound(sorted.begin(), sorted.end(), value, cmp); break;
+    default:
+        // the other operators are not handled by WhereWrapper, they accept everything
+        res.reserve(nb_obj);
+        for (type::idx_t idx = 0; idx < nb_obj; ++idx) { res.insert(res.end(), idx); }
+        return res;
+    }
+    std::vector<type::idx_t> idxs;
+    idxs.reserve(std::distance(begin, end));
+    for (auto it = begin; it != end; ++it) { idxs.push_back(it->second); }
+    boost::sort(idxs);
+    res.insert(boost::container::ordered_unique_range_t(), idxs.begin(), idxs.end());
+    return res;
+}
+
+template<typename T>
+static std::shared_ptr<const AttributeIndex> make_name_index(const std::vector<T*>& objs) {
+    auto res = std::make_shared<AttributeIndex>();
+    for (const auto* obj: objs) { res->add(obj->name, obj->idx); }
+    res->finalize();
+    return std::move(res);
+}
+
+AttributeIndexes::AttributeIndexes(const type::Data& data) {
+    const auto& pt_data = *data.pt_data;
+#define NAME_INDEX(type_name, collection_name)\
+    indexes[{type::Type_e::type_name, "name"}] = make_name_index(pt_data.collection_name);
+    NAME_INDEX(Line, lines)
+    NAME_INDEX(LineGroup, line_groups)
+    NAME_INDEX(StopPoint, stop_points)
+    NAME_INDEX(StopArea, stop_areas)
+    NAME_INDEX(Network, networks)
+    NAME_INDEX(PhysicalMode, physical_modes)
+    NAME_INDEX(CommercialMode, commercial_modes)
+    NAME_INDEX(Company, companies)
+    NAME_INDEX(Route, routes)
+    NAME_INDEX(Contributor, contributors)
+    NAME_INDEX(Calendar, calendars)
+    NAME_INDEX(Dataset, datasets)
+#undef NAME_INDEX
+
+    auto line_codes = std::make_shared<AttributeIndex>();
+    for (const auto* line: pt_data.lines) { line_codes->add(line->code, line->idx); }
+    line_codes->finalize();
+    indexes[{type::Type_e::Line, "code"}] = std::move(line_codes);
+
+    build_vehicle_journey_indexes(data);
+}
+
+AttributeIndexes::AttributeIndexes(const AttributeIndexes& previous, const type::Data& data):
+        indexes(previous.indexes) {
+    build_vehicle_journey_indexes(data);
+}
+
+void AttributeIndexes::build_vehicle_journey_indexes(const type::Data& data) {
+    const auto& pt_data = *data.pt_data;
+    indexes[{type::Type_e::VehicleJourney, "name"}] = make_name_index(pt_data.vehicle_journeys);
+
+    vjs_by_physical_mode.assign(pt_data.physical_modes.size(), type::Indexes());
+    for (const auto* vj: pt_data.vehicle_journeys) {
+        if (! vj->physical_mode || vj->physical_mode->idx >= vjs_by_physical_mode.size()) { continue; }
+        vjs_by_physical_mode[vj->physical_mode->idx].insert(vj->idx);
+    }
+}
+
+const AttributeIndex* AttributeIndexes::get(const type::Type_e type, const std::string& attribute) const {
+    const auto it = indexes.find({type, attribute});
+    if (it == indexes.end()) { return nullptr; }
+    return it->second.get();
+}
+
+type::Indexes AttributeIndexes::get_vjs_of_physical_modes(const type::Indexes& physical_modes) const {
+    type::Indexes res;
+    for (const auto idx: physical_modes) {
+        if (idx >= vjs_by_physical_mode.size()) { continue; }
+        const auto& vjs = vjs_by_physical_mode[idx];
+        res.insert(vjs.begin(), vjs.end());
+    }
+    return res;
+}
+
+size_t AttributeIndexes::nb_indexed_values() const {
+    size_t res = 0;
+    for (const auto& index: indexes) { res += index.second->sorted.size(); }
+    return res;
+}
+
+}} // navitia::ptref
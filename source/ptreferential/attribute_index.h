@@ -0,0 +1,89 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+/** Secondary indexes used by ptref instead of a scan of the whole collection
+  *
+  * Without them, a filter like `vehicle_journey.name=bob` evaluates a WhereWrapper
+  * on each object of the collection. The indexes are built with the relations
+  * (and after each data load), they are not serialized. When they are not built,
+  * ptref falls back on the scan.
+  */
+
+#include "type/type.h"
+#include "where.h"
+
+#include <memory>
+#include <unordered_map>
+
+namespace navitia {
+namespace type { class Data; }
+namespace ptref {
+
+/// index of the objects of one type by the value of one of their string attributes
+struct AttributeIndex {
+    // objects by value, for the = and <> operators
+    std::unordered_map<std::string, type::Indexes> by_value;
+    // (value, idx) sorted by value, for the <, <=, > and >= operators
+    std::vector<std::pair<std::string, type::idx_t>> sorted;
+
+    void add(const std::string& value, const type::idx_t idx);
+    void finalize();
+
+    /// nb_obj is the size of the indexed collection, needed for <>
+    type::Indexes find(const Operator_e op, const std::string& value, const size_t nb_obj) const;
+};
+
+struct AttributeIndexes {
+    explicit AttributeIndexes(const type::Data& data);
+
+    /// indexes of data, a realtime update of the data of previous: the realtime only creates
+    /// and deletes vehicle journeys, so only their indexes are rebuilt, the others are shared
+    AttributeIndexes(const AttributeIndexes& previous, const type::Data& data);
+
+    /// return the index of the attribute of the type, nullptr if there is none
+    const AttributeIndex* get(const type::Type_e type, const std::string& attribute) const;
+
+    /// vehicle journeys of the physical modes
+    type::Indexes get_vjs_of_physical_modes(const type::Indexes& physical_modes) const;
+
+    size_t nb_indexed_values() const;
+
+private:
+    void build_vehicle_journey_indexes(const type::Data& data);
+
+    // the indexes are immutable once built, so they can be shared between the Data
+    std::map<std::pair<type::Type_e, std::string>, std::shared_ptr<const AttributeIndex>> indexes;
+    // vjs_by_physical_mode[physical_mode->idx]
+    std::vector<type::Indexes> vjs_by_physical_mode;
+};
+
+}} // navitia::ptref
@@ -33,6 +33,8 @@ www.navitia.io
 #include "where.h"
 #include "proximity_list/proximity_list.h"
 #include "type/data.h"
+#include "query_plan.h"
+#include "attribute_index.h"
 
 #include <algorithm>
 
@@ -302,24 +304,52 @@ static Indexes get_indexes_by_impacts(const Data & d, const type::Type_e& type_e
     return result;
 }
 
+// the secondary index that can be used instead of a scan for the filter
+static const AttributeIndex* get_attribute_index(const Filter& filter, const Data& d) {
+    if (! d.ptref_indexes || ! filter.method.empty()) {
+        return nullptr;
+    }
+    if (! in(filter.op, {EQ, NEQ, LT, GT, LEQ, GEQ})) {
+        return nullptr;
+    }
+    return d.ptref_indexes->get(filter.navitia_type, filter.attribute);
+}
+
+static Indexes get_target_by_source(const Data& d, const Type_e source, const Type_e target,
+                                    const Indexes& source_idx) {
+    // PhysicalMode::get would look at all the vehicle journeys for each physical mode
+    if (d.ptref_indexes && source == Type_e::PhysicalMode && target == Type_e::VehicleJourney) {
+        return d.ptref_indexes->get_vjs_of_physical_modes(source_idx);
+    }
+    return d.get_target_by_source(source, target, source_idx);
+}
+
+// the DWITHIN value is "lon, lat, distance", none is returned if there is not 3 parameters
+static boost::optional<std::pair<GeographicalCoord, float>> parse_dwithin(const Filter& filter) {
+    std::vector<std::string> splited;
+    boost::algorithm::split(splited, filter.value, boost::algorithm::is_any_of(","));
+    if (splited.size() != 3) {
+        return boost::none;
+    }
+    try {
+        std::string slon = boost::trim_copy(splited[0]);
+        std::string slat = boost::trim_copy(splited[1]);
+        std::string sdist = boost::trim_copy(splited[2]);
+        return std::make_pair(type::GeographicalCoord(boost::lexical_cast<double>(slon),
+                                                      boost::lexical_cast<double>(slat)),
+                              boost::lexical_cast<float>(sdist));
+    } catch (...) {
+        throw parsing_error(parsing_error::partial_error, "Unable to parse the DWITHIN parameter " + filter.value);
+    }
+}
+
 template<typename T>
 Indexes get_indexes(Filter filter,  Type_e requested_type, const Data & d) {
     Indexes indexes;
     if(filter.op == DWITHIN) {
-        std::vector<std::string> splited;
-        boost::algorithm::split(splited, filter.value, boost::algorithm::is_any_of(","));
-        GeographicalCoord coord;
-        float distance;
-        if(splited.size() == 3) {
-            try {
-                std::string slon = boost::trim_copy(splited[0]);
-                std::string slat = boost::trim_copy(splited[1]);
-                std::string sdist = boost::trim_copy(splited[2]);
-                coord = type::GeographicalCoord(boost::lexical_cast<double>(slon), boost::lexical_cast<double>(slat) );
-                distance = boost::lexical_cast<float>(sdist);
-            } catch (...) {
-                throw parsing_error(parsing_error::partial_error, "Unable to parse the DWITHIN parameter " + filter.value);
-            }
+        if (const auto dwithin = parse_dwithin(filter)) {
+            const auto& coord = dwithin->first;
+            const auto distance = dwithin->second;
             std::vector<std::pair<idx_t, GeographicalCoord> > tmp;
             switch(filter.navitia_type){
             case Type_e::StopPoint: tmp = d.pt_data->stop_point_proximity_list.find_within(coord, distance); break;
@@ -384,14 +414,20 @@ Indexes get_indexes(Filter filter,  Type_e requested_type, const Data & d) {
     } else if (filter.attribute == "uri" && filter.op == EQ) {
         // for filtering with uri we can look up in the maps
         indexes = filtered_indexes_by_uri<T>(d.get_assoc_data<T>(), filter.value);
+    } else if (const auto* attribute_index = get_attribute_index(filter, d)) {
+        indexes = attribute_index->find(filter.op, filter.value, d.get_nb_obj(filter.navitia_type));
+        LOG4CPLUS_DEBUG(log4cplus::Logger::getInstance("log"), "ptref: the " << filter.attribute
+                        << " index of " << filter.object << " is used, " << indexes.size() << " objects found");
     } else {
         const auto& data = d.get_data<T>();
         indexes = filtered_indexes(data, build_clause<T>({filter}));
+        LOG4CPLUS_DEBUG(log4cplus::Logger::getInstance("log"), "ptref: no index for " << filter.object
+                        << "." << filter.attribute << ", " << data.size() << " objects scanned");
     }
     Type_e current = filter.navitia_type;
     std::map<Type_e, Type_e> path = find_path(requested_type);
     while(path[current] != current){
-        indexes = d.get_target_by_source(current, path[current], indexes);
+        indexes = get_target_by_source(d, current, path[current], indexes);
         current = path[current];
     }
 
@@ -419,6 +455,115 @@ std::vector<Filter> parse(std::string request){
     return filters;
 }
 
+static bool is_filterable(const Type_e type) {
+    switch (type) {
+#define FILTERABLE_TYPE(type_name, collection_name)\
+    case Type_e::type_name:
+    ITERATE_NAVITIA_PT_TYPES(FILTERABLE_TYPE)
+#undef FILTERABLE_TYPE
+    case Type_e::JourneyPattern:
+    case Type_e::JourneyPatternPoint:
+    case Type_e::POI:
+    case Type_e::POIType:
+    case Type_e::Connection:
+    case Type_e::MetaVehicleJourney:
+    case Type_e::Impact:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// A filter might not be executed if a previous one has no result, so everything
+// get_indexes would reject has to be rejected at compilation
+static void check_filter(const Filter& filter, const Data& data) {
+    if (! is_filterable(filter.navitia_type)) {
+        throw parsing_error(parsing_error::partial_error,
+                "Filter: Unable to find the requested type. Not parsed: >>"
+                + nt::static_data::get()->captionByType(filter.navitia_type) + "<<");
+    }
+    if (filter.op == DWITHIN) {
+        if (parse_dwithin(filter) &&
+                ! in(filter.navitia_type, {Type_e::StopPoint, Type_e::StopArea, Type_e::POI})) {
+            throw ptref_error("The requested object can not be used a DWITHIN clause");
+        }
+    } else if (filter.op == HAVING || filter.op == AFTER) {
+        compile_query(filter.value, data);
+    } else if (! filter.method.empty()) {
+        const bool is_known_method =
+            (filter.object == "vehicle_journey" && filter.method == "has_headsign" && filter.args.size() == 1)
+            || (filter.object == "vehicle_journey" && filter.method == "has_disruption" && filter.args.empty())
+            || (filter.method == "has_code" && filter.args.size() == 2);
+        if (! is_known_method) {
+            throw parsing_error(parsing_error::partial_error,
+                                "Unknown method " + filter.object + ":" + filter.method);
+        }
+    }
+}
+
+static size_t estimate_cost(const Filter& filter, const Data& data) {
+    if (filter.op == HAVING || filter.op == AFTER) {
+        // a whole subquery has to be run, we keep them for the end
+        return std::numeric_limits<size_t>::max();
+    }
+    const size_t nb_obj = data.get_nb_obj(filter.navitia_type);
+    if (filter.op == DWITHIN) {
+        return nb_obj;
+    }
+    if (! filter.method.empty()) {
+        if (filter.method == "has_disruption") {
+            return data.pt_data->disruption_holder.get_weak_impacts().size();
+        }
+        // has_code and has_headsign are lookups in a map
+        return std::min<size_t>(1, nb_obj);
+    }
+    if (filter.op == EQ && filter.attribute == "uri") {
+        return std::min<size_t>(1, nb_obj);
+    }
+    if (filter.op == EQ && filter.attribute == "name" &&
+            in(filter.navitia_type, {Type_e::JourneyPattern, Type_e::JourneyPatternPoint})) {
+        return std::min<size_t>(1, nb_obj);
+    }
+    if (filter.op == EQ && get_attribute_index(filter, data)) {
+        return std::min<size_t>(1, nb_obj);
+    }
+    // we have to look at each object
+    return nb_obj;
+}
+
+QueryPlan compile_query(const std::string& request, const Data& data) {
+    QueryPlan plan;
+    if (request.empty()) {
+        return plan;
+    }
+    auto start = bt::microsec_clock::universal_time();
+    std::vector<Filter> filters = parse(request);
+    plan.parse_duration = bt::microsec_clock::universal_time() - start;
+
+    start = bt::microsec_clock::universal_time();
+    type::static_data* static_data = type::static_data::get();
+    for (Filter& filter: filters) {
+        try {
+            filter.navitia_type = static_data->typeByCaption(filter.object);
+        } catch(...) {
+            throw parsing_error(parsing_error::error_type::unknown_object,
+                    "Filter Unknown object type: " + filter.object);
+        }
+        check_filter(filter, data);
+        QueryPlan::Step step;
+        step.estimated_cost = estimate_cost(filter, data);
+        step.filter = std::move(filter);
+        plan.steps.push_back(std::move(step));
+    }
+    // the filters are intersected, so the order does not change the result
+    std::stable_sort(plan.steps.begin(), plan.steps.end(),
+                     [](const QueryPlan::Step& a, const QueryPlan::Step& b) {
+        return a.estimated_cost < b.estimated_cost;
+    });
+    plan.plan_duration = bt::microsec_clock::universal_time() - start;
+    return plan;
+}
+
 Indexes get_difference(const Indexes& idxs1, const Indexes& idxs2) {
     Indexes tmp_indexes;
     std::insert_iterator<Indexes> it(tmp_indexes, std::begin(tmp_indexes));
@@ -570,33 +715,21 @@ Indexes make_query(const Type_e requested_type,
                               const boost::optional<boost::posix_time::ptime>& since,
                               const boost::optional<boost::posix_time::ptime>& until,
                               const Data& data) {
-    std::vector<Filter> filters;
-
-    if(!request.empty()){
-        filters = parse(request);
-    }
-
-    type::static_data* static_data = type::static_data::get();
-    for(Filter & filter : filters){
-        try {
-            filter.navitia_type = static_data->typeByCaption(filter.object);
-        } catch(...) {
-            throw parsing_error(parsing_error::error_type::unknown_object,
-                    "Filter Unknown object type: " + filter.object);
-        }
-    }
+    const auto plan = data.ptref_plan_cache->get(request);
+    const auto start = bt::microsec_clock::universal_time();
 
     Indexes final_indexes;
     if (! data.get_nb_obj(requested_type)) {
         throw ptref_error("Filters: No requested object in the database");
     }
 
-    if (filters.empty()) {
+    if (plan->steps.empty()) {
         final_indexes = data.get_all_index(requested_type);
     } else {
         Indexes indexes;
         bool first_time = true;
-        for (const Filter& filter : filters) {
+        for (const auto& step: plan->steps) {
+            const Filter& filter = step.filter;
             switch(filter.navitia_type){
     #define GET_INDEXES(type_name, collection_name)\
             case Type_e::type_name:\
@@ -636,9 +769,12 @@ Indexes make_query(const Type_e requested_type,
                 final_indexes = get_intersection(final_indexes, indexes);
             }
             first_time = false;
+            // the next filters cannot add anything
+            if (final_indexes.empty()) { break; }
         }
     }
     //We now filter with forbidden uris
+    type::static_data* static_data = type::static_data::get();
     for(const auto forbidden_uri : forbidden_uris) {
         const auto type_ = data.get_type_of_id(forbidden_uri);
         //We don't use unknown forbidden type object as a filter.
@@ -694,6 +830,7 @@ Indexes make_query(const Type_e requested_type,
     if (since || until) {
         final_indexes = filter_on_period(final_indexes, requested_type, since, until, data);
     }
+    data.ptref_plan_cache->add_execution(bt::microsec_clock::universal_time() - start);
 
     // When the filters have emptied the results
     if(final_indexes.empty()){
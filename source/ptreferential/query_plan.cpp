@@ -0,0 +1,69 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "query_plan.h"
+#include "utils/logger.h"
+
+namespace navitia { namespace ptref {
+
+QueryPlanCache::QueryPlanCache(const type::Data& data, size_t max_cache):
+    stats(std::make_unique<QueryStats>()),
+    lru({data, *stats}, max_cache) {}
+
+QueryPlanCache::~QueryPlanCache() {
+    auto logger = log4cplus::Logger::getInstance("log");
+    LOG4CPLUS_INFO(logger, "ptref plan cache miss : " << lru.get_nb_cache_miss() << " / " << lru.get_nb_calls());
+    LOG4CPLUS_INFO(logger, "ptref queries: " << stats->nb_queries
+                   << ", compilations: " << stats->nb_compilations
+                   << ", parse: " << stats->parse_duration << "us"
+                   << ", plan: " << stats->plan_duration << "us"
+                   << ", execute: " << stats->execute_duration << "us");
+}
+
+std::shared_ptr<const QueryPlan> QueryPlanCache::get(const std::string& request) const {
+    return lru(request);
+}
+
+void QueryPlanCache::add_execution(const boost::posix_time::time_duration& duration) const {
+    ++ stats->nb_queries;
+    stats->execute_duration += duration.total_microseconds();
+}
+
+QueryPlan QueryPlanCache::PlanCreator::operator()(const std::string& request) const {
+    auto plan = compile_query(request, data);
+    ++ stats.nb_compilations;
+    stats.parse_duration += plan.parse_duration.total_microseconds();
+    stats.plan_duration += plan.plan_duration.total_microseconds();
+    LOG4CPLUS_DEBUG(log4cplus::Logger::getInstance("log"), "ptref plan for \"" << request << "\" compiled in "
+                    << (plan.parse_duration + plan.plan_duration).total_microseconds() << "us");
+    return plan;
+}
+
+}} // navitia::ptref
@@ -0,0 +1,106 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+/** A ptref request is compiled into a QueryPlan before being executed
+  *
+  * The compilation parses the filter string, resolves the object types and
+  * checks everything that can be checked without the data. The filters are
+  * then sorted by their estimated cost, so that the most selective ones (the
+  * lookups by uri or by code) are executed first and the query can stop as
+  * soon as the intersection is empty.
+  *
+  * Since the same filters are sent again and again by jormungandr, the plans
+  * are kept in a LRU cache owned by the Data (and thus dropped on data reload).
+  * The HAVING subqueries go through make_query, so they are cached too.
+  */
+
+#include "ptreferential.h"
+#include "utils/lru.h"
+
+#include <atomic>
+#include <limits>
+
+namespace navitia { namespace ptref {
+
+struct QueryPlan {
+    struct Step {
+        Filter filter;
+        // roughly the number of objects looked at to evaluate the filter
+        size_t estimated_cost = std::numeric_limits<size_t>::max();
+    };
+    // sorted by increasing estimated_cost
+    std::vector<Step> steps;
+
+    boost::posix_time::time_duration parse_duration;
+    boost::posix_time::time_duration plan_duration;
+};
+
+/// parse, check and sort the filters of the request
+QueryPlan compile_query(const std::string& request, const type::Data& data);
+
+/// cumulative figures on the ptref queries, in microseconds
+struct QueryStats {
+    std::atomic<uint64_t> nb_queries{0};
+    std::atomic<uint64_t> nb_compilations{0};
+    std::atomic<uint64_t> parse_duration{0};
+    std::atomic<uint64_t> plan_duration{0};
+    std::atomic<uint64_t> execute_duration{0};
+};
+
+struct QueryPlanCache {
+    explicit QueryPlanCache(const type::Data& data, size_t max_cache = 512);
+    ~QueryPlanCache();
+
+    std::shared_ptr<const QueryPlan> get(const std::string& request) const;
+
+    void add_execution(const boost::posix_time::time_duration& duration) const;
+
+    const QueryStats& get_stats() const { return *stats; }
+    size_t get_nb_cache_miss() const { return lru.get_nb_cache_miss(); }
+    size_t get_nb_calls() const { return lru.get_nb_calls(); }
+
+private:
+    struct PlanCreator {
+        typedef std::string const& argument_type;
+        typedef QueryPlan result_type;
+        const type::Data& data;
+        QueryStats& stats;
+        PlanCreator(const type::Data& d, QueryStats& s): data(d), stats(s) {}
+        QueryPlan operator()(const std::string& request) const;
+    };
+
+    // the stats are allocated before the lru, since the PlanCreator points to them
+    std::unique_ptr<QueryStats> stats;
+    mutable ConcurrentLru<PlanCreator> lru;
+};
+
+}} // navitia::ptref
@@ -35,6 +35,8 @@ www.navitia.io
 #include "ptreferential/ptreferential_api.h"
 #include "ptreferential/reflexion.h"
 #include "ptreferential/ptref_graph.h"
+#include "ptreferential/query_plan.h"
+#include "ptreferential/attribute_index.h"
 #include "ed/build_helper.h"
 
 #include <boost/graph/strong_components.hpp>
@@ -574,6 +576,137 @@ BOOST_AUTO_TEST_CASE(after_filter) {
 }
 
 
+BOOST_AUTO_TEST_CASE(compiled_query_plan) {
+    ed::builder b("201303011T1739");
+    b.generate_dummy_basis();
+    b.vj("A")("stop1", 8000,8050)("stop2", 8200,8250);
+    b.vj("B")("stop3", 9000,9050)("stop4", 9200,9250);
+    b.finish();
+    b.data->pt_data->build_uri();
+
+    // the uri lookup is done first, then the scan on the names, and the subquery at the end
+    const auto plan = compile_query("stop_area HAVING (line.uri=A) and line.name=A and stop_point.uri=stop1",
+                                    *b.data);
+    BOOST_REQUIRE_EQUAL(plan.steps.size(), 3);
+    BOOST_CHECK_EQUAL(plan.steps[0].filter.object, "stop_point");
+    BOOST_CHECK(plan.steps[0].filter.navitia_type == nt::Type_e::StopPoint);
+    BOOST_CHECK_EQUAL(plan.steps[1].filter.object, "line");
+    BOOST_CHECK_EQUAL(plan.steps[2].filter.op, HAVING);
+
+    // the errors are raised at compilation, even for the filters that might not be executed
+    BOOST_CHECK_THROW(compile_query("line.uri=B and vehicle_journey.unknown_method()", *b.data), parsing_error);
+    BOOST_CHECK_THROW(compile_query("line.uri=B and stop_area HAVING (bob.uri=A)", *b.data), parsing_error);
+    BOOST_CHECK_THROW(make_query(nt::Type_e::Line, "line.uri=B and vehicle_journey.unknown_method()", *b.data),
+                      parsing_error);
+
+    // no stop_point stop3 on line A
+    BOOST_CHECK_THROW(make_query(nt::Type_e::Line, "line.uri=A and stop_point.uri=stop3", *b.data), ptref_error);
+}
+
+BOOST_AUTO_TEST_CASE(query_plan_cache) {
+    ed::builder b("201303011T1739");
+    b.generate_dummy_basis();
+    b.vj("A")("stop1", 8000,8050)("stop2", 8200,8250);
+    b.vj("B")("stop3", 9000,9050)("stop4", 9200,9250);
+    b.finish();
+    b.data->pt_data->build_uri();
+
+    const auto& cache = *b.data->ptref_plan_cache;
+    const auto nb_cache_miss = cache.get_nb_cache_miss();
+
+    auto indexes = make_query(nt::Type_e::StopArea, "stop_area HAVING (line.uri=A)", *b.data);
+    BOOST_CHECK_EQUAL(indexes.size(), 2);
+    // the request and its subquery have been compiled
+    BOOST_CHECK_EQUAL(cache.get_nb_cache_miss(), nb_cache_miss + 2);
+
+    indexes = make_query(nt::Type_e::StopArea, "stop_area HAVING (line.uri=A)", *b.data);
+    BOOST_CHECK_EQUAL(indexes.size(), 2);
+    BOOST_CHECK_EQUAL(cache.get_nb_cache_miss(), nb_cache_miss + 2);
+    BOOST_CHECK_EQUAL(cache.get_stats().nb_compilations.load(), 2);
+    BOOST_CHECK_EQUAL(cache.get_stats().nb_queries.load(), 4);
+}
+
+
+BOOST_AUTO_TEST_CASE(attribute_indexes) {
+    ed::builder b("201303011T1739");
+    b.generate_dummy_basis();
+    b.vj("A","11110000","",true,"", "","physical_mode:Car")("stop1", 8000,8050)("stop2", 8200,8250);
+    b.vj("A","00001111","",true,"", "","physical_mode:0x1")("stop1", 9000,9050)("stop2", 9200,9250);
+    b.vj("B","11111111","",true,"", "","physical_mode:0x1")("stop3", 9000,9050)("stop4", 9200,9250);
+    b.lines["A"]->code = "line_A";
+    b.lines["B"]->code = "line_B";
+    b.finish();
+    b.data->pt_data->build_uri();
+    for (auto* vj: b.data->pt_data->vehicle_journeys) {
+        vj->name = "name_" + vj->uri;
+    }
+    const auto& vj_uris = get_uris<nt::VehicleJourney>(b.data->get_all_index(nt::Type_e::VehicleJourney),
+                                                       *b.data);
+    BOOST_REQUIRE_EQUAL(vj_uris.size(), 3);
+    const auto& first_vj = *vj_uris.begin();
+
+    const std::vector<std::pair<nt::Type_e, std::string>> requests = {
+        {nt::Type_e::VehicleJourney, "vehicle_journey.name=\"name_" + first_vj + "\""},
+        {nt::Type_e::VehicleJourney, "vehicle_journey.name<>\"name_" + first_vj + "\""},
+        {nt::Type_e::VehicleJourney, "vehicle_journey.name<=\"name_" + first_vj + "\""},
+        {nt::Type_e::VehicleJourney, "vehicle_journey.name>=\"name_" + first_vj + "\""},
+        {nt::Type_e::VehicleJourney, "physical_mode.uri=physical_mode:0x1"},
+        {nt::Type_e::VehicleJourney, "physical_mode.uri=physical_mode:Car"},
+        {nt::Type_e::Line, "line.code=line_B"},
+        {nt::Type_e::Route, "line.code>line_A"},
+        {nt::Type_e::Line, "line.name<>unknown"},
+    };
+
+    // without the indexes, everything is scanned
+    BOOST_REQUIRE(! b.data->ptref_indexes);
+    std::vector<nt::Indexes> scanned;
+    for (const auto& request: requests) {
+        scanned.push_back(make_query(request.first, request.second, *b.data));
+    }
+
+    b.data->build_relations();
+    BOOST_REQUIRE(b.data->ptref_indexes);
+    BOOST_CHECK(b.data->ptref_indexes->get(nt::Type_e::VehicleJourney, "name"));
+    BOOST_CHECK(b.data->ptref_indexes->get(nt::Type_e::Line, "code"));
+    BOOST_CHECK(! b.data->ptref_indexes->get(nt::Type_e::Route, "code"));
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        BOOST_CHECK_EQUAL_RANGE(make_query(requests[i].first, requests[i].second, *b.data), scanned[i]);
+    }
+    BOOST_CHECK_EQUAL(scanned[0].size(), 1);
+    BOOST_CHECK_EQUAL(scanned[1].size(), 2);
+    BOOST_CHECK_EQUAL(scanned[2].size(), 1);
+    BOOST_CHECK_EQUAL(scanned[3].size(), 3);
+    BOOST_CHECK_EQUAL(scanned[4].size(), 2);
+    BOOST_CHECK_EQUAL(scanned[5].size(), 1);
+    BOOST_CHECK_EQUAL(scanned[8].size(), 2);
+}
+
+// after a realtime update, only the indexes of the vehicle journeys are rebuilt
+BOOST_AUTO_TEST_CASE(attribute_indexes_after_realtime) {
+    ed::builder b("201303011T1739");
+    b.generate_dummy_basis();
+    b.vj("A")("stop1", 8000,8050)("stop2", 8200,8250);
+    b.vj("B")("stop3", 9000,9050)("stop4", 9200,9250);
+    b.finish();
+    b.data->pt_data->build_uri();
+    b.data->build_relations();
+    BOOST_REQUIRE(b.data->ptref_indexes);
+    const auto* line_names = b.data->ptref_indexes->get(nt::Type_e::Line, "name");
+    const auto* vj_names = b.data->ptref_indexes->get(nt::Type_e::VehicleJourney, "name");
+
+    auto* vj = b.data->pt_data->vehicle_journeys.front();
+    vj->name = "realtime_name";
+    b.data->build_ptref_indexes(*b.data);
+
+    BOOST_CHECK_EQUAL(b.data->ptref_indexes->get(nt::Type_e::Line, "name"), line_names);
+    BOOST_CHECK_NE(b.data->ptref_indexes->get(nt::Type_e::VehicleJourney, "name"), vj_names);
+    const auto indexes = make_query(nt::Type_e::VehicleJourney, "vehicle_journey.name=realtime_name", *b.data);
+    BOOST_REQUIRE_EQUAL(indexes.size(), 1);
+    BOOST_CHECK_EQUAL(*indexes.begin(), vj->idx);
+}
+
+
 BOOST_AUTO_TEST_CASE(find_path_test){
     auto res = find_path(nt::Type_e::Route);
     // Cas où on veut partir et arriver au même point
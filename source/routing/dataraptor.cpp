@@ -82,7 +82,7 @@ void dataRAPTOR::JppsFromJp::load(const JourneyPatternContainer& jp_container) {
 }
 
 
-void dataRAPTOR::load(const type::PT_Data& data, size_t cache_size)
+void dataRAPTOR::load(const type::PT_Data& data, size_t cache_size, size_t snapshot_cache_size)
 {
     jp_container.load(data);
     labels_const.init_inf(data.stop_points);
@@ -118,6 +118,10 @@ void dataRAPTOR::load(const type::PT_Data& data, size_t cache_size)
     }
 
     cached_next_st_manager = std::make_unique<CachedNextStopTimeManager>(*this, cache_size);
+    departure_snapshots.reset();
+    if (snapshot_cache_size > 0) {
+        departure_snapshots = std::make_unique<DepartureSnapshotManager>(snapshot_cache_size);
+    }
 }
 
 }}
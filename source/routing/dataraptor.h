@@ -35,6 +35,7 @@ www.navitia.io
 #include "utils/idx_map.h"
 #include "routing/next_stop_time.h"
 #include "routing/journey_pattern_container.h"
+#include "routing/departure_snapshot.h"
 
 #include <boost/foreach.hpp>
 #include <boost/dynamic_bitset.hpp>
@@ -102,6 +103,8 @@ struct dataRAPTOR {
 
     NextStopTimeData next_stop_time_data;
     std::unique_ptr<CachedNextStopTimeManager> cached_next_st_manager;
+    // daily stop times by stop area, null if disabled
+    std::unique_ptr<DepartureSnapshotManager> departure_snapshots;
 
     JourneyPatternContainer jp_container;
 
@@ -113,7 +116,7 @@ struct dataRAPTOR {
     flat_enum_map<type::RTLevel, std::vector<boost::dynamic_bitset<>>> jp_validity_patterns;
 
     dataRAPTOR() {}
-    void load(const navitia::type::PT_Data&, size_t cache_size = 10);
+    void load(const navitia::type::PT_Data&, size_t cache_size = 10, size_t snapshot_cache_size = 0);
 };
 
 }}
@@ -0,0 +1,128 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "departure_snapshot.h"
+#include "routing/dataraptor.h"
+#include "routing/next_stop_time.h"
+#include "type/data.h"
+#include "type/pt_data.h"
+
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include <tuple>
+
+namespace navitia { namespace routing {
+
+DepartureSnapshot::DepartureSnapshot(const type::Data& data,
+                                     const type::StopArea& stop_area,
+                                     const DateTime day,
+                                     const type::RTLevel rt_level,
+                                     const StopEvent stop_event) {
+    const auto begin = DateTimeUtils::set(day, 0);
+    const auto end = DateTimeUtils::set(day + 1, 0);
+    for (const auto* sp: stop_area.stop_point_list) {
+        for (const auto& jpp: data.dataRaptor->jpps_from_sp[SpIdx(*sp)]) {
+            const uint32_t from = dtsts.size();
+            // same walk as get_stop_times: the next stop time must be at least one second after
+            NextStopTimeCursor cursor(data, stop_event, jpp.idx, true, rt_level, {});
+            for (auto st = cursor.next(begin); st.first && st.second < end; st = cursor.next(st.second + 1)) {
+                dtsts.emplace_back(st.second, st.first);
+            }
+            ranges[jpp.idx] = {from, uint32_t(dtsts.size())};
+        }
+    }
+    dtsts.shrink_to_fit();
+    ranges.shrink_to_fit();
+}
+
+DepartureSnapshot::DtStRange DepartureSnapshot::operator[](const JppIdx& jpp_idx) const {
+    const auto it = ranges.find(jpp_idx);
+    if (it == ranges.end()) {
+        return boost::make_iterator_range(dtsts.end(), dtsts.end());
+    }
+    return boost::make_iterator_range(dtsts.begin() + it->second.first, dtsts.begin() + it->second.second);
+}
+
+size_t DepartureSnapshot::memory_footprint() const {
+    return sizeof(*this)
+        + dtsts.capacity() * sizeof(DtSt)
+        + ranges.capacity() * sizeof(decltype(ranges)::value_type);
+}
+
+bool DepartureSnapshotKey::operator<(const DepartureSnapshotKey& other) const {
+    return std::tie(stop_area_idx, day, rt_level, stop_event)
+        < std::tie(other.stop_area_idx, other.day, other.rt_level, other.stop_event);
+}
+
+DepartureSnapshotManager::~DepartureSnapshotManager() {
+    auto logger = log4cplus::Logger::getInstance("log");
+    LOG4CPLUS_INFO(logger, "Departure snapshots cache miss : " << nb_cache_miss << " / " << nb_calls
+                   << ", " << nb_snapshots() << " snapshots using " << memory << " bytes");
+}
+
+size_t DepartureSnapshotManager::nb_snapshots() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return snapshots.size();
+}
+
+std::shared_ptr<const DepartureSnapshot>
+DepartureSnapshotManager::get(const type::Data& data,
+                              const type::StopArea& stop_area,
+                              const DateTime day,
+                              const type::RTLevel rt_level,
+                              const StopEvent stop_event) {
+    ++nb_calls;
+    const DepartureSnapshotKey key{stop_area.idx, day, rt_level, stop_event};
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = snapshots.find(key);
+        if (it != snapshots.end()) { return it->second; }
+    }
+
+    // the snapshot is built without holding the lock, another thread may build the same
+    // one at the same time, only the first inserted is kept
+    ++nb_cache_miss;
+    auto snapshot = std::make_shared<const DepartureSnapshot>(data, stop_area, day, rt_level, stop_event);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto inserted = snapshots.insert({key, snapshot});
+    if (! inserted.second) { return inserted.first->second; }
+    memory += snapshot->memory_footprint();
+    build_order.push_back(key);
+    while (snapshots.size() > max_snapshots) {
+        const auto oldest = snapshots.find(build_order.front());
+        memory -= oldest->second->memory_footprint();
+        snapshots.erase(oldest);
+        build_order.pop_front();
+    }
+    return snapshot;
+}
+
+}} // namespace navitia::routing
@@ -0,0 +1,128 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include "routing/raptor_utils.h"
+#include "routing/stop_event.h"
+#include "type/rt_level.h"
+
+#include <boost/container/flat_map.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace navitia {
+
+namespace type {
+class Data;
+struct StopArea;
+struct StopTime;
+}
+
+namespace routing {
+
+/*
+ * All the stop times of the jpps of a stop area for one day and one RT level
+ *
+ * For a jpp, the stop times are the ones successively given by NextStopTime::next_stop_time
+ * from the beginning of the day to its end, without accessibility constraints.
+ * The datetimes are the ones of the stop event (without boarding or alighting duration).
+ */
+struct DepartureSnapshot {
+    using DtSt = std::pair<DateTime, const type::StopTime*>;
+    using DtStRange = boost::iterator_range<std::vector<DtSt>::const_iterator>;
+
+    DepartureSnapshot(const type::Data& data,
+                      const type::StopArea& stop_area,
+                      const DateTime day,
+                      const type::RTLevel rt_level,
+                      const StopEvent stop_event);
+
+    // stop times of the jpp sorted by datetime, empty if the jpp is not in the stop area
+    DtStRange operator[](const JppIdx& jpp_idx) const;
+    bool contains(const JppIdx& jpp_idx) const { return ranges.count(jpp_idx); }
+
+    size_t memory_footprint() const;
+
+private:
+    // every stop times, grouped by jpp
+    std::vector<DtSt> dtsts;
+    // for a jpp, its stop times are dtsts[ranges[jpp].first, ranges[jpp].second[
+    boost::container::flat_map<JppIdx, std::pair<uint32_t, uint32_t>> ranges;
+};
+
+struct DepartureSnapshotKey {
+    type::idx_t stop_area_idx;
+    DateTime day;
+    type::RTLevel rt_level;
+    StopEvent stop_event;
+
+    bool operator<(const DepartureSnapshotKey& other) const;
+};
+
+/*
+ * Lazily builds and keeps the snapshots of the most used stop areas
+ *
+ * It is owned by the dataRAPTOR, so it is rebuilt (empty) each time the data or its
+ * realtime version changes.
+ * When there is more than max_snapshots snapshots, the oldest built is dropped.
+ */
+struct DepartureSnapshotManager {
+    explicit DepartureSnapshotManager(size_t max_snapshots): max_snapshots(max_snapshots) {}
+    ~DepartureSnapshotManager();
+
+    std::shared_ptr<const DepartureSnapshot> get(const type::Data& data,
+                                                 const type::StopArea& stop_area,
+                                                 const DateTime day,
+                                                 const type::RTLevel rt_level,
+                                                 const StopEvent stop_event);
+
+    // memory used by the stored snapshots, in bytes
+    size_t memory_footprint() const { return memory; }
+    size_t nb_snapshots() const;
+    size_t get_nb_cache_miss() const { return nb_cache_miss; }
+    size_t get_nb_calls() const { return nb_calls; }
+
+private:
+    const size_t max_snapshots;
+    mutable std::mutex mutex;
+    std::map<DepartureSnapshotKey, std::shared_ptr<const DepartureSnapshot>> snapshots;
+    // keys in building order, to drop the oldest snapshot
+    std::list<DepartureSnapshotKey> build_order;
+    std::atomic<size_t> memory{0};
+    std::atomic<size_t> nb_calls{0};
+    std::atomic<size_t> nb_cache_miss{0};
+};
+
+}} // namespace navitia::routing
@@ -33,9 +33,81 @@ www.navitia.io
 #include "routing/dataraptor.h"
 #include "type/pb_converter.h"
 #include <functional>
+#include <algorithm>
+#include <boost/optional.hpp>
 
 namespace navitia { namespace routing {
 
+/*
+ * get_stop_times using the departure snapshots of a stop area
+ *
+ * Returns none if the snapshots cannot be used, ie if they are disabled, the request is anticlockwise,
+ * has accessibility constraints, spans more than 2 days or if the jpps are not in the same stop area.
+ */
+static boost::optional<std::vector<datetime_stop_time>>
+get_stop_times_from_snapshots(const routing::StopEvent stop_event,
+                              const std::vector<routing::JppIdx>& journey_pattern_points,
+                              const DateTime dt,
+                              const DateTime max_dt,
+                              const size_t max_departures,
+                              const type::Data& data,
+                              const type::RTLevel rt_level,
+                              const type::AccessibiliteParams& accessibilite_params) {
+    auto& snapshots = data.dataRaptor->departure_snapshots;
+    if (! snapshots || max_dt < dt || journey_pattern_points.empty()) { return boost::none; }
+    if (accessibilite_params.properties.any() || accessibilite_params.vehicle_properties.any()) {
+        return boost::none;
+    }
+    // next_stop_time only looks for a stop time on the day of dt and the day after
+    const auto first_day = DateTimeUtils::date(dt);
+    const auto last_day = DateTimeUtils::date(max_dt);
+    if (last_day > first_day + 1) { return boost::none; }
+
+    const auto get_stop_area = [&](const JppIdx jpp_idx) {
+        const auto& jpp = data.dataRaptor->jp_container.get(jpp_idx);
+        return data.pt_data->stop_points[jpp.sp_idx.val]->stop_area;
+    };
+    const type::StopArea* stop_area = get_stop_area(journey_pattern_points.front());
+    if (! stop_area) { return boost::none; }
+    for (const auto& jpp_idx: journey_pattern_points) {
+        if (get_stop_area(jpp_idx) != stop_area) { return boost::none; }
+    }
+
+    // The candidates are pushed day by day, jpp by jpp, and then stable sorted:
+    // on equality, the first jpp wins, as in the tournament of get_stop_times.
+    using DtSt = DepartureSnapshot::DtSt;
+    const auto cmp = [](const DtSt& lhs, const DtSt& rhs) { return lhs.first < rhs.first; };
+    std::vector<DtSt> candidates;
+    for (auto day = first_day; day <= last_day; ++day) {
+        const auto snapshot = snapshots->get(data, *stop_area, day, rt_level, stop_event);
+        for (const auto& jpp_idx: journey_pattern_points) {
+            const auto range = (*snapshot)[jpp_idx];
+            const auto begin = std::lower_bound(range.begin(), range.end(), DtSt(dt, nullptr), cmp);
+            const auto end = std::upper_bound(begin, range.end(), DtSt(max_dt, nullptr), cmp);
+            candidates.insert(candidates.end(), begin, end);
+        }
+        // the stop times of the next day are all after the ones of this day
+        if (candidates.size() >= max_departures) { break; }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), cmp);
+    if (candidates.size() > max_departures) {
+        candidates.resize(max_departures);
+    }
+
+    std::vector<datetime_stop_time> result;
+    result.reserve(candidates.size());
+    for (const auto& dt_st: candidates) {
+        auto result_dt = dt_st.first;
+        if (stop_event == StopEvent::pick_up) {
+            result_dt += dt_st.second->get_boarding_duration();
+        } else {
+            result_dt -= dt_st.second->get_alighting_duration();
+        }
+        result.push_back(std::make_pair(result_dt, dt_st.second));
+    }
+    return result;
+}
+
 std::vector<datetime_stop_time> get_stop_times(const routing::StopEvent stop_event,
                                                const std::vector<routing::JppIdx>& journey_pattern_points,
                                                const DateTime& dt,
@@ -44,33 +116,39 @@ std::vector<datetime_stop_time> get_stop_times(const routing::StopEvent stop_eve
                                                const type::Data& data, 
                                                const type::RTLevel rt_level,
                                                const type::AccessibiliteParams& accessibilite_params) {
+    if (auto result = get_stop_times_from_snapshots(stop_event, journey_pattern_points, dt, max_dt,
+                                                    max_departures, data, rt_level, accessibilite_params)) {
+        return std::move(*result);
+    }
+
     const bool clockwise(max_dt >= dt);
     std::vector<datetime_stop_time> result;
-    routing::NextStopTime next_st = routing::NextStopTime(data);
 
-    // Next departure for the next stop: we store it to have the next departure for each jpp
-    // We init it with the next_stop_time for each jpp
-    JppStQueue next_requested_dt({clockwise});
+    // One cursor per jpp: the successive requested dt of a jpp are monotone, so each
+    // cursor only moves forward (or backward) in the stop times of its jpp.
+    // We init the tournament with the next stop time of each jpp
+    std::vector<NextStopTimeCursor> cursors;
+    std::vector<JppSt> first_stop_times;
+    cursors.reserve(journey_pattern_points.size());
+    first_stop_times.reserve(journey_pattern_points.size());
     for (const auto& jpp_idx : journey_pattern_points) {
         const routing::JourneyPatternPoint& jpp = data.dataRaptor->jp_container.get(jpp_idx);
         if (! data.pt_data->stop_points[jpp.sp_idx.val]->accessible(accessibilite_params.properties)) {
-            // we do not push them in the queue at all
+            // we do not push them in the tournament at all
             continue;
         }
-        auto st = next_st.next_stop_time(stop_event, jpp_idx,
-                                         dt, clockwise, rt_level,
-                                         accessibilite_params.vehicle_properties, true);
-        if (st.first) {
-            next_requested_dt.push({jpp_idx, st.first, st.second});
-        }
+        cursors.emplace_back(data, stop_event, jpp_idx, clockwise, rt_level,
+                             accessibilite_params.vehicle_properties);
+        const auto st = cursors.back().next(dt);
+        first_stop_times.push_back({jpp_idx, st.first, st.second});
     }
 
+    JppStTournament next_requested_dt(std::move(first_stop_times), clockwise);
     while (! next_requested_dt.empty() && result.size() < max_departures) {
         const auto best_jpp_dt = next_requested_dt.top(); // copy
-        next_requested_dt.pop();
         if ((clockwise && best_jpp_dt.dt > max_dt) ||
                 (!clockwise && best_jpp_dt.dt < max_dt)) {
-            // the best elt of the queue is after the limit, we can stop
+            // the best elt of the tournament is after the limit, we can stop
             break;
         }
 
@@ -82,13 +160,13 @@ std::vector<datetime_stop_time> get_stop_times(const routing::StopEvent stop_eve
         }
         result.push_back(std::make_pair(result_dt, best_jpp_dt.st));
 
-        // we insert the next stop time in the queue (it must be at least one second after/before)
+        // we replace the winner by its next stop time (it must be at least one second after/before)
         auto next_dt = best_jpp_dt.dt + (clockwise ? 1 : -1);
-        auto st = next_st.next_stop_time(stop_event, best_jpp_dt.jpp,
-                                         next_dt, clockwise, rt_level,
-                                         accessibilite_params.vehicle_properties, true);
+        const auto st = cursors[next_requested_dt.top_leaf()].next(next_dt);
         if (st.first) {
-            next_requested_dt.push({best_jpp_dt.jpp, st.first, st.second});
+            next_requested_dt.replace_top({best_jpp_dt.jpp, st.first, st.second});
+        } else {
+            next_requested_dt.pop();
         }
     }
 
@@ -96,6 +174,46 @@ std::vector<datetime_stop_time> get_stop_times(const routing::StopEvent stop_eve
 }
 
 
+JppStTournament::JppStTournament(std::vector<JppSt> l, const bool clockwise):
+    leaves(std::move(l)), comp{clockwise} {
+    while (nb_leaves < leaves.size()) { nb_leaves *= 2; }
+    // the padding leaves (index >= leaves.size()) are never valid
+    tree.resize(2 * nb_leaves);
+    for (size_t i = 0; i < nb_leaves; ++i) {
+        tree[nb_leaves + i] = i;
+    }
+    for (size_t node = nb_leaves - 1; node > 0; --node) {
+        tree[node] = winner(tree[2 * node], tree[2 * node + 1]);
+    }
+}
+
+size_t JppStTournament::winner(const size_t leaf1, const size_t leaf2) const {
+    if (! is_valid(leaf2)) { return leaf1; }
+    if (! is_valid(leaf1)) { return leaf2; }
+    // comp(a, b) is true if b is better than a
+    if (comp(leaves[leaf1], leaves[leaf2])) { return leaf2; }
+    if (comp(leaves[leaf2], leaves[leaf1])) { return leaf1; }
+    return std::min(leaf1, leaf2);
+}
+
+void JppStTournament::replay(const size_t leaf) {
+    for (size_t node = (nb_leaves + leaf) / 2; node > 0; node /= 2) {
+        tree[node] = winner(tree[2 * node], tree[2 * node + 1]);
+    }
+}
+
+void JppStTournament::replace_top(const JppSt& jpp_st) {
+    const auto leaf = top_leaf();
+    leaves[leaf] = jpp_st;
+    replay(leaf);
+}
+
+void JppStTournament::pop() {
+    const auto leaf = top_leaf();
+    leaves[leaf].st = nullptr;
+    replay(leaf);
+}
+
 std::vector<datetime_stop_time>
 get_calendar_stop_times(const std::vector<routing::JppIdx>& journey_pattern_points,
                const uint32_t begining_time,
@@ -88,7 +88,7 @@ struct JppSt {
  * for anticlockwise, we want the greatest first
  */
 struct BestDTComp {
-    bool operator()(const JppSt& j1, const JppSt& j2) {
+    bool operator()(const JppSt& j1, const JppSt& j2) const {
         if (clockwise) { return j1.dt > j2.dt; }
         return j1.dt < j2.dt;
     }
@@ -97,6 +97,36 @@ struct BestDTComp {
 
 using JppStQueue = std::priority_queue<JppSt, std::vector<JppSt>, BestDTComp>;
 
+/*
+ * Tournament tree (winner tree) over the next stop time of each jpp
+ *
+ * Each leaf is the current best stop time of a jpp, the internal nodes store the
+ * winning leaf of their subtree. Replacing the winner only replays the matches on the
+ * path from its leaf to the root, ie log2(nb jpp) comparisons.
+ * On equality, the leaf with the smallest index wins, so the merge is stable.
+ * A leaf with a null stop time is exhausted and never wins.
+ */
+struct JppStTournament {
+    JppStTournament(std::vector<JppSt> leaves, const bool clockwise);
+
+    bool empty() const { return ! is_valid(tree[1]); }
+    const JppSt& top() const { return leaves[tree[1]]; }
+    size_t top_leaf() const { return tree[1]; }
+    void replace_top(const JppSt& jpp_st);
+    void pop();
+
+private:
+    bool is_valid(const size_t leaf) const { return leaf < leaves.size() && leaves[leaf].st != nullptr; }
+    size_t winner(const size_t leaf1, const size_t leaf2) const;
+    void replay(const size_t leaf);
+
+    std::vector<JppSt> leaves;
+    // tree[1] is the root, the leaf i is at tree[nb_leaves + i]
+    std::vector<size_t> tree;
+    size_t nb_leaves = 1;
+    BestDTComp comp;
+};
+
 
 /*
  * for schedule with calendar, we want to sort the result a quite a strange way
@@ -341,6 +341,120 @@ NextStopTime::tardiest_stop_time(const StopEvent stop_event,
     return first_discrete_st_pair;
 }
 
+NextStopTimeCursor::NextStopTimeCursor(const type::Data& data,
+                                       const StopEvent stop_event,
+                                       const JppIdx jpp_idx,
+                                       const bool clockwise,
+                                       const type::RTLevel rt_level,
+                                       const type::VehicleProperties& vehicle_props):
+    data(&data),
+    stop_event(stop_event),
+    jpp_idx(jpp_idx),
+    clockwise(clockwise),
+    rt_level(rt_level),
+    vehicle_props(vehicle_props),
+    times(&data.dataRaptor->next_stop_time_data.times(jpp_idx, stop_event)),
+    stop_times(&data.dataRaptor->next_stop_time_data.stop_times(jpp_idx, stop_event))
+{
+    const auto& jp_container = data.dataRaptor->jp_container;
+    has_freq = ! jp_container.get(jp_container.get(jpp_idx).jp_idx).freq_vjs.empty();
+}
+
+// same as next_valid_discrete without bound
+std::pair<const type::StopTime*, DateTime> NextStopTimeCursor::next_discrete(const DateTime dt) {
+    const auto day = DateTimeUtils::date(dt);
+    const auto hour = DateTimeUtils::hour(dt);
+    if (! date || *date != day) {
+        date = day;
+        pos = boost::lower_bound(*times, hour) - times->begin();
+    } else {
+        // the stop times we skip here were before the previous dt or not valid on this day
+        while (pos < times->size() && (*times)[pos] < hour) { ++pos; }
+    }
+    for (size_t i = pos; i < times->size(); ++i) {
+        const auto* st = (*stop_times)[i];
+        if (is_valid(st, day, true, rt_level, vehicle_props)) {
+            pos = i;
+            return {st, DateTimeUtils::set(day, (*times)[i])};
+        }
+    }
+    pos = times->size();
+
+    //if none was found, we try again the next day
+    for (size_t i = 0; i < times->size(); ++i) {
+        const auto* st = (*stop_times)[i];
+        if (is_valid(st, day + 1, true, rt_level, vehicle_props)) {
+            date = day + 1;
+            pos = i;
+            return {st, DateTimeUtils::set(day + 1, (*times)[i])};
+        }
+    }
+    return {nullptr, DateTimeUtils::inf};
+}
+
+// same as previous_valid_discrete without bound
+std::pair<const type::StopTime*, DateTime> NextStopTimeCursor::previous_discrete(const DateTime dt) {
+    const auto day = DateTimeUtils::date(dt);
+    const auto hour = DateTimeUtils::hour(dt);
+    if (! date || *date != day) {
+        date = day;
+        pos = boost::upper_bound(*times, hour) - times->begin();
+    } else {
+        while (pos > 0 && (*times)[pos - 1] > hour) { --pos; }
+    }
+    for (size_t i = pos; i > 0; --i) {
+        const auto* st = (*stop_times)[i - 1];
+        if (is_valid(st, day, false, rt_level, vehicle_props)) {
+            pos = i;
+            return {st, DateTimeUtils::set(day, (*times)[i - 1])};
+        }
+    }
+    pos = 0;
+
+    if (day == 0) {
+        return {nullptr, DateTimeUtils::not_valid};
+    }
+    for (size_t i = times->size(); i > 0; --i) {
+        const auto* st = (*stop_times)[i - 1];
+        if (is_valid(st, day - 1, false, rt_level, vehicle_props)) {
+            date = day - 1;
+            pos = i;
+            return {st, DateTimeUtils::set(day - 1, (*times)[i - 1])};
+        }
+    }
+    return {nullptr, DateTimeUtils::not_valid};
+}
+
+std::pair<const type::StopTime*, DateTime> NextStopTimeCursor::next(const DateTime dt) {
+    if (clockwise) {
+        const auto discrete = next_discrete(dt);
+        if (has_freq) {
+            const auto frequency =
+                next_valid_frequency(stop_event, *data->dataRaptor, jpp_idx, dt, rt_level, vehicle_props);
+            if (frequency.second < discrete.second) {
+                return frequency;
+            }
+        }
+        return discrete;
+    }
+
+    const auto discrete = previous_discrete(dt);
+    if (has_freq) {
+        const auto frequency =
+            previous_valid_frequency(stop_event, *data->dataRaptor, jpp_idx, dt, rt_level, vehicle_props);
+        if (discrete.second == DateTimeUtils::not_valid) {
+            return frequency;
+        }
+        if (frequency.second == DateTimeUtils::not_valid) {
+            return discrete;
+        }
+        if (frequency.second < discrete.second) {
+            return frequency;
+        }
+    }
+    return discrete;
+}
+
 
 /*
  * Discrete VJs and Frequency VJs are looped differently when computing the next stop time
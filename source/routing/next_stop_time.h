@@ -100,6 +100,24 @@ struct NextStopTimeData {
         }
     }
 
+    // Returns the hours of the stop times of the jpp in increasing order,
+    // stop_times(jpp_idx, stop_event)[i] is at times(jpp_idx, stop_event)[i]
+    inline const std::vector<DateTime>& times(const JppIdx jpp_idx, const StopEvent stop_event) const {
+        if (stop_event == StopEvent::pick_up) {
+            return departure[jpp_idx].times;
+        } else {
+            return arrival[jpp_idx].times;
+        }
+    }
+    inline const std::vector<const type::StopTime*>& stop_times(const JppIdx jpp_idx,
+                                                                const StopEvent stop_event) const {
+        if (stop_event == StopEvent::pick_up) {
+            return departure[jpp_idx].stop_times;
+        } else {
+            return arrival[jpp_idx].stop_times;
+        }
+    }
+
 private:
     struct Departure {
         DateTime get_time(const type::StopTime& st) const;
@@ -200,6 +218,46 @@ private:
     const type::Data& data;
 };
 
+/*
+ * Iterates over the successive stop times of a journey pattern point
+ *
+ * next(dt) returns the same thing as NextStopTime::next_stop_time(stop_event, jpp_idx, dt, clockwise, ...),
+ * but the successive dt must be monotone (increasing if clockwise, decreasing otherwise).
+ * The position in the NextStopTimeData is kept between two calls, so there is no new
+ * binary search on each call, the cursor only moves forward (or backward).
+ */
+struct NextStopTimeCursor {
+    NextStopTimeCursor(const type::Data& data,
+                       const StopEvent stop_event,
+                       const JppIdx jpp_idx,
+                       const bool clockwise,
+                       const type::RTLevel rt_level,
+                       const type::VehicleProperties& vehicle_props);
+
+    std::pair<const type::StopTime*, DateTime> next(const DateTime dt);
+
+    JppIdx get_jpp_idx() const { return jpp_idx; }
+
+private:
+    std::pair<const type::StopTime*, DateTime> next_discrete(const DateTime dt);
+    std::pair<const type::StopTime*, DateTime> previous_discrete(const DateTime dt);
+
+    const type::Data* data;
+    StopEvent stop_event;
+    JppIdx jpp_idx;
+    bool clockwise;
+    type::RTLevel rt_level;
+    type::VehicleProperties vehicle_props;
+    bool has_freq;
+    const std::vector<DateTime>* times;
+    const std::vector<const type::StopTime*>* stop_times;
+
+    // date of the current position, none if the cursor has not been used yet
+    boost::optional<DateTime> date;
+    // clockwise: the candidates are [pos, size[, anticlockwise they are [0, pos[
+    size_t pos = 0;
+};
+
 struct CachedNextStopTimeKey {
     using Day = size_t;
 
@@ -277,6 +335,9 @@ struct CachedNextStopTimeManager {
          const type::RTLevel rt_level,
          const type::AccessibiliteParams& accessibilite_params);
 
+    size_t get_nb_cache_miss() const { return lru.get_nb_cache_miss(); }
+    size_t get_nb_calls() const { return lru.get_nb_calls(); }
+
 private:
     struct CacheCreator {
         typedef CachedNextStopTimeKey const& argument_type;
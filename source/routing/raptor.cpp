@@ -91,6 +91,7 @@ bool RAPTOR::apply_vj_extension(const Visitor& v,
 
             working_labels.mut_dt_pt(sp_idx) = workingDt;
             best_labels_pts[sp_idx] = workingDt;
+            ++stats.nb_improved_labels;
             result = true;
         }
         vj = v.get_extension_vj(vj);
@@ -124,6 +125,7 @@ bool RAPTOR::foot_path(const Visitor& v) {
             //if we can improve the best label, we mark it
             working_labels.mut_dt_transfer(destination_sp_idx) = next;
             best_labels_transfers[destination_sp_idx] = next;
+            ++stats.nb_improved_labels;
             result = true;
         }
     }
@@ -679,6 +681,7 @@ void RAPTOR::raptor_loop(Visitor visitor,
 
     while(continue_algorithm && count <= max_transfers) {
         ++count;
+        ++stats.nb_rounds;
         continue_algorithm = false;
         if(count == labels.size()) {
             if(visitor.clockwise()) {
@@ -721,6 +724,7 @@ void RAPTOR::raptor_loop(Visitor visitor,
                         {
                             working_labels.mut_dt_pt(jpp.sp_idx) = workingDt;
                             best_labels_pts[jpp.sp_idx] = working_labels.dt_pt(jpp.sp_idx);
+                            ++stats.nb_improved_labels;
                             continue_algorithm = true;
                         }
                     }
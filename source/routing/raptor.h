@@ -81,6 +81,13 @@ struct RAPTOR
     // set to store if the stop_point is valid
     boost::dynamic_bitset<> valid_stop_points;
 
+    /// Work done by the computations since the last reset, for the metrics of kraken
+    struct Stats {
+        uint64_t nb_rounds = 0;
+        uint64_t nb_improved_labels = 0;
+    };
+    Stats stats;
+
     explicit RAPTOR(const navitia::type::Data& data) :
         data(data),
         best_labels_pts(data.pt_data->stop_points),
@@ -94,6 +101,30 @@ struct RAPTOR
         first_pass_labels.assign(10, data.dataRaptor->labels_const);
     }
 
+    /// Build a RAPTOR for data reusing the buffers of a previous one, avoiding
+    /// the allocations when the sizes did not change
+    RAPTOR(const navitia::type::Data& data, RAPTOR&& recycled) :
+        data(data),
+        labels(std::move(recycled.labels)),
+        first_pass_labels(std::move(recycled.first_pass_labels)),
+        best_labels_pts(std::move(recycled.best_labels_pts)),
+        best_labels_transfers(std::move(recycled.best_labels_transfers)),
+        count(0),
+        valid_journey_patterns(std::move(recycled.valid_journey_patterns)),
+        Q(std::move(recycled.Q)),
+        valid_stop_points(std::move(recycled.valid_stop_points))
+    {
+        labels.assign(10, data.dataRaptor->labels_const);
+        first_pass_labels.assign(10, data.dataRaptor->labels_const);
+        best_labels_pts.assign(data.pt_data->stop_points, DateTime());
+        best_labels_transfers.assign(data.pt_data->stop_points, DateTime());
+        Q.assign(data.dataRaptor->jp_container.get_jps_values(), int());
+        valid_journey_patterns.resize(data.dataRaptor->jp_container.nb_jps());
+        valid_journey_patterns.reset();
+        valid_stop_points.resize(data.pt_data->stop_points.size());
+        valid_stop_points.reset();
+    }
+
     void clear(bool clockwise, DateTime bound);
 
     ///Initialize starting points
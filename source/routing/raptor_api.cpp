@@ -53,13 +53,34 @@ static void add_coord(const type::GeographicalCoord& coord, pbnavitia::Section*
     new_coord->set_lat(coord.lat());
 }
 
+/*
+ * fill the shape of the section and its length
+ *
+ * the length is computed while the coordinates are added, and the shape is
+ * reserved beforehand, so the repeated field is written only once
+ */
 static void fill_shape(pbnavitia::Section* pb_section,
                        const std::vector<const type::StopTime*>& stop_times)
 {
-    if (stop_times.empty()) { return; }
+    if (stop_times.empty()) {
+        pb_section->set_length(0);
+        return;
+    }
 
+    size_t nb_coords = stop_times.size();
+    for (const auto* st: stop_times) {
+        if (st->shape_from_prev != nullptr) { nb_coords += st->shape_from_prev->size(); }
+    }
+    pb_section->mutable_shape()->Reserve(pb_section->shape_size() + static_cast<int>(nb_coords));
+
+    double length = 0;
     type::GeographicalCoord prev_coord = stop_times.front()->stop_point->coord;
     add_coord(prev_coord, pb_section);
+    auto add_next_coord = [&](const type::GeographicalCoord& coord) {
+        add_coord(coord, pb_section);
+        length += prev_coord.distance_to(coord);
+        prev_coord = coord;
+    };
     auto prev_order = stop_times.front()->order();
     for (auto it = stop_times.begin() + 1; it != stop_times.end(); ++it) {
         const auto* st = *it;
@@ -71,34 +92,17 @@ static void fill_shape(pbnavitia::Section* pb_section,
         if (prev_order + 1 == cur_order && st-> shape_from_prev != nullptr) {
             for (const auto& cur_coord: *st->shape_from_prev) {
                 if (cur_coord == prev_coord) { continue; }
-                add_coord(cur_coord, pb_section);
-                prev_coord = cur_coord;
+                add_next_coord(cur_coord);
             }
         }
         // Add the coordinates of the stop point if not already added
         // by the shape.
         const auto& sp_coord = st->stop_point->coord;
         if (sp_coord != prev_coord) {
-            add_coord(sp_coord, pb_section);
-            prev_coord = sp_coord;
+            add_next_coord(sp_coord);
         }
         prev_order = cur_order;
     }
-}
-
-static void set_length(pbnavitia::Section* pb_section) {
-    type::GeographicalCoord prev_geo;
-    if (pb_section->shape_size() > 0) {
-        const auto& first_coord = pb_section->shape(0);
-        prev_geo = type::GeographicalCoord(first_coord.lon(), first_coord.lat());
-    }
-    double length = 0;
-    for (int i = 1; i < pb_section->shape_size(); ++i) {
-        const auto& cur_coord = pb_section->shape(i);
-        const auto cur_geo = type::GeographicalCoord(cur_coord.lon(), cur_coord.lat());
-        length += prev_geo.distance_to(cur_geo);
-        prev_geo = cur_geo;
-    }
     pb_section->set_length(length);
 }
 
@@ -162,7 +166,6 @@ static void fill_section(PbCreator& pb_creator, pbnavitia::Section *pb_section,
     pb_creator.fill(&vj_stoptimes, vj_pt_display_information, 1);
 
     fill_shape(pb_section, stop_times);
-    set_length(pb_section);
     pb_creator.fill_co2_emission(pb_section, vj);
 }
 
@@ -271,9 +274,18 @@ static bt::ptime get_base_dt(const nt::StopTime* st_orig, const nt::StopTime* st
     return bt::ptime(validity_pattern_dt_day, boost::posix_time::seconds(hour_of_day_base));
 }
 
+/// fares of all the journeys of the response, computed together since the
+/// journeys often share their first sections
+static std::vector<fare::results> compute_fares(PbCreator& pb_creator,
+                                                const std::vector<navitia::routing::Path>& paths) {
+    pb_creator.data->load_section(type::DataSection::Fare);
+    return pb_creator.data->fare->compute_fares(paths);
+}
+
 static bt::ptime handle_pt_sections(pbnavitia::Journey* pb_journey,
                                     PbCreator& pb_creator,
-                                    const navitia::routing::Path& path){
+                                    const navitia::routing::Path& path,
+                                    const fare::results& fare){
     log4cplus::Logger logger = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"));
     pb_journey->set_nb_transfers(path.nb_changes);
     pb_journey->set_requested_date_time(navitia::to_posix_timestamp(path.request_time));
@@ -448,8 +460,6 @@ static bt::ptime handle_pt_sections(pbnavitia::Journey* pb_journey,
 
     compute_most_serious_disruption(pb_journey, pb_creator);
 
-    //fare computation, done at the end for the journey to be complete
-    auto fare = pb_creator.data->fare->compute_fare(path);
     try {
         pb_creator.fill_fare_section(pb_journey, fare);
     } catch(const navitia::exception& e) {
@@ -469,8 +479,10 @@ static void add_pathes(PbCreator& pb_creator,
                        const bool clockwise) {
 
     log4cplus::Logger logger = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"));
+    const auto fares = compute_fares(pb_creator, paths);
 
-    for(const Path& path : paths) {
+    for(size_t i = 0; i < paths.size(); ++i) {
+        const Path& path = paths[i];
         bt::ptime arrival_time = bt::pos_infin;
         if (path.items.empty()) {
             continue;
@@ -550,7 +562,7 @@ static void add_pathes(PbCreator& pb_creator,
             }
         }
 
-        arrival_time = handle_pt_sections(pb_journey, pb_creator, path);
+        arrival_time = handle_pt_sections(pb_journey, pb_creator, path, fares[i]);
         // for 'taxi like' odt, we want to start from the address, not the 1 stop point
         if (journey_begin_with_address_odt) {
             auto* section = pb_journey->mutable_sections(0);
@@ -657,14 +669,16 @@ static void add_pt_pathes(PbCreator& pb_creator,
                        const std::vector<navitia::routing::Path>& paths) {
 
     log4cplus::Logger logger = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"));
-    for(const Path& path : paths) {
+    const auto fares = compute_fares(pb_creator, paths);
+    for(size_t i = 0; i < paths.size(); ++i) {
+        const Path& path = paths[i];
         //TODO: what do we want to do in this case?
         if (path.items.empty()) {
             continue;
         }
         bt::ptime departure_time = path.items.front().departures.front();
         pbnavitia::Journey* pb_journey = pb_creator.add_journeys();
-        bt::ptime arrival_time = handle_pt_sections(pb_journey, pb_creator, path);
+        bt::ptime arrival_time = handle_pt_sections(pb_journey, pb_creator, path, fares[i]);
 
 
         pb_journey->set_departure_date_time(navitia::to_posix_timestamp(departure_time));
@@ -35,6 +35,7 @@ www.navitia.io
 #include "routing/get_stop_times.h"
 #include "ed/build_helper.h"
 #include "routing/dataraptor.h"
+#include "routing/next_stop_time.h"
 
 using namespace navitia;
 using namespace navitia::routing;
@@ -479,6 +480,82 @@ BOOST_AUTO_TEST_CASE(queue_comp_test_anti_clockwise) {
     q.pop();
     BOOST_CHECK_EQUAL(q.top().dt, 12);
 }
+
+/*
+ * small test to check the tournament tree used in get_stop_times
+ */
+BOOST_AUTO_TEST_CASE(tournament_test) {
+    nt::StopTime st;
+    JppStTournament t({{JppIdx(0), &st, 12},
+                       {JppIdx(1), &st, 42},
+                       {JppIdx(2), nullptr, 1}, // exhausted, never the best
+                       {JppIdx(3), &st, 6},
+                       {JppIdx(4), &st, 12}}, true);
+
+    //for clockwise, we want the smallest first
+    BOOST_REQUIRE(! t.empty());
+    BOOST_CHECK_EQUAL(t.top().dt, 6);
+    BOOST_CHECK_EQUAL(t.top_leaf(), 3);
+    t.replace_top({JppIdx(3), &st, 50});
+    // on equality, the first leaf wins
+    BOOST_CHECK_EQUAL(t.top().dt, 12);
+    BOOST_CHECK_EQUAL(t.top_leaf(), 0);
+    t.pop();
+    BOOST_CHECK_EQUAL(t.top().dt, 12);
+    BOOST_CHECK_EQUAL(t.top_leaf(), 4);
+    t.pop();
+    BOOST_CHECK_EQUAL(t.top().dt, 42);
+    t.pop();
+    BOOST_CHECK_EQUAL(t.top().dt, 50);
+    t.pop();
+    BOOST_CHECK(t.empty());
+
+    JppStTournament anti({{JppIdx(0), &st, 12}, {JppIdx(1), &st, 42}, {JppIdx(2), &st, 6}}, false);
+    //for anticlockwise, we want the greatest first
+    BOOST_CHECK_EQUAL(anti.top().dt, 42);
+    anti.pop();
+    BOOST_CHECK_EQUAL(anti.top().dt, 12);
+
+    BOOST_CHECK(JppStTournament({}, true).empty());
+}
+
+/*
+ * The cursor must give the same stop times as NextStopTime for monotone requests,
+ * across the days and with vj not valid every day
+ */
+BOOST_AUTO_TEST_CASE(next_stop_time_cursor_test) {
+    ed::builder b("20120614");
+    b.vj("A", "1010", "", true, "vj1")("stop1", 8000, 8000)("stop2", 8100, 8100);
+    b.vj("A", "0101", "", true, "vj2")("stop1", 8000, 8000)("stop2", 8200, 8200);
+    b.vj("A", "1111", "", true, "vj3")("stop1", 9000, 9000)("stop2", 9100, 9100);
+    b.vj("A", "0011", "", true, "vj4")("stop1", 30000, 30000)("stop2", 30100, 30100);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+
+    const NextStopTime next_st(*b.data);
+    for (const auto& jpp: b.data->dataRaptor->jp_container.get_jpps()) {
+        for (const auto stop_event: {StopEvent::pick_up, StopEvent::drop_off}) {
+            NextStopTimeCursor cursor(*b.data, stop_event, jpp.first, true, nt::RTLevel::Base, {});
+            for (DateTime dt = 0; dt < DateTimeUtils::set(4, 0); dt += 600) {
+                const auto expected = next_st.next_stop_time(stop_event, jpp.first, dt, true,
+                                                             nt::RTLevel::Base, {});
+                const auto res = cursor.next(dt);
+                BOOST_CHECK_EQUAL(res.first, expected.first);
+                BOOST_CHECK_EQUAL(res.second, expected.second);
+            }
+
+            NextStopTimeCursor anti_cursor(*b.data, stop_event, jpp.first, false, nt::RTLevel::Base, {});
+            for (DateTime dt = DateTimeUtils::set(4, 0); dt > 0; dt -= 600) {
+                const auto expected = next_st.next_stop_time(stop_event, jpp.first, dt, false,
+                                                             nt::RTLevel::Base, {});
+                const auto res = anti_cursor.next(dt);
+                BOOST_CHECK_EQUAL(res.first, expected.first);
+                BOOST_CHECK_EQUAL(res.second, expected.second);
+            }
+        }
+    }
+}
 /**
  *
  * There are 3 lines with multiple vj that pass through the 'center' station.
@@ -553,3 +630,71 @@ BOOST_FIXTURE_TEST_CASE(dep_arr_filtering, departure_helper) {
     BOOST_CHECK_EQUAL(prev_departures.at(3).first, "19:01"_t);
     BOOST_CHECK_EQUAL(prev_departures.at(4).first, "11:01"_t);
 }
+
+/*
+ * get_stop_times must give the same results with and without the departure snapshots
+ *
+ * the stop area 'hub' has 2 stop points, with 2 lines, and vj not valid every day
+ */
+BOOST_AUTO_TEST_CASE(departure_snapshots_test) {
+    ed::builder b("20120614");
+    b.sa("hub", 0, 0, false)("hub:1")("hub:2");
+    b.vj("A", "1111", "", true, "A1")("hub:1", 8000, 8000)("A_end", 9000, 9000);
+    b.vj("A", "0101", "", true, "A2")("hub:1", 8000, 8000)("A_end", 9100, 9100);
+    b.vj("A", "1010", "", true, "A3")("hub:1", 80000, 80000)("A_end", 90000, 90000);
+    b.vj("B", "1111", "", true, "B1")("B_start", 7000, 7000)("hub:2", 8000, 8000)("B_end", 9000, 9000);
+    b.vj("B", "0011", "", true, "B2")("B_start", 40000, 40000)("hub:2", 43000, 43100)("B_end", 50000, 50000);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor(10, 3);
+    BOOST_REQUIRE(b.data->dataRaptor->departure_snapshots);
+
+    std::vector<JppIdx> hub_jpps;
+    for (const auto* sp: b.data->pt_data->stop_areas_map["hub"]->stop_point_list) {
+        for (const auto& jpp: b.data->dataRaptor->jpps_from_sp[SpIdx(*sp)]) {
+            hub_jpps.push_back(jpp.idx);
+        }
+    }
+    BOOST_REQUIRE_EQUAL(hub_jpps.size(), 2);
+
+    auto get = [&](const StopEvent stop_event, const DateTime dt, const DateTime max_dt, const size_t nb) {
+        return get_stop_times(stop_event, hub_jpps, dt, max_dt, nb, *b.data, nt::RTLevel::Base);
+    };
+    const std::vector<std::pair<DateTime, DateTime>> windows = {
+        {0, "24:00"_t},
+        {8001, "24:00"_t},
+        {"12:00"_t, "24:00"_t + "12:00"_t},
+        {"24:00"_t + 8000, "48:00"_t + 8000},
+        {"24:00"_t, "24:00"_t + 8000},
+        {0, "72:00"_t}, // too long for the snapshots
+    };
+    std::vector<std::vector<datetime_stop_time>> with_snapshots;
+    for (const auto& window: windows) {
+        for (const auto stop_event: {StopEvent::pick_up, StopEvent::drop_off}) {
+            for (const size_t nb: {1, 2, 100}) {
+                with_snapshots.push_back(get(stop_event, window.first, window.second, nb));
+            }
+        }
+    }
+    BOOST_CHECK(b.data->dataRaptor->departure_snapshots->get_nb_calls() > 0);
+    BOOST_CHECK(b.data->dataRaptor->departure_snapshots->nb_snapshots() <= 3);
+    BOOST_CHECK(b.data->dataRaptor->departure_snapshots->memory_footprint() > 0);
+
+    b.data->dataRaptor->departure_snapshots.reset();
+    size_t i = 0;
+    for (const auto& window: windows) {
+        for (const auto stop_event: {StopEvent::pick_up, StopEvent::drop_off}) {
+            for (const size_t nb: {1, 2, 100}) {
+                const auto expected = get(stop_event, window.first, window.second, nb);
+                const auto& res = with_snapshots.at(i++);
+                BOOST_REQUIRE_EQUAL(res.size(), expected.size());
+                for (size_t j = 0; j < res.size(); ++j) {
+                    BOOST_CHECK_EQUAL(res[j].first, expected[j].first);
+                    BOOST_CHECK_EQUAL(res[j].second, expected[j].second);
+                }
+            }
+        }
+    }
+    // the first window gives the 3 departures of the first day, A1 and A2 being both at 8000 on hub:1
+    BOOST_CHECK_EQUAL(with_snapshots.at(2).size(), 3);
+}
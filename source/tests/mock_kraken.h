@@ -77,7 +77,13 @@ struct mock_kraken {
 
 
         // Launch only one thread for the tests
-        threads.create_thread(std::bind(&doWork, std::ref(context), std::ref(data_manager), conf));
+        navitia::Metrics metrics;
+        threads.create_thread(std::bind(&doWork, std::ref(context), std::ref(data_manager),
+                                        std::ref(metrics), conf));
+        if (const auto metrics_socket = conf.metrics_socket_path()) {
+            threads.create_thread(std::bind(&serve_metrics, std::ref(context), std::ref(data_manager),
+                                            std::cref(metrics), *metrics_socket));
+        }
 
         // Connect work threads to client threads via a queue
         do {
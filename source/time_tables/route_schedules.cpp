@@ -41,6 +41,9 @@ www.navitia.io
 #include <boost/range/algorithm_ext/for_each.hpp>
 #include <boost/graph/topological_sort.hpp>
 #include <boost/graph/adjacency_matrix.hpp>
+#include <limits>
+#include <queue>
+#include <tuple>
 
 namespace pt = boost::posix_time;
 
@@ -293,9 +296,109 @@ std::vector<uint32_t> compute_order(const size_t nb_vertices, const std::vector<
                    << ", nb_topo_sort = " << is_dag.nb_call);
     return std::move(is_dag.order);
 }
-void ranked_pairs_sort(std::vector<std::vector<routing::datetime_stop_time>>& v) {
-    const auto edges = create_edges(v);
-    const auto order = compute_order(v.size(), edges);
+// Near linear alternative to ranked pairs for big route schedules.
+//
+// At each stop point, the vj stopping there are ordered by their
+// time: it's a chain of constraints.  The order of the route schedule
+// is a topological merge of all these chains (Kahn's algorithm).
+// Contrary to a sort using the score, that is not transitive, two vj
+// without any common stop point (short turns, disjoint branches) are
+// ordered by the vj they share stop points with.
+//
+// Among the vj with all their constraints done, the first one is the
+// one leaving first.  If there is a cycle (overtaking), we take the
+// remaining vj with the less constraints not done, i.e. the one that
+// is the most often before the other remaining vj.
+//
+// Let n be the number of vj and m the number of stop points, it's
+// O(m * n * log(n)) instead of O(n² * m) only to create the edges of
+// ranked pairs.
+std::vector<uint32_t> compute_merge_order(const std::vector<std::vector<routing::datetime_stop_time>>& v) {
+    const uint32_t n = v.size();
+    const size_t nb_stops = v.empty() ? 0 : v.front().size();
+
+    std::vector<DateTime> first_departure(n, std::numeric_limits<DateTime>::max());
+    for (uint32_t i = 0; i < n; ++i) {
+        for (const auto& dt_st: v[i]) {
+            if (dt_st.second != nullptr) { first_departure[i] = dt_st.first; break; }
+        }
+    }
+    const auto leaves_after = [&](const uint32_t a, const uint32_t b) {
+        return std::tie(first_departure[a], a) > std::tie(first_departure[b], b);
+    };
+
+    std::vector<std::vector<uint32_t>> successors(n);
+    std::vector<uint32_t> nb_predecessors(n, 0);
+    std::vector<uint32_t> column;
+    for (size_t s = 0; s < nb_stops; ++s) {
+        column.clear();
+        for (uint32_t i = 0; i < n; ++i) {
+            if (v[i][s].second != nullptr) { column.push_back(i); }
+        }
+        std::sort(column.begin(), column.end(), [&](const uint32_t a, const uint32_t b) {
+                return v[a][s].first < v[b][s].first;
+            });
+        // the vj at the same time are not ordered by this stop point,
+        // each of them is before the vj of the next time
+        size_t prev = 0, cur = 0;
+        while (cur < column.size()) {
+            size_t end = cur + 1;
+            while (end < column.size() && v[column[end]][s].first == v[column[cur]][s].first) { ++end; }
+            for (size_t a = prev; a < cur; ++a) {
+                for (size_t b = cur; b < end; ++b) {
+                    successors[column[a]].push_back(column[b]);
+                    ++nb_predecessors[column[b]];
+                }
+            }
+            prev = cur;
+            cur = end;
+        }
+    }
+
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    std::vector<bool> done(n, false);
+    std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(leaves_after)> ready(leaves_after);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (nb_predecessors[i] == 0) { ready.push(i); }
+    }
+    size_t nb_cycles = 0;
+    while (order.size() < n) {
+        if (ready.empty()) {
+            ++nb_cycles;
+            uint32_t best = n;
+            for (uint32_t i = 0; i < n; ++i) {
+                if (done[i]) { continue; }
+                if (best == n || nb_predecessors[i] < nb_predecessors[best]
+                    || (nb_predecessors[i] == nb_predecessors[best] && leaves_after(best, i))) {
+                    best = i;
+                }
+            }
+            ready.push(best);
+        }
+        const uint32_t vj = ready.top();
+        ready.pop();
+        done[vj] = true;
+        order.push_back(vj);
+        for (const auto succ: successors[vj]) {
+            if (! done[succ] && --nb_predecessors[succ] == 0) { ready.push(succ); }
+        }
+    }
+    LOG4CPLUS_DEBUG(log4cplus::Logger::getInstance("log"),
+                    "merge order done with nb_vertices = " << n << ", nb_cycles = " << nb_cycles);
+    return order;
+}
+}
+
+void sort_route_schedule(std::vector<std::vector<routing::datetime_stop_time>>& v,
+                         const size_t max_ranked_pairs_size) {
+    std::vector<uint32_t> order;
+    if (v.size() <= max_ranked_pairs_size) {
+        const auto edges = create_edges(v);
+        order = compute_order(v.size(), edges);
+    } else {
+        order = compute_merge_order(v);
+    }
 
     // reordering v according to the given order
     std::vector<std::vector<routing::datetime_stop_time>> res;
@@ -305,7 +408,6 @@ void ranked_pairs_sort(std::vector<std::vector<routing::datetime_stop_time>>& v)
     }
     boost::swap(res, v);
 }
-}
 
 static std::vector<std::vector<routing::datetime_stop_time> >
 make_matrix(const std::vector<std::vector<routing::datetime_stop_time> >& stop_times,
@@ -329,7 +431,7 @@ make_matrix(const std::vector<std::vector<routing::datetime_stop_time> >& stop_t
         ++y;
     }
 
-    ranked_pairs_sort(tmp);
+    sort_route_schedule(tmp);
     // We rotate the matrice, so it can be handle more easily in route_schedule
     for (size_t i=0; i<tmp.size(); ++i) {
         for (size_t j=0; j<tmp[i].size(); ++j) {
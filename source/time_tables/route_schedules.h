@@ -48,6 +48,16 @@ get_all_route_stop_times(const navitia::type::Route* route,
                          const type::RTLevel rt_level,
                          const boost::optional<const std::string> calendar_id);
 
+/*
+ * Sorts the vehicle journeys of a route schedule, v[i] being the stop times of a vj
+ * aligned on the thermometer (null stop time if the vj does not stop).
+ *
+ * Up to max_ranked_pairs_size vj, the order is given by ranked pairs, above it is given
+ * by a topological merge of the orders of the vj at each stop point, much faster on big routes.
+ */
+void sort_route_schedule(std::vector<std::vector<routing::datetime_stop_time>>& v,
+                         const size_t max_ranked_pairs_size = 100);
+
 void route_schedule(PbCreator& pb_creator, const std::string & line_externalcode,
                     const boost::optional<const std::string> calendar_id,
                     const std::vector<std::string>& forbidden_uris,
@@ -891,3 +891,87 @@ BOOST_AUTO_TEST_CASE(route_schedule_with_boarding_time_order_check) {
     BOOST_CHECK_EQUAL(route_schedule.table().rows(1).date_times(1).time(), "8:10"_t);
     BOOST_CHECK_EQUAL(route_schedule.table().rows(2).date_times(1).time(), "8:15"_t);
 }
+
+// The merge order used for big routes must give the same order as ranked pairs
+// when there is no cycle
+BOOST_AUTO_TEST_CASE(merge_order_as_ranked_pairs) {
+    using DtSt = navitia::routing::datetime_stop_time;
+    using Matrix = std::vector<std::vector<DtSt>>;
+    nt::StopTime st;
+    const DtSt no_st = {0, nullptr};
+    auto t = [&](const navitia::DateTime dt) { return DtSt(dt, &st); };
+
+    // same as complicated_order_1, the vj are given in the order B A C, we want C A B
+    const Matrix m = {
+        {t(1), t(3), t(5), t(6), t(7), t(8)},
+        {no_st, no_st, no_st, t(5), t(6), t(7)},
+        {t(2), no_st, no_st, t(3), t(4), t(5)},
+    };
+    auto ranked_pairs = m;
+    ntt::sort_route_schedule(ranked_pairs);
+    auto merge = m;
+    ntt::sort_route_schedule(merge, 0);
+    BOOST_REQUIRE_EQUAL(merge.size(), 3);
+    BOOST_CHECK_EQUAL(merge[0][3].first, 3);
+    BOOST_CHECK_EQUAL(merge[1][3].first, 5);
+    BOOST_CHECK_EQUAL(merge[2][3].first, 6);
+    BOOST_CHECK(merge == ranked_pairs);
+
+    // a big route, shuffled, with some vj not stopping everywhere
+    Matrix big;
+    for (size_t i = 0; i < 300; ++i) {
+        const navitia::DateTime dep = (i * 7919) % 300 * 60;
+        std::vector<DtSt> vj;
+        for (size_t s = 0; s < 10; ++s) {
+            vj.push_back((i + s) % 4 == 0 ? no_st : t(dep + s * 120));
+        }
+        big.push_back(vj);
+    }
+    ranked_pairs = big;
+    ntt::sort_route_schedule(ranked_pairs, big.size());
+    ntt::sort_route_schedule(big);
+    BOOST_CHECK(big == ranked_pairs);
+}
+
+// The vj without any common stop point (short turns, disjoint branches) must be
+// ordered by the vj they share stop points with
+BOOST_AUTO_TEST_CASE(merge_order_short_turns) {
+    using DtSt = navitia::routing::datetime_stop_time;
+    using Matrix = std::vector<std::vector<DtSt>>;
+    nt::StopTime st;
+    const DtSt no_st = {0, nullptr};
+    const size_t nb_stops = 8;
+    // a vj leaving at dep, stopping every 5 min from the stop first to the stop last
+    auto vj = [&](const navitia::DateTime dep, const size_t first, const size_t last) {
+        std::vector<DtSt> res(nb_stops, no_st);
+        for (size_t s = first; s <= last; ++s) { res[s] = DtSt(dep + (s - first) * 300, &st); }
+        return res;
+    };
+
+    Matrix m;
+    for (size_t i = 0; i < 20; ++i) {
+        const navitia::DateTime dep = i * 1200;
+        m.push_back(vj(dep, 0, 7));
+        // short turn on the first half, between this vj and the next one
+        m.push_back(vj(dep + 600, 0, 3));
+        // short turn on the second half, leaving after the next vj from the start
+        // of the line, but passing before it
+        m.push_back(vj(dep + 1200 + 600, 4, 7));
+        // the end of a branch
+        m.push_back(vj(dep + 2100 + 60, 6, 7));
+    }
+    // shuffled
+    Matrix big;
+    for (size_t i = 0; i < m.size(); ++i) { big.push_back(m[(i * 37) % m.size()]); }
+
+    ntt::sort_route_schedule(big, 0);
+    BOOST_REQUIRE_EQUAL(big.size(), m.size());
+    for (size_t i = 0; i < big.size(); ++i) {
+        for (size_t j = i + 1; j < big.size(); ++j) {
+            for (size_t s = 0; s < nb_stops; ++s) {
+                if (big[i][s].second == nullptr || big[j][s].second == nullptr) { continue; }
+                BOOST_CHECK_LE(big[i][s].first, big[j][s].first);
+            }
+        }
+    }
+}
@@ -55,6 +55,9 @@ www.navitia.io
 #include "routing/dataraptor.h"
 #include "georef/georef.h"
 #include "fare/fare.h"
+#include "ptreferential/query_plan.h"
+#include "ptreferential/attribute_index.h"
+#include "type/pb_fragment_cache.h"
 #include "type/meta_data.h"
 #include "kraken/fill_disruption_from_database.h"
 
@@ -64,7 +67,7 @@ namespace navitia { namespace type {
 
 wrong_version::~wrong_version() noexcept {}
 
-const unsigned int Data::data_version = 66; //< *INCREMENT* every time serialized data are modified
+const unsigned int Data::data_version = 68; //< *INCREMENT* every time serialized data are modified
 
 Data::Data(size_t data_identifier) :
     data_identifier(data_identifier),
@@ -73,6 +76,8 @@ Data::Data(size_t data_identifier) :
     geo_ref(std::make_unique<navitia::georef::GeoRef>()),
     dataRaptor(std::make_unique<navitia::routing::dataRAPTOR>()),
     fare(std::make_unique<navitia::fare::Fare>()),
+    ptref_plan_cache(std::make_unique<navitia::ptref::QueryPlanCache>(*this)),
+    pb_fragment_cache(std::make_unique<navitia::PbFragmentCache>()),
     find_admins(
             [&](const GeographicalCoord &c){
             return geo_ref->find_admins(c);
@@ -81,6 +86,10 @@ Data::Data(size_t data_identifier) :
     loaded = false;
     is_connected_to_rabbitmq = false;
     is_realtime_loaded = false;
+    // a data built in memory has all its sections
+    for (auto& section_loaded: sections_loaded) {
+        section_loaded = true;
+    }
 }
 
 Data::~Data(){}
@@ -88,13 +97,20 @@ Data::~Data(){}
 bool Data::load(const std::string& filename,
                 const boost::optional<std::string>& chaos_database,
                 const std::vector<std::string>& contributors,
-                const size_t raptor_cache_size) {
+                const size_t raptor_cache_size,
+                const size_t departure_snapshot_cache_size,
+                const SectionsLoading& sections_loading) {
     log4cplus::Logger logger = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"));
     loading = true;
     try {
         std::ifstream ifs(filename.c_str(), std::ios::in | std::ios::binary);
         ifs.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        this->load(ifs);
+        if (SectionsReader::is_sectioned(ifs)) {
+            // the reader keeps its own stream opened for the lazy sections
+            load_sections(std::make_shared<SectionsReader>(filename), sections_loading);
+        } else {
+            this->load(ifs);
+        }
         last_load_at = pt::microsec_clock::universal_time();
         last_load = true;
         loaded = true;
@@ -106,7 +122,8 @@ bool Data::load(const std::string& filename,
         if (chaos_database) {
             fill_disruption_from_database(*chaos_database, *pt_data, *meta, contributors);
         }
-        build_raptor(raptor_cache_size);
+        build_raptor(raptor_cache_size, departure_snapshot_cache_size);
+        build_ptref_indexes();
     } catch(const wrong_version& ex) {
         LOG4CPLUS_ERROR(logger, "Cannot load data: " << ex.what());
         last_load = false;
@@ -121,9 +138,115 @@ bool Data::load(const std::string& filename,
     return this->last_load;
 }
 
+void Data::check_version() const {
+    if(this->version != data_version){
+        unsigned int v = data_version;//sinon ca link pas...
+        auto msg = boost::format("Warning data version don't match with the data version of kraken %u (current version: %d)") % version % v;
+        throw wrong_version(msg.str());
+    }
+}
+
+void Data::read_section(SectionsReader& reader, DataSection section) {
+    auto logger = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"));
+    const auto start = pt::microsec_clock::local_time();
+    const auto memory_before = resident_memory();
+    reader.read(section, [&](std::streambuf& buf) {
+        eos::portable_iarchive ia(buf);
+        serialize_section(ia, *this, section);
+    });
+    const auto memory_after = resident_memory();
+    LOG4CPLUS_INFO(logger, "section " << to_string(section) << " loaded in "
+                   << (pt::microsec_clock::local_time() - start).total_milliseconds() << " ms, resident memory: +"
+                   << (memory_after > memory_before ? memory_after - memory_before : 0) / (1024 * 1024) << " MB");
+}
+
+void Data::clear_section(DataSection section) {
+    switch (section) {
+    case DataSection::Main:
+        break;
+    case DataSection::Autocomplete:
+        geo_ref->fl_admin = autocomplete::Autocomplete<unsigned int>(Type_e::Admin);
+        geo_ref->fl_way = autocomplete::Autocomplete<unsigned int>(Type_e::Way);
+        geo_ref->fl_poi = autocomplete::Autocomplete<unsigned int>(Type_e::POI);
+        pt_data->stop_area_autocomplete = autocomplete::Autocomplete<idx_t>(Type_e::StopArea);
+        pt_data->stop_point_autocomplete = autocomplete::Autocomplete<idx_t>(Type_e::StopPoint);
+        pt_data->line_autocomplete = autocomplete::Autocomplete<idx_t>(Type_e::Line);
+        pt_data->network_autocomplete = autocomplete::Autocomplete<idx_t>(Type_e::Network);
+        pt_data->mode_autocomplete = autocomplete::Autocomplete<idx_t>(Type_e::CommercialMode);
+        pt_data->route_autocomplete = autocomplete::Autocomplete<idx_t>(Type_e::Route);
+        break;
+    case DataSection::Fare:
+        fare = std::make_unique<navitia::fare::Fare>();
+        break;
+    }
+}
+
+void Data::load_sections(const std::shared_ptr<SectionsReader>& reader, const SectionsLoading& loading) {
+    auto logger = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"));
+    this->version = reader->data_version();
+    check_version();
+    sections_loading = loading;
+    bool has_lazy_section = false;
+    for (const auto& entry: reader->entries()) {
+        const auto section_loading = entry.section == DataSection::Main ?
+            SectionLoading::Eager : find_or_default(entry.section, loading);
+        const auto size_mb = entry.raw_size / (1024 * 1024);
+        switch (section_loading) {
+        case SectionLoading::Eager:
+            read_section(*reader, entry.section);
+            break;
+        case SectionLoading::Lazy:
+            sections_loaded[size_t(entry.section)] = false;
+            has_lazy_section = true;
+            LOG4CPLUS_INFO(logger, "section " << to_string(entry.section)
+                           << " will be loaded at its first use, saving about " << size_mb << " MB until then");
+            break;
+        case SectionLoading::Skip:
+            sections_loaded[size_t(entry.section)] = false;
+            LOG4CPLUS_INFO(logger, "section " << to_string(entry.section)
+                           << " is not loaded, saving about " << size_mb << " MB");
+            break;
+        }
+    }
+    if (has_lazy_section) {
+        sections_file = reader;
+    }
+}
+
+void Data::load_section(DataSection section) const {
+    if (sections_loaded[size_t(section)]) { return; }
+    std::lock_guard<std::mutex> lock(sections_mutex);
+    if (sections_loaded[size_t(section)]) { return; }
+    if (! sections_file || find_or_default(section, sections_loading) != SectionLoading::Lazy) {
+        // skipped section, it stays empty
+        return;
+    }
+    // the data is shared between the workers, loading a lazy section is the only mutation allowed
+    auto& data = const_cast<Data&>(*this);
+    try {
+        data.read_section(*sections_file, section);
+    } catch (const std::exception& e) {
+        LOG4CPLUS_ERROR(log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger")),
+                        "unable to load section " << to_string(section) << ", it will stay empty: " << e.what());
+        data.clear_section(section);
+    }
+    sections_loaded[size_t(section)] = true;
+}
+
 void Data::load(std::istream& ifs) {
+    if (SectionsReader::is_sectioned(ifs)) {
+        // the stream is not kept, all the sections are loaded now
+        load_sections(std::make_shared<SectionsReader>(ifs), {});
+        return;
+    }
+    // data.nav written before the sections
     boost::iostreams::filtering_streambuf<boost::iostreams::input> in;
-    in.push(LZ4Decompressor(2048*500),8192*500, 8192*500);
+    if (lz4_frame::is_framed(ifs)) {
+        in.push(LZ4FrameDecompressor(), 1024*500, 1024*500);
+    } else {
+        // data.nav written before the framed format
+        in.push(LZ4Decompressor(2048*500),8192*500, 8192*500);
+    }
     in.push(ifs);
     eos::portable_iarchive ia(in);
     ia >> *this;
@@ -172,11 +295,15 @@ void Data::save(const std::string& filename) const {
 }
 
 void Data::save(std::ostream& ofs) const {
-    boost::iostreams::filtering_streambuf<boost::iostreams::output> out;
-    out.push(LZ4Compressor(2048*500), 1024*500, 1024*500);
-    out.push(ofs);
-    eos::portable_oarchive oa(out);
-    oa << *this;
+    SectionsWriter writer(ofs, data_version, data_sections().size());
+    for (const auto section: data_sections()) {
+        load_section(section);
+        writer.write(section, [&](std::streambuf& buf) {
+            eos::portable_oarchive oa(buf);
+            serialize_section(oa, *this, section);
+        });
+    }
+    writer.close();
 }
 
 void Data::build_uri(){
@@ -249,10 +376,10 @@ void Data::build_autocomplete(){
     pt_data->compute_score_autocomplete(*geo_ref);
 }
 
-void Data::build_raptor(size_t cache_size) {
+void Data::build_raptor(size_t cache_size, size_t snapshot_cache_size) {
     LOG4CPLUS_DEBUG(log4cplus::Logger::getInstance("log"),
                     "Start to build dataRaptor");
-    dataRaptor->load(*this->pt_data, cache_size);
+    dataRaptor->load(*this->pt_data, cache_size, snapshot_cache_size);
     LOG4CPLUS_DEBUG(log4cplus::Logger::getInstance("log"),
                     "Finished to build dataRaptor");
 }
@@ -456,6 +583,28 @@ void Data::build_relations(){
             vj->route->line->physical_mode_list.push_back(vj->physical_mode);
         }
     }
+    build_ptref_indexes();
+}
+
+void Data::build_ptref_indexes() {
+    auto logger = log4cplus::Logger::getInstance("log");
+    auto start = pt::microsec_clock::universal_time();
+    ptref_indexes = std::make_unique<navitia::ptref::AttributeIndexes>(*this);
+    LOG4CPLUS_INFO(logger, "ptref indexes built in "
+                   << (pt::microsec_clock::universal_time() - start).total_milliseconds() << "ms ("
+                   << ptref_indexes->nb_indexed_values() << " values)");
+}
+
+void Data::build_ptref_indexes(const Data& previous) {
+    if (! previous.ptref_indexes) {
+        build_ptref_indexes();
+        return;
+    }
+    auto logger = log4cplus::Logger::getInstance("log");
+    auto start = pt::microsec_clock::universal_time();
+    ptref_indexes = std::make_unique<navitia::ptref::AttributeIndexes>(*previous.ptref_indexes, *this);
+    LOG4CPLUS_INFO(logger, "ptref indexes of the vehicle journeys rebuilt in "
+                   << (pt::microsec_clock::universal_time() - start).total_milliseconds() << "ms");
 }
 
 void Data::aggregate_odt(){
@@ -789,10 +938,20 @@ struct Pipe {
 // in our object.  To avoid having the whole binary_oarchive in
 // memory, we construct a pipe between 2 threads.
 void Data::clone_from(const Data& from) {
+    // no lazy section is loaded in from during the copy
+    std::lock_guard<std::mutex> lock(from.sections_mutex);
     Pipe p;
     std::thread write([&]() {boost::archive::binary_oarchive oa(p.out); oa << from;});
     { boost::archive::binary_iarchive ia(p.in); ia >> *this; }
     write.join();
+    // the sections not loaded yet will be loaded by the clone from the same file
+    sections_file = from.sections_file;
+    sections_loading = from.sections_loading;
+    for (size_t i = 0; i < sections_loaded.size(); ++i) {
+        sections_loaded[i] = from.sections_loaded[i].load();
+    }
+    // the fragments of from are not copied, they are filled again on the clone
+    pb_fragment_cache->set_enabled(from.pb_fragment_cache->is_enabled());
 }
 
 }} //namespace navitia::type
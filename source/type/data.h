@@ -34,8 +34,11 @@ www.navitia.io
 #include <boost/serialization/version.hpp>
 #include <boost/format.hpp>
 #include <boost/optional.hpp>
+#include <array>
 #include <atomic>
+#include <mutex>
 #include "type/type.h"
+#include "type/data_sections.h"
 #include "utils/serialization_unique_ptr.h"
 #include "utils/serialization_atomic.h"
 #include "utils/exception.h"
@@ -43,6 +46,7 @@ www.navitia.io
 
 //forward declare
 namespace navitia {
+    struct PbFragmentCache;
     namespace georef {
         struct GeoRef;
         struct POI;
@@ -59,6 +63,10 @@ namespace navitia {
     namespace type {
         struct MetaData;
     }
+    namespace ptref {
+        struct QueryPlanCache;
+        struct AttributeIndexes;
+    }
 }
 
 namespace navitia { namespace type {
@@ -150,6 +158,15 @@ public:
     /// Fare data
     std::unique_ptr<navitia::fare::Fare> fare;
 
+    /// compiled ptref filters, not serialized
+    std::unique_ptr<navitia::ptref::QueryPlanCache> ptref_plan_cache;
+
+    /// secondary indexes for the ptref filters, not serialized, null if not built
+    std::unique_ptr<navitia::ptref::AttributeIndexes> ptref_indexes;
+
+    /// static parts of the protobuf of the pt objects, not serialized, disabled by default
+    std::unique_ptr<navitia::PbFragmentCache> pb_fragment_cache;
+
     // functor to find admins
     std::function<std::vector<georef::Admin*>(const GeographicalCoord&)> find_admins;
 
@@ -203,20 +220,37 @@ public:
     Data(size_t data_identifier=0);
     ~Data();
 
+    /// Content of each section of the data.nav, D is Data or const Data
+    template<class Archive, class D> static void serialize_section(Archive& ar, D& data, DataSection section) {
+        switch (section) {
+        case DataSection::Main:
+            ar & data.pt_data & data.geo_ref & data.meta & data.last_load_at & data.loaded & data.last_load
+               & data.is_connected_to_rabbitmq & data.is_realtime_loaded;
+            break;
+        case DataSection::Autocomplete:
+            ar & data.geo_ref->fl_admin & data.geo_ref->fl_way & data.geo_ref->fl_poi
+               & data.pt_data->stop_area_autocomplete & data.pt_data->stop_point_autocomplete
+               & data.pt_data->line_autocomplete & data.pt_data->network_autocomplete
+               & data.pt_data->mode_autocomplete & data.pt_data->route_autocomplete;
+            break;
+        case DataSection::Fare:
+            ar & data.fare;
+            break;
+        }
+    }
+
     friend class boost::serialization::access;
     template<class Archive> void save(Archive & ar, const unsigned int) const {
-        ar & pt_data & geo_ref & meta & fare & last_load_at & loaded & last_load & is_connected_to_rabbitmq
-           & is_realtime_loaded;
+        for (const auto section: data_sections()) {
+            serialize_section(ar, *this, section);
+        }
     }
     template<class Archive> void load(Archive & ar, const unsigned int version) {
         this->version = version;
-        if(this->version != data_version){
-            unsigned int v = data_version;//sinon ca link pas...
-            auto msg = boost::format("Warning data version don't match with the data version of kraken %u (current version: %d)") % version % v;
-            throw wrong_version(msg.str());
+        check_version();
+        for (const auto section: data_sections()) {
+            serialize_section(ar, *this, section);
         }
-        ar & pt_data & geo_ref & meta & fare & last_load_at & loaded & last_load & is_connected_to_rabbitmq
-           & is_realtime_loaded;
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 
@@ -224,7 +258,15 @@ public:
     bool load(const std::string & filename,
               const boost::optional<std::string>& chaos_database = {},
               const std::vector<std::string>& contributors = {},
-              const size_t raptor_cache_size = 10);
+              const size_t raptor_cache_size = 10,
+              const size_t departure_snapshot_cache_size = 0,
+              const SectionsLoading& sections_loading = {});
+
+    /** Load a section configured as lazy if it is not loaded yet, to be called before using it
+     *
+     * Thread safe, the section is loaded only once
+     */
+    void load_section(DataSection section) const;
 
     /** Sauvegarde les données */
     void save(const std::string & filename) const;
@@ -241,13 +283,19 @@ public:
     /** Set admins*/
     void build_administrative_regions();
     /** Construit les données raptor */
-    void build_raptor(size_t cache_size = 10);
+    void build_raptor(size_t cache_size = 10, size_t snapshot_cache_size = 0);
 
     void build_associated_calendar();
 
     void aggregate_odt();
     void build_relations();
 
+    /** Build the ptref secondary indexes, to be done after each modification of the data */
+    void build_ptref_indexes();
+    /** Build the ptref secondary indexes after a realtime update of previous, only the
+     * indexes of the vehicle journeys are rebuilt */
+    void build_ptref_indexes(const Data& previous);
+
     void build_grid_validity_pattern();
 
     void complete();
@@ -272,6 +320,17 @@ public:
     // Deep clone from the given Data.
     void clone_from(const Data&);
 private:
+    /// the data.nav, kept opened to load the lazy sections, shared with the clones
+    std::shared_ptr<SectionsReader> sections_file;
+    SectionsLoading sections_loading;
+    mutable std::mutex sections_mutex;
+    mutable std::array<std::atomic<bool>, enum_size_trait<DataSection>::size()> sections_loaded;
+
+    void check_version() const;
+    void load_sections(const std::shared_ptr<SectionsReader>& reader, const SectionsLoading& loading);
+    void read_section(SectionsReader& reader, DataSection section);
+    void clear_section(DataSection section);
+
     /** Get similar validitypattern **/
     ValidityPattern* get_similar_validity_pattern(ValidityPattern* vp) const;
 };
@@ -0,0 +1,250 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "data_sections.h"
+#include "lz4_filter/filter.h"
+#include "utils/exception.h"
+
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <random>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace io = boost::iostreams;
+
+namespace navitia { namespace type {
+
+namespace {
+
+const char sections_magic[4] = {'N', 'A', 'V', 'S'};
+const uint32_t sections_format_version = 1;
+
+template<typename T>
+void write_value(std::ostream& os, T value) {
+    os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<typename T>
+T read_value(std::istream& is) {
+    T value;
+    is.read(reinterpret_cast<char*>(&value), sizeof(value));
+    if (is.gcount() != sizeof(value)) {
+        throw navitia::exception("data file: truncated table of contents");
+    }
+    return value;
+}
+
+void write_entry(std::ostream& os, const SectionEntry& entry) {
+    write_value<uint32_t>(os, static_cast<uint32_t>(entry.section));
+    write_value<uint64_t>(os, entry.offset);
+    write_value<uint64_t>(os, entry.size);
+    write_value<uint64_t>(os, entry.raw_size);
+}
+
+/// output filter counting the bytes going through it
+class ByteCounter : public io::multichar_output_filter {
+    std::shared_ptr<uint64_t> count;
+public:
+    explicit ByteCounter(std::shared_ptr<uint64_t> count): count(std::move(count)) {}
+
+    template<typename Sink>
+    std::streamsize write(Sink& dest, const char* s, std::streamsize n) {
+        const auto res = io::write(dest, s, n);
+        if (res > 0) { *count += res; }
+        return res;
+    }
+};
+
+} // anonymous namespace
+
+const std::vector<DataSection>& data_sections() {
+    static const std::vector<DataSection> sections = []() {
+        std::vector<DataSection> res;
+        for (const auto section: enum_range<DataSection>()) { res.push_back(section); }
+        return res;
+    }();
+    return sections;
+}
+
+std::string to_string(DataSection section) {
+    switch (section) {
+    case DataSection::Main: return "main";
+    case DataSection::Autocomplete: return "autocomplete";
+    case DataSection::Fare: return "fare";
+    }
+    throw navitia::exception("unknown data section");
+}
+
+DataSection data_section_from_string(const std::string& name) {
+    for (const auto section: data_sections()) {
+        if (to_string(section) == name) { return section; }
+    }
+    throw std::invalid_argument("unknown data section: " + name);
+}
+
+size_t resident_memory() {
+    std::ifstream statm("/proc/self/statm");
+    size_t size = 0, resident = 0;
+    if (! (statm >> size >> resident)) { return 0; }
+    return resident * size_t(sysconf(_SC_PAGESIZE));
+}
+
+SectionsWriter::SectionsWriter(std::ostream& os, uint32_t data_version, size_t nb_sections):
+        os(os), nb_sections(nb_sections) {
+    std::random_device rd;
+    const uint64_t file_id = (uint64_t(rd()) << 32) | rd();
+    os.write(sections_magic, sizeof(sections_magic));
+    write_value<uint32_t>(os, sections_format_version);
+    write_value<uint32_t>(os, data_version);
+    write_value<uint64_t>(os, file_id);
+    write_value<uint32_t>(os, nb_sections);
+    // the entries are filled at the end, we only reserve their space
+    toc_pos = os.tellp();
+    for (size_t i = 0; i < nb_sections; ++i) {
+        write_entry(os, SectionEntry());
+    }
+}
+
+void SectionsWriter::write(DataSection section, const std::function<void(std::streambuf&)>& serialize) {
+    if (entries.size() == nb_sections) {
+        throw navitia::exception("data file: too many sections");
+    }
+    SectionEntry entry;
+    entry.section = section;
+    entry.offset = os.tellp();
+    auto raw_size = std::make_shared<uint64_t>(0);
+    {
+        io::filtering_streambuf<io::output> out;
+        out.push(ByteCounter(raw_size), 1024*500, 1024*500);
+        out.push(LZ4FrameCompressor(), 1024*500, 1024*500);
+        out.push(os);
+        serialize(out);
+        // closing the chain writes the last blocks
+        out.pop();
+    }
+    entry.size = uint64_t(os.tellp()) - entry.offset;
+    entry.raw_size = *raw_size;
+    entries.push_back(entry);
+}
+
+void SectionsWriter::close() {
+    if (entries.size() != nb_sections) {
+        throw navitia::exception("data file: missing sections");
+    }
+    const auto end = os.tellp();
+    os.seekp(toc_pos);
+    for (const auto& entry: entries) {
+        write_entry(os, entry);
+    }
+    os.seekp(end);
+    os.flush();
+}
+
+SectionsReader::SectionsReader(const std::string& filename):
+        file(new std::ifstream(filename.c_str(), std::ios::in | std::ios::binary)), is(*file) {
+    if (! *file) {
+        throw navitia::exception("unable to open " + filename);
+    }
+    read_header();
+}
+
+SectionsReader::SectionsReader(std::istream& is): is(is) {
+    read_header();
+}
+
+bool SectionsReader::is_sectioned(std::istream& is) {
+    const auto pos = is.tellg();
+    char header[sizeof(sections_magic)] = {};
+    is.read(header, sizeof(header));
+    const bool res = is.gcount() == sizeof(header) &&
+        std::equal(header, header + sizeof(header), sections_magic);
+    is.clear(is.rdstate() & ~(std::ios::failbit | std::ios::eofbit));
+    is.seekg(pos);
+    return res;
+}
+
+void SectionsReader::read_header() {
+    is.seekg(0);
+    char header[sizeof(sections_magic)] = {};
+    is.read(header, sizeof(header));
+    if (! std::equal(header, header + sizeof(header), sections_magic)) {
+        throw navitia::exception("data file: not a sectioned file");
+    }
+    if (read_value<uint32_t>(is) != sections_format_version) {
+        throw navitia::exception("data file: unknown sections format");
+    }
+    data_version_ = read_value<uint32_t>(is);
+    file_id = read_value<uint64_t>(is);
+    const auto nb_sections = read_value<uint32_t>(is);
+    for (uint32_t i = 0; i < nb_sections; ++i) {
+        SectionEntry entry;
+        const auto section = read_value<uint32_t>(is);
+        if (section >= data_sections().size()) {
+            throw navitia::exception("data file: unknown section");
+        }
+        entry.section = static_cast<DataSection>(section);
+        entry.offset = read_value<uint64_t>(is);
+        entry.size = read_value<uint64_t>(is);
+        entry.raw_size = read_value<uint64_t>(is);
+        entries_.push_back(entry);
+    }
+}
+
+uint64_t SectionsReader::read_file_id() {
+    is.seekg(sizeof(sections_magic) + 2 * sizeof(uint32_t));
+    return read_value<uint64_t>(is);
+}
+
+const SectionEntry* SectionsReader::find(DataSection section) const {
+    for (const auto& entry: entries_) {
+        if (entry.section == section) { return &entry; }
+    }
+    return nullptr;
+}
+
+void SectionsReader::read(DataSection section, const std::function<void(std::streambuf&)>& deserialize) {
+    const auto* entry = find(section);
+    if (! entry) {
+        throw navitia::exception("data file: no section " + to_string(section));
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    is.clear();
+    // the file could have been rewritten since the table of contents was read
+    if (read_file_id() != file_id) {
+        throw navitia::exception("data file has been rewritten, cannot read section " + to_string(section));
+    }
+    is.seekg(entry->offset);
+    io::filtering_streambuf<io::input> in;
+    in.push(LZ4FrameDecompressor(), 1024*500, 1024*500);
+    in.push(is);
+    deserialize(in);
+}
+
+}} // namespace navitia::type
@@ -0,0 +1,144 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include "utils/flat_enum_map.h"
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace navitia { namespace type {
+
+/// Parts of the data.nav that are stored, and can be loaded, separately
+/// Note: if a section is added, don't forget to update enum_size_trait<type::DataSection>
+enum class DataSection {
+    Main,         ///< pt_data, geo_ref and meta, always loaded
+    Autocomplete, ///< autocomplete indexes of the geo_ref and pt_data objects
+    Fare
+};
+
+enum class SectionLoading {
+    Eager, ///< loaded with the data
+    Lazy,  ///< loaded at its first use
+    Skip   ///< never loaded
+};
+
+/// the sections not in the map are eagerly loaded
+using SectionsLoading = std::map<DataSection, SectionLoading>;
+
+const std::vector<DataSection>& data_sections();
+std::string to_string(DataSection section);
+/// throw std::invalid_argument for an unknown section name
+DataSection data_section_from_string(const std::string& name);
+
+/// resident memory of the process in bytes, 0 if it is not available
+size_t resident_memory();
+
+struct SectionEntry {
+    DataSection section = DataSection::Main;
+    uint64_t offset = 0;
+    uint64_t size = 0;     ///< size in the file
+    uint64_t raw_size = 0; ///< size once uncompressed
+};
+
+/**
+ * Container of the data.nav, each section being an independent LZ4 frame:
+ *
+ *  "NAVS" | uint32 format version | uint32 data version | uint64 file id | uint32 nb sections
+ *  nb sections * (uint32 section | uint64 offset | uint64 size | uint64 raw size)
+ *  the sections
+ *
+ * Thanks to the table of contents, a reader can load only some of the sections,
+ * and the others later. The file id is random, it allows to check that the file
+ * has not been rewritten in between.
+ */
+class SectionsWriter {
+    std::ostream& os;
+    std::streampos toc_pos;
+    std::vector<SectionEntry> entries;
+    size_t nb_sections;
+
+public:
+    /// the stream must be seekable, the table of contents is written at the end
+    SectionsWriter(std::ostream& os, uint32_t data_version, size_t nb_sections);
+
+    /// serialize is given the streambuf to write the section in
+    void write(DataSection section, const std::function<void(std::streambuf&)>& serialize);
+
+    void close();
+};
+
+class SectionsReader {
+    std::unique_ptr<std::ifstream> file;
+    std::istream& is;
+    std::mutex mutex;
+    uint32_t data_version_ = 0;
+    uint64_t file_id = 0;
+    std::vector<SectionEntry> entries_;
+
+    void read_header();
+    uint64_t read_file_id();
+
+public:
+    /// open the file, it is kept opened to read the sections later
+    explicit SectionsReader(const std::string& filename);
+    explicit SectionsReader(std::istream& is);
+
+    /// true if the stream starts with a sections header, the stream position is left unchanged
+    static bool is_sectioned(std::istream& is);
+
+    uint32_t data_version() const { return data_version_; }
+    const std::vector<SectionEntry>& entries() const { return entries_; }
+    const SectionEntry* find(DataSection section) const;
+
+    /**
+     * deserialize is given the streambuf of the uncompressed section.
+     *
+     * Can be called from several threads, throw if the file has been rewritten since it has been opened
+     */
+    void read(DataSection section, const std::function<void(std::streambuf&)>& deserialize);
+};
+
+}} // namespace navitia::type
+
+namespace navitia {
+template <>
+struct enum_size_trait<type::DataSection> {
+    static constexpr typename get_enum_type<type::DataSection>::type size() {
+        return 3;
+    }
+};
+} // namespace navitia
@@ -263,11 +263,15 @@ struct Impact {
     //(even if the impact is stored as a share_ptr in the disruption to allow for weak_ptr towards it)
     Disruption* disruption;
 
+    // reverse index of the meta vjs having this impact in their impacted_by,
+    // to find them without scanning all the meta vjs
+    std::vector<MetaVehicleJourney*> impacted_meta_vjs;
+
     template<class Archive>
     void serialize(Archive& ar, const unsigned int) {
         ar & uri & created_at & updated_at & application_periods
            & severity & _informed_entities & messages & disruption
-           & aux_info;
+           & aux_info & impacted_meta_vjs;
     }
 
     boost::iterator_range<std::vector<PtObj>::const_iterator> informed_entities() const {
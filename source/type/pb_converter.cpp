@@ -34,6 +34,7 @@ www.navitia.io
 #include "utils/exception.h"
 #include "utils/exception.h"
 #include <functional>
+#include <limits>
 #include <boost/lexical_cast.hpp>
 #include <boost/date_time/date_defs.hpp>
 #include <boost/geometry/algorithms/length.hpp>
@@ -43,6 +44,7 @@ www.navitia.io
 #include "time_tables/thermometer.h"
 #include "routing/dataraptor.h"
 #include "ptreferential/ptreferential.h"
+#include "type/pb_fragment_cache.h"
 
 
 namespace gd = boost::gregorian;
@@ -340,6 +342,31 @@ void PbCreator::Filler::add_contributor(const T* nav) {
     }
 }
 
+template<typename NAV, typename PB, typename F>
+void PbCreator::Filler::memoized_fill(const NAV* nav_object, PB* pb_object, F fill_fun) {
+    const auto key = std::make_tuple(static_cast<const void*>(nav_object), PB::descriptor(), depth);
+    auto it = pb_creator.memoized_fills.find(key);
+    if (it == pb_creator.memoized_fills.end()) {
+        // the contributors are registered by the first fill, and they are
+        // the same for the whole response
+        std::unique_ptr<PB> filled(new PB());
+        fill_fun(filled.get());
+        it = pb_creator.memoized_fills.emplace(key, std::move(filled)).first;
+    }
+    pb_object->MergeFrom(static_cast<const PB&>(*it->second));
+}
+
+template<typename NAV, typename PB, typename F>
+void PbCreator::Filler::fill_static_fragment(const NAV* nav_object, PB* pb_object, F fill_fun) {
+    if (pb_creator.data == nullptr || ! pb_creator.data->pb_fragment_cache) {
+        fill_fun(pb_object);
+        return;
+    }
+    const PbFragmentCache::Key key(nav_object, PB::descriptor(), depth, pb_creator.disable_geojson);
+    pb_creator.data->pb_fragment_cache->fill(key, pb_object, fill_fun,
+                                             pb_creator.nb_fragment_calls, pb_creator.nb_fragment_cache_miss);
+}
+
 template<typename NAV, typename PB>
 void PbCreator::Filler::fill(NAV* nav_object, PB* pb_object) {
     if (nav_object == nullptr) { return; }
@@ -418,34 +445,39 @@ void PbCreator::Filler::fill_pb_object(const nt::Dataset* ds, pbnavitia::Dataset
     fill(ds->contributor, dataset);
 }
 
-void PbCreator::Filler::fill_pb_object(const nt::StopArea* sa, pbnavitia::StopArea* stop_area) {
+void PbCreator::Filler::fill_pb_object(const nt::StopArea* sa, pbnavitia::StopArea* pb_stop_area) {
+    memoized_fill(sa, pb_stop_area, [&](pbnavitia::StopArea* stop_area) {
+        fill_static_fragment(sa, stop_area, [&](pbnavitia::StopArea* static_stop_area) {
+            static_stop_area->set_uri(sa->uri);
+            static_stop_area->set_name(sa->name);
+            static_stop_area->set_label(sa->label);
+            static_stop_area->set_timezone(sa->timezone);
 
-    stop_area->set_uri(sa->uri);
-    add_contributor(sa);
-    stop_area->set_name(sa->name);
-    stop_area->set_label(sa->label);
-    stop_area->set_timezone(sa->timezone);
+            fill_comments(sa, static_stop_area);
 
-    fill_comments(sa, stop_area);
+            if(sa->coord.is_initialized()) {
+                static_stop_area->mutable_coord()->set_lon(sa->coord.lon());
+                static_stop_area->mutable_coord()->set_lat(sa->coord.lat());
+            }
 
-    if(sa->coord.is_initialized()) {
-        stop_area->mutable_coord()->set_lon(sa->coord.lon());
-        stop_area->mutable_coord()->set_lat(sa->coord.lat());
-    }
-    if(depth > 0){
-        fill(sa->admin_list, stop_area->mutable_administrative_regions());
-    }
+            if (depth > 1) {
+                std::vector<nt::CommercialMode*> cm = ptref_indexes<nt::CommercialMode>(sa);
+                fill(cm, static_stop_area->mutable_commercial_modes());
 
-    if (depth > 1) {
-        std::vector<nt::CommercialMode*> cm = ptref_indexes<nt::CommercialMode>(sa);
-        fill(cm, stop_area->mutable_commercial_modes());
+                std::vector<nt::PhysicalMode*> pm = ptref_indexes<nt::PhysicalMode>(sa);
+                fill(pm, static_stop_area->mutable_physical_modes());
+            }
 
-        std::vector<nt::PhysicalMode*> pm = ptref_indexes<nt::PhysicalMode>(sa);
-        fill(pm, stop_area->mutable_physical_modes());
-    }
+            fill_codes(sa, static_stop_area);
+        });
+        add_contributor(sa);
+
+        if(depth > 0){
+            fill(sa->admin_list, stop_area->mutable_administrative_regions());
+        }
+    });
 
-    fill_messages(sa, stop_area);
-    fill_codes(sa, stop_area);
+    fill_messages(sa, pb_stop_area);
 }
 
 void PbCreator::Filler::fill_pb_object(const ng::Admin* adm, pbnavitia::AdministrativeRegion* admin){
@@ -476,76 +508,78 @@ void PbCreator::Filler::fill_pb_object(const ng::Admin* adm, pbnavitia::Administ
     }
 }
 
-void PbCreator::Filler::fill_pb_object(const nt::StopPoint* sp, pbnavitia::StopPoint* stop_point) {
+void PbCreator::Filler::fill_pb_object(const nt::StopPoint* sp, pbnavitia::StopPoint* pb_stop_point) {
+    memoized_fill(sp, pb_stop_point, [&](pbnavitia::StopPoint* stop_point) {
+        stop_point->set_uri(sp->uri);
+        add_contributor(sp);
+        stop_point->set_name(sp->name);
+        stop_point->set_label(sp->label);
+        if(!sp->platform_code.empty()) {
+            stop_point->set_platform_code(sp->platform_code);
+        }
+        fill_comments(sp, stop_point);
 
-    stop_point->set_uri(sp->uri);
-    add_contributor(sp);
-    stop_point->set_name(sp->name);
-    stop_point->set_label(sp->label);
-    if(!sp->platform_code.empty()) {
-        stop_point->set_platform_code(sp->platform_code);
-    }
-    fill_comments(sp, stop_point);
+        if(sp->coord.is_initialized()) {
+            stop_point->mutable_coord()->set_lon(sp->coord.lon());
+            stop_point->mutable_coord()->set_lat(sp->coord.lat());
+        }
 
-    if(sp->coord.is_initialized()) {
-        stop_point->mutable_coord()->set_lon(sp->coord.lon());
-        stop_point->mutable_coord()->set_lat(sp->coord.lat());
-    }
+        pbnavitia::hasEquipments* has_equipments =  stop_point->mutable_has_equipments();
+        if (sp->wheelchair_boarding()){
+            has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_wheelchair_boarding);
+        }
+        if (sp->sheltered()){
+            has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_sheltered);
+        }
+        if (sp->elevator()){
+            has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_elevator);
+        }
+        if (sp->escalator()){
+            has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_escalator);
+        }
+        if (sp->bike_accepted()){
+            has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_bike_accepted);
+        }
+        if (sp->bike_depot()){
+            has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_bike_depot);
+        }
+        if (sp->visual_announcement()){
+            has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_visual_announcement);
+        }
+        if (sp->audible_announcement()){
+            has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_audible_announcement);
+        }
+        if (sp->appropriate_escort()){
+            has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_appropriate_escort);
+        }
+        if (sp->appropriate_signage()){
+            has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_appropriate_signage);
+        }
+        if(depth > 0){
+            fill(sp->admin_list, stop_point->mutable_administrative_regions());
+        }
 
-    pbnavitia::hasEquipments* has_equipments =  stop_point->mutable_has_equipments();
-    if (sp->wheelchair_boarding()){
-        has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_wheelchair_boarding);
-    }
-    if (sp->sheltered()){
-        has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_sheltered);
-    }
-    if (sp->elevator()){
-        has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_elevator);
-    }
-    if (sp->escalator()){
-        has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_escalator);
-    }
-    if (sp->bike_accepted()){
-        has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_bike_accepted);
-    }
-    if (sp->bike_depot()){
-        has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_bike_depot);
-    }
-    if (sp->visual_announcement()){
-        has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_visual_announcement);
-    }
-    if (sp->audible_announcement()){
-        has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_audible_announcement);
-    }
-    if (sp->appropriate_escort()){
-        has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_appropriate_escort);
-    }
-    if (sp->appropriate_signage()){
-        has_equipments->add_has_equipments(pbnavitia::hasEquipments::has_appropriate_signage);
-    }
-    if(depth > 0){
-        fill(sp->admin_list, stop_point->mutable_administrative_regions());
-    }
 
+        if(depth > 2){
+            fill(&sp->coord, stop_point);
+        }
 
-    if(depth > 2){
-        fill(&sp->coord, stop_point);
-    }
+        if (depth > 1) {
+            std::vector<nt::CommercialMode*> cm = ptref_indexes<nt::CommercialMode>(sp);
+            fill(cm, stop_point->mutable_commercial_modes());
 
-    if(depth > 0){
-        fill(sp->stop_area, stop_point);
-    }
+            std::vector<nt::PhysicalMode*> pm = ptref_indexes<nt::PhysicalMode>(sp);
+            fill(pm, stop_point->mutable_physical_modes());
+        }
 
-    if (depth > 1) {
-        std::vector<nt::CommercialMode*> cm = ptref_indexes<nt::CommercialMode>(sp);
-        fill(cm, stop_point->mutable_commercial_modes());
+        fill_codes(sp, stop_point);
+    });
 
-        std::vector<nt::PhysicalMode*> pm = ptref_indexes<nt::PhysicalMode>(sp);
-        fill(pm, stop_point->mutable_physical_modes());
+    if(depth > 0){
+        fill(sp->stop_area, pb_stop_point);
     }
 
-    fill_messages(sp, stop_point);
-    fill_codes(sp, stop_point);
+    fill_messages(sp, pb_stop_point);
 }
 
 void PbCreator::Filler::fill_pb_object(const nt::Company* c, pbnavitia::Company* company){
@@ -558,13 +592,14 @@ void PbCreator::Filler::fill_pb_object(const nt::Company* c, pbnavitia::Company*
 }
 
 void PbCreator::Filler::fill_pb_object(const nt::Network* n, pbnavitia::Network* network){
-
-    network->set_name(n->name);
-    network->set_uri(n->uri);
+    fill_static_fragment(n, network, [&](pbnavitia::Network* static_network) {
+        static_network->set_name(n->name);
+        static_network->set_uri(n->uri);
+        fill_codes(n, static_network);
+    });
     add_contributor(n);
 
     fill_messages(n, network);
-    fill_codes(n, network);
 }
 
 void PbCreator::Filler::fill_pb_object(const nt::PhysicalMode* m,
@@ -581,53 +616,56 @@ void PbCreator::Filler::fill_pb_object(const nt::CommercialMode* m,
     commercial_mode->set_uri(m->uri);
 }
 
-void PbCreator::Filler::fill_pb_object(const nt::Line* l, pbnavitia::Line* line){
-
-    fill_comments(l, line);
-
-    if(!l->code.empty()){
-        line->set_code(l->code);
-    }
-    if(!l->color.empty()){
-        line->set_color(l->color);
-    }
+void PbCreator::Filler::fill_pb_object(const nt::Line* l, pbnavitia::Line* pb_line){
+    memoized_fill(l, pb_line, [&](pbnavitia::Line* line) {
+        fill_static_fragment(l, line, [&](pbnavitia::Line* static_line) {
+            fill_comments(l, static_line);
 
-    if(! l->text_color.empty())
-        line->set_text_color(l->text_color);
+            if(!l->code.empty()){
+                static_line->set_code(l->code);
+            }
+            if(!l->color.empty()){
+                static_line->set_color(l->color);
+            }
 
-    line->set_name(l->name);
-    line->set_uri(l->uri);
-    add_contributor(l);
-    if (l->opening_time) {
-        line->set_opening_time((*l->opening_time).total_seconds());
-    }
-    if (l->closing_time) {
-        line->set_closing_time((*l->closing_time).total_seconds());
-    }
+            if(! l->text_color.empty())
+                static_line->set_text_color(l->text_color);
 
+            static_line->set_name(l->name);
+            static_line->set_uri(l->uri);
+            if (l->opening_time) {
+                static_line->set_opening_time((*l->opening_time).total_seconds());
+            }
+            if (l->closing_time) {
+                static_line->set_closing_time((*l->closing_time).total_seconds());
+            }
 
-    if (depth > 0) {
-        if(!this->pb_creator.disable_geojson) {
-            fill(&l->shape, line);
-        }
+            if (depth > 0) {
+                if(!this->pb_creator.disable_geojson) {
+                    fill(&l->shape, static_line);
+                }
+                fill(l->physical_mode_list, static_line->mutable_physical_modes());
+                fill(l->commercial_mode, static_line);
+            }
 
-        fill(l->route_list, line->mutable_routes());
-        fill(l->physical_mode_list, line->mutable_physical_modes());
+            fill_codes(l, static_line);
 
-        fill(l->commercial_mode, line);
-        fill(l->network, line);
+            for(auto property : l->properties) {
+                auto* pb_property = static_line->add_properties();
+                pb_property->set_name(property.first);
+                pb_property->set_value(property.second);
+            }
+        });
+        add_contributor(l);
+    });
 
-        fill(l->line_group_list, line->mutable_line_groups());
+    if (depth > 0) {
+        fill(l->route_list, pb_line->mutable_routes());
+        fill(l->network, pb_line);
+        fill(l->line_group_list, pb_line->mutable_line_groups());
     }
 
-    fill_messages(l, line);
-    fill_codes(l, line);
-
-    for(auto property : l->properties) {
-        auto* pb_property = line->add_properties();
-        pb_property->set_name(property.first);
-        pb_property->set_value(property.second);
-    }
+    fill_messages(l, pb_line);
 
     if (dump_message_options ==  DumpMessageOptions{DumpMessage::Yes, DumpLineSectionMessage::Yes} ) {
         /*
@@ -644,7 +682,7 @@ void PbCreator::Filler::fill_pb_object(const nt::Line* l, pbnavitia::Line* line)
                 for (const auto& entity: impact_ptr->informed_entities()) {
                     if (boost::get<nt::disruption::LineSection>(&entity) &&
                             added_impact.insert(impact_ptr).second ) {
-                        fill_messages(vj.meta_vj, line);
+                        fill_messages(vj.meta_vj, pb_line);
                         return true;
                     }
                 }
@@ -657,37 +695,43 @@ void PbCreator::Filler::fill_pb_object(const nt::Line* l, pbnavitia::Line* line)
     }
 }
 
-void PbCreator::Filler::fill_pb_object(const nt::Route* r, pbnavitia::Route* route){
+void PbCreator::Filler::fill_pb_object(const nt::Route* r, pbnavitia::Route* pb_route){
+    memoized_fill(r, pb_route, [&](pbnavitia::Route* route) {
+        fill_static_fragment(r, route, [&](pbnavitia::Route* static_route) {
+            static_route->set_name(r->name);
+            static_route->set_direction_type(r->direction_type);
+            fill_comments(r, static_route);
+            static_route->set_uri(r->uri);
+            fill_codes(r, static_route);
 
-    route->set_name(r->name);
-    route->set_direction_type(r->direction_type);
+            if (depth == 0) { return; }
 
-    fill_with_creator(r->destination, [&](){return route->mutable_direction();});
-    fill_comments(r, route);
+            if(!this->pb_creator.disable_geojson) {
+                fill(&r->shape, static_route);
+            }
 
-    route->set_uri(r->uri);
-    add_contributor(r);
-    fill_messages(r, route);
+            if (depth > 2) {
+                std::vector<nt::PhysicalMode*> pm = ptref_indexes<nt::PhysicalMode>(r);
+                fill(pm, static_route->mutable_physical_modes());
+            }
+        });
+        add_contributor(r);
+    });
 
-    fill_codes(r, route);
+    fill_with_creator(r->destination, [&](){return pb_route->mutable_direction();});
+    fill_messages(r, pb_route);
 
     if (depth == 0) { return; }
 
-    fill(r->line, route);
-
-    if(!this->pb_creator.disable_geojson) {
-        fill(&r->shape, route);
-    }
+    fill(r->line, pb_route);
 
     if (depth>2) {
         auto thermometer = navitia::timetables::Thermometer();
         thermometer.generate_thermometer(r);
         for(auto idx : thermometer.get_thermometer()) {
             auto stop_point = pb_creator.data->pt_data->stop_points[idx];
-            fill_with_creator(stop_point, [&](){return route->add_stop_points();});
+            fill_with_creator(stop_point, [&](){return pb_route->add_stop_points();});
         }
-        std::vector<nt::PhysicalMode*> pm = ptref_indexes<nt::PhysicalMode>(r);
-        fill(pm, route->mutable_physical_modes());
     }
 }
 
@@ -36,6 +36,9 @@ www.navitia.io
 #include "vptranslator/vptranslator.h"
 #include "ptreferential/ptreferential.h"
 
+#include <memory>
+#include <tuple>
+
 namespace pt = boost::posix_time;
 namespace nt = navitia::type;
 namespace ng = navitia::georef;
@@ -185,6 +188,9 @@ struct PbCreator {
     size_t nb_sections = 0;
     std::map<std::pair<pbnavitia::Journey*, size_t>, std::string> routing_section_map;
     pbnavitia::Ticket* unknown_ticket = nullptr; //we want only one unknown ticket
+    // use of the PbFragmentCache of the data, kept by the creator until they are reported
+    size_t nb_fragment_calls = 0;
+    size_t nb_fragment_cache_miss = 0;
 
     PbCreator() = default;
 
@@ -215,6 +221,7 @@ struct PbCreator {
         this->contributors.clear();
         this->impacts.clear();
         this->routing_section_map.clear();
+        this->memoized_fills.clear();
         this->response.Clear();
         this->unknown_ticket = nullptr;
     }
@@ -315,6 +322,14 @@ struct PbCreator {
 private:
 
     pbnavitia::Response response;
+
+    // the objects shared by the response (stop points, lines...) are filled only once,
+    // the following fills are copies of the first one.
+    // Only the part that does not depend on now and the action period is memoized: the
+    // messages, and the sub objects that have messages, are filled for each object
+    using MemoizedFillKey = std::tuple<const void*, const google::protobuf::Descriptor*, int>;
+    std::map<MemoizedFillKey, std::unique_ptr<google::protobuf::Message>> memoized_fills;
+
     struct Filler {
         struct PtObjVisitor;
         const int depth;
@@ -332,6 +347,11 @@ private:
         void fill(NAV* nav_object, PB* pb_object);
         template<typename NAV, typename F>
         void fill_with_creator(NAV* nav_object, F creator);
+        template<typename NAV, typename PB, typename F>
+        void memoized_fill(const NAV* nav_object, PB* pb_object, F fill_fun);
+        // fill the part of the object that does not depend on the request, cf PbFragmentCache
+        template<typename NAV, typename PB, typename F>
+        void fill_static_fragment(const NAV* nav_object, PB* pb_object, F fill_fun);
 
         template<typename NAV, typename PB>
         void fill(const NAV& nav_object, PB* pb_object) {
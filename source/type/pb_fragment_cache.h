@@ -0,0 +1,100 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include <google/protobuf/message.h>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <tuple>
+
+namespace navitia {
+
+/** Static parts of the protobuf of the pt objects, shared by all the responses on a Data
+ *
+ * The names, codes, comments, colors and geojson of the lines, routes, networks and
+ * stop areas only change with the data. When the cache is enabled, they are filled
+ * once by object and depth, and merged into the responses. The impacts, the
+ * contributors and the sub objects are still filled by each response.
+ *
+ * The cache is owned by the Data, so it is dropped on data swap. The objects must not
+ * be modified in place once the cache is enabled.
+ *
+ * Once warm, the cache is only read, so the lookups share the lock and only the
+ * insertion of a new fragment takes it exclusively. The calls and misses are counted
+ * by the caller, in counters of its own thread.
+ */
+struct PbFragmentCache {
+    // object, protobuf type, depth, disable_geojson
+    using Key = std::tuple<const void*, const google::protobuf::Descriptor*, int, bool>;
+
+    void set_enabled(bool value) { enabled = value; }
+    bool is_enabled() const { return enabled; }
+
+    template<typename PB, typename F>
+    void fill(const Key& key, PB* pb_object, F fill_fragment, size_t& nb_calls, size_t& nb_cache_miss) const {
+        if (! enabled) {
+            fill_fragment(pb_object);
+            return;
+        }
+        ++nb_calls;
+        std::shared_ptr<const google::protobuf::Message> fragment;
+        {
+            boost::shared_lock<boost::shared_mutex> lock(mutex);
+            auto it = fragments.find(key);
+            if (it != fragments.end()) { fragment = it->second; }
+        }
+        if (! fragment) {
+            // filled outside the lock, if 2 threads fill the same fragment, the first one is kept
+            ++nb_cache_miss;
+            auto new_fragment = std::make_shared<PB>();
+            fill_fragment(new_fragment.get());
+            boost::unique_lock<boost::shared_mutex> lock(mutex);
+            fragment = fragments.emplace(key, std::move(new_fragment)).first->second;
+        }
+        pb_object->MergeFrom(static_cast<const PB&>(*fragment));
+    }
+
+    size_t size() const {
+        boost::shared_lock<boost::shared_mutex> lock(mutex);
+        return fragments.size();
+    }
+
+private:
+    std::atomic<bool> enabled{false};
+    mutable boost::shared_mutex mutex;
+    mutable std::map<Key, std::shared_ptr<const google::protobuf::Message>> fragments;
+};
+
+} // namespace navitia
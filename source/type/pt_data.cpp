@@ -30,17 +30,52 @@ www.navitia.io
 
 #include "pt_data.h"
 #include "utils/functions.h"
+#include "utils/logger.h"
 
+#include <boost/range/algorithm/find.hpp>
 #include <boost/range/algorithm/find_if.hpp>
 
 namespace navitia { namespace type {
 
-ValidityPattern* PT_Data::get_or_create_validity_pattern(const ValidityPattern& vp_ref) {
-    for (auto vp : validity_patterns) {
+void PT_Data::index_validity_patterns() {
+    // validity patterns can have been added to the list since the last call, we index them
+    if (nb_indexed_validity_patterns > validity_patterns.size()) {
+        validity_patterns_by_days.clear();
+        nb_indexed_validity_patterns = 0;
+    }
+    for (; nb_indexed_validity_patterns < validity_patterns.size(); ++nb_indexed_validity_patterns) {
+        auto* indexed_vp = validity_patterns[nb_indexed_validity_patterns];
+        validity_patterns_by_days[indexed_vp->days].push_back(indexed_vp);
+    }
+}
+
+static ValidityPattern*
+find_same_vp(const std::vector<ValidityPattern*>& same_days_vps, const ValidityPattern& vp_ref) {
+    for (auto* vp: same_days_vps) {
+        // the days are checked again as a validity pattern may have been modified since its indexation
         if (vp->days == vp_ref.days && vp->beginning_date == vp_ref.beginning_date) {
             return vp;
         }
     }
+    return nullptr;
+}
+
+ValidityPattern* PT_Data::find_validity_pattern(const ValidityPattern& vp_ref) const {
+    const auto it = validity_patterns_by_days.find(vp_ref.days);
+    if (it == validity_patterns_by_days.end()) { return nullptr; }
+    return find_same_vp(it->second, vp_ref);
+}
+
+ValidityPattern* PT_Data::get_or_create_validity_pattern(const ValidityPattern& vp_ref) {
+    if (auto* staging = RealtimeStaging::current()) {
+        return staging->get_or_create_validity_pattern(vp_ref, *this);
+    }
+    index_validity_patterns();
+
+    auto& same_days_vps = validity_patterns_by_days[vp_ref.days];
+    if (auto* vp = find_same_vp(same_days_vps, vp_ref)) {
+        return vp;
+    }
     auto vp = new nt::ValidityPattern();
     vp->idx = validity_patterns.size();
     vp->uri = make_adapted_uri(vp->uri);
@@ -48,9 +83,42 @@ ValidityPattern* PT_Data::get_or_create_validity_pattern(const ValidityPattern&
     vp->days = vp_ref.days;
     validity_patterns.push_back(vp);
     validity_patterns_map[vp->uri] = vp;
+    same_days_vps.push_back(vp);
+    ++nb_indexed_validity_patterns;
     return vp;
 }
 
+size_t PT_Data::clean_unused_validity_patterns() {
+    std::vector<size_t> nb_references(validity_patterns.size(), 0);
+    for (const auto* vj: vehicle_journeys) {
+        for (const auto* vp: vj->validity_patterns) {
+            if (vp && vp->idx < nb_references.size() && validity_patterns[vp->idx] == vp) {
+                ++nb_references[vp->idx];
+            }
+        }
+    }
+    std::vector<ValidityPattern*> used_vps;
+    used_vps.reserve(validity_patterns.size());
+    for (auto* vp: validity_patterns) {
+        if (nb_references[vp->idx]) {
+            used_vps.push_back(vp);
+        } else {
+            validity_patterns_map.erase(vp->uri);
+            delete vp;
+        }
+    }
+    const size_t nb_deleted = validity_patterns.size() - used_vps.size();
+    if (nb_deleted) {
+        validity_patterns = std::move(used_vps);
+        for (size_t i = 0; i < validity_patterns.size(); ++i) {
+            validity_patterns[i]->idx = i;
+        }
+        validity_patterns_by_days.clear();
+        nb_indexed_validity_patterns = 0;
+    }
+    return nb_deleted;
+}
+
 void PT_Data::sort(){
 
 #define SORT_AND_INDEX(type_name, collection_name)\
@@ -208,6 +276,9 @@ void PT_Data::clean_weak_impacts() {
     for (const auto& obj: lines) { obj->clean_weak_impacts(); }
     for (const auto& obj: routes) { obj->clean_weak_impacts(); }
     for (const auto& obj: meta_vjs) { obj->clean_weak_impacts(); }
+    // the validity patterns of the deleted realtime vehicle journeys are not needed anymore
+    const auto nb_deleted_vps = clean_unused_validity_patterns();
+    LOG4CPLUS_DEBUG(log4cplus::Logger::getInstance("log"), nb_deleted_vps << " unused validity patterns deleted");
 }
 
 Indexes
@@ -241,6 +312,89 @@ PT_Data::get_stop_point_connection(const StopPoint& from, const StopPoint& to) c
 }
 
 
+static thread_local RealtimeStaging* current_staging = nullptr;
+
+RealtimeStaging* RealtimeStaging::current() {
+    return current_staging;
+}
+
+std::unique_lock<std::mutex> RealtimeStaging::lock_shared() {
+    if (! current_staging) { return {}; }
+    return std::unique_lock<std::mutex>(current_staging->shared_mutex);
+}
+
+RealtimeStaging::Scope::Scope(RealtimeStaging& staging) {
+    assert(! current_staging);
+    current_staging = &staging;
+}
+
+RealtimeStaging::Scope::~Scope() {
+    current_staging = nullptr;
+}
+
+ValidityPattern* RealtimeStaging::get_or_create_validity_pattern(const ValidityPattern& vp_ref,
+                                                                 const PT_Data& pt_data) {
+    // the index of the pt_data is built before the threads start
+    if (auto* vp = pt_data.find_validity_pattern(vp_ref)) {
+        return vp;
+    }
+    auto& same_days_vps = validity_patterns_by_days[vp_ref.days];
+    if (auto* vp = find_same_vp(same_days_vps, vp_ref)) {
+        return vp;
+    }
+    // the uri and the idx are given by the merge
+    auto vp = std::make_unique<ValidityPattern>();
+    vp->beginning_date = vp_ref.beginning_date;
+    vp->days = vp_ref.days;
+    same_days_vps.push_back(vp.get());
+    validity_patterns.push_back(std::move(vp));
+    return validity_patterns.back().get();
+}
+
+void RealtimeStaging::merge(PT_Data& pt_data) {
+    assert(! current_staging);
+    std::unordered_map<const ValidityPattern*, ValidityPattern*> merged_vps;
+    for (const auto& vp: validity_patterns) {
+        merged_vps[vp.get()] = pt_data.get_or_create_validity_pattern(*vp);
+    }
+    meta_vj->for_all_vjs([&](VehicleJourney& vj) {
+        for (const auto l: enum_range<RTLevel>()) {
+            const auto it = merged_vps.find(vj.validity_patterns[l]);
+            if (it != merged_vps.end()) { vj.validity_patterns[l] = it->second; }
+        }
+    });
+
+    for (const auto& vj: removed_vjs) {
+        const auto it = boost::find(created_vjs, vj.get());
+        if (it != created_vjs.end()) {
+            // created and removed by the staging, the pt_data never knew it
+            created_vjs.erase(it);
+        } else {
+            cleanup_useless_vj_link(vj.get(), pt_data);
+        }
+    }
+    removed_vjs.clear();
+
+    for (auto* vj: created_vjs) {
+        vj->idx = pt_data.vehicle_journeys.size();
+        pt_data.vehicle_journeys.push_back(vj);
+        pt_data.vehicle_journeys_map[vj->uri] = vj;
+        if (vj->route) {
+            if (auto* discrete_vj = dynamic_cast<DiscreteVehicleJourney*>(vj)) {
+                vj->route->discrete_vehicle_journey_list.push_back(discrete_vj);
+            } else if (auto* frequency_vj = dynamic_cast<FrequencyVehicleJourney*>(vj)) {
+                vj->route->frequency_vehicle_journey_list.push_back(frequency_vj);
+            }
+        }
+        if (vj->physical_mode) {
+            vj->physical_mode->vehicle_journey_list.push_back(vj);
+        }
+    }
+    created_vjs.clear();
+    validity_patterns.clear();
+    validity_patterns_by_days.clear();
+}
+
 PT_Data::~PT_Data() {
     //big uggly hack :(
     // the vj are objects owned by the jp,
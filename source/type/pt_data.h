@@ -45,6 +45,9 @@ www.navitia.io
 
 #include <boost/serialization/map.hpp>
 #include "utils/serialization_unordered_map.h"
+#include <unordered_map>
+#include <memory>
+#include <mutex>
 #include "utils/serialization_tuple.h"
 
 namespace navitia {
@@ -108,12 +111,16 @@ struct PT_Data : boost::noncopyable{
     // timezone manager
     TimeZoneManager tz_manager;
 
+    // hash index of the validity_patterns by days for get_or_create_validity_pattern,
+    // not serialized, the validity patterns are indexed lazily
+    std::unordered_map<ValidityPattern::year_bitset, std::vector<ValidityPattern*>> validity_patterns_by_days;
+    size_t nb_indexed_validity_patterns = 0;
+
+    // the autocomplete indexes are serialized in their own section, cf Data::serialize_section
     template<class Archive> void serialize(Archive & ar, const unsigned int) {
         ar
         #define SERIALIZE_ELEMENTS(type_name, collection_name) & collection_name & collection_name##_map
                 ITERATE_NAVITIA_PT_TYPES(SERIALIZE_ELEMENTS)
-                & stop_area_autocomplete & stop_point_autocomplete & line_autocomplete
-                & network_autocomplete & mode_autocomplete & route_autocomplete
                 & stop_area_proximity_list & stop_point_proximity_list
                 & stop_point_connections
                 & disruption_holder
@@ -159,6 +166,17 @@ struct PT_Data : boost::noncopyable{
 
     type::ValidityPattern* get_or_create_validity_pattern(const ValidityPattern& vp_ref);
 
+    /// Index the validity patterns added since the last call, for get_or_create_validity_pattern
+    void index_validity_patterns();
+
+    /// The already indexed validity pattern with the same days as vp_ref, nullptr if none
+    type::ValidityPattern* find_validity_pattern(const ValidityPattern& vp_ref) const;
+
+    /// Delete the validity patterns that are not referenced by any vehicle journey anymore
+    /// (the realtime creates a lot of them) and re-index the others.
+    /// Return the number of deleted validity patterns.
+    size_t clean_unused_validity_patterns();
+
     /** Retrouve un élément par un attribut arbitraire de type chaine de caractères
       *
       * Le template a été surchargé pour gérer des const char* (string passée comme literal)
@@ -183,6 +201,50 @@ struct PT_Data : boost::noncopyable{
 
 };
 
+/// Remove all the references of the PT_Data to a vj, before deleting it
+void cleanup_useless_vj_link(const VehicleJourney* vj, PT_Data& pt_data);
+
+/**
+ * Modifications of the shared state of a PT_Data by the realtime of a meta vj, when the
+ * realtime of independent meta vjs is applied by several threads (cf handle_realtime).
+ *
+ * While a staging is set for a thread, the shared collections of the PT_Data are only
+ * read: the validity patterns, and the vjs created or removed (with their links to the
+ * routes, physical modes, datasets and headsign handler) are kept in the staging.
+ * merge() adds them to the PT_Data once all the threads are done.
+ */
+struct RealtimeStaging {
+    // the only meta vj modified with this staging
+    MetaVehicleJourney* meta_vj;
+    // locks the objects shared by the threads, like the disruption holder
+    std::mutex& shared_mutex;
+
+    std::vector<std::unique_ptr<ValidityPattern>> validity_patterns;
+    std::unordered_map<ValidityPattern::year_bitset, std::vector<ValidityPattern*>> validity_patterns_by_days;
+    std::vector<VehicleJourney*> created_vjs;
+    std::vector<std::unique_ptr<VehicleJourney>> removed_vjs;
+
+    RealtimeStaging(MetaVehicleJourney& meta_vj, std::mutex& shared_mutex):
+        meta_vj(&meta_vj), shared_mutex(shared_mutex) {}
+
+    ValidityPattern* get_or_create_validity_pattern(const ValidityPattern& vp_ref, const PT_Data& pt_data);
+
+    /// Add the modifications to the PT_Data, must be called without staging for the thread
+    void merge(PT_Data& pt_data);
+
+    /// The staging of the current thread, nullptr if none
+    static RealtimeStaging* current();
+
+    /// Lock of the objects shared by the threads, does not lock if the thread has no staging
+    static std::unique_lock<std::mutex> lock_shared();
+
+    /// Set the staging of the current thread during its lifetime
+    struct Scope {
+        explicit Scope(RealtimeStaging& staging);
+        ~Scope();
+    };
+};
+
 #define GENERIC_PT_DATA_COLLECTION_SPECIALIZATION(type_name, collection_name) \
     template<> const std::vector<type_name*>& PT_Data::collection() const;
 ITERATE_NAVITIA_PT_TYPES(GENERIC_PT_DATA_COLLECTION_SPECIALIZATION)
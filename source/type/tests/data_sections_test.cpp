@@ -0,0 +1,110 @@
+/* Copyright © 2001-2017, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE data_sections_test
+#include <boost/test/unit_test.hpp>
+#include "type/data_sections.h"
+#include "utils/exception.h"
+#include <fstream>
+#include <sstream>
+
+using namespace navitia::type;
+
+static std::string read_all(std::streambuf& buf) {
+    std::string res;
+    char buffer[1000];
+    for (auto size = buf.sgetn(buffer, sizeof(buffer)); size > 0; size = buf.sgetn(buffer, sizeof(buffer))) {
+        res.append(buffer, size);
+    }
+    return res;
+}
+
+static std::string section_content(DataSection section) {
+    std::string res;
+    for (int i = 0; i < 10000; ++i) {
+        res += to_string(section) + std::to_string(i);
+    }
+    return res;
+}
+
+static void write_sections(const std::string& filename, uint32_t data_version) {
+    std::ofstream ofs(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    SectionsWriter writer(ofs, data_version, data_sections().size());
+    for (const auto section: data_sections()) {
+        writer.write(section, [&](std::streambuf& buf) {
+            const auto content = section_content(section);
+            buf.sputn(content.data(), content.size());
+        });
+    }
+    writer.close();
+}
+
+BOOST_AUTO_TEST_CASE(section_names) {
+    for (const auto section: data_sections()) {
+        BOOST_CHECK(data_section_from_string(to_string(section)) == section);
+    }
+    BOOST_CHECK_THROW(data_section_from_string("pois"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(read_sections) {
+    write_sections("sections.nav", 42);
+    std::ifstream ifs("sections.nav", std::ios::binary);
+    BOOST_CHECK(SectionsReader::is_sectioned(ifs));
+    BOOST_CHECK_EQUAL(ifs.tellg(), 0);
+
+    SectionsReader reader("sections.nav");
+    BOOST_CHECK_EQUAL(reader.data_version(), 42);
+    BOOST_REQUIRE_EQUAL(reader.entries().size(), data_sections().size());
+    for (const auto& entry: reader.entries()) {
+        BOOST_CHECK_EQUAL(entry.raw_size, section_content(entry.section).size());
+        BOOST_CHECK(entry.size < entry.raw_size);
+    }
+    // the sections can be read in any order, several times
+    for (const auto section: {DataSection::Fare, DataSection::Main, DataSection::Autocomplete, DataSection::Fare}) {
+        std::string content;
+        reader.read(section, [&](std::streambuf& buf) { content = read_all(buf); });
+        BOOST_CHECK_EQUAL(content, section_content(section));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(rewritten_file) {
+    write_sections("rewritten_sections.nav", 42);
+    SectionsReader reader("rewritten_sections.nav");
+    write_sections("rewritten_sections.nav", 42);
+    BOOST_CHECK_THROW(reader.read(DataSection::Fare, [](std::streambuf&) {}), navitia::exception);
+}
+
+BOOST_AUTO_TEST_CASE(not_sectioned) {
+    std::stringstream ss("some data");
+    BOOST_CHECK(! SectionsReader::is_sectioned(ss));
+    BOOST_CHECK_EQUAL(ss.tellg(), 0);
+    BOOST_CHECK_THROW(SectionsReader{ss}, navitia::exception);
+}
@@ -37,6 +37,7 @@ www.navitia.io
 #include "type/response.pb.h"
 #include "ed/build_helper.h"
 #include "type/pb_converter.h"
+#include "type/pb_fragment_cache.h"
 #include "tests/utils_test.h"
 #include "utils/functions.h"
 
@@ -252,3 +253,132 @@ BOOST_AUTO_TEST_CASE(label_formater_line) {
     rer_a->commercial_mode = nullptr;
     BOOST_CHECK_EQUAL(rer_a->get_label(), "Transilien A");
 }
+
+// the objects shared by a response are filled once, the following fills are copies of the first one
+BOOST_AUTO_TEST_CASE(shared_objects_filled_once_by_response) {
+    ed::builder b("20161026");
+    b.generate_dummy_basis();
+
+    b.vj("A")("stop1", 8000, 8050)("stop2", 8200, 8250);
+    b.finish();
+    b.data->build_uri();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+
+    auto* sp = b.sps.at("stop1");
+    auto * data_ptr = b.data.get();
+    navitia::PbCreator pb_creator(data_ptr, pt::not_a_date_time, null_time_period);
+
+    pbnavitia::StopPoint first_fill;
+    pb_creator.fill(sp, &first_fill, 2);
+    BOOST_CHECK_EQUAL(first_fill.uri(), "stop1");
+    BOOST_CHECK_EQUAL(first_fill.stop_area().uri(), "stop1");
+
+    sp->name = "renamed stop1";
+    pbnavitia::StopPoint second_fill;
+    pb_creator.fill(sp, &second_fill, 2);
+    BOOST_CHECK_EQUAL(second_fill.SerializeAsString(), first_fill.SerializeAsString());
+
+    // with another depth, the stop point is filled again
+    pbnavitia::StopPoint other_depth_fill;
+    pb_creator.fill(sp, &other_depth_fill, 0);
+    BOOST_CHECK_EQUAL(other_depth_fill.name(), "renamed stop1");
+    BOOST_CHECK(! other_depth_fill.has_stop_area());
+
+    // a new response fills it again
+    pb_creator.init(data_ptr, pt::not_a_date_time, null_time_period);
+    pbnavitia::StopPoint new_response_fill;
+    pb_creator.fill(sp, &new_response_fill, 2);
+    BOOST_CHECK_EQUAL(new_response_fill.name(), "renamed stop1");
+    BOOST_CHECK_EQUAL(new_response_fill.stop_area().uri(), "stop1");
+}
+
+// the memoized fill does not depend on the action period, the messages are filled for each period
+BOOST_AUTO_TEST_CASE(shared_objects_messages_filled_by_period) {
+    ed::builder b("20161026");
+    b.generate_dummy_basis();
+
+    b.vj("A")("stop1", 8000, 8050)("stop2", 8200, 8250);
+    b.finish();
+    b.data->build_uri();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+    b.impact(nt::RTLevel::Adapted)
+            .uri("impact_on_stop1")
+            .publish(boost::posix_time::time_period("20161026T000000"_dt, "20161027T000000"_dt))
+            .application_periods(boost::posix_time::time_period("20161026T080000"_dt, "20161026T090000"_dt))
+            .severity(nt::disruption::Effect::SIGNIFICANT_DELAYS)
+            .on(nt::Type_e::StopPoint, "stop1");
+
+    auto* sp = b.sps.at("stop1");
+    auto * data_ptr = b.data.get();
+    navitia::PbCreator pb_creator(data_ptr, "20161026T080000"_dt,
+                                  boost::posix_time::time_period("20161026T080000"_dt, "20161026T083000"_dt));
+
+    pbnavitia::StopPoint first_fill;
+    pb_creator.fill(sp, &first_fill, 2);
+    BOOST_REQUIRE_EQUAL(first_fill.impact_uris_size(), 1);
+    BOOST_CHECK_EQUAL(first_fill.impact_uris(0), "impact_on_stop1");
+
+    sp->name = "renamed stop1";
+    pb_creator.action_period = boost::posix_time::time_period("20161026T100000"_dt, "20161026T110000"_dt);
+    pbnavitia::StopPoint second_fill;
+    pb_creator.fill(sp, &second_fill, 2);
+    BOOST_CHECK_EQUAL(second_fill.name(), "stop1");
+    BOOST_CHECK_EQUAL(second_fill.stop_area().uri(), "stop1");
+    BOOST_CHECK_EQUAL(second_fill.impact_uris_size(), 0);
+}
+
+// with the fragment cache, the static parts of a line are filled once by data, the impacts are still filled
+BOOST_AUTO_TEST_CASE(static_fragments_shared_between_responses) {
+    ed::builder b("20161026");
+    b.generate_dummy_basis();
+
+    b.vj("A")("stop1", 8000, 8050)("stop2", 8200, 8250);
+    b.finish();
+    b.data->build_uri();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+    b.data->pb_fragment_cache->set_enabled(true);
+
+    auto* line = b.lines.at("A");
+    auto * data_ptr = b.data.get();
+    const auto now = "20161026T080000"_dt;
+    const auto period = boost::posix_time::time_period("20161026T080000"_dt, "20161026T090000"_dt);
+
+    pbnavitia::Line first_fill;
+    navitia::PbCreator first_creator(data_ptr, now, period);
+    first_creator.fill(line, &first_fill, 1);
+    BOOST_CHECK_EQUAL(first_fill.name(), "A");
+    BOOST_CHECK_EQUAL(first_fill.routes_size(), 1);
+    BOOST_CHECK_EQUAL(first_fill.impact_uris_size(), 0);
+    BOOST_CHECK(b.data->pb_fragment_cache->size() > 0);
+    BOOST_CHECK(first_creator.nb_fragment_calls > 0);
+    BOOST_CHECK_EQUAL(first_creator.nb_fragment_cache_miss, first_creator.nb_fragment_calls);
+
+    // the objects must not be modified once the cache is enabled, we do it to check that the name comes from it
+    line->name = "renamed A";
+    b.impact(nt::RTLevel::Adapted)
+            .uri("impact_on_A")
+            .publish(boost::posix_time::time_period("20161026T000000"_dt, "20161027T000000"_dt))
+            .application_periods(boost::posix_time::time_period("20161026T000000"_dt, "20161027T000000"_dt))
+            .severity(nt::disruption::Effect::SIGNIFICANT_DELAYS)
+            .on(nt::Type_e::Line, "A");
+
+    pbnavitia::Line second_fill;
+    navitia::PbCreator second_creator(data_ptr, now, period);
+    second_creator.fill(line, &second_fill, 1);
+    BOOST_CHECK_EQUAL(second_fill.name(), "A");
+    BOOST_CHECK_EQUAL(second_fill.routes_size(), 1);
+    BOOST_REQUIRE_EQUAL(second_fill.impact_uris_size(), 1);
+    BOOST_CHECK_EQUAL(second_fill.impact_uris(0), "impact_on_A");
+    BOOST_CHECK_EQUAL(second_creator.nb_fragment_calls, first_creator.nb_fragment_calls);
+    BOOST_CHECK_EQUAL(second_creator.nb_fragment_cache_miss, 0);
+
+    // a new data has its own cache
+    b.data->pb_fragment_cache = std::make_unique<navitia::PbFragmentCache>();
+    pbnavitia::Line third_fill;
+    navitia::PbCreator third_creator(data_ptr, now, period);
+    third_creator.fill(line, &third_fill, 1);
+    BOOST_CHECK_EQUAL(third_fill.name(), "renamed A");
+}
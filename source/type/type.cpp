@@ -449,6 +449,8 @@ template<> std::vector<FrequencyVehicleJourney*>& get_vjs(Route* r) {
     return r->frequency_vehicle_journey_list;
 }
 
+}// anonymous namespace
+
 void cleanup_useless_vj_link(const nt::VehicleJourney* vj, nt::PT_Data& pt_data) {
     // clean all backref to a vehicle journey before deleting it
     // need to be thorough !!
@@ -475,7 +477,6 @@ void cleanup_useless_vj_link(const nt::VehicleJourney* vj, nt::PT_Data& pt_data)
 
     pt_data.vehicle_journeys_map.erase(vj->uri);
 }
-}// anonymous namespace
 
 void MetaVehicleJourney::clean_up_useless_vjs(nt::PT_Data& pt_data) {
     std::vector<std::pair<RTLevel, size_t>> vj_idx_to_remove;
@@ -496,7 +497,13 @@ void MetaVehicleJourney::clean_up_useless_vjs(nt::PT_Data& pt_data) {
         auto vj_idx = level_and_vj_idx_to_remove.second;
         auto& vj = this->rtlevel_to_vjs_map[rt_level][vj_idx];
 
-        cleanup_useless_vj_link(vj.get(), pt_data);
+        if (auto* staging = RealtimeStaging::current()) {
+            // the collections of the pt_data are shared with the other threads,
+            // the vj is unlinked and deleted by the merge of the staging
+            staging->removed_vjs.push_back(std::move(vj));
+        } else {
+            cleanup_useless_vj_link(vj.get(), pt_data);
+        }
 
         // once all the links to the vj have been cleaned we can destroy the object
         // (by removing the unique_ptr from the vector)
@@ -573,11 +580,17 @@ VJ* MetaVehicleJourney::impl_create_vj(const std::string& uri,
     clean_up_useless_vjs(pt_data);
 
     // inserting the vj in the model
-    vj_ptr->idx = pt_data.vehicle_journeys.size();
-    pt_data.vehicle_journeys.push_back(ret);
-    pt_data.vehicle_journeys_map[ret->uri] = ret;
-    if (route) {
-        get_vjs<VJ>(route).push_back(ret);
+    if (auto* staging = RealtimeStaging::current()) {
+        // inserted by the merge of the staging, the idx only keeps the order of creation until then
+        vj_ptr->idx = pt_data.vehicle_journeys.size() + staging->created_vjs.size();
+        staging->created_vjs.push_back(ret);
+    } else {
+        vj_ptr->idx = pt_data.vehicle_journeys.size();
+        pt_data.vehicle_journeys.push_back(ret);
+        pt_data.vehicle_journeys_map[ret->uri] = ret;
+        if (route) {
+            get_vjs<VJ>(route).push_back(ret);
+        }
     }
     rtlevel_to_vjs_map[level].emplace_back(std::move(vj_ptr));
     return ret;
@@ -691,6 +704,7 @@ bool MetaVehicleJourney::is_already_impacted_by(const boost::shared_ptr<disrupti
 void MetaVehicleJourney::push_unique_impact(const boost::shared_ptr<disruption::Impact>& impact) {
     if (! is_already_impacted_by(impact)) {
         impacted_by.push_back(impact);
+        impact->impacted_meta_vjs.push_back(this);
     }
 }
 